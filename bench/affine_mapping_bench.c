@@ -0,0 +1,82 @@
+/**
+ * Times frames of a textured scene with affine texture mapping picked by the
+ * interpolated vertex clip test, then by the reference geometry shader. The
+ * scene is drawn several times a frame so vertex work dominates.
+ */
+#include "glad.h"
+
+#include <stdio.h>
+
+#include "game.h"
+#include "screen.h"
+#include "shaders.h"
+#include "test_scene.h"
+
+// Frames to render before timing, so the shaders have been built
+static const int SETTLE_FRAMES = 10;
+static const int TIMED_FRAMES = 200;
+static const int DRAWS_PER_FRAME = 20;
+
+static const char *const MODE_NAMES[2] = {
+    "vertex clip test", "geometry shader"
+};
+
+static struct PRGLTestScene scene;
+static int mode = 0;
+static int frame = 0;
+static double start_time = 0;
+
+static void init(void)
+{
+    prgl_init_test_scene(&scene, prgl_create_test_texture(), 0);
+}
+
+static void update(void) { prgl_update_test_scene(&scene); }
+
+static void draw_3d(void)
+{
+    for (int i = 0; i < DRAWS_PER_FRAME; i++)
+    {
+        prgl_draw_test_scene(&scene);
+    }
+}
+
+static void draw_2d(void) {}
+
+static void cleanup(void)
+{
+    // Wait for the frame so the time covers the GPU work
+    glFinish();
+
+    frame++;
+    if (frame == SETTLE_FRAMES)
+    {
+        start_time = prgl_time_elapsed();
+    }
+    if (frame < SETTLE_FRAMES + TIMED_FRAMES)
+    {
+        return;
+    }
+
+    const double elapsed = prgl_time_elapsed() - start_time;
+    printf(
+        "%-16s %8.3f ms per frame\n", MODE_NAMES[mode],
+        elapsed * 1000.0 / TIMED_FRAMES
+    );
+
+    frame = 0;
+    if (++mode == 2)
+    {
+        prgl_close_game();
+        return;
+    }
+    prgl_set_geometry_shader_affine_enabled(true);
+}
+
+int main(void)
+{
+    prgl_run_game(
+        "affine_mapping_bench", init, update, draw_3d, draw_2d, cleanup
+    );
+    return 0;
+}
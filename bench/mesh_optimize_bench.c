@@ -0,0 +1,193 @@
+/**
+ * Builds the generator meshes, which are welded and reordered for the
+ * post-transform cache as they're created, and prints their vertex counts and
+ * vertex shader runs before and after.
+ *
+ * Runs before are estimated by simulating the cache over the generated
+ * geometry, the generated geometry isn't kept so it can't be drawn. Runs after
+ * are counted by drawing each mesh inside a GL_VERTEX_SHADER_INVOCATIONS query
+ * when the context has GL 4.6 or ARB_pipeline_statistics_query, else they're
+ * estimated the same way.
+ */
+#include "glad.h"
+
+#include <GLFW/glfw3.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "camera.h"
+#include "game.h"
+#include "gl_state_internal.h"
+#include "mesh.h"
+#include "mesh_internal.h"
+#include "render_internal.h"
+#include "screen.h"
+#include "shaders.h"
+#include "texture.h"
+
+// The loader only covers GL 3.3
+#ifndef GL_VERTEX_SHADER_INVOCATIONS
+#define GL_VERTEX_SHADER_INVOCATIONS 0x82F0
+#endif
+
+#define NUM_MESHES 9
+
+// Frames to render before drawing the meshes, so the shaders have been built
+static const int SETTLE_FRAMES = 2;
+
+static const char *const MESH_NAMES[NUM_MESHES] = {
+    "triangle",       "circle 64",      "quad",
+    "pyramid",        "cube",           "cube sphere 4",
+    "cube sphere 16", "cube sphere 64", "cube sphere 120",
+};
+
+static struct PRGLCamera camera;
+static PRGLMeshHandle meshes[NUM_MESHES];
+static struct PRGLMeshStats stats[NUM_MESHES];
+static GLuint64 measured_runs[NUM_MESHES];
+static bool can_query = false;
+static bool measured = false;
+static int frame = 0;
+
+/**
+ * @param index Which of MESH_NAMES to create.
+ * @return The new mesh.
+ */
+static PRGLMeshHandle create_mesh(int index)
+{
+    static const int SPHERE_RESOLUTIONS[4] = {4, 16, 64, 120};
+
+    switch (index)
+    {
+    case 0:
+        return prgl_create_triangle(PRGL_NO_TEXTURE);
+    case 1:
+        return prgl_create_circle(PRGL_NO_TEXTURE, 64);
+    case 2:
+        return prgl_create_quad(PRGL_NO_TEXTURE);
+    case 3:
+        return prgl_create_pyramid(PRGL_NO_TEXTURE);
+    case 4:
+        return prgl_create_cube(PRGL_NO_TEXTURE);
+    default:
+        return prgl_create_cube_sphere(
+            SPHERE_RESOLUTIONS[index - 5], PRGL_NO_TEXTURE
+        );
+    }
+}
+
+static void init(void)
+{
+    prgl_init_camera(&camera, 60.0f, 1.0f, PRGL_CAMERA_PROJECTION_PERSPECTIVE);
+
+    // The mesh stats are running totals, so each mesh's are the difference
+    for (int i = 0; i < NUM_MESHES; i++)
+    {
+        const struct PRGLMeshStats before = prgl_mesh_stats();
+        meshes[i] = create_mesh(i);
+        const struct PRGLMeshStats after = prgl_mesh_stats();
+        stats[i] = (struct PRGLMeshStats){
+            .triangles = after.triangles - before.triangles,
+            .source_vertices = after.source_vertices - before.source_vertices,
+            .unique_vertices = after.unique_vertices - before.unique_vertices,
+            .source_vertex_shader_runs = after.source_vertex_shader_runs
+                                       - before.source_vertex_shader_runs,
+            .vertex_shader_runs =
+                after.vertex_shader_runs - before.vertex_shader_runs,
+        };
+    }
+
+    can_query = (GLVersion.major == 4 && GLVersion.minor >= 6)
+             || GLVersion.major > 4
+             || glfwExtensionSupported("GL_ARB_pipeline_statistics_query");
+}
+
+static void update(void) {}
+
+static void draw_3d(void)
+{
+    if (!can_query || measured || frame < SETTLE_FRAMES)
+    {
+        return;
+    }
+
+    GLuint query;
+    glGenQueries(1, &query);
+    for (int i = 0; i < NUM_MESHES; i++)
+    {
+        if (meshes[i] == NULL)
+        {
+            continue;
+        }
+        prgl_gl_bind_vertex_array(meshes[i]->vao);
+        glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS, query);
+        prgl_draw_mesh(meshes[i]);
+        glEndQuery(GL_VERTEX_SHADER_INVOCATIONS);
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &measured_runs[i]);
+    }
+    glDeleteQueries(1, &query);
+    measured = true;
+}
+
+static void draw_2d(void) {}
+
+static void cleanup(void)
+{
+    if (++frame <= SETTLE_FRAMES)
+    {
+        return;
+    }
+    for (int i = 0; i < NUM_MESHES; i++)
+    {
+        if (meshes[i] != NULL)
+        {
+            prgl_delete_mesh(meshes[i]);
+        }
+    }
+    prgl_close_game();
+}
+
+/**
+ * @param runs
+ * @param triangles
+ * @return Vertex shader runs per triangle, 0.5 is the best a regular grid can
+ * do and 3 means no vertex is reused.
+ */
+static double acmr(double runs, int triangles)
+{
+    return triangles > 0 ? runs / triangles : 0.0;
+}
+
+int main(void)
+{
+    prgl_run_game(
+        "mesh_optimize_bench", init, update, draw_3d, draw_2d, cleanup
+    );
+
+    printf(
+        "mesh_optimize_bench: runs after are %s\n",
+        measured ? "counted with GL_VERTEX_SHADER_INVOCATIONS" : "estimated"
+    );
+    printf(
+        "%-16s %9s %9s %9s %9s %9s %7s %7s\n", "mesh", "triangles",
+        "vertices", "welded", "runs", "runs", "ACMR", "ACMR"
+    );
+    printf(
+        "%-16s %9s %9s %9s %9s %9s %7s %7s\n", "", "", "", "", "before",
+        "after", "before", "after"
+    );
+    for (int i = 0; i < NUM_MESHES; i++)
+    {
+        const double runs_after = measured ? (double)measured_runs[i]
+                                           : stats[i].vertex_shader_runs;
+        printf(
+            "%-16s %9d %9d %9d %9d %9.0f %7.3f %7.3f\n", MESH_NAMES[i],
+            stats[i].triangles, stats[i].source_vertices,
+            stats[i].unique_vertices, stats[i].source_vertex_shader_runs,
+            runs_after,
+            acmr(stats[i].source_vertex_shader_runs, stats[i].triangles),
+            acmr(runs_after, stats[i].triangles)
+        );
+    }
+    return 0;
+}
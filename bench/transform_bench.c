@@ -0,0 +1,149 @@
+/**
+ * Measures how fast model and normal matrices are built for many objects:
+ * - inverse loop: prgl_create_model_matrix() and prgl_create_normal_matrix(),
+ * which inverts the model matrix.
+ * - cached rebuild: the cached game object path, with every object dirty.
+ * - SoA batch: prgl_build_transform_matrices() over a transform store.
+ *
+ * Doesn't open a window.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "game_object.h"
+#include "transform_internal.h"
+#include "transform_store.h"
+
+// Each method builds this many transforms per object count, so small counts
+// are repeated enough to time
+static const int TRANSFORMS_PER_METHOD = 10000000;
+
+static double cpu_seconds(void) { return (double)clock() / CLOCKS_PER_SEC; }
+
+static double millions_per_second(int num_transforms, double seconds)
+{
+    return num_transforms / seconds / 1e6;
+}
+
+/**
+ * Times every method over the same objects and prints the rates.
+ *
+ * @param num_objects
+ * @return False if memory couldn't be allocated.
+ */
+static bool run_benchmark(int num_objects)
+{
+    struct PRGLGameObject *const game_objs =
+        malloc(sizeof(*game_objs) * num_objects);
+    mat4 *const models = malloc(sizeof(*models) * num_objects);
+    mat3 *const normal_matrices =
+        malloc(sizeof(*normal_matrices) * num_objects);
+    struct PRGLTransformStore store;
+    if (!prgl_init_transform_store(&store, num_objects) || game_objs == NULL
+        || models == NULL || normal_matrices == NULL)
+    {
+        fprintf(stderr, "run_benchmark: Error allocating memory!\n");
+        free(game_objs);
+        free(models);
+        free(normal_matrices);
+        prgl_delete_transform_store(&store);
+        return false;
+    }
+
+    // Scattered, turned every way, and a third stretched on one axis
+    srand(1);
+    for (int i = 0; i < num_objects; i++)
+    {
+        struct PRGLGameObject *const game_obj = &game_objs[i];
+        prgl_init_game_object(
+            game_obj, NULL,
+            (vec3){(float)(rand() % 100) - 50.0f, (float)(rand() % 100) - 50.0f,
+                   (float)(rand() % 100) * 0.1f}
+        );
+        prgl_rotate_game_object(
+            game_obj, (float)(rand() % 360), (float)(rand() % 360),
+            (float)(rand() % 360)
+        );
+        const float scale = 0.5f + (float)(rand() % 100) * 0.01f;
+        prgl_set_game_object_scale(
+            game_obj, (vec3){scale, i % 3 ? scale : scale * 2.0f, scale}
+        );
+        prgl_add_transform(
+            &store, game_obj->position, game_obj->orientation, game_obj->scale
+        );
+    }
+
+    const int num_runs = TRANSFORMS_PER_METHOD / num_objects;
+    const int num_transforms = num_runs * num_objects;
+
+    const double inverse_start = cpu_seconds();
+    for (int run = 0; run < num_runs; run++)
+    {
+        for (int i = 0; i < num_objects; i++)
+        {
+            prgl_create_model_matrix(models[i], &game_objs[i]);
+            prgl_create_normal_matrix(normal_matrices[i], models[i]);
+        }
+    }
+
+    const double cached_start = cpu_seconds();
+    for (int run = 0; run < num_runs; run++)
+    {
+        for (int i = 0; i < num_objects; i++)
+        {
+            game_objs[i].transform_dirty = true;
+            prgl_update_game_object_transform(&game_objs[i]);
+        }
+    }
+
+    const double batch_start = cpu_seconds();
+    for (int run = 0; run < num_runs; run++)
+    {
+        prgl_build_transform_matrices(&store, models, normal_matrices);
+    }
+    const double batch_end = cpu_seconds();
+
+    // The batch uses the same math as the cached path, so this should be 0
+    float max_difference = 0.0f;
+    for (int i = 0; i < num_objects; i++)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            const float difference =
+                game_objs[i].model[j / 4][j % 4] - models[i][j / 4][j % 4];
+            max_difference = fmaxf(max_difference, fabsf(difference));
+        }
+    }
+
+    printf(
+        "%7d objects: inverse loop %5.1f M/s, cached rebuild %5.1f M/s, "
+        "SoA batch %5.1f M/s, max difference %g\n",
+        num_objects,
+        millions_per_second(num_transforms, cached_start - inverse_start),
+        millions_per_second(num_transforms, batch_start - cached_start),
+        millions_per_second(num_transforms, batch_end - batch_start),
+        max_difference
+    );
+
+    free(game_objs);
+    free(models);
+    free(normal_matrices);
+    prgl_delete_transform_store(&store);
+    return true;
+}
+
+int main(void)
+{
+    const int object_counts[2] = {10000, 100000};
+    for (int i = 0; i < 2; i++)
+    {
+        if (!run_benchmark(object_counts[i]))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
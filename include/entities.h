@@ -0,0 +1,161 @@
+#ifndef PRGL_ENTITIES_H
+#define PRGL_ENTITIES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cglm/types.h"
+
+/// The most component types that can be registered, built in ones included.
+#define PRGL_MAX_COMPONENTS 32
+
+/// Turns a component type into its bit in a component mask.
+#define PRGL_COMPONENT_BIT(component) ((uint32_t)1 << (component))
+
+/**
+ * @brief Component types which come with prgl, any others are registered with
+ * prgl_register_component().
+ */
+enum PRGLBuiltinComponent
+{
+    PRGL_COMPONENT_TRANSFORM, ///< A struct PRGLTransform.
+    PRGL_COMPONENT_MESH,      ///< A PRGLMeshHandle.
+    PRGL_COMPONENT_COLOR,     ///< A vec3 RGB fill color.
+    PRGL_NUM_BUILTIN_COMPONENTS
+};
+
+/**
+ * @brief Position, rotation and scale of an entity. New transforms have no
+ * rotation and a scale of 1.
+ */
+struct PRGLTransform
+{
+    versor orientation; ///< Quaternion rotation.
+    vec3 position;
+    vec3 scale;
+};
+
+/**
+ * @brief A handle to an entity. The generation tells a destroyed entity from
+ * a later one reusing its index, so stale handles are safe to use.
+ */
+typedef struct PRGLEntity
+{
+    uint32_t index;
+    uint32_t generation;
+} PRGLEntity;
+
+/**
+ * @brief Iterates over the chunks of entities which have a set of components.
+ * Start one with prgl_query_entities().
+ */
+struct PRGLEntityQuery
+{
+    uint32_t components;
+    int archetype;
+    int chunk;
+};
+
+/**
+ * @brief A chunk of entities found by a query.
+ *
+ * Each component is a contiguous column with one value per entity, indexed by
+ * the component type. Only the columns of the components in the entities'
+ * archetype are set, the rest are NULL. Values can be written in place, but
+ * entities can't be created or destroyed while a query is in progress.
+ */
+struct PRGLEntityBatch
+{
+    int count;
+    const PRGLEntity *entities;
+    void *columns[PRGL_MAX_COMPONENTS];
+};
+
+/**
+ * @brief Registers a new component type.
+ *
+ * @param size The size of one component value in bytes.
+ * @return The component type, or -1 if PRGL_MAX_COMPONENTS are registered.
+ */
+int prgl_register_component(size_t size);
+
+/**
+ * @brief Creates entities which all have the same components.
+ *
+ * Entities with the same set of components are stored together in chunks,
+ * with a contiguous column per component. Built in components start out as
+ * an identity transform, no mesh and a white color, other components are
+ * zeroed.
+ *
+ * @param components Mask of the components, see PRGL_COMPONENT_BIT().
+ * @param count
+ * @param entities[out] Receives the handle of each entity.
+ * @return False if memory couldn't be allocated, no entities are created.
+ */
+bool prgl_create_entities(
+    uint32_t components, int count, PRGLEntity entities[]
+);
+
+/**
+ * @brief Destroys entities, their handles become stale. Stale handles are
+ * skipped.
+ *
+ * @param entities[in]
+ * @param count
+ */
+void prgl_destroy_entities(const PRGLEntity entities[], int count);
+
+/**
+ * @brief Checks if an entity handle refers to an entity which still exists.
+ *
+ * @param entity
+ * @return True if the entity hasn't been destroyed.
+ */
+bool prgl_entity_alive(PRGLEntity entity);
+
+/**
+ * @brief Gets one of an entity's components.
+ *
+ * The pointer is invalidated when entities are created or destroyed, or the
+ * entity's components change.
+ *
+ * @param entity
+ * @param component The component type.
+ * @return The component value, or NULL if the handle is stale or the entity
+ * doesn't have the component.
+ */
+void *prgl_entity_component(PRGLEntity entity, int component);
+
+/**
+ * @brief Changes which components an entity has, moving it to the chunks of
+ * its new set of components. Components it keeps keep their values, new ones
+ * start out as they do in prgl_create_entities().
+ *
+ * @param entity
+ * @param components Mask of the components, see PRGL_COMPONENT_BIT().
+ * @return False if the handle is stale or memory couldn't be allocated.
+ */
+bool prgl_set_entity_components(PRGLEntity entity, uint32_t components);
+
+/**
+ * @brief Starts a query over every entity which has at least the given
+ * components. Pass it to prgl_next_entity_batch() to get the entities.
+ *
+ * @param components Mask of the components, see PRGL_COMPONENT_BIT().
+ * @return The query.
+ */
+struct PRGLEntityQuery prgl_query_entities(uint32_t components);
+
+/**
+ * @brief Gets the next chunk of entities matching a query.
+ *
+ * @param query[in,out]
+ * @param batch[out]
+ * @return False once every matching chunk has been returned.
+ */
+bool prgl_next_entity_batch(
+    struct PRGLEntityQuery *const query, struct PRGLEntityBatch *const batch
+);
+
+#endif
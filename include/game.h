@@ -11,6 +11,8 @@
  * `prgl_init` is called one time before the core game loop starts.
  * All other callbacks are called once per frame in the following order:
  * `prgl_update` -> `prgl_draw_3d` -> `prgl_draw_2d -> `prgl_cleanup`
+ * With a fixed timestep `prgl_update` is instead called once per tick, which
+ * can be any number of times in a frame, see `prgl_set_fixed_timestep`.
  *
  * @param[in] title Title of the game, this will be used as the window header
  * @param[in] prgl_init Initialize callback, runs one time before the
@@ -26,14 +28,64 @@ void prgl_run_game(
     void (*prgl_cleanup)(void)
 );
 
+/**
+ * @brief Sets a callback which draws a loading screen while shaders compile.
+ *
+ * Shaders are compiled in the background where the driver supports it. While
+ * any are still compiling the frame calls this instead of `prgl_update`,
+ * `prgl_draw_3d` and `prgl_draw_2d`, with the 2D shader in use, and
+ * `prgl_cleanup` still runs at the end of it. The 2D shaders are compiled
+ * before the others start, so the loading screen never waits on them. Draws
+ * made with other shaders wait for them to compile, which the loading screen
+ * is meant to avoid. Pass NULL to run the game right away, the default.
+ *
+ * @param[in] draw_loading_screen Draws the loading screen, or NULL.
+ */
+void prgl_set_loading_screen(void (*draw_loading_screen)(void));
+
+/**
+ * @brief Runs the update callback at a fixed rate instead of once per frame.
+ *
+ * Each frame runs as many update ticks as the time since the last frame
+ * covers, so the simulation steps by the same amount no matter the frame
+ * rate. A frame runs at most `max_ticks` ticks, time beyond that is dropped so
+ * the game slows down instead of falling further behind. 3D draws of game
+ * objects are interpolated between their transforms in the last two ticks by
+ * `prgl_interpolation_alpha`.
+ *
+ * @param tick_rate Update ticks per second, or 0 to update once per frame,
+ * the default.
+ * @param max_ticks The most ticks to run in one frame, at least 1.
+ */
+void prgl_set_fixed_timestep(double tick_rate, int max_ticks);
+
 /**
  * Gets the time elapsed in seconds from the start of the last update until the
- * start of the current update.
+ * start of the current update. With a fixed timestep it is the tick length.
  *
  * @return The delta time of the previous frame.
  */
 double prgl_delta_time(void);
 
+/**
+ * @brief Gets how far the frame being drawn is between the last two update
+ * ticks, from 0 at the previous tick to 1 at the latest one.
+ *
+ * @return The interpolation alpha, always 1 without a fixed timestep.
+ */
+double prgl_interpolation_alpha(void);
+
+/**
+ * @brief Gets the number of the update tick in progress, or of the last one
+ * once it has finished.
+ *
+ * Counts up from 1 with each call of the update callback, and is 0 before the
+ * first.
+ *
+ * @return The current update tick.
+ */
+unsigned long prgl_current_tick(void);
+
 /**
  * @brief Gets the total time since the game was first initialized.
  *
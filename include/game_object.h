@@ -1,9 +1,21 @@
 #ifndef PRGL_GAME_OBJECT_H
 #define PRGL_GAME_OBJECT_H
 
+#include <stdbool.h>
+
 #include "cglm/types.h"
 #include "types.h"
 
+/**
+ * @brief An object in the game world, drawn with its mesh.
+ *
+ * The model and normal matrices are cached for 3D draws and only rebuilt when
+ * the transform changes through the prgl functions below. After writing
+ * position, orientation or scale directly, call prgl_mark_game_object_moved().
+ *
+ * With a fixed timestep, the transform a game object had before it first moved
+ * in a tick is kept so 3D draws can interpolate between the last two ticks.
+ */
 struct CGLM_ALIGN_MAT PRGLGameObject
 {
     versor orientation; ///< Quaternion rotation.
@@ -11,6 +23,19 @@ struct CGLM_ALIGN_MAT PRGLGameObject
     vec3 scale;
     vec3 color;
     PRGLMeshHandle mesh;
+
+    mat4 model; ///< Cached model matrix, valid when transform_dirty is false.
+    mat3 normal_matrix; ///< Cached normal matrix, valid with the model matrix.
+    bool transform_dirty; ///< True if the cached matrices need rebuilding.
+
+    /// Set by scene graphs, the transform is then relative to the parent and
+    /// the cached matrices are world space.
+    const struct PRGLGameObject *parent;
+
+    versor previous_orientation; ///< Orientation before the last move tick.
+    vec3 previous_position;      ///< Position before the last move tick.
+    vec3 previous_scale;         ///< Scale before the last move tick.
+    unsigned long move_tick;     ///< The last update tick it moved in.
 };
 
 /**
@@ -25,6 +50,38 @@ void prgl_init_game_object(
     vec3 position
 );
 
+/**
+ * @brief Sets the position of a game object.
+ *
+ * @param game_obj[out]
+ * @param position
+ */
+void prgl_set_game_object_position(
+    struct PRGLGameObject *const game_obj, vec3 position
+);
+
+/**
+ * @brief Sets the scale of a game object along each axis.
+ *
+ * @param game_obj[out]
+ * @param scale
+ */
+void prgl_set_game_object_scale(
+    struct PRGLGameObject *const game_obj, vec3 scale
+);
+
+/**
+ * @brief Marks a game object's cached matrices as out of date, for when its
+ * position, orientation or scale were written directly.
+ *
+ * With a fixed timestep, call it before writing the transform for the draws
+ * to interpolate the move. Calling it after makes the draws jump to the new
+ * transform instead.
+ *
+ * @param game_obj[out]
+ */
+void prgl_mark_game_object_moved(struct PRGLGameObject *const game_obj);
+
 /**
  * @brief Rotates a game object.
  *
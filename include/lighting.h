@@ -1,9 +1,24 @@
 #ifndef PRGL_LIGHTING_H
 #define PRGL_LIGHTING_H
 
+#include <stdbool.h>
+
 #include "cglm/types.h"
+#include "types.h"
 
-#define PRGL_MAX_POINT_LIGHTS 32
+struct PRGLGameObject;
+
+/**
+ * Most point lights passed to the shaders. With more than a few lights each
+ * vertex only evaluates the lights which can reach its cluster of the view, so
+ * large numbers of small lights stay cheap.
+ */
+#define PRGL_MAX_POINT_LIGHTS 256
+
+/**
+ * Most point lights an object is lit by when lights are selected per object.
+ */
+#define PRGL_MAX_OBJECT_POINT_LIGHTS 4
 
 /**
  * @brief Determines the distance and fall-off for a light.
@@ -52,7 +67,11 @@ struct CGLM_ALIGN(8) PRGLPointLight
 void prgl_init_point_light(struct PRGLPointLight *const light, vec3 position);
 
 /**
- * @brief Passes lighting data from lights to the active shader.
+ * @brief Passes lighting data from lights to the lit shaders.
+ *
+ * Lights are shared by all shaders through the PRGLLights uniform block. Only
+ * the lights which changed since the last call are uploaded, so it's cheap to
+ * call every frame with the same lights.
  *
  * @param point_lights[in] PRGLPointLight The point lights for the scene.
  * @param num_lights
@@ -61,6 +80,80 @@ void prgl_update_lighting(
     struct PRGLPointLight *const point_lights, int num_lights
 );
 
+/**
+ * @brief Sets the static point lights, which are baked into static meshes
+ * instead of being passed to the shaders.
+ *
+ * Meshes baked with prgl_bake_game_object_lighting() store the light the
+ * static lights add to each vertex, and lights from prgl_update_lighting() are
+ * added on top when they're drawn, so don't pass static lights to both. Only
+ * the lights which changed since the last call are re-baked, and only into the
+ * meshes they reach, by taking away the light they added before and adding
+ * their new light. A mesh re-baked this way many times is baked again from
+ * scratch, so float error doesn't build up.
+ *
+ * @param point_lights[in] PRGLPointLight The static point lights.
+ * @param num_lights
+ */
+void prgl_update_static_lighting(
+    struct PRGLPointLight *const point_lights, int num_lights
+);
+
+/**
+ * @brief Bakes the static point lights into a game object's mesh.
+ *
+ * The lights are evaluated at each vertex for the game object's transform on
+ * the CPU, split across several threads for large meshes. Drawing the mesh
+ * with the 3D shaders then starts from the baked light instead of evaluating
+ * the static lights. The baked light is stored on the mesh, so the mesh
+ * should only be drawn with this transform. Give each static game object its
+ * own mesh, and bake it again if it moves. Baking a mesh which is already
+ * baked for another game object at a different transform is refused with an
+ * error, clear it first with prgl_clear_baked_lighting() to move the bake.
+ * Meshes without normals can't be baked.
+ *
+ * @param game_obj[in]
+ */
+void prgl_bake_game_object_lighting(struct PRGLGameObject *const game_obj);
+
+/**
+ * @brief Stops a mesh using its baked lighting, so drawing it evaluates every
+ * light again except the static ones. Meshes are cleared when deleted.
+ *
+ * @param mesh
+ */
+void prgl_clear_baked_lighting(PRGLMeshHandle mesh);
+
+/**
+ * @brief Enables or disables clustered light assignment, enabled by default.
+ *
+ * With more than a few point lights the view is split into clusters and each
+ * light is assigned to the clusters within its reach, so each vertex only
+ * evaluates nearby lights. A light's reach ends where it would add less than
+ * half a step of an 8 bit color channel. Disabling it makes every vertex
+ * evaluate every light, which is mostly useful for comparison.
+ *
+ * @param enabled
+ */
+void prgl_set_clustered_lighting_enabled(bool enabled);
+
+/**
+ * @brief Lights each 3D draw with only the point lights affecting it most,
+ * disabled by default.
+ *
+ * When there are more point lights than the given number, the lights reaching
+ * each object's bounding sphere are found on the CPU and the most influential
+ * ones are passed with the draw, or with each instance of instanced draws.
+ * Lit shaders then loop over those few lights instead of every light, which
+ * is cheaper than clustered lighting but drops the dimmest lights where many
+ * overlap. Influence is the most a light adds at the nearest point of the
+ * object's bounding sphere.
+ *
+ * @param num_lights Lights per object, at most PRGL_MAX_OBJECT_POINT_LIGHTS,
+ * or 0 to light objects with every light.
+ */
+void prgl_set_lights_per_object(int num_lights);
+
 /**
  * @brief Gets the linear constant for light attenuation from the intensity.
  *
@@ -4,6 +4,24 @@
 #include "cglm/types.h"
 #include "types.h"
 
+/**
+ * @brief Totals for every triangle mesh created so far.
+ *
+ * Meshes are welded, indexed, and reordered for the GPU's post-transform
+ * vertex cache when they're created. Vertex shader runs are estimated by
+ * simulating a small FIFO cache, so comparing the source and optimized counts
+ * shows how much vertex work the optimization saves.
+ */
+struct PRGLMeshStats
+{
+    int triangles;
+    int source_vertices; ///< Vertices as the mesh generators made them.
+    int unique_vertices; ///< Vertices left after welding duplicates.
+
+    int source_vertex_shader_runs; ///< Estimated for the generated geometry.
+    int vertex_shader_runs;        ///< Estimated for the optimized geometry.
+};
+
 /**
  * @brief Creates a triangle mesh.
  *
@@ -65,6 +83,22 @@ PRGLMeshHandle prgl_create_cube_sphere(int resolution, PRGLTexture texture);
  */
 PRGLMeshHandle prgl_create_line_strip(vec3 points[], int num_points);
 
+/**
+ * @brief Gets the vertex counts of the meshes created so far.
+ *
+ * @return The totals for all meshes, including deleted ones.
+ */
+struct PRGLMeshStats prgl_mesh_stats(void);
+
+/**
+ * @brief Packs the geometry of the live meshes together.
+ *
+ * Meshes share large buffers, so deleting meshes leaves gaps. This moves the
+ * remaining meshes' geometry to close the gaps and frees buffers no mesh uses.
+ * It's also done automatically when new geometry doesn't fit any gap.
+ */
+void prgl_compact_mesh_geometry(void);
+
 /**
  * @brief Cleans up the GL objects associated with the mesh and frees it.
  *
@@ -1,12 +1,49 @@
 #ifndef PRGL_RENDER_H
 #define PRGL_RENDER_H
 
+#include <stdbool.h>
+
 #include "cglm/types.h"
+#include "types.h"
 
 struct PRGLGameObject;
+struct PRGLTransformStore;
 
 extern const vec2 PRGL_RENDER_RESOLUTION;
 
+/**
+ * @brief Counters for the draws flushed from the render queue in a frame.
+ *
+ * The unsorted counts are the binds the same draws would have needed in the
+ * order they were made, so the difference is what sorting saved.
+ */
+struct PRGLRenderStats
+{
+    int draws;
+    int opaque_draws;
+    int translucent_draws;
+
+    int shader_binds;
+    int vao_binds;
+    int texture_binds;
+
+    int unsorted_shader_binds;
+    int unsorted_vao_binds;
+    int unsorted_texture_binds;
+
+    int sprite_batches;  ///< Draw calls made for batched 2D draws.
+    int batched_sprites; ///< 2D draws that went into a batch.
+
+    int multi_draws; ///< Indirect draw calls made for merged 3D draws.
+    int multi_drawn; ///< 3D draws that went into an indirect draw call.
+
+    int visible_draws; ///< 3D draws and instances inside the camera frustum.
+    int culled_draws;  ///< 3D draws and instances skipped by frustum culling.
+
+    int gpu_tested_draws;    ///< 3D draws frustum culled in a compute pass.
+    int gpu_cull_mismatches; ///< GPU culling results the CPU disagreed with.
+};
+
 /**
  * Clears the screen using the given color. Values are from 0-1.
  *
@@ -20,6 +57,12 @@ void prgl_clear_screen(float r, float g, float b, float a);
 /**
  * Draws a game object to the screen.
  *
+ * While the render queue is enabled the draw is recorded along with the
+ * current shader, alpha, and tile factor, and it is issued when the 3D phase
+ * of the game loop ends. Opaque draws are grouped by shader, texture and mesh
+ * and drawn front to back, draws with an alpha below 1 are drawn back to front
+ * after them.
+ *
  * @param[in] game_obj
  */
 void prgl_draw_game_object_3d(struct PRGLGameObject *const game_obj);
@@ -28,8 +71,146 @@ void prgl_draw_game_object_3d(struct PRGLGameObject *const game_obj);
  * Draws a game object to the screen at a 2D position.
  * Rotation will be about the Z axis.
  *
+ * While the render queue is enabled the draw is recorded and issued when the
+ * 2D phase of the game loop ends, 2D draws keep the order they were made in.
+ * Consecutive triangle, quad and circle draws made with the 2D shader are
+ * transformed on the CPU and drawn together, a new batch is only started when
+ * the texture changes.
+ *
  * @param[in] game_obj
  */
 void prgl_draw_game_object_2d(struct PRGLGameObject *const game_obj);
 
+/**
+ * @brief Draws many game objects which share a mesh in a single draw call.
+ *
+ * All game objects are drawn with the mesh of the first game object, so only
+ * group game objects with the same mesh. Works with the 3D and unlit shaders,
+ * which are swapped for their instanced versions for the draw. Custom shaders
+ * fall back to drawing each game object individually.
+ *
+ * @param[in] game_objs
+ * @param num_game_objs
+ */
+void prgl_draw_game_objects_3d_instanced(
+    struct PRGLGameObject *const game_objs, int num_game_objs
+);
+
+/**
+ * @brief Draws a mesh once per model matrix in a single draw call.
+ *
+ * Same as prgl_draw_game_objects_3d_instanced() but takes raw transforms for
+ * when game objects aren't used to store them.
+ *
+ * @param mesh The mesh to draw.
+ * @param[in] models A model matrix for each instance.
+ * @param[in] colors A fill color for each instance, or NULL for white.
+ * @param num_instances
+ */
+void prgl_draw_mesh_3d_instanced(
+    PRGLMeshHandle mesh, mat4 models[], vec3 colors[], int num_instances
+);
+
+/**
+ * @brief Draws a mesh once per transform in a transform store in a single draw
+ * call.
+ *
+ * Same as prgl_draw_mesh_3d_instanced() but the matrices are built from the
+ * store several at a time, straight into the instance data.
+ *
+ * @param mesh The mesh to draw.
+ * @param[in] store The transforms to draw the mesh with.
+ * @param[in] colors A fill color for each transform, or NULL for white.
+ */
+void prgl_draw_transforms_3d_instanced(
+    PRGLMeshHandle mesh, const struct PRGLTransformStore *const store,
+    vec3 colors[]
+);
+
+/**
+ * @brief Draws every entity which has a transform and a mesh component.
+ *
+ * The transform, mesh and color columns are read straight from the entity
+ * chunks, entities without a color are drawn white and ones without a mesh are
+ * skipped. Draws are queued and culled like prgl_draw_game_object_3d().
+ */
+void prgl_draw_entities_3d(void);
+
+/**
+ * @brief Enables or disables the render queue, enabled by default.
+ *
+ * Queued draws only keep the model, fill color, alpha, and tile factor
+ * uniforms they were made with. Disable the queue if you set other uniforms
+ * between draws, draws are then issued immediately in the order they're made.
+ *
+ * @param enabled
+ */
+void prgl_set_render_queue_enabled(bool enabled);
+
+/**
+ * @brief Enables or disables frustum culling of 3D draws, enabled by default.
+ *
+ * Each mesh's bounding box and sphere are tested against the active camera's
+ * frustum, draws and instances outside it are skipped. Disable culling if a
+ * custom shader moves vertices outside the mesh's bounds.
+ *
+ * @param enabled
+ */
+void prgl_set_frustum_culling_enabled(bool enabled);
+
+/**
+ * @brief Enables or disables merging queued 3D draws, enabled by default.
+ *
+ * On GL 4.3 contexts, queued draws with the 3D and unlit shaders whose meshes
+ * share geometry buffers, a texture, alpha and tile factor are issued together
+ * with one glMultiDrawElementsIndirect call using the instanced shaders. Each
+ * draw's model matrix and fill color are read as instance data. On older
+ * contexts every draw is issued on its own regardless of this setting.
+ *
+ * @param enabled
+ */
+void prgl_set_multi_draw_enabled(bool enabled);
+
+/**
+ * @brief Enables or disables frustum culling multi draws on the GPU, enabled
+ * by default.
+ *
+ * When frustum culling is enabled on a GL 4.3 context, opaque draws that go
+ * into a multi draw are tested against the frustum in a compute pass instead
+ * of on the CPU, and only the visible ones are drawn. They are counted in
+ * gpu_tested_draws rather than visible_draws and culled_draws.
+ *
+ * @param enabled
+ */
+void prgl_set_gpu_culling_enabled(bool enabled);
+
+/**
+ * @brief Enables or disables checking GPU culling against the CPU test,
+ * disabled by default.
+ *
+ * Every GPU culled draw is also tested on the CPU, disagreements are printed
+ * and counted in gpu_cull_mismatches. Reading the results back stalls the GPU,
+ * so this is for debugging only.
+ *
+ * @param enabled
+ */
+void prgl_set_gpu_culling_validation(bool enabled);
+
+/**
+ * @brief Gets the render queue counters for the previous frame.
+ *
+ * @return The stats for the last full frame.
+ */
+struct PRGLRenderStats prgl_render_stats(void);
+
+/**
+ * @brief Forgets all GL state prgl has tracked.
+ *
+ * prgl skips binds and state changes that wouldn't change anything. If you
+ * bind programs, vertex arrays, textures, or framebuffers, or change the
+ * viewport or depth test, culling, or blending with GL directly, call this
+ * afterwards so the next prgl call sets its state again.
+ */
+void prgl_reset_gl_state_cache(void);
+
 #endif
@@ -0,0 +1,89 @@
+#ifndef PRGL_SCENE_GRAPH_H
+#define PRGL_SCENE_GRAPH_H
+
+#include <stdbool.h>
+
+struct PRGLGameObject;
+
+/**
+ * @brief A hierarchy of game objects, each placed relative to its parent.
+ *
+ * Nodes are kept in one array with every parent before its children and each
+ * subtree in one contiguous range, so updating walks the array once in order.
+ * A game object's position, orientation and scale are relative to its parent
+ * while it's in a graph, and its cached matrices are world space. Game objects
+ * must stay at the same address while they're in a graph.
+ */
+struct PRGLSceneGraph
+{
+    struct PRGLGameObject **nodes;
+
+    /// Index of each node's parent in nodes, -1 for roots.
+    int *parents;
+
+    /// Whether each node's world transform changed in the last update.
+    bool *changed;
+
+    int count;
+    int capacity;
+};
+
+/**
+ * @brief Initializes an empty scene graph.
+ *
+ * @param graph[out]
+ * @param capacity The number of nodes to allocate room for, the graph grows
+ * past it when needed.
+ * @return False if memory couldn't be allocated.
+ */
+bool prgl_init_scene_graph(struct PRGLSceneGraph *const graph, int capacity);
+
+/**
+ * @brief Frees the arrays of a scene graph and detaches its game objects.
+ *
+ * @param graph[in,out]
+ */
+void prgl_delete_scene_graph(struct PRGLSceneGraph *const graph);
+
+/**
+ * @brief Adds a game object to a scene graph.
+ *
+ * The game object's transform becomes relative to the parent from the next
+ * update.
+ *
+ * @param graph[in,out]
+ * @param game_obj[in,out] The game object to add, not already in a graph.
+ * @param parent[in] A game object in the graph, or NULL to add a root.
+ * @return False if the parent isn't in the graph or memory couldn't be
+ * allocated.
+ */
+bool prgl_add_scene_node(
+    struct PRGLSceneGraph *const graph, struct PRGLGameObject *const game_obj,
+    struct PRGLGameObject *const parent
+);
+
+/**
+ * @brief Removes a game object and all of its descendants from a scene graph.
+ *
+ * Their transforms are no longer relative to a parent from the next time
+ * they're drawn.
+ *
+ * @param graph[in,out]
+ * @param game_obj[in,out]
+ */
+void prgl_remove_scene_node(
+    struct PRGLSceneGraph *const graph, struct PRGLGameObject *const game_obj
+);
+
+/**
+ * @brief Updates the world matrices of the game objects in a scene graph.
+ *
+ * Only game objects which moved and their descendants are recomputed, and
+ * large graphs are split by root into jobs run on worker threads. Call once
+ * per frame after moving game objects in the graph and before drawing them.
+ *
+ * @param graph[in,out]
+ */
+void prgl_update_scene_graph(struct PRGLSceneGraph *const graph);
+
+#endif
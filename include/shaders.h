@@ -14,20 +14,37 @@
  * clarity. If you would like more information on how these are used refer to
  * the prgl source code on GitHub: github.com/hyperchomp/prgl/
  *
- * For 2D shaders the uniforms are the same except with the absence of the view
- * and normalMatrix. Layout is the same as well except there is no aNormal, note
- * that EVERYTHING else is the same including the layout location numbers.
+ * For 2D shaders the uniforms are the same except with the absence of the
+ * normalMatrix, and orthoProjection is used in place of viewProjection. Layout
+ * is the same as well except there is no aNormal, note that EVERYTHING else is
+ * the same including the layout location numbers.
  *
  * == Shader Contract ==
  *
  * Uniforms:
  *
+ * UNIFORM BLOCKS (bound automatically when a shader is created):
+ * - layout (std140) uniform PRGLFrame {
+ *       mat4 view;
+ *       mat4 projection;
+ *       mat4 viewProjection;
+ *       mat4 orthoProjection;
+ *       vec2 renderResolution;
+ *       float time;
+ *   };
+ * - layout (std140) uniform PRGLLights {
+ *       int numPointLights;
+ *       PointLight pointLights[PRGL_MAX_POINT_LIGHTS];
+ *   };
+ *   Where PointLight is { vec3 position; float ambient; vec3 color;
+ *   float linear; float quadratic; }, in that order.
+ *
  * VERTEX SHADER UNIFORMS:
  * - uniform mat4 model;
- * - uniform mat4 view;
- * - uniform mat4 projection;
  * - uniform mat3 normalMatrix;
- * - uniform vec2 renderResolution;
+ *
+ * Custom shaders may instead declare view, projection and renderResolution as
+ * plain uniforms, prgl sets them when switching shaders as before.
  *
  * FRAGMENT SHADER UNIFORMS:
  * - uniform bool useTexture = true;
@@ -40,6 +57,11 @@
  * - layout (location = 0) in vec3 aPos;
  * - layout (location = 1) in vec3 aNormal;
  * - layout (location = 2) in vec2 aTexCoord;
+ *
+ * INSTANCED VERTEX ATTRIBUTES LAYOUT (replaces model, normalMatrix, fillColor):
+ * - layout (location = 3) in mat4 aInstanceModel;
+ * - layout (location = 7) in mat3 aInstanceNormalMatrix;
+ * - layout (location = 10) in vec3 aInstanceFillColor;
  */
 
 #ifndef PRGL_SHADERS_H
@@ -52,6 +74,8 @@
 #include "cglm/types.h"
 
 extern const char *const PRGL_MODEL_UNIFORM;
+extern const char *const PRGL_VIEW_UNIFORM;
+extern const char *const PRGL_PROJECTION_UNIFORM;
 extern const char *const PRGL_NORMAL_MATRIX_UNIFORM;
 
 extern const char *const PRGL_NUM_POINT_LIGHTS_UNIFORM;
@@ -65,12 +89,33 @@ extern const char *const PRGL_RENDER_RESOLUTION_UNIFORM;
 extern const char *const PRGL_TILE_FACTOR_UNIFORM;
 extern const char *const PRGL_FILL_COLOR_UNIFORM;
 extern const char *const PRGL_USE_TEXTURE_UNIFORM;
+extern const char *const PRGL_ALPHA_UNIFORM;
+
+/**
+ * Counters for the shader programs created so far.
+ */
+struct PRGLShaderStats
+{
+    int programs_compiled;  ///< Programs compiled and linked from source.
+    int programs_cached;    ///< Programs loaded from the binary cache.
+    int programs_compiling; ///< Programs submitted but not finished yet.
+    double build_seconds;   ///< Time spent creating programs either way.
+};
 
 /**
  * Precompiled shader types. These can be used with prgl_shader() to get the ID
  * of a precompiled shader.
  *
  * The default is PRGL_SHADER_TYPE_3D for 3D, and PRGL_SHADER_TYPE_2D for 2D
+ *
+ * The 3D and unlit types are specialized per draw. Draws made with them use a
+ * variant compiled for whether the mesh is textured, how many point lights
+ * there are, and the wobble and affine mapping settings.
+ *
+ * The instanced types are used automatically by the instanced draw functions,
+ * they read model, normalMatrix and fillColor from per-instance attributes.
+ * PRGL_SHADER_TYPE_2D_BATCHED is used automatically for batched 2D draws made
+ * with PRGL_SHADER_TYPE_2D.
  */
 enum PRGLShaderType
 {
@@ -78,6 +123,9 @@ enum PRGLShaderType
     PRGL_SHADER_TYPE_2D,
     PRGL_SHADER_TYPE_3D,
     PRGL_SHADER_TYPE_UNLIT,
+    PRGL_SHADER_TYPE_3D_INSTANCED,
+    PRGL_SHADER_TYPE_UNLIT_INSTANCED,
+    PRGL_SHADER_TYPE_2D_BATCHED,
     PRGL_SHADER_TYPE_COUNT
 };
 
@@ -102,6 +150,11 @@ PRGLShader prgl_current_shader(void);
 /**
  * Creates a shader from the given sources.
  *
+ * The sources are handed to the driver and the program is returned without
+ * waiting for it to compile, so many programs can be compiled at once.
+ * prgl_use_shader() and prgl_uniform_handle() wait for the program if it's
+ * still compiling, use prgl_shader_ready() to check without waiting.
+ *
  * @param[in] vertex_source The GLSL code for the vertex shader.
  * @param[in] frag_source The GLSL code for the fragment shader.
  * @param[in] geometry_source GLSL code for the geometry shader. Can be NULL.
@@ -113,10 +166,61 @@ PRGLShader prgl_create_shader(
     const char *const geometry_source[], int num_geometry_sources
 );
 
+/**
+ * @brief Sets the file compiled shader programs are cached in, or NULL to
+ * disable the cache.
+ *
+ * Must be called before prgl_run_game() to take effect. Programs created with
+ * prgl_create_shader() are saved as driver binaries when the game exits and
+ * loaded from the file on the next run instead of being compiled, which
+ * shortens startup. The file is keyed by the GL vendor, renderer and version,
+ * so it's ignored after a driver change, and programs whose sources changed
+ * are recompiled. Defaults to "prgl_shader_cache.bin" in the working
+ * directory. The cache is unused if the driver can't save program binaries.
+ *
+ * @param path[in] The path is copied.
+ */
+void prgl_set_shader_cache_path(const char *const path);
+
+/**
+ * Checks if a shader has finished compiling without waiting for it.
+ *
+ * Drivers without GL_KHR_parallel_shader_compile can't be asked, so on those
+ * the shader is finished on the spot, waiting for the driver if needed, and
+ * this always returns true.
+ *
+ * @param shader
+ * @return True if the shader can be used without waiting.
+ */
+bool prgl_shader_ready(PRGLShader shader);
+
+/**
+ * @brief Checks if every shader created so far has finished compiling.
+ *
+ * Shaders which have finished are set up for use along the way. Can be
+ * polled each frame to keep showing a loading screen while shaders compile,
+ * see prgl_set_loading_screen(). Has the same driver limits as
+ * prgl_shader_ready().
+ *
+ * @return True if no shaders are still compiling.
+ */
+bool prgl_shaders_ready(void);
+
+/**
+ * Gets counters for the shader programs created so far, including the time
+ * spent building them.
+ *
+ * @return The shader program counters.
+ */
+struct PRGLShaderStats prgl_shader_stats(void);
+
 /**
  * Activates a shader for use. Keep in mind there are default shaders activated
  * for the render and render_gui loops.
  *
+ * A shader which is still compiling is never bound, this waits for it to
+ * finish first.
+ *
  * @param shader The ID of the shader to use.
  */
 void prgl_use_shader(PRGLShader shader);
@@ -142,6 +246,39 @@ void prgl_use_shader_unlit(void);
  */
 void prgl_use_shader_2d(void);
 
+/**
+ * @brief Enables or disables snapping 3D vertices to the render resolution's
+ * pixel grid, enabled by default.
+ *
+ * Affects the built in 3D and unlit shaders.
+ *
+ * @param enabled
+ */
+void prgl_set_vertex_wobble_enabled(bool enabled);
+
+/**
+ * @brief Enables or disables affine texture mapping in the built in 3D
+ * shader, enabled by default.
+ *
+ * Affine mapping is only used for triangles with every vertex inside the clip
+ * volume, other triangles are always mapped with perspective correction.
+ *
+ * @param enabled
+ */
+void prgl_set_affine_mapping_enabled(bool enabled);
+
+/**
+ * @brief Selects how the built in 3D shader picks affine texture mapping,
+ * disabled by default.
+ *
+ * By default the vertex clip test is interpolated without perspective, which
+ * avoids running a geometry shader. Enabling this uses the original geometry
+ * shader instead, which is slower on many drivers and kept as a reference.
+ *
+ * @param enabled
+ */
+void prgl_set_geometry_shader_affine_enabled(bool enabled);
+
 /**
  * Flags a shader for deletion.
  *
@@ -152,6 +289,9 @@ void prgl_delete_shader(PRGLShader shader);
 /**
  * Sets the value of shader uniform variable which takes 4 floats.
  *
+ * The prgl_set_shader_uniform_* functions look the name up in the shader's
+ * uniform cache on every call, prefer prgl_uniform_handle() in hot code.
+ *
  * @param shader The shader ID to set the uniform on.
  * @param name[in] The name of the uniform to set.
  * @param a
@@ -241,6 +381,92 @@ void prgl_set_shader_uniform_bool(
     PRGLShader shader, const char *const name, bool value
 );
 
+/**
+ * @brief Gets a handle to a uniform on a shader.
+ *
+ * Uniform locations are looked up once when a shader is linked, so this is
+ * cheap, but hot code should still get its handles once up front and reuse
+ * them with the prgl_set_uniform_* functions.
+ *
+ * Uniform values are cached per shader and uploads are skipped if the value
+ * hasn't changed since it was last set through prgl. If you set a uniform with
+ * glUniform* directly the cache will be out of date, so don't mix the two.
+ *
+ * @param shader The shader to find the uniform on.
+ * @param name[in] The name of the uniform.
+ * @return The uniform handle, the location will be -1 if it isn't active.
+ */
+PRGLUniform prgl_uniform_handle(PRGLShader shader, const char *const name);
+
+/**
+ * Sets the value of a uniform which takes 4 floats.
+ *
+ * @param uniform Handle from prgl_uniform_handle(), its shader must be in use.
+ * @param a
+ * @param b
+ * @param c
+ * @param d
+ */
+void prgl_set_uniform_4f(
+    PRGLUniform uniform, float a, float b, float c, float d
+);
+
+/**
+ * Sets the value of a uniform which takes a vec3.
+ *
+ * @param uniform Handle from prgl_uniform_handle(), its shader must be in use.
+ * @param vec
+ */
+void prgl_set_uniform_vec3(PRGLUniform uniform, vec3 vec);
+
+/**
+ * Sets the value of a uniform which takes a vec2.
+ *
+ * @param uniform Handle from prgl_uniform_handle(), its shader must be in use.
+ * @param vec
+ */
+void prgl_set_uniform_vec2(PRGLUniform uniform, vec2 vec);
+
+/**
+ * Sets the value of a uniform which takes 4x4 floats.
+ *
+ * @param uniform Handle from prgl_uniform_handle(), its shader must be in use.
+ * @param matrix
+ */
+void prgl_set_uniform_mat4(PRGLUniform uniform, mat4 matrix);
+
+/**
+ * Sets the value of a uniform which takes 3x3 floats.
+ *
+ * @param uniform Handle from prgl_uniform_handle(), its shader must be in use.
+ * @param matrix
+ */
+void prgl_set_uniform_mat3(PRGLUniform uniform, mat3 matrix);
+
+/**
+ * Sets the value of a uniform which takes a float.
+ *
+ * @param uniform Handle from prgl_uniform_handle(), its shader must be in use.
+ * @param value
+ */
+void prgl_set_uniform_float(PRGLUniform uniform, float value);
+
+/**
+ * Sets the value of a uniform which takes an int.
+ *
+ * @param uniform Handle from prgl_uniform_handle(), its shader must be in use.
+ * @param value
+ */
+void prgl_set_uniform_int(PRGLUniform uniform, int value);
+
+/**
+ * Sets the value of a uniform which takes a bool.
+ *
+ * @param uniform Handle from prgl_uniform_handle(), its shader must be in use.
+ * @param value
+ */
+void prgl_set_uniform_bool(PRGLUniform uniform, bool value);
+
 /**
  * @brief Sets values for uniforms which are needed for default shaders.
  *
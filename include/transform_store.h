@@ -0,0 +1,99 @@
+#ifndef PRGL_TRANSFORM_STORE_H
+#define PRGL_TRANSFORM_STORE_H
+
+#include <stdbool.h>
+
+#include "cglm/types.h"
+
+/**
+ * @brief Transforms of many objects, kept as one array per component.
+ *
+ * An alternative to storing transforms in game objects for large numbers of
+ * objects sharing a mesh. Matrices are built for several objects at once with
+ * prgl_build_transform_matrices(), or straight into the instance data with
+ * prgl_draw_transforms_3d_instanced(). The arrays can be written directly,
+ * entries from 0 to count are in use.
+ */
+struct PRGLTransformStore
+{
+    float *position_x;
+    float *position_y;
+    float *position_z;
+
+    /// Quaternion rotation components.
+    float *orientation_x;
+    float *orientation_y;
+    float *orientation_z;
+    float *orientation_w;
+
+    float *scale_x;
+    float *scale_y;
+    float *scale_z;
+
+    int count;
+    int capacity;
+};
+
+/**
+ * @brief Initializes an empty transform store.
+ *
+ * @param store[out]
+ * @param capacity The number of transforms to allocate room for, the store
+ * grows past it when needed.
+ * @return False if memory couldn't be allocated.
+ */
+bool prgl_init_transform_store(
+    struct PRGLTransformStore *const store, int capacity
+);
+
+/**
+ * @brief Frees the arrays of a transform store and empties it.
+ *
+ * @param store[in,out]
+ */
+void prgl_delete_transform_store(struct PRGLTransformStore *const store);
+
+/**
+ * @brief Adds a transform to the end of a transform store.
+ *
+ * @param store[in,out]
+ * @param position
+ * @param orientation Quaternion rotation.
+ * @param scale
+ * @return The index of the transform, or -1 if memory couldn't be allocated.
+ */
+int prgl_add_transform(
+    struct PRGLTransformStore *const store, vec3 position, versor orientation,
+    vec3 scale
+);
+
+/**
+ * @brief Replaces a transform in a transform store.
+ *
+ * @param store[in,out]
+ * @param index
+ * @param position
+ * @param orientation Quaternion rotation.
+ * @param scale
+ */
+void prgl_set_transform(
+    struct PRGLTransformStore *const store, int index, vec3 position,
+    versor orientation, vec3 scale
+);
+
+/**
+ * @brief Builds the model and normal matrices of every transform in a store.
+ *
+ * Matrices are built four at a time with SSE2 where it's available.
+ *
+ * @param store[in]
+ * @param models[out] A model matrix for each transform.
+ * @param normal_matrices[out] A normal matrix for each transform, or NULL to
+ * only build model matrices.
+ */
+void prgl_build_transform_matrices(
+    const struct PRGLTransformStore *const store, mat4 models[],
+    mat3 normal_matrices[]
+);
+
+#endif
@@ -22,6 +22,22 @@ typedef struct PRGLShader
     unsigned int id;
 } PRGLShader;
 
+/**
+ * @brief A resolved handle to a uniform on a specific shader program.
+ *
+ * Get one with prgl_uniform_handle() and keep it around, setting a uniform
+ * through a handle skips the name lookup entirely. A location of -1 means the
+ * uniform is not active in the program and setting it does nothing.
+ */
+typedef struct PRGLUniform
+{
+    unsigned int shader_id;
+    int location;
+
+    /// Index of the uniform in the shader's cache, -1 if it isn't cached.
+    int slot;
+} PRGLUniform;
+
 /**
  * @brief Stores an ID for a texture.
  */
@@ -0,0 +1,521 @@
+#include "glad.h"
+
+#include "baked_lighting_internal.h"
+#include "lighting.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cglm/mat3.h"
+#include "cglm/mat4.h"
+#include "cglm/vec3.h"
+#include "game_object.h"
+#include "geometry_arena_internal.h"
+#include "lighting_internal.h"
+#include "mesh_internal.h"
+#include "parallel_internal.h"
+#include "transform_internal.h"
+
+// Vertices are split into jobs of at least this many, so small meshes are
+// baked on the calling thread
+static const GLsizei MIN_BAKE_VERTICES_PER_JOB = 2048;
+
+// Incremental re-bakes add float error each time, so after this many a mesh
+// is baked again from scratch
+static const int MAX_BAKE_INCREMENTS = 32;
+
+/**
+ * A static light as the bake evaluates it. The weight is 1 to add the light
+ * and -1 to take it away again.
+ */
+struct PRGLBakeLight
+{
+    vec3 position;
+    vec3 color;
+    float ambient;
+    float linear;
+    float quadratic;
+    float reach;
+    float weight;
+};
+
+/**
+ * The baked lighting of a mesh and the transform it was baked for.
+ */
+struct PRGLBakedLighting
+{
+    struct PRGLMesh *mesh;
+
+    /// The game object the mesh was baked for.
+    const struct PRGLGameObject *game_obj;
+    mat4 model;
+    mat3 normal_matrix;
+
+    /// World space bounding sphere, to skip lights that don't reach the mesh.
+    vec4 world_sphere;
+
+    /// Summed light of each vertex, an RGB float each.
+    GLfloat *colors;
+
+    /// Incremental re-bakes since the colors were last baked from scratch.
+    int num_increments;
+
+    /// Position in prgl_baked_meshes.
+    int slot;
+};
+
+/**
+ * A range of a mesh's vertices for one job to add lights into.
+ */
+struct PRGLBakeJob
+{
+    const struct PRGLBakedLighting *baked;
+    const struct PRGLBakeLight *lights;
+    int num_lights;
+    GLsizei first_vertex;
+    GLsizei end_vertex;
+};
+
+static struct PRGLBakedLighting **prgl_baked_meshes = NULL;
+static int prgl_num_baked_meshes = 0;
+static int prgl_baked_meshes_capacity = 0;
+
+static struct PRGLBakeLight *prgl_static_lights = NULL;
+static int prgl_num_static_lights = 0;
+static int prgl_static_lights_capacity = 0;
+
+// Lights being baked, the changed lights and the ones reaching a mesh
+static struct PRGLBakeLight *prgl_bake_changes = NULL;
+static struct PRGLBakeLight *prgl_bake_reaching = NULL;
+static int prgl_bake_lights_capacity = 0;
+
+static bool prgl_reserve_bake_lights(int num_lights);
+static void prgl_convert_bake_light(
+    const struct PRGLPointLight *const light,
+    struct PRGLBakeLight *const bake_light
+);
+static int prgl_lights_reaching(
+    const struct PRGLBakedLighting *const baked,
+    const struct PRGLBakeLight lights[], int num_lights
+);
+static void prgl_bake_static_lights(struct PRGLBakedLighting *const baked);
+static void prgl_bake_lights(
+    struct PRGLBakedLighting *const baked, const struct PRGLBakeLight lights[],
+    int num_lights
+);
+static void prgl_run_bake_job(void *job);
+
+void prgl_update_static_lighting(
+    struct PRGLPointLight *const point_lights, int num_lights
+)
+{
+    num_lights = num_lights < 0 ? 0 : num_lights;
+    const int max_lights = num_lights > prgl_num_static_lights
+                             ? num_lights
+                             : prgl_num_static_lights;
+    if (!prgl_reserve_bake_lights(max_lights * 2))
+    {
+        return;
+    }
+    if (num_lights > prgl_static_lights_capacity)
+    {
+        struct PRGLBakeLight *lights = realloc(
+            prgl_static_lights, sizeof(struct PRGLBakeLight) * num_lights
+        );
+        if (lights == NULL)
+        {
+            fprintf(
+                stderr, "prgl_update_static_lighting: Error allocating "
+                        "static light memory!\n"
+            );
+            return;
+        }
+        prgl_static_lights = lights;
+        prgl_static_lights_capacity = num_lights;
+    }
+
+    // A changed light takes away what it added before and adds its new light
+    int num_changes = 0;
+    for (int i = 0; i < max_lights; i++)
+    {
+        struct PRGLBakeLight light = {0};
+        if (i < num_lights)
+        {
+            prgl_convert_bake_light(&point_lights[i], &light);
+        }
+        if (i < num_lights && i < prgl_num_static_lights
+            && memcmp(&light, &prgl_static_lights[i], sizeof(light)) == 0)
+        {
+            continue;
+        }
+
+        if (i < prgl_num_static_lights)
+        {
+            prgl_bake_changes[num_changes] = prgl_static_lights[i];
+            prgl_bake_changes[num_changes++].weight = -1.0f;
+        }
+        if (i < num_lights)
+        {
+            prgl_static_lights[i] = light;
+            prgl_bake_changes[num_changes++] = light;
+        }
+    }
+    prgl_num_static_lights = num_lights;
+
+    for (int m = 0; m < prgl_num_baked_meshes && num_changes > 0; m++)
+    {
+        struct PRGLBakedLighting *const baked = prgl_baked_meshes[m];
+        const int num_reaching =
+            prgl_lights_reaching(baked, prgl_bake_changes, num_changes);
+        if (num_reaching == 0)
+        {
+            continue;
+        }
+
+        if (++baked->num_increments >= MAX_BAKE_INCREMENTS)
+        {
+            prgl_bake_static_lights(baked);
+        }
+        else
+        {
+            prgl_bake_lights(baked, prgl_bake_reaching, num_reaching);
+        }
+        prgl_upload_geometry_light(&baked->mesh->geometry, baked->colors);
+    }
+}
+
+void prgl_bake_game_object_lighting(struct PRGLGameObject *const game_obj)
+{
+    struct PRGLMesh *const mesh = (struct PRGLMesh *)game_obj->mesh;
+    if (mesh->light_geometry == NULL || mesh->geometry.page == NULL)
+    {
+        fprintf(
+            stderr, "prgl_bake_game_object_lighting: The mesh has no "
+                    "normals to bake lighting into.\n"
+        );
+        return;
+    }
+    if (!prgl_reserve_bake_lights(prgl_num_static_lights))
+    {
+        return;
+    }
+
+    // The baked colors are stored on the mesh, so other game objects drawn
+    // with it would get this transform's lighting
+    prgl_update_game_object_transform(game_obj);
+    struct PRGLBakedLighting *baked = mesh->baked_lighting;
+    if (baked != NULL && baked->game_obj != game_obj
+        && memcmp(baked->model, game_obj->model, sizeof(mat4)) != 0)
+    {
+        fprintf(
+            stderr, "prgl_bake_game_object_lighting: The mesh is already "
+                    "baked for another game object's transform, give each "
+                    "baked game object its own mesh.\n"
+        );
+        return;
+    }
+    if (baked == NULL)
+    {
+        if (prgl_num_baked_meshes == prgl_baked_meshes_capacity)
+        {
+            const int capacity = prgl_baked_meshes_capacity == 0
+                                   ? 16
+                                   : prgl_baked_meshes_capacity * 2;
+            struct PRGLBakedLighting **meshes = realloc(
+                prgl_baked_meshes,
+                sizeof(struct PRGLBakedLighting *) * capacity
+            );
+            if (meshes == NULL)
+            {
+                fprintf(
+                    stderr, "prgl_bake_game_object_lighting: Error "
+                            "allocating baked mesh memory!\n"
+                );
+                return;
+            }
+            prgl_baked_meshes = meshes;
+            prgl_baked_meshes_capacity = capacity;
+        }
+
+        baked = malloc(sizeof(struct PRGLBakedLighting));
+        GLfloat *colors =
+            malloc(sizeof(GLfloat) * 3 * (size_t)mesh->geometry.num_vertices);
+        if (baked == NULL || colors == NULL)
+        {
+            fprintf(
+                stderr, "prgl_bake_game_object_lighting: Error allocating "
+                        "baked lighting memory!\n"
+            );
+            free(baked);
+            free(colors);
+            return;
+        }
+
+        baked->mesh = mesh;
+        baked->colors = colors;
+        baked->slot = prgl_num_baked_meshes;
+        prgl_baked_meshes[prgl_num_baked_meshes++] = baked;
+        mesh->baked_lighting = baked;
+    }
+
+    baked->game_obj = game_obj;
+    glm_mat4_copy(game_obj->model, baked->model);
+    glm_mat3_copy(game_obj->normal_matrix, baked->normal_matrix);
+
+    // Same world space sphere as culling, radius scaled by the largest axis
+    glm_mat4_mulv3(
+        baked->model, mesh->bounding_sphere, 1.0f, baked->world_sphere
+    );
+    const float max_scale = fmaxf(
+        glm_vec3_norm2(baked->model[0]),
+        fmaxf(glm_vec3_norm2(baked->model[1]), glm_vec3_norm2(baked->model[2]))
+    );
+    baked->world_sphere[3] = mesh->bounding_sphere[3] * sqrtf(max_scale);
+
+    prgl_bake_static_lights(baked);
+    prgl_upload_geometry_light(&mesh->geometry, baked->colors);
+}
+
+void prgl_clear_baked_lighting(PRGLMeshHandle mesh)
+{
+    struct PRGLBakedLighting *const baked =
+        ((struct PRGLMesh *)mesh)->baked_lighting;
+    if (baked == NULL)
+    {
+        return;
+    }
+
+    // Swap the last baked mesh into the cleared slot
+    struct PRGLBakedLighting *const last =
+        prgl_baked_meshes[--prgl_num_baked_meshes];
+    prgl_baked_meshes[baked->slot] = last;
+    last->slot = baked->slot;
+
+    baked->mesh->baked_lighting = NULL;
+    free(baked->colors);
+    free(baked);
+}
+
+void prgl_delete_baked_lighting(void)
+{
+    while (prgl_num_baked_meshes > 0)
+    {
+        prgl_clear_baked_lighting(
+            prgl_baked_meshes[prgl_num_baked_meshes - 1]->mesh
+        );
+    }
+    free(prgl_baked_meshes);
+    prgl_baked_meshes = NULL;
+    prgl_baked_meshes_capacity = 0;
+
+    free(prgl_static_lights);
+    prgl_static_lights = NULL;
+    prgl_num_static_lights = 0;
+    prgl_static_lights_capacity = 0;
+
+    free(prgl_bake_changes);
+    free(prgl_bake_reaching);
+    prgl_bake_changes = NULL;
+    prgl_bake_reaching = NULL;
+    prgl_bake_lights_capacity = 0;
+}
+
+/**
+ * Makes sure the lists of lights being baked can hold the given number.
+ *
+ * @param num_lights
+ * @return False if memory couldn't be allocated.
+ */
+static bool prgl_reserve_bake_lights(int num_lights)
+{
+    if (num_lights <= prgl_bake_lights_capacity)
+    {
+        return true;
+    }
+
+    struct PRGLBakeLight *changes = realloc(
+        prgl_bake_changes, sizeof(struct PRGLBakeLight) * num_lights
+    );
+    if (changes != NULL)
+    {
+        prgl_bake_changes = changes;
+    }
+    struct PRGLBakeLight *reaching = realloc(
+        prgl_bake_reaching, sizeof(struct PRGLBakeLight) * num_lights
+    );
+    if (reaching != NULL)
+    {
+        prgl_bake_reaching = reaching;
+    }
+    if (changes == NULL || reaching == NULL)
+    {
+        fprintf(
+            stderr, "prgl_reserve_bake_lights: Error allocating bake light "
+                    "memory!\n"
+        );
+        return false;
+    }
+
+    prgl_bake_lights_capacity = num_lights;
+    return true;
+}
+
+/**
+ * Looks up a light's attenuation constants and reach for baking. Unused bytes
+ * are zeroed so converted lights can be compared with memcmp().
+ *
+ * @param light[in]
+ * @param bake_light[out] Has a weight of 1.
+ */
+static void prgl_convert_bake_light(
+    const struct PRGLPointLight *const light,
+    struct PRGLBakeLight *const bake_light
+)
+{
+    memset(bake_light, 0, sizeof(struct PRGLBakeLight));
+    glm_vec3_copy((float *)light->position, bake_light->position);
+    glm_vec3_copy((float *)light->lightColor, bake_light->color);
+    bake_light->ambient = prgl_point_light_ambient(light);
+    bake_light->linear =
+        prgl_light_attenuation_linear_constant(light->intensity);
+    bake_light->quadratic =
+        prgl_light_attenuation_quadratic_constant(light->intensity);
+    bake_light->reach = prgl_point_light_reach(light);
+    bake_light->weight = 1.0f;
+}
+
+/**
+ * Copies the lights which reach a baked mesh's bounding sphere into
+ * prgl_bake_reaching, which must be able to hold all of them.
+ *
+ * @param baked[in]
+ * @param lights[in]
+ * @param num_lights
+ * @return The number of lights copied.
+ */
+static int prgl_lights_reaching(
+    const struct PRGLBakedLighting *const baked,
+    const struct PRGLBakeLight lights[], int num_lights
+)
+{
+    int num_reaching = 0;
+    for (int i = 0; i < num_lights; i++)
+    {
+        const float distance =
+            glm_vec3_distance((float *)lights[i].position,
+                              (float *)baked->world_sphere)
+            - baked->world_sphere[3];
+        if (distance < lights[i].reach)
+        {
+            prgl_bake_reaching[num_reaching++] = lights[i];
+        }
+    }
+    return num_reaching;
+}
+
+/**
+ * Bakes a mesh's colors from scratch with every static light reaching it.
+ * prgl_bake_reaching must be able to hold all of the static lights.
+ *
+ * @param baked[in,out]
+ */
+static void prgl_bake_static_lights(struct PRGLBakedLighting *const baked)
+{
+    memset(
+        baked->colors, 0,
+        sizeof(GLfloat) * 3 * (size_t)baked->mesh->geometry.num_vertices
+    );
+    prgl_bake_lights(
+        baked, prgl_bake_reaching,
+        prgl_lights_reaching(
+            baked, prgl_static_lights, prgl_num_static_lights
+        )
+    );
+    baked->num_increments = 0;
+}
+
+/**
+ * Adds lights to the baked colors of a mesh's vertices, splitting the vertices
+ * into parallel jobs when there are enough of them.
+ *
+ * @param baked[in,out]
+ * @param lights[in]
+ * @param num_lights
+ */
+static void prgl_bake_lights(
+    struct PRGLBakedLighting *const baked, const struct PRGLBakeLight lights[],
+    int num_lights
+)
+{
+    if (num_lights == 0)
+    {
+        return;
+    }
+
+    const GLsizei num_vertices = baked->mesh->geometry.num_vertices;
+    const int num_jobs =
+        prgl_parallel_job_count(num_vertices, MIN_BAKE_VERTICES_PER_JOB);
+
+    struct PRGLBakeJob jobs[PRGL_MAX_PARALLEL_JOBS];
+    for (int t = 0; t < num_jobs; t++)
+    {
+        jobs[t] = (struct PRGLBakeJob){
+            .baked = baked,
+            .lights = lights,
+            .num_lights = num_lights,
+            .first_vertex = (GLsizei)((long)num_vertices * t / num_jobs),
+            .end_vertex = (GLsizei)((long)num_vertices * (t + 1) / num_jobs),
+        };
+    }
+
+    prgl_run_parallel(jobs, sizeof(jobs[0]), num_jobs, prgl_run_bake_job);
+}
+
+/**
+ * Evaluates a job's lights at its vertices the same way the 3D shaders'
+ * calculatePointLight() does, and adds them to the baked colors.
+ *
+ * @param job[in] A struct PRGLBakeJob.
+ */
+static void prgl_run_bake_job(void *job)
+{
+    const struct PRGLBakeJob *const bake_job = job;
+    const struct PRGLBakedLighting *const baked = bake_job->baked;
+    const GLfloat *const geometry = baked->mesh->light_geometry;
+
+    for (GLsizei v = bake_job->first_vertex; v < bake_job->end_vertex; v++)
+    {
+        vec3 position;
+        vec3 normal;
+        glm_mat4_mulv3(
+            (vec4 *)baked->model, (float *)&geometry[v * 6], 1.0f, position
+        );
+        glm_mat3_mulv(
+            (vec3 *)baked->normal_matrix, (float *)&geometry[v * 6 + 3], normal
+        );
+        glm_vec3_normalize(normal);
+
+        GLfloat *const color = &baked->colors[v * 3];
+        for (int i = 0; i < bake_job->num_lights; i++)
+        {
+            const struct PRGLBakeLight *const light = &bake_job->lights[i];
+            vec3 to_light;
+            glm_vec3_sub((float *)light->position, position, to_light);
+            const float distance = glm_vec3_norm(to_light);
+            const float diffuse =
+                distance > 0.0f
+                    ? fmaxf(glm_vec3_dot(normal, to_light) / distance, 0.0f)
+                    : 0.0f;
+            const float attenuation =
+                1.0f / (1.0f + light->linear * distance
+                        + light->quadratic * distance * distance);
+            glm_vec3_muladds(
+                (float *)light->color,
+                (light->ambient + diffuse) * attenuation * light->weight, color
+            );
+        }
+    }
+}
@@ -0,0 +1,10 @@
+#ifndef PRGL_BAKED_LIGHTING_INTERNAL_H
+#define PRGL_BAKED_LIGHTING_INTERNAL_H
+
+/**
+ * Clears the baked lighting of every mesh and frees the static lights. Should
+ * be called once before the geometry arena is deleted.
+ */
+void prgl_delete_baked_lighting(void);
+
+#endif
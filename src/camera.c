@@ -1,11 +1,14 @@
 #include "glad.h"
 #include "camera.h"
+#include "frame_uniforms_internal.h"
 #include "mathx.h"
 #include "screen_internal.h"
 #include "shaders.h"
+#include "shaders_internal.h"
 #include "render.h"
 #include "cglm/types.h"
 #include "cglm/cam.h"
+#include "cglm/mat4.h"
 #include "cglm/vec3.h"
 #include <stddef.h>
 #include <stdio.h>
@@ -13,6 +16,8 @@
 static vec3 PRGL_WORLD_UP = {0.0f, 1.0f, 0.0f};
 static struct PRGLCamera *prgl_active_camera_ref = NULL;
 
+static void prgl_calculate_orthogonal_projection(struct PRGLCamera *const cam);
+
 void prgl_init_camera(
     struct PRGLCamera *const cam, float fov_degrees, float move_speed,
     enum PRGLCameraProjectionType projection_type
@@ -39,6 +44,10 @@ void prgl_init_camera(
     cam->look_sensitivity = 0.1f;
     cam->projection_type = projection_type;
 
+    // Both projections are kept up to date since the frame uniforms use the
+    // perspective one for 3D and the orthogonal one for 2D
+    glm_mat4_identity(cam->projection_perspective);
+    prgl_calculate_orthogonal_projection(cam);
     prgl_set_camera_projection(cam, fov_degrees, projection_type);
 }
 
@@ -68,7 +77,16 @@ void prgl_update_camera(struct PRGLCamera *const cam)
     glm_lookat(cam->position, direction, cam->up, cam->view);
 
     // The view matrix is the camera position, which we calculated above
-    prgl_set_shader_uniform_mat4(prgl_current_shader(), "view", cam->view);
+    prgl_set_uniform_mat4(
+        prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_VIEW), cam->view
+    );
+
+    // Built in shaders read the camera from the PRGLFrame block, refreshed
+    // here so a camera moved while drawing applies to the draws after it
+    if (cam == prgl_active_camera_ref)
+    {
+        prgl_update_frame_camera();
+    }
 }
 
 void prgl_move_camera_fly(
@@ -136,24 +154,41 @@ void prgl_set_camera_projection(
         glm_perspective(
             fov, aspect_ratio, 0.1f, 100.0f, cam->projection_perspective
         );
-        prgl_set_shader_uniform_mat4(
-            prgl_current_shader(), "projection", cam->projection_perspective
+        prgl_set_uniform_mat4(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_PROJECTION),
+            cam->projection_perspective
         );
     }
     else if (projection_type == PRGL_CAMERA_PROJECTION_ORTHOGONAL)
     {
         cam->projection_type = PRGL_CAMERA_PROJECTION_ORTHOGONAL;
 
-        // Orthogonal is 2D so uses width/height, the clipping plane is the
-        // OpenGL coordinate plane which goes from -1.0 to 1.0
-        glm_ortho(
-            0.0f, PRGL_RENDER_RESOLUTION[0], PRGL_RENDER_RESOLUTION[1], 0.0f,
-            -1.0f, 1.0f, cam->projection_orthogonal
-        );
-        prgl_set_shader_uniform_mat4(
-            prgl_current_shader(), "projection", cam->projection_orthogonal
+        prgl_calculate_orthogonal_projection(cam);
+        prgl_set_uniform_mat4(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_PROJECTION),
+            cam->projection_orthogonal
         );
     }
+
+    if (cam == prgl_active_camera_ref)
+    {
+        prgl_update_frame_camera();
+    }
 }
 
 struct PRGLCamera *prgl_active_camera(void) { return prgl_active_camera_ref; }
+
+/**
+ * Calculates the camera's orthogonal projection for the render resolution.
+ *
+ * @param cam[in,out]
+ */
+static void prgl_calculate_orthogonal_projection(struct PRGLCamera *const cam)
+{
+    // Orthogonal is 2D so uses width/height, the clipping plane is the
+    // OpenGL coordinate plane which goes from -1.0 to 1.0
+    glm_ortho(
+        0.0f, PRGL_RENDER_RESOLUTION[0], PRGL_RENDER_RESOLUTION[1], 0.0f, -1.0f,
+        1.0f, cam->projection_orthogonal
+    );
+}
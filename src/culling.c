@@ -0,0 +1,350 @@
+#include "culling_internal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __SSE2__
+#include <xmmintrin.h>
+#endif
+
+#include "camera.h"
+#include "cglm/box.h"
+#include "cglm/frustum.h"
+#include "cglm/mat4.h"
+#include "cglm/vec3.h"
+#include "cglm/vec4.h"
+#include "mesh_internal.h"
+#include "render.h"
+
+static bool prgl_culling_enabled = true;
+
+// Whether there is a camera this frame to take the planes from
+static bool prgl_culling_active = false;
+static vec4 prgl_frustum_planes[6];
+
+// Culling batch, world space spheres plus what's needed to refine with boxes
+static vec4 *prgl_cull_spheres = NULL;
+static struct PRGLMesh **prgl_cull_meshes = NULL;
+static vec4 **prgl_cull_models = NULL;
+static bool *prgl_cull_visible = NULL;
+static int prgl_cull_capacity = 0;
+
+static void prgl_world_bounding_sphere(
+    vec4 local_sphere, mat4 model, vec4 dest
+);
+static int prgl_test_sphere(vec4 sphere);
+static bool prgl_box_in_frustum(struct PRGLMesh *const mesh, mat4 model);
+
+// Results of testing a sphere, intersecting spheres need a box test to be sure
+enum PRGLSphereTest
+{
+    PRGL_SPHERE_OUTSIDE,
+    PRGL_SPHERE_INTERSECTS,
+    PRGL_SPHERE_INSIDE
+};
+
+void prgl_set_frustum_culling_enabled(bool enabled)
+{
+    prgl_culling_enabled = enabled;
+}
+
+void prgl_update_culling(void)
+{
+    struct PRGLCamera *const cam = prgl_active_camera();
+    prgl_culling_active = prgl_culling_enabled && cam != NULL;
+    if (!prgl_culling_active)
+    {
+        return;
+    }
+
+    mat4 view_projection;
+    glm_mat4_mul(cam->projection_perspective, cam->view, view_projection);
+    glm_frustum_planes(view_projection, prgl_frustum_planes);
+}
+
+void prgl_delete_culling(void)
+{
+    free(prgl_cull_spheres);
+    free(prgl_cull_meshes);
+    free(prgl_cull_models);
+    free(prgl_cull_visible);
+    prgl_cull_spheres = NULL;
+    prgl_cull_meshes = NULL;
+    prgl_cull_models = NULL;
+    prgl_cull_visible = NULL;
+    prgl_cull_capacity = 0;
+}
+
+bool prgl_mesh_in_frustum(struct PRGLMesh *const mesh, mat4 model)
+{
+    if (!prgl_culling_active)
+    {
+        return true;
+    }
+
+    vec4 sphere;
+    prgl_world_bounding_sphere(mesh->bounding_sphere, model, sphere);
+    switch (prgl_test_sphere(sphere))
+    {
+        case PRGL_SPHERE_OUTSIDE:
+            return false;
+        case PRGL_SPHERE_INSIDE:
+            return true;
+        default:
+            return prgl_box_in_frustum(mesh, model);
+    }
+}
+
+bool prgl_reserve_cull_batch(int count)
+{
+    if (count <= prgl_cull_capacity)
+    {
+        return true;
+    }
+
+    const int capacity = count;
+    vec4 *spheres = realloc(prgl_cull_spheres, sizeof(vec4) * capacity);
+    if (spheres != NULL)
+    {
+        prgl_cull_spheres = spheres;
+    }
+    struct PRGLMesh **meshes =
+        realloc(prgl_cull_meshes, sizeof(struct PRGLMesh *) * capacity);
+    if (meshes != NULL)
+    {
+        prgl_cull_meshes = meshes;
+    }
+    vec4 **models = realloc(prgl_cull_models, sizeof(vec4 *) * capacity);
+    if (models != NULL)
+    {
+        prgl_cull_models = models;
+    }
+    bool *visible = realloc(prgl_cull_visible, sizeof(bool) * capacity);
+    if (visible != NULL)
+    {
+        prgl_cull_visible = visible;
+    }
+
+    if (spheres == NULL || meshes == NULL || models == NULL || visible == NULL)
+    {
+        fprintf(
+            stderr, "prgl_reserve_cull_batch: Error allocating culling "
+                    "memory!\n"
+        );
+        return false;
+    }
+
+    prgl_cull_capacity = capacity;
+    return true;
+}
+
+void prgl_set_cull_object(int index, struct PRGLMesh *const mesh, mat4 model)
+{
+    prgl_cull_meshes[index] = mesh;
+    prgl_cull_models[index] = model;
+    if (mesh == NULL)
+    {
+        // An infinite radius is never outside a plane
+        glm_vec4_copy(
+            (vec4){0.0f, 0.0f, 0.0f, INFINITY}, prgl_cull_spheres[index]
+        );
+        return;
+    }
+
+    prgl_world_bounding_sphere(
+        mesh->bounding_sphere, model, prgl_cull_spheres[index]
+    );
+}
+
+int prgl_cull_batch(int count)
+{
+    if (!prgl_culling_active)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            prgl_cull_visible[i] = true;
+        }
+        return count;
+    }
+
+    int i = 0;
+#ifdef __SSE2__
+    // Spheres are transposed so each lane holds one object, all six planes
+    // are tested against four objects at once
+    __m128 plane_x[6];
+    __m128 plane_y[6];
+    __m128 plane_z[6];
+    __m128 plane_d[6];
+    for (int p = 0; p < 6; p++)
+    {
+        plane_x[p] = _mm_set1_ps(prgl_frustum_planes[p][0]);
+        plane_y[p] = _mm_set1_ps(prgl_frustum_planes[p][1]);
+        plane_z[p] = _mm_set1_ps(prgl_frustum_planes[p][2]);
+        plane_d[p] = _mm_set1_ps(prgl_frustum_planes[p][3]);
+    }
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(prgl_cull_spheres[i]);
+        __m128 y = _mm_loadu_ps(prgl_cull_spheres[i + 1]);
+        __m128 z = _mm_loadu_ps(prgl_cull_spheres[i + 2]);
+        __m128 r = _mm_loadu_ps(prgl_cull_spheres[i + 3]);
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+        const __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), r);
+
+        __m128 outside = _mm_setzero_ps();
+        __m128 intersects = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++)
+        {
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(
+                    _mm_mul_ps(plane_x[p], x), _mm_mul_ps(plane_y[p], y)
+                ),
+                _mm_add_ps(_mm_mul_ps(plane_z[p], z), plane_d[p])
+            );
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, neg_r));
+            intersects = _mm_or_ps(intersects, _mm_cmplt_ps(distance, r));
+        }
+
+        const int outside_mask = _mm_movemask_ps(outside);
+        const int intersects_mask = _mm_movemask_ps(intersects);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            prgl_cull_visible[i + lane] = !(outside_mask & (1 << lane));
+            if (prgl_cull_visible[i + lane] && (intersects_mask & (1 << lane))
+                && prgl_cull_meshes[i + lane] != NULL)
+            {
+                prgl_cull_visible[i + lane] = prgl_box_in_frustum(
+                    prgl_cull_meshes[i + lane], prgl_cull_models[i + lane]
+                );
+            }
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        switch (prgl_test_sphere(prgl_cull_spheres[i]))
+        {
+            case PRGL_SPHERE_OUTSIDE:
+                prgl_cull_visible[i] = false;
+                break;
+            case PRGL_SPHERE_INSIDE:
+                prgl_cull_visible[i] = true;
+                break;
+            default:
+                prgl_cull_visible[i] =
+                    prgl_cull_meshes[i] == NULL
+                    || prgl_box_in_frustum(
+                        prgl_cull_meshes[i], prgl_cull_models[i]
+                    );
+        }
+    }
+
+    int num_visible = 0;
+    for (i = 0; i < count; i++)
+    {
+        num_visible += prgl_cull_visible[i];
+    }
+    return num_visible;
+}
+
+bool prgl_cull_object_visible(int index) { return prgl_cull_visible[index]; }
+
+bool prgl_culling_frustum_planes(vec4 dest[6])
+{
+    if (!prgl_culling_active)
+    {
+        return false;
+    }
+
+    for (int p = 0; p < 6; p++)
+    {
+        glm_vec4_copy(prgl_frustum_planes[p], dest[p]);
+    }
+    return true;
+}
+
+float prgl_sphere_frustum_margin(vec4 local_sphere, mat4 model)
+{
+    vec4 sphere;
+    prgl_world_bounding_sphere(local_sphere, model, sphere);
+
+    float margin = INFINITY;
+    for (int p = 0; p < 6; p++)
+    {
+        const float distance =
+            glm_vec3_dot(prgl_frustum_planes[p], sphere)
+            + prgl_frustum_planes[p][3] + sphere[3];
+        margin = distance < margin ? distance : margin;
+    }
+    return margin;
+}
+
+/**
+ * Moves a mesh's bounding sphere into world space. The radius is scaled by the
+ * largest axis scale so the sphere still contains the mesh under non-uniform
+ * scaling.
+ *
+ * @param local_sphere The local space center in xyz and the radius in w.
+ * @param model
+ * @param dest[out] The world space center in xyz and the radius in w.
+ */
+static void prgl_world_bounding_sphere(
+    vec4 local_sphere, mat4 model, vec4 dest
+)
+{
+    vec4 center = {local_sphere[0], local_sphere[1], local_sphere[2], 1.0f};
+    glm_mat4_mulv(model, center, dest);
+
+    const float scale_x = glm_vec3_norm2(model[0]);
+    const float scale_y = glm_vec3_norm2(model[1]);
+    const float scale_z = glm_vec3_norm2(model[2]);
+    float max_scale = scale_x > scale_y ? scale_x : scale_y;
+    max_scale = max_scale > scale_z ? max_scale : scale_z;
+    dest[3] = local_sphere[3] * sqrtf(max_scale);
+}
+
+/**
+ * Tests a world space sphere against the frustum planes.
+ *
+ * @param sphere The center in xyz and the radius in w.
+ * @return A PRGLSphereTest value.
+ */
+static int prgl_test_sphere(vec4 sphere)
+{
+    int result = PRGL_SPHERE_INSIDE;
+    for (int p = 0; p < 6; p++)
+    {
+        const float distance =
+            glm_vec3_dot(prgl_frustum_planes[p], sphere)
+            + prgl_frustum_planes[p][3];
+        if (distance < -sphere[3])
+        {
+            return PRGL_SPHERE_OUTSIDE;
+        }
+        if (distance < sphere[3])
+        {
+            result = PRGL_SPHERE_INTERSECTS;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Tests a mesh's bounding box against the frustum planes. The box is moved to
+ * world space as a new axis aligned box, which is looser than the mesh's box
+ * when rotated but still much tighter than the sphere for long thin meshes.
+ *
+ * @param mesh[in]
+ * @param model
+ * @return False if the box is outside the frustum.
+ */
+static bool prgl_box_in_frustum(struct PRGLMesh *const mesh, mat4 model)
+{
+    vec3 world_box[2];
+    glm_aabb_transform(mesh->aabb, model, world_box);
+    return glm_aabb_frustum(world_box, prgl_frustum_planes);
+}
@@ -0,0 +1,86 @@
+#ifndef PRGL_CULLING_INTERNAL_H
+#define PRGL_CULLING_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "cglm/types.h"
+
+struct PRGLMesh;
+
+/**
+ * Extracts the frustum planes from the active camera's view projection. Should
+ * be called once per frame after the game has updated its camera and before
+ * drawing. Culling is skipped for the frame if there is no active camera.
+ */
+void prgl_update_culling(void);
+
+/**
+ * Frees the memory used for culling batches.
+ */
+void prgl_delete_culling(void);
+
+/**
+ * Tests a single mesh against the frustum, first with its bounding sphere and
+ * then with its bounding box if the sphere intersects a plane.
+ *
+ * @param mesh[in]
+ * @param model
+ * @return False if the mesh is outside the frustum, always true if culling is
+ * disabled.
+ */
+bool prgl_mesh_in_frustum(struct PRGLMesh *const mesh, mat4 model);
+
+/**
+ * Makes sure a culling batch can hold the given number of objects.
+ *
+ * @param count
+ * @return False if the memory couldn't be allocated.
+ */
+bool prgl_reserve_cull_batch(int count);
+
+/**
+ * Adds an object to the culling batch. The model matrix is read when the batch
+ * is culled, so it must stay valid until then.
+ *
+ * @param index Position in the batch, less than the reserved count.
+ * @param mesh[in] The mesh of the object, or NULL to never cull it.
+ * @param model
+ */
+void prgl_set_cull_object(int index, struct PRGLMesh *const mesh, mat4 model);
+
+/**
+ * Tests the objects in the culling batch against the frustum. Bounding spheres
+ * are tested four at a time, then bounding boxes are tested for the objects
+ * whose spheres intersect a plane.
+ *
+ * @param count Number of objects in the batch.
+ * @return The number of visible objects.
+ */
+int prgl_cull_batch(int count);
+
+/**
+ * @param index Position in the batch.
+ * @return True if the object passed the last prgl_cull_batch().
+ */
+bool prgl_cull_object_visible(int index);
+
+/**
+ * Gets this frame's frustum planes, normalized with the inside positive.
+ *
+ * @param dest[out] Left, right, bottom, top, near, then far.
+ * @return False if culling is inactive this frame, dest is left unchanged.
+ */
+bool prgl_culling_frustum_planes(vec4 dest[6]);
+
+/**
+ * Brute force sphere only frustum test, used as the reference for GPU culling.
+ * Only meaningful while prgl_culling_frustum_planes() returns true.
+ *
+ * @param local_sphere A mesh's local bounding sphere.
+ * @param model
+ * @return How far the world space sphere reaches inside the nearest plane, a
+ * negative value means the sphere is outside the frustum.
+ */
+float prgl_sphere_frustum_margin(vec4 local_sphere, mat4 model);
+
+#endif
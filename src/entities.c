@@ -0,0 +1,595 @@
+#include "entities.h"
+#include "entities_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cglm/quat.h"
+#include "cglm/vec3.h"
+#include "types.h"
+
+// Chunks are sized to hold about this many bytes of entities, and columns in
+// a chunk start on this alignment
+static const size_t CHUNK_TARGET_BYTES = 16 * 1024;
+static const size_t COLUMN_ALIGNMENT = 16;
+
+/**
+ * Storage for every entity with one particular set of components. Entities
+ * are packed into the rows of fixed size chunks, every chunk is full but the
+ * last one in use. A chunk holds the handles of its entities followed by a
+ * column for each component.
+ */
+struct PRGLArchetype
+{
+    uint32_t components;
+    size_t column_offsets[PRGL_MAX_COMPONENTS];
+    size_t chunk_bytes;
+    int chunk_capacity;
+
+    unsigned char **chunks;
+    int num_chunks;
+    int chunks_capacity;
+
+    /// Number of entities, the rows from 0 to count are in use.
+    int count;
+};
+
+/**
+ * Where an entity index's entity is stored, and the generation a handle needs
+ * to refer to it.
+ */
+struct PRGLEntityRecord
+{
+    uint32_t generation;
+
+    /// Index in prgl_archetypes, -1 while the index is free.
+    int archetype;
+    int row;
+};
+
+static size_t prgl_component_sizes[PRGL_MAX_COMPONENTS] = {
+    [PRGL_COMPONENT_TRANSFORM] = sizeof(struct PRGLTransform),
+    [PRGL_COMPONENT_MESH] = sizeof(PRGLMeshHandle),
+    [PRGL_COMPONENT_COLOR] = sizeof(vec3),
+};
+static int prgl_num_components = PRGL_NUM_BUILTIN_COMPONENTS;
+
+static struct PRGLArchetype *prgl_archetypes = NULL;
+static int prgl_num_archetypes = 0;
+static int prgl_archetypes_capacity = 0;
+
+static struct PRGLEntityRecord *prgl_entity_records = NULL;
+static int prgl_num_entity_records = 0;
+static int prgl_entity_records_capacity = 0;
+
+// Indices of destroyed entities, reused before new ones are added
+static uint32_t *prgl_free_entities = NULL;
+static int prgl_num_free_entities = 0;
+
+static int prgl_find_archetype(uint32_t components);
+static bool prgl_reserve_entity_records(int num_new);
+static bool prgl_reserve_archetype_rows(
+    struct PRGLArchetype *const archetype, int num_rows
+);
+static PRGLEntity *prgl_row_entity(
+    const struct PRGLArchetype *const archetype, int row
+);
+static void *prgl_row_component(
+    const struct PRGLArchetype *const archetype, int row, int component
+);
+static void prgl_init_row(
+    const struct PRGLArchetype *const archetype, int row, uint32_t components
+);
+static void prgl_remove_row(struct PRGLArchetype *const archetype, int row);
+static struct PRGLEntityRecord *prgl_entity_record(PRGLEntity entity);
+
+int prgl_register_component(size_t size)
+{
+    if (prgl_num_components == PRGL_MAX_COMPONENTS)
+    {
+        fprintf(
+            stderr, "prgl_register_component: The maximum of %d component "
+                    "types are registered.\n",
+            PRGL_MAX_COMPONENTS
+        );
+        return -1;
+    }
+
+    prgl_component_sizes[prgl_num_components] = size;
+    return prgl_num_components++;
+}
+
+bool prgl_create_entities(
+    uint32_t components, int count, PRGLEntity entities[]
+)
+{
+    const int archetype_index = prgl_find_archetype(components);
+    if (archetype_index < 0)
+    {
+        return false;
+    }
+    struct PRGLArchetype *const archetype = &prgl_archetypes[archetype_index];
+    if (!prgl_reserve_entity_records(count)
+        || !prgl_reserve_archetype_rows(archetype, archetype->count + count))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const uint32_t index =
+            prgl_num_free_entities > 0
+                ? prgl_free_entities[--prgl_num_free_entities]
+                : (uint32_t)prgl_num_entity_records++;
+        struct PRGLEntityRecord *const record = &prgl_entity_records[index];
+        record->archetype = archetype_index;
+        record->row = archetype->count++;
+
+        entities[i] = (PRGLEntity){
+            .index = index,
+            .generation = record->generation,
+        };
+        *prgl_row_entity(archetype, record->row) = entities[i];
+        prgl_init_row(archetype, record->row, components);
+    }
+    return true;
+}
+
+void prgl_destroy_entities(const PRGLEntity entities[], int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        struct PRGLEntityRecord *const record =
+            prgl_entity_record(entities[i]);
+        if (record == NULL)
+        {
+            continue;
+        }
+
+        prgl_remove_row(&prgl_archetypes[record->archetype], record->row);
+        record->generation++;
+        record->archetype = -1;
+        prgl_free_entities[prgl_num_free_entities++] = entities[i].index;
+    }
+}
+
+bool prgl_entity_alive(PRGLEntity entity)
+{
+    return prgl_entity_record(entity) != NULL;
+}
+
+void *prgl_entity_component(PRGLEntity entity, int component)
+{
+    const struct PRGLEntityRecord *const record = prgl_entity_record(entity);
+    if (record == NULL || component < 0 || component >= PRGL_MAX_COMPONENTS)
+    {
+        return NULL;
+    }
+
+    const struct PRGLArchetype *const archetype =
+        &prgl_archetypes[record->archetype];
+    if (!(archetype->components & PRGL_COMPONENT_BIT(component)))
+    {
+        return NULL;
+    }
+    return prgl_row_component(archetype, record->row, component);
+}
+
+bool prgl_set_entity_components(PRGLEntity entity, uint32_t components)
+{
+    struct PRGLEntityRecord *const record = prgl_entity_record(entity);
+    if (record == NULL)
+    {
+        return false;
+    }
+    if (prgl_archetypes[record->archetype].components == components)
+    {
+        return true;
+    }
+
+    // Finding the archetype can move the archetypes, so look both up after
+    const int new_index = prgl_find_archetype(components);
+    if (new_index < 0)
+    {
+        return false;
+    }
+    struct PRGLArchetype *const old_archetype =
+        &prgl_archetypes[record->archetype];
+    struct PRGLArchetype *const new_archetype = &prgl_archetypes[new_index];
+    if (!prgl_reserve_archetype_rows(new_archetype, new_archetype->count + 1))
+    {
+        return false;
+    }
+
+    const int new_row = new_archetype->count++;
+    *prgl_row_entity(new_archetype, new_row) = entity;
+    prgl_init_row(
+        new_archetype, new_row, components & ~old_archetype->components
+    );
+    const uint32_t kept = components & old_archetype->components;
+    for (int c = 0; c < prgl_num_components; c++)
+    {
+        if (kept & PRGL_COMPONENT_BIT(c))
+        {
+            memcpy(
+                prgl_row_component(new_archetype, new_row, c),
+                prgl_row_component(old_archetype, record->row, c),
+                prgl_component_sizes[c]
+            );
+        }
+    }
+
+    prgl_remove_row(old_archetype, record->row);
+    record->archetype = new_index;
+    record->row = new_row;
+    return true;
+}
+
+struct PRGLEntityQuery prgl_query_entities(uint32_t components)
+{
+    return (struct PRGLEntityQuery){
+        .components = components,
+        .archetype = 0,
+        .chunk = 0,
+    };
+}
+
+bool prgl_next_entity_batch(
+    struct PRGLEntityQuery *const query, struct PRGLEntityBatch *const batch
+)
+{
+    for (; query->archetype < prgl_num_archetypes;
+         query->archetype++, query->chunk = 0)
+    {
+        const struct PRGLArchetype *const archetype =
+            &prgl_archetypes[query->archetype];
+        const int first_row = query->chunk * archetype->chunk_capacity;
+        if ((archetype->components & query->components) != query->components
+            || first_row >= archetype->count)
+        {
+            continue;
+        }
+
+        unsigned char *const chunk = archetype->chunks[query->chunk++];
+        const int remaining = archetype->count - first_row;
+        batch->count = remaining < archetype->chunk_capacity
+                         ? remaining
+                         : archetype->chunk_capacity;
+        batch->entities = (const PRGLEntity *)chunk;
+        for (int c = 0; c < PRGL_MAX_COMPONENTS; c++)
+        {
+            batch->columns[c] =
+                archetype->components & PRGL_COMPONENT_BIT(c)
+                    ? chunk + archetype->column_offsets[c]
+                    : NULL;
+        }
+        return true;
+    }
+    return false;
+}
+
+void prgl_delete_entities(void)
+{
+    for (int a = 0; a < prgl_num_archetypes; a++)
+    {
+        for (int c = 0; c < prgl_archetypes[a].num_chunks; c++)
+        {
+            free(prgl_archetypes[a].chunks[c]);
+        }
+        free(prgl_archetypes[a].chunks);
+    }
+    free(prgl_archetypes);
+    prgl_archetypes = NULL;
+    prgl_num_archetypes = 0;
+    prgl_archetypes_capacity = 0;
+
+    free(prgl_entity_records);
+    free(prgl_free_entities);
+    prgl_entity_records = NULL;
+    prgl_free_entities = NULL;
+    prgl_num_entity_records = 0;
+    prgl_entity_records_capacity = 0;
+    prgl_num_free_entities = 0;
+
+    prgl_num_components = PRGL_NUM_BUILTIN_COMPONENTS;
+}
+
+/**
+ * Finds the archetype with a set of components, creating it if there isn't
+ * one yet. Creating one can move the existing archetypes.
+ *
+ * @param components
+ * @return The index of the archetype, or -1 if a component type isn't
+ * registered or memory couldn't be allocated.
+ */
+static int prgl_find_archetype(uint32_t components)
+{
+    for (int a = 0; a < prgl_num_archetypes; a++)
+    {
+        if (prgl_archetypes[a].components == components)
+        {
+            return a;
+        }
+    }
+
+    if (prgl_num_components < PRGL_MAX_COMPONENTS
+        && components >> prgl_num_components != 0)
+    {
+        fprintf(
+            stderr, "prgl_find_archetype: A component type is not "
+                    "registered.\n"
+        );
+        return -1;
+    }
+    if (prgl_num_archetypes == prgl_archetypes_capacity)
+    {
+        const int capacity =
+            prgl_archetypes_capacity == 0 ? 16 : prgl_archetypes_capacity * 2;
+        struct PRGLArchetype *archetypes = realloc(
+            prgl_archetypes, sizeof(struct PRGLArchetype) * capacity
+        );
+        if (archetypes == NULL)
+        {
+            fprintf(
+                stderr, "prgl_find_archetype: Error allocating archetype "
+                        "memory!\n"
+            );
+            return -1;
+        }
+        prgl_archetypes = archetypes;
+        prgl_archetypes_capacity = capacity;
+    }
+
+    struct PRGLArchetype *const archetype =
+        &prgl_archetypes[prgl_num_archetypes];
+    memset(archetype, 0, sizeof(struct PRGLArchetype));
+    archetype->components = components;
+
+    size_t row_bytes = sizeof(PRGLEntity);
+    for (int c = 0; c < prgl_num_components; c++)
+    {
+        if (components & PRGL_COMPONENT_BIT(c))
+        {
+            row_bytes += prgl_component_sizes[c];
+        }
+    }
+    archetype->chunk_capacity = (int)(CHUNK_TARGET_BYTES / row_bytes);
+    archetype->chunk_capacity =
+        archetype->chunk_capacity < 1 ? 1 : archetype->chunk_capacity;
+
+    // Handles first, then each column on its own aligned range
+    size_t offset = sizeof(PRGLEntity) * archetype->chunk_capacity;
+    for (int c = 0; c < prgl_num_components; c++)
+    {
+        if (components & PRGL_COMPONENT_BIT(c))
+        {
+            offset = (offset + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1);
+            archetype->column_offsets[c] = offset;
+            offset += prgl_component_sizes[c] * archetype->chunk_capacity;
+        }
+    }
+    archetype->chunk_bytes = offset;
+
+    return prgl_num_archetypes++;
+}
+
+/**
+ * Makes sure there are entity records and free list room for the given number
+ * of new entities.
+ *
+ * @param num_new
+ * @return False if memory couldn't be allocated.
+ */
+static bool prgl_reserve_entity_records(int num_new)
+{
+    const int needed =
+        prgl_num_entity_records + num_new - prgl_num_free_entities;
+    if (needed <= prgl_entity_records_capacity)
+    {
+        return true;
+    }
+
+    int capacity =
+        prgl_entity_records_capacity == 0 ? 256
+                                          : prgl_entity_records_capacity * 2;
+    capacity = capacity < needed ? needed : capacity;
+    struct PRGLEntityRecord *records = realloc(
+        prgl_entity_records, sizeof(struct PRGLEntityRecord) * capacity
+    );
+    if (records != NULL)
+    {
+        prgl_entity_records = records;
+    }
+    uint32_t *free_entities =
+        realloc(prgl_free_entities, sizeof(uint32_t) * capacity);
+    if (free_entities != NULL)
+    {
+        prgl_free_entities = free_entities;
+    }
+    if (records == NULL || free_entities == NULL)
+    {
+        fprintf(
+            stderr, "prgl_reserve_entity_records: Error allocating entity "
+                    "memory!\n"
+        );
+        return false;
+    }
+
+    for (int i = prgl_entity_records_capacity; i < capacity; i++)
+    {
+        prgl_entity_records[i] = (struct PRGLEntityRecord){
+            .generation = 0,
+            .archetype = -1,
+            .row = 0,
+        };
+    }
+    prgl_entity_records_capacity = capacity;
+    return true;
+}
+
+/**
+ * Makes sure an archetype has chunks for the given number of rows.
+ *
+ * @param archetype[in,out]
+ * @param num_rows
+ * @return False if memory couldn't be allocated.
+ */
+static bool prgl_reserve_archetype_rows(
+    struct PRGLArchetype *const archetype, int num_rows
+)
+{
+    const int num_chunks = (num_rows + archetype->chunk_capacity - 1)
+                         / archetype->chunk_capacity;
+    if (num_chunks > archetype->chunks_capacity)
+    {
+        int capacity = archetype->chunks_capacity == 0
+                         ? 4
+                         : archetype->chunks_capacity * 2;
+        capacity = capacity < num_chunks ? num_chunks : capacity;
+        unsigned char **chunks =
+            realloc(archetype->chunks, sizeof(unsigned char *) * capacity);
+        if (chunks == NULL)
+        {
+            fprintf(
+                stderr, "prgl_reserve_archetype_rows: Error allocating chunk "
+                        "memory!\n"
+            );
+            return false;
+        }
+        archetype->chunks = chunks;
+        archetype->chunks_capacity = capacity;
+    }
+
+    while (archetype->num_chunks < num_chunks)
+    {
+        unsigned char *const chunk = malloc(archetype->chunk_bytes);
+        if (chunk == NULL)
+        {
+            fprintf(
+                stderr, "prgl_reserve_archetype_rows: Error allocating chunk "
+                        "memory!\n"
+            );
+            return false;
+        }
+        archetype->chunks[archetype->num_chunks++] = chunk;
+    }
+    return true;
+}
+
+/**
+ * @param archetype[in]
+ * @param row
+ * @return The handle stored for the entity in a row.
+ */
+static PRGLEntity *prgl_row_entity(
+    const struct PRGLArchetype *const archetype, int row
+)
+{
+    unsigned char *const chunk =
+        archetype->chunks[row / archetype->chunk_capacity];
+    return &((PRGLEntity *)chunk)[row % archetype->chunk_capacity];
+}
+
+/**
+ * @param archetype[in]
+ * @param row
+ * @param component A component type in the archetype.
+ * @return The component value of the entity in a row.
+ */
+static void *prgl_row_component(
+    const struct PRGLArchetype *const archetype, int row, int component
+)
+{
+    unsigned char *const chunk =
+        archetype->chunks[row / archetype->chunk_capacity];
+    return chunk + archetype->column_offsets[component]
+         + prgl_component_sizes[component]
+               * (size_t)(row % archetype->chunk_capacity);
+}
+
+/**
+ * Sets components of a row to their starting values.
+ *
+ * @param archetype[in]
+ * @param row
+ * @param components The components to set, all in the archetype.
+ */
+static void prgl_init_row(
+    const struct PRGLArchetype *const archetype, int row, uint32_t components
+)
+{
+    for (int c = 0; c < prgl_num_components; c++)
+    {
+        if (components & PRGL_COMPONENT_BIT(c))
+        {
+            memset(
+                prgl_row_component(archetype, row, c), 0,
+                prgl_component_sizes[c]
+            );
+        }
+    }
+
+    if (components & PRGL_COMPONENT_BIT(PRGL_COMPONENT_TRANSFORM))
+    {
+        struct PRGLTransform *const transform =
+            prgl_row_component(archetype, row, PRGL_COMPONENT_TRANSFORM);
+        glm_quat_identity(transform->orientation);
+        glm_vec3_one(transform->scale);
+    }
+    if (components & PRGL_COMPONENT_BIT(PRGL_COMPONENT_COLOR))
+    {
+        glm_vec3_one(prgl_row_component(archetype, row, PRGL_COMPONENT_COLOR));
+    }
+}
+
+/**
+ * Removes a row from an archetype by moving the last row into it, keeping the
+ * rows packed.
+ *
+ * @param archetype[in,out]
+ * @param row
+ */
+static void prgl_remove_row(struct PRGLArchetype *const archetype, int row)
+{
+    const int last = --archetype->count;
+    if (row == last)
+    {
+        return;
+    }
+
+    for (int c = 0; c < prgl_num_components; c++)
+    {
+        if (archetype->components & PRGL_COMPONENT_BIT(c))
+        {
+            memcpy(
+                prgl_row_component(archetype, row, c),
+                prgl_row_component(archetype, last, c),
+                prgl_component_sizes[c]
+            );
+        }
+    }
+
+    const PRGLEntity moved = *prgl_row_entity(archetype, last);
+    *prgl_row_entity(archetype, row) = moved;
+    prgl_entity_records[moved.index].row = row;
+}
+
+/**
+ * @param entity
+ * @return The record of the entity, or NULL if the handle is stale.
+ */
+static struct PRGLEntityRecord *prgl_entity_record(PRGLEntity entity)
+{
+    if (entity.index >= (uint32_t)prgl_num_entity_records)
+    {
+        return NULL;
+    }
+
+    struct PRGLEntityRecord *const record = &prgl_entity_records[entity.index];
+    if (record->archetype < 0 || record->generation != entity.generation)
+    {
+        return NULL;
+    }
+    return record;
+}
@@ -0,0 +1,10 @@
+#ifndef PRGL_ENTITIES_INTERNAL_H
+#define PRGL_ENTITIES_INTERNAL_H
+
+/**
+ * Destroys every entity, frees the entity storage and forgets the registered
+ * component types.
+ */
+void prgl_delete_entities(void);
+
+#endif
@@ -0,0 +1,115 @@
+#include "glad.h"
+
+#include "frame_uniforms_internal.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "camera.h"
+#include "cglm/mat4.h"
+#include "game.h"
+#include "render.h"
+
+const char *const PRGL_FRAME_UNIFORM_BLOCK = "PRGLFrame";
+
+/**
+ * CPU copy of the PRGLFrame block, laid out to match std140.
+ */
+struct PRGLFrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    mat4 ortho_projection;
+    vec2 render_resolution;
+    float time;
+};
+
+// Size of the block in GLSL, std140 rounds it up to a multiple of a vec4
+static const GLsizeiptr FRAME_UNIFORMS_SIZE = 272;
+static const GLintptr FRAME_UNIFORMS_TAIL_OFFSET =
+    offsetof(struct PRGLFrameUniforms, render_resolution);
+
+static GLuint prgl_frame_ubo = 0;
+static struct PRGLFrameUniforms prgl_frame_uniforms;
+static bool prgl_frame_matrices_uploaded = false;
+static unsigned prgl_frame_matrices_version = 0;
+
+void prgl_init_frame_uniforms(void)
+{
+    glGenBuffers(1, &prgl_frame_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, prgl_frame_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_SIZE, NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(
+        GL_UNIFORM_BUFFER, PRGL_FRAME_UNIFORM_BINDING, prgl_frame_ubo
+    );
+    prgl_frame_matrices_uploaded = false;
+}
+
+void prgl_update_frame_uniforms(void)
+{
+    prgl_update_frame_camera();
+
+    prgl_frame_uniforms.render_resolution[0] = PRGL_RENDER_RESOLUTION[0];
+    prgl_frame_uniforms.render_resolution[1] = PRGL_RENDER_RESOLUTION[1];
+    prgl_frame_uniforms.time = (float)prgl_time_elapsed();
+
+    glBindBuffer(GL_UNIFORM_BUFFER, prgl_frame_ubo);
+    glBufferSubData(
+        GL_UNIFORM_BUFFER, FRAME_UNIFORMS_TAIL_OFFSET,
+        FRAME_UNIFORMS_SIZE - FRAME_UNIFORMS_TAIL_OFFSET,
+        prgl_frame_uniforms.render_resolution
+    );
+}
+
+void prgl_update_frame_camera(void)
+{
+    if (prgl_frame_ubo == 0)
+    {
+        return;
+    }
+
+    struct PRGLFrameUniforms frame = prgl_frame_uniforms;
+    struct PRGLCamera *const cam = prgl_active_camera();
+    if (cam != NULL)
+    {
+        glm_mat4_copy(cam->view, frame.view);
+        glm_mat4_copy(cam->projection_perspective, frame.projection);
+        glm_mat4_copy(cam->projection_orthogonal, frame.ortho_projection);
+    }
+    else
+    {
+        glm_mat4_identity(frame.view);
+        glm_mat4_identity(frame.projection);
+        glm_mat4_identity(frame.ortho_projection);
+    }
+    glm_mat4_mul(frame.projection, frame.view, frame.view_projection);
+
+    // The camera is usually still, so most calls upload nothing
+    if (prgl_frame_matrices_uploaded
+        && memcmp(&frame, &prgl_frame_uniforms, FRAME_UNIFORMS_TAIL_OFFSET)
+               == 0)
+    {
+        return;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, prgl_frame_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, FRAME_UNIFORMS_TAIL_OFFSET, &frame);
+    prgl_frame_uniforms = frame;
+    prgl_frame_matrices_uploaded = true;
+    prgl_frame_matrices_version++;
+}
+
+unsigned prgl_frame_camera_matrices(mat4 view, mat4 projection)
+{
+    glm_mat4_copy(prgl_frame_uniforms.view, view);
+    glm_mat4_copy(prgl_frame_uniforms.projection, projection);
+    return prgl_frame_matrices_version;
+}
+
+void prgl_delete_frame_uniforms(void)
+{
+    glDeleteBuffers(1, &prgl_frame_ubo);
+    prgl_frame_ubo = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef PRGL_FRAME_UNIFORMS_INTERNAL_H
+#define PRGL_FRAME_UNIFORMS_INTERNAL_H
+
+#include "cglm/types.h"
+
+/**
+ * Uniform buffer binding point the PRGLFrame block is bound to when a shader
+ * program is linked.
+ */
+#define PRGL_FRAME_UNIFORM_BINDING 0
+
+/**
+ * Name of the per-frame uniform block in GLSL.
+ */
+extern const char *const PRGL_FRAME_UNIFORM_BLOCK;
+
+/**
+ * Creates the per-frame uniform buffer and binds it to
+ * PRGL_FRAME_UNIFORM_BINDING.
+ */
+void prgl_init_frame_uniforms(void);
+
+/**
+ * Fills the per-frame uniform buffer from the active camera and the elapsed
+ * time. The camera matrices are only uploaded if they have changed since they
+ * were last uploaded. Should be called once per frame before drawing.
+ */
+void prgl_update_frame_uniforms(void);
+
+/**
+ * Uploads the active camera's matrices to the per-frame uniform buffer if they
+ * changed since they were last uploaded. Called when a camera is updated or
+ * re-projected, so built in shaders see camera changes made during the frame.
+ */
+void prgl_update_frame_camera(void);
+
+/**
+ * Gets the camera matrices last uploaded to the per-frame uniform buffer.
+ *
+ * @param view[out]
+ * @param projection[out]
+ * @return A version which changes whenever the matrices do.
+ */
+unsigned prgl_frame_camera_matrices(mat4 view, mat4 projection);
+
+/**
+ * Deletes the per-frame uniform buffer.
+ */
+void prgl_delete_frame_uniforms(void);
+
+#endif
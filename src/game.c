@@ -1,16 +1,39 @@
 #include "glad.h"
+#include "baked_lighting_internal.h"
+#include "culling_internal.h"
+#include "entities_internal.h"
+#include "frame_uniforms_internal.h"
 #include "game.h"
+#include "geometry_arena_internal.h"
+#include "gl_state_internal.h"
+#include "gpu_culling_internal.h"
+#include "light_clusters_internal.h"
+#include "lighting_internal.h"
 #include "mesh.h"
 #include "mesh_internal.h"
+#include "multi_draw_internal.h"
+#include "parallel_internal.h"
 #include "render_internal.h"
+#include "render_queue_internal.h"
 #include "shaders.h"
 #include "texture_internal.h"
 #include "screen_internal.h"
 #include "shaders_internal.h"
+#include "sprite_batch_internal.h"
 #include <GLFW/glfw3.h>
+#include <math.h>
 
 static double last_update_start = 0;
 static double dt = 0;
+
+// Fixed timestep state, a tick length of 0 updates once per frame instead
+static double tick_length = 0;
+static int max_ticks_per_frame = 0;
+static double tick_accumulator = 0;
+static double interpolation_alpha = 1.0;
+static unsigned long current_tick = 0;
+
+static void (*prgl_draw_loading_screen)(void) = NULL;
 struct PRGLRenderTexture render_texture;
 struct PRGLMesh *screen_render_quad;
 
@@ -24,27 +47,85 @@ void prgl_run_game(
     prgl_create_window(title);
 
     prgl_init_shader_pool();
+    prgl_init_renderer();
+    prgl_init_frame_uniforms();
+    prgl_init_lighting();
+    prgl_init_light_clusters();
+    prgl_init_sprite_batch();
+    prgl_init_multi_draw();
+    prgl_init_gpu_culling();
     prgl_use_shader(prgl_shader(PRGL_SHADER_TYPE_3D));
     render_texture = prgl_create_render_texture();
     screen_render_quad = prgl_create_screen_quad(render_texture.texture);
     prgl_init();
 
     struct PRGLScreen screen = *prgl_screen();
+    // Startup isn't counted in the first frame's time
+    last_update_start = glfwGetTime();
     while (!glfwWindowShouldClose(screen.window))
     {
-        dt = glfwGetTime() - last_update_start;
+        const double frame_time = glfwGetTime() - last_update_start;
         last_update_start = glfwGetTime();
+        prgl_begin_render_stats_frame();
+
+        // Polled every frame so shaders are set up as soon as they finish
+        if (!prgl_shaders_ready() && prgl_draw_loading_screen != NULL)
+        {
+            prgl_enable_render_texture(render_texture.fbo);
+            prgl_gl_set_capability(GL_DEPTH_TEST, false);
+            prgl_use_shader_2d();
+            prgl_update_frame_uniforms();
+            prgl_update_culling();
+            prgl_draw_loading_screen();
+            prgl_flush_render_queue();
+
+            prgl_render_render_texture(screen_render_quad);
+
+            prgl_cleanup();
+
+            glfwSwapBuffers(screen.window);
+            glfwPollEvents();
+            continue;
+        }
 
         prgl_enable_render_texture(render_texture.fbo);
-        glEnable(GL_DEPTH_TEST);
+        prgl_gl_set_capability(GL_DEPTH_TEST, true);
         prgl_use_shader_3d();
-        prgl_update();
+        if (tick_length > 0)
+        {
+            // Run as many ticks as the frame covered, up to the limit. Past
+            // it the whole ticks are dropped so a slow frame can't make the
+            // next one slower still.
+            tick_accumulator += frame_time;
+            dt = tick_length;
+            int num_ticks = 0;
+            while (tick_accumulator >= tick_length
+                   && num_ticks < max_ticks_per_frame)
+            {
+                current_tick++;
+                prgl_update();
+                tick_accumulator -= tick_length;
+                num_ticks++;
+            }
+            tick_accumulator = fmod(tick_accumulator, tick_length);
+            interpolation_alpha = tick_accumulator / tick_length;
+        }
+        else
+        {
+            dt = frame_time;
+            current_tick++;
+            prgl_update();
+        }
+        prgl_update_frame_uniforms();
+        prgl_update_culling();
 
         prgl_draw_3d();
+        prgl_flush_render_queue();
 
-        glDisable(GL_DEPTH_TEST);
+        prgl_gl_set_capability(GL_DEPTH_TEST, false);
         prgl_use_shader_2d();
         prgl_draw_2d();
+        prgl_flush_render_queue();
 
         prgl_render_render_texture(screen_render_quad);
 
@@ -55,11 +136,42 @@ void prgl_run_game(
     }
 
     prgl_delete_mesh(screen_render_quad);
+    prgl_delete_baked_lighting();
+    prgl_delete_geometry_arena();
+
+    prgl_delete_render_queue();
+    prgl_delete_culling();
+    prgl_delete_entities();
+    prgl_delete_renderer();
+    prgl_delete_frame_uniforms();
+    prgl_delete_lighting();
+    prgl_delete_light_clusters();
+    prgl_delete_sprite_batch();
+    prgl_delete_multi_draw();
+    prgl_delete_gpu_culling();
+    prgl_delete_parallel();
 
     prgl_delete_shader_pool();
     prgl_destroy_window();
 }
 
+void prgl_set_loading_screen(void (*draw_loading_screen)(void))
+{
+    prgl_draw_loading_screen = draw_loading_screen;
+}
+
+void prgl_set_fixed_timestep(double tick_rate, int max_ticks)
+{
+    tick_length = tick_rate > 0 ? 1.0 / tick_rate : 0;
+    max_ticks_per_frame = max_ticks < 1 ? 1 : max_ticks;
+    tick_accumulator = 0;
+    interpolation_alpha = 1.0;
+}
+
 double prgl_delta_time(void) { return dt; }
 
+double prgl_interpolation_alpha(void) { return interpolation_alpha; }
+
+unsigned long prgl_current_tick(void) { return current_tick; }
+
 double prgl_time_elapsed(void) { return glfwGetTime(); }
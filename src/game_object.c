@@ -1,8 +1,11 @@
 #include "game_object.h"
 #include "cglm/quat.h"
 #include "cglm/vec3.h"
+#include "game.h"
 #include "types.h"
 
+static void prgl_begin_game_object_move(struct PRGLGameObject *const game_obj);
+
 void prgl_init_game_object(
     struct PRGLGameObject *const game_obj, const PRGLMeshHandle mesh,
     vec3 position
@@ -13,6 +16,34 @@ void prgl_init_game_object(
     glm_vec3_one(game_obj->scale);
     glm_vec3_one(game_obj->color);
     game_obj->mesh = mesh;
+    game_obj->transform_dirty = true;
+    game_obj->parent = NULL;
+
+    glm_quat_copy(game_obj->orientation, game_obj->previous_orientation);
+    glm_vec3_copy(game_obj->position, game_obj->previous_position);
+    glm_vec3_copy(game_obj->scale, game_obj->previous_scale);
+    game_obj->move_tick = 0;
+}
+
+void prgl_set_game_object_position(
+    struct PRGLGameObject *const game_obj, vec3 position
+)
+{
+    prgl_begin_game_object_move(game_obj);
+    glm_vec3_copy(position, game_obj->position);
+}
+
+void prgl_set_game_object_scale(
+    struct PRGLGameObject *const game_obj, vec3 scale
+)
+{
+    prgl_begin_game_object_move(game_obj);
+    glm_vec3_copy(scale, game_obj->scale);
+}
+
+void prgl_mark_game_object_moved(struct PRGLGameObject *const game_obj)
+{
+    prgl_begin_game_object_move(game_obj);
 }
 
 void prgl_rotate_game_object(
@@ -29,6 +60,8 @@ void prgl_rotate_game_object(
     glm_quatv(pitch_quat, glm_rad(pitch_d), (vec3){1.0f, 0.0f, 0.0f});
     glm_quatv(roll_quat, glm_rad(roll_d), (vec3){0.0f, 0.0f, 1.0f});
 
+    prgl_begin_game_object_move(game_obj);
+
     // Multiply with game object orientation in order yaw->pitch->roll
     glm_quat_mul(roll_quat, game_obj->orientation, game_obj->orientation);
     glm_quat_mul(pitch_quat, game_obj->orientation, game_obj->orientation);
@@ -39,6 +72,7 @@ void prgl_set_game_object_axis_angle(
     struct PRGLGameObject *const game_obj, vec3 axis, float angle_d
 )
 {
+    prgl_begin_game_object_move(game_obj);
     glm_quatv(game_obj->orientation, glm_rad(angle_d), axis);
 }
 
@@ -50,3 +84,23 @@ void prgl_set_game_object_color(
     game_obj->color[1] = g;
     game_obj->color[2] = b;
 }
+
+/**
+ * Marks a game object's cached matrices as out of date before its transform
+ * changes. The first move in an update tick keeps the transform from the end
+ * of the last tick to interpolate from.
+ *
+ * @param game_obj[in,out]
+ */
+static void prgl_begin_game_object_move(struct PRGLGameObject *const game_obj)
+{
+    const unsigned long tick = prgl_current_tick();
+    if (game_obj->move_tick != tick)
+    {
+        glm_quat_copy(game_obj->orientation, game_obj->previous_orientation);
+        glm_vec3_copy(game_obj->position, game_obj->previous_position);
+        glm_vec3_copy(game_obj->scale, game_obj->previous_scale);
+        game_obj->move_tick = tick;
+    }
+    game_obj->transform_dirty = true;
+}
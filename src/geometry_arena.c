@@ -0,0 +1,725 @@
+#include "glad.h"
+
+#include "geometry_arena_internal.h"
+#include "mesh.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gl_state_internal.h"
+
+// Size of a new page's buffers. Geometry bigger than a page gets a page of
+// its own sized to fit.
+static const GLsizeiptr VERTEX_PAGE_BYTES = 4 * 1024 * 1024;
+static const GLsizeiptr INDEX_PAGE_BYTES = 2 * 1024 * 1024;
+
+// Index ranges are kept four byte aligned so any index type can start there
+static const GLsizeiptr INDEX_ALIGNMENT = 4;
+
+// Baked vertex lighting is a float RGB per vertex, read as aBakedLight
+static const GLsizei LIGHT_STRIDE = sizeof(GLfloat) * 3;
+static const GLuint BAKED_LIGHT_LOCATION = 12;
+
+/**
+ * A free range of a page's buffer, in vertices for vertex buffers and in bytes
+ * for element buffers.
+ */
+struct PRGLRange
+{
+    GLintptr offset;
+    GLsizeiptr size;
+};
+
+/**
+ * Free ranges sorted by offset, neighbouring ranges are always merged.
+ */
+struct PRGLRangeList
+{
+    struct PRGLRange *ranges;
+    int count;
+    int capacity;
+};
+
+struct PRGLGeometryPage
+{
+    struct PRGLVertexLayout layout;
+    GLuint vao;
+    GLuint vbo;
+    GLuint ebo;
+
+    // Baked lighting of each vertex, only made once a mesh in it is baked
+    GLuint light_vbo;
+
+    GLsizei vertex_capacity;
+    GLsizeiptr index_capacity;
+    struct PRGLRangeList free_vertices;
+    struct PRGLRangeList free_indices;
+
+    // Every live allocation, so compaction can move them
+    struct PRGLGeometryAllocation **allocations;
+    int num_allocations;
+    int allocations_capacity;
+};
+
+static struct PRGLGeometryPage **prgl_pages = NULL;
+static int prgl_num_pages = 0;
+static int prgl_pages_capacity = 0;
+
+static bool prgl_page_allocate(
+    struct PRGLGeometryPage *const page, GLsizei num_vertices,
+    GLsizeiptr index_bytes, struct PRGLGeometryAllocation *const allocation
+);
+static bool prgl_allocate_in_layout(
+    const struct PRGLVertexLayout *const layout, GLsizei num_vertices,
+    GLsizeiptr index_bytes, struct PRGLGeometryAllocation *const allocation
+);
+static struct PRGLGeometryPage *prgl_create_page(
+    const struct PRGLVertexLayout *const layout, GLsizei min_vertices,
+    GLsizeiptr min_index_bytes
+);
+static void prgl_delete_page(int page_index);
+static bool prgl_page_fragmented(const struct PRGLGeometryPage *const page);
+static void prgl_compact_page(struct PRGLGeometryPage *const page);
+static bool prgl_compact_layout(const struct PRGLVertexLayout *const layout);
+static bool prgl_range_allocate(
+    struct PRGLRangeList *const list, GLsizeiptr size, GLintptr *const offset
+);
+static void prgl_range_free(
+    struct PRGLRangeList *const list, GLintptr offset, GLsizeiptr size
+);
+static bool prgl_range_reset(
+    struct PRGLRangeList *const list, GLintptr offset, GLsizeiptr size
+);
+
+bool prgl_allocate_geometry(
+    const struct PRGLVertexLayout *const layout, const void *const vertices,
+    GLsizei num_vertices, const void *const indices, GLsizeiptr index_bytes,
+    struct PRGLGeometryAllocation *const allocation
+)
+{
+    const GLsizeiptr aligned_index_bytes =
+        (index_bytes + INDEX_ALIGNMENT - 1) & ~(INDEX_ALIGNMENT - 1);
+
+    // Compacting only helps if space was lost to gaps between allocations
+    bool allocated = prgl_allocate_in_layout(
+        layout, num_vertices, aligned_index_bytes, allocation
+    );
+    if (!allocated && prgl_compact_layout(layout))
+    {
+        allocated = prgl_allocate_in_layout(
+            layout, num_vertices, aligned_index_bytes, allocation
+        );
+    }
+    if (!allocated)
+    {
+        struct PRGLGeometryPage *const page =
+            prgl_create_page(layout, num_vertices, aligned_index_bytes);
+        allocated = page != NULL
+                 && prgl_page_allocate(
+                        page, num_vertices, aligned_index_bytes, allocation
+                    );
+    }
+    if (!allocated)
+    {
+        fprintf(
+            stderr, "prgl_allocate_geometry: Error allocating geometry "
+                    "memory!\n"
+        );
+        return false;
+    }
+
+    const struct PRGLGeometryPage *const page = allocation->page;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->vbo);
+    glBufferSubData(
+        GL_COPY_WRITE_BUFFER,
+        (GLintptr)allocation->base_vertex * layout->stride,
+        (GLsizeiptr)num_vertices * layout->stride, vertices
+    );
+    if (index_bytes > 0)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, page->ebo);
+        glBufferSubData(
+            GL_COPY_WRITE_BUFFER, allocation->index_offset, index_bytes,
+            indices
+        );
+    }
+    return true;
+}
+
+void prgl_free_geometry(struct PRGLGeometryAllocation *const allocation)
+{
+    struct PRGLGeometryPage *const page = allocation->page;
+    if (page == NULL)
+    {
+        return;
+    }
+
+    prgl_range_free(
+        &page->free_vertices, allocation->base_vertex, allocation->num_vertices
+    );
+    prgl_range_free(
+        &page->free_indices, allocation->index_offset, allocation->index_bytes
+    );
+
+    // Swap the last allocation into the freed slot
+    struct PRGLGeometryAllocation *const last =
+        page->allocations[--page->num_allocations];
+    page->allocations[allocation->slot] = last;
+    last->slot = allocation->slot;
+
+    *allocation = (struct PRGLGeometryAllocation){0};
+}
+
+GLuint prgl_geometry_vao(const struct PRGLGeometryAllocation *const allocation)
+{
+    return allocation->page->vao;
+}
+
+GLuint prgl_geometry_vbo(const struct PRGLGeometryAllocation *const allocation)
+{
+    return allocation->page->vbo;
+}
+
+GLuint prgl_geometry_ebo(const struct PRGLGeometryAllocation *const allocation)
+{
+    return allocation->page->ebo;
+}
+
+void prgl_upload_geometry_light(
+    const struct PRGLGeometryAllocation *const allocation,
+    const GLfloat colors[]
+)
+{
+    struct PRGLGeometryPage *const page = allocation->page;
+    if (page->light_vbo == 0)
+    {
+        glGenBuffers(1, &page->light_vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, page->light_vbo);
+        glBufferData(
+            GL_ARRAY_BUFFER, (GLsizeiptr)page->vertex_capacity * LIGHT_STRIDE,
+            NULL, GL_DYNAMIC_DRAW
+        );
+
+        prgl_gl_bind_vertex_array(page->vao);
+        glVertexAttribPointer(
+            BAKED_LIGHT_LOCATION, 3, GL_FLOAT, GL_FALSE, LIGHT_STRIDE,
+            (const GLvoid *)0
+        );
+        glEnableVertexAttribArray(BAKED_LIGHT_LOCATION);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->light_vbo);
+    glBufferSubData(
+        GL_COPY_WRITE_BUFFER, (GLintptr)allocation->base_vertex * LIGHT_STRIDE,
+        (GLsizeiptr)allocation->num_vertices * LIGHT_STRIDE, colors
+    );
+}
+
+void prgl_compact_mesh_geometry(void)
+{
+    for (int p = prgl_num_pages - 1; p >= 0; p--)
+    {
+        if (prgl_pages[p]->num_allocations == 0)
+        {
+            prgl_delete_page(p);
+        }
+        else if (prgl_page_fragmented(prgl_pages[p]))
+        {
+            prgl_compact_page(prgl_pages[p]);
+        }
+    }
+}
+
+void prgl_delete_geometry_arena(void)
+{
+    while (prgl_num_pages > 0)
+    {
+        prgl_delete_page(prgl_num_pages - 1);
+    }
+
+    free(prgl_pages);
+    prgl_pages = NULL;
+    prgl_pages_capacity = 0;
+}
+
+/**
+ * Takes ranges for an allocation from a page.
+ *
+ * @param page[in,out]
+ * @param num_vertices
+ * @param index_bytes Already aligned to INDEX_ALIGNMENT.
+ * @param allocation[out]
+ * @return False if the page doesn't have room, the page is unchanged.
+ */
+static bool prgl_page_allocate(
+    struct PRGLGeometryPage *const page, GLsizei num_vertices,
+    GLsizeiptr index_bytes, struct PRGLGeometryAllocation *const allocation
+)
+{
+    if (page->num_allocations == page->allocations_capacity)
+    {
+        const int capacity = page->allocations_capacity == 0
+                               ? 64
+                               : page->allocations_capacity * 2;
+        struct PRGLGeometryAllocation **allocations = realloc(
+            page->allocations,
+            sizeof(struct PRGLGeometryAllocation *) * capacity
+        );
+        if (allocations == NULL)
+        {
+            return false;
+        }
+        page->allocations = allocations;
+        page->allocations_capacity = capacity;
+    }
+
+    GLintptr base_vertex = 0;
+    GLintptr index_offset = 0;
+    if (!prgl_range_allocate(&page->free_vertices, num_vertices, &base_vertex))
+    {
+        return false;
+    }
+    if (!prgl_range_allocate(&page->free_indices, index_bytes, &index_offset))
+    {
+        prgl_range_free(&page->free_vertices, base_vertex, num_vertices);
+        return false;
+    }
+
+    *allocation = (struct PRGLGeometryAllocation){
+        .page = page,
+        .base_vertex = (GLint)base_vertex,
+        .num_vertices = num_vertices,
+        .index_offset = index_offset,
+        .index_bytes = index_bytes,
+        .slot = page->num_allocations,
+    };
+    page->allocations[page->num_allocations++] = allocation;
+    return true;
+}
+
+/**
+ * Tries each existing page with the given layout in turn.
+ *
+ * @param layout[in]
+ * @param num_vertices
+ * @param index_bytes Already aligned to INDEX_ALIGNMENT.
+ * @param allocation[out]
+ * @return False if no page had room.
+ */
+static bool prgl_allocate_in_layout(
+    const struct PRGLVertexLayout *const layout, GLsizei num_vertices,
+    GLsizeiptr index_bytes, struct PRGLGeometryAllocation *const allocation
+)
+{
+    for (int p = 0; p < prgl_num_pages; p++)
+    {
+        struct PRGLGeometryPage *const page = prgl_pages[p];
+        if (memcmp(&page->layout, layout, sizeof(struct PRGLVertexLayout)) == 0
+            && prgl_page_allocate(page, num_vertices, index_bytes, allocation))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Creates a page's buffers and sets up its vertex array for a layout.
+ *
+ * @param layout[in]
+ * @param min_vertices The page is made at least this big.
+ * @param min_index_bytes
+ * @return The new page, or NULL if memory couldn't be allocated.
+ */
+static struct PRGLGeometryPage *prgl_create_page(
+    const struct PRGLVertexLayout *const layout, GLsizei min_vertices,
+    GLsizeiptr min_index_bytes
+)
+{
+    if (prgl_num_pages == prgl_pages_capacity)
+    {
+        const int capacity =
+            prgl_pages_capacity == 0 ? 8 : prgl_pages_capacity * 2;
+        struct PRGLGeometryPage **pages =
+            realloc(prgl_pages, sizeof(struct PRGLGeometryPage *) * capacity);
+        if (pages == NULL)
+        {
+            return NULL;
+        }
+        prgl_pages = pages;
+        prgl_pages_capacity = capacity;
+    }
+
+    struct PRGLGeometryPage *const page =
+        calloc(1, sizeof(struct PRGLGeometryPage));
+    if (page == NULL)
+    {
+        return NULL;
+    }
+
+    page->layout = *layout;
+    page->vertex_capacity = (GLsizei)(VERTEX_PAGE_BYTES / layout->stride);
+    if (page->vertex_capacity < min_vertices)
+    {
+        page->vertex_capacity = min_vertices;
+    }
+    page->index_capacity = INDEX_PAGE_BYTES;
+    if (page->index_capacity < min_index_bytes)
+    {
+        page->index_capacity = min_index_bytes;
+    }
+
+    if (!prgl_range_reset(&page->free_vertices, 0, page->vertex_capacity)
+        || !prgl_range_reset(&page->free_indices, 0, page->index_capacity))
+    {
+        free(page->free_vertices.ranges);
+        free(page->free_indices.ranges);
+        free(page);
+        return NULL;
+    }
+
+    glGenVertexArrays(1, &page->vao);
+    glGenBuffers(1, &page->vbo);
+    glGenBuffers(1, &page->ebo);
+
+    // The element buffer binding is part of the vertex array's state
+    prgl_gl_bind_vertex_array(page->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, page->vbo);
+    glBufferData(
+        GL_ARRAY_BUFFER, (GLsizeiptr)page->vertex_capacity * layout->stride,
+        NULL, GL_STATIC_DRAW
+    );
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->ebo);
+    glBufferData(
+        GL_ELEMENT_ARRAY_BUFFER, page->index_capacity, NULL, GL_STATIC_DRAW
+    );
+    prgl_setup_vertex_layout(layout);
+
+    prgl_pages[prgl_num_pages++] = page;
+    return page;
+}
+
+/**
+ * Deletes a page's GL objects and frees it. Any allocations still in it are
+ * left pointing at freed memory.
+ *
+ * @param page_index Index of the page in prgl_pages.
+ */
+static void prgl_delete_page(int page_index)
+{
+    struct PRGLGeometryPage *const page = prgl_pages[page_index];
+    prgl_gl_delete_vertex_array(page->vao);
+    glDeleteBuffers(1, &page->vbo);
+    glDeleteBuffers(1, &page->ebo);
+    if (page->light_vbo != 0)
+    {
+        glDeleteBuffers(1, &page->light_vbo);
+    }
+    free(page->free_vertices.ranges);
+    free(page->free_indices.ranges);
+    free(page->allocations);
+    free(page);
+
+    prgl_pages[page_index] = prgl_pages[--prgl_num_pages];
+}
+
+/**
+ * @param page[in]
+ * @return True if the page's free space is split into more than one range, so
+ * compacting it would make a bigger range.
+ */
+static bool prgl_page_fragmented(const struct PRGLGeometryPage *const page)
+{
+    return page->free_vertices.count > 1 || page->free_indices.count > 1;
+}
+
+/**
+ * Moves a page's allocations to the start of its buffers so its free space is
+ * one range at the end. The data goes through a scratch buffer since copies
+ * within a buffer can't overlap, and the page's buffers are kept so its vertex
+ * array stays valid.
+ *
+ * @param page[in,out]
+ */
+static void prgl_compact_page(struct PRGLGeometryPage *const page)
+{
+    const GLsizei stride = page->layout.stride;
+    GLsizei used_vertices = 0;
+    GLsizeiptr used_index_bytes = 0;
+    for (int a = 0; a < page->num_allocations; a++)
+    {
+        used_vertices += page->allocations[a]->num_vertices;
+        used_index_bytes += page->allocations[a]->index_bytes;
+    }
+
+    const GLsizeiptr used_vertex_bytes = (GLsizeiptr)used_vertices * stride;
+    GLsizeiptr scratch_bytes = used_vertex_bytes > used_index_bytes
+                                 ? used_vertex_bytes
+                                 : used_index_bytes;
+    if (page->light_vbo != 0
+        && (GLsizeiptr)used_vertices * LIGHT_STRIDE > scratch_bytes)
+    {
+        scratch_bytes = (GLsizeiptr)used_vertices * LIGHT_STRIDE;
+    }
+
+    GLuint scratch;
+    glGenBuffers(1, &scratch);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+    glBufferData(GL_COPY_WRITE_BUFFER, scratch_bytes, NULL, GL_STREAM_COPY);
+
+    // Baked lighting follows its vertices, moved before they update their
+    // base vertex
+    if (page->light_vbo != 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, page->light_vbo);
+        GLsizei light_cursor = 0;
+        for (int a = 0; a < page->num_allocations; a++)
+        {
+            struct PRGLGeometryAllocation *const allocation =
+                page->allocations[a];
+            glCopyBufferSubData(
+                GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                (GLintptr)allocation->base_vertex * LIGHT_STRIDE,
+                (GLintptr)light_cursor * LIGHT_STRIDE,
+                (GLsizeiptr)allocation->num_vertices * LIGHT_STRIDE
+            );
+            light_cursor += allocation->num_vertices;
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, scratch);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, page->light_vbo);
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+            (GLsizeiptr)light_cursor * LIGHT_STRIDE
+        );
+        glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+    }
+
+    // Vertices, packed into the scratch buffer and copied back in one go
+    glBindBuffer(GL_COPY_READ_BUFFER, page->vbo);
+    GLsizei vertex_cursor = 0;
+    for (int a = 0; a < page->num_allocations; a++)
+    {
+        struct PRGLGeometryAllocation *const allocation = page->allocations[a];
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            (GLintptr)allocation->base_vertex * stride,
+            (GLintptr)vertex_cursor * stride,
+            (GLsizeiptr)allocation->num_vertices * stride
+        );
+        allocation->base_vertex = vertex_cursor;
+        vertex_cursor += allocation->num_vertices;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, scratch);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->vbo);
+    glCopyBufferSubData(
+        GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used_vertex_bytes
+    );
+
+    // Indices are relative to the base vertex, so they can be moved as is
+    glBindBuffer(GL_COPY_READ_BUFFER, page->ebo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+    GLintptr index_cursor = 0;
+    for (int a = 0; a < page->num_allocations; a++)
+    {
+        struct PRGLGeometryAllocation *const allocation = page->allocations[a];
+        if (allocation->index_bytes > 0)
+        {
+            glCopyBufferSubData(
+                GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                allocation->index_offset, index_cursor,
+                allocation->index_bytes
+            );
+        }
+        allocation->index_offset = index_cursor;
+        index_cursor += allocation->index_bytes;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, scratch);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->ebo);
+    glCopyBufferSubData(
+        GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used_index_bytes
+    );
+
+    glDeleteBuffers(1, &scratch);
+
+    // Resetting to one range never needs more memory than the list has
+    prgl_range_reset(
+        &page->free_vertices, vertex_cursor,
+        page->vertex_capacity - vertex_cursor
+    );
+    prgl_range_reset(
+        &page->free_indices, index_cursor, page->index_capacity - index_cursor
+    );
+}
+
+/**
+ * Compacts the fragmented pages with a layout.
+ *
+ * @param layout[in]
+ * @return True if any page was compacted.
+ */
+static bool prgl_compact_layout(const struct PRGLVertexLayout *const layout)
+{
+    bool compacted = false;
+    for (int p = 0; p < prgl_num_pages; p++)
+    {
+        struct PRGLGeometryPage *const page = prgl_pages[p];
+        if (memcmp(&page->layout, layout, sizeof(struct PRGLVertexLayout)) == 0
+            && prgl_page_fragmented(page))
+        {
+            prgl_compact_page(page);
+            compacted = true;
+        }
+    }
+
+    return compacted;
+}
+
+/**
+ * Takes space from the first free range big enough.
+ *
+ * @param list[in,out]
+ * @param size Zero always succeeds without taking any space.
+ * @param offset[out]
+ * @return False if no range is big enough.
+ */
+static bool prgl_range_allocate(
+    struct PRGLRangeList *const list, GLsizeiptr size, GLintptr *const offset
+)
+{
+    if (size == 0)
+    {
+        *offset = 0;
+        return true;
+    }
+
+    for (int r = 0; r < list->count; r++)
+    {
+        struct PRGLRange *const range = &list->ranges[r];
+        if (range->size < size)
+        {
+            continue;
+        }
+
+        *offset = range->offset;
+        range->offset += size;
+        range->size -= size;
+        if (range->size == 0)
+        {
+            memmove(
+                range, range + 1,
+                sizeof(struct PRGLRange) * (list->count - r - 1)
+            );
+            list->count--;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Returns space to a range list, merging it with the ranges either side.
+ *
+ * @param list[in,out]
+ * @param offset
+ * @param size Zero does nothing.
+ */
+static void prgl_range_free(
+    struct PRGLRangeList *const list, GLintptr offset, GLsizeiptr size
+)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    int next = 0;
+    while (next < list->count && list->ranges[next].offset < offset)
+    {
+        next++;
+    }
+
+    const bool joins_previous =
+        next > 0
+        && list->ranges[next - 1].offset + list->ranges[next - 1].size
+               == offset;
+    const bool joins_next =
+        next < list->count && offset + size == list->ranges[next].offset;
+
+    if (joins_previous && joins_next)
+    {
+        list->ranges[next - 1].size += size + list->ranges[next].size;
+        memmove(
+            &list->ranges[next], &list->ranges[next + 1],
+            sizeof(struct PRGLRange) * (list->count - next - 1)
+        );
+        list->count--;
+        return;
+    }
+    if (joins_previous)
+    {
+        list->ranges[next - 1].size += size;
+        return;
+    }
+    if (joins_next)
+    {
+        list->ranges[next].offset = offset;
+        list->ranges[next].size += size;
+        return;
+    }
+
+    if (list->count == list->capacity)
+    {
+        const int capacity = list->capacity * 2;
+        struct PRGLRange *ranges =
+            realloc(list->ranges, sizeof(struct PRGLRange) * capacity);
+        if (ranges == NULL)
+        {
+            // The space is lost until the page is compacted
+            fprintf(
+                stderr, "prgl_range_free: Error allocating free range "
+                        "memory!\n"
+            );
+            return;
+        }
+        list->ranges = ranges;
+        list->capacity = capacity;
+    }
+
+    memmove(
+        &list->ranges[next + 1], &list->ranges[next],
+        sizeof(struct PRGLRange) * (list->count - next)
+    );
+    list->ranges[next] = (struct PRGLRange){.offset = offset, .size = size};
+    list->count++;
+}
+
+/**
+ * Makes a range list hold a single range, allocating the list if needed.
+ *
+ * @param list[in,out]
+ * @param offset
+ * @param size Zero leaves the list empty.
+ * @return False if memory couldn't be allocated.
+ */
+static bool prgl_range_reset(
+    struct PRGLRangeList *const list, GLintptr offset, GLsizeiptr size
+)
+{
+    if (list->ranges == NULL)
+    {
+        list->ranges = malloc(sizeof(struct PRGLRange) * 8);
+        if (list->ranges == NULL)
+        {
+            return false;
+        }
+        list->capacity = 8;
+    }
+
+    list->ranges[0] = (struct PRGLRange){.offset = offset, .size = size};
+    list->count = size > 0 ? 1 : 0;
+    return true;
+}
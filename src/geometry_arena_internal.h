@@ -0,0 +1,100 @@
+#ifndef PRGL_GEOMETRY_ARENA_INTERNAL_H
+#define PRGL_GEOMETRY_ARENA_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "glad.h"
+#include "vertex_format_internal.h"
+
+struct PRGLGeometryPage;
+
+/**
+ * @brief A mesh's vertices and indices inside a shared geometry page.
+ *
+ * Pages hold the geometry of many meshes with the same vertex layout in one
+ * vertex buffer and one element buffer, with one vertex array set up for both.
+ * Indices are relative to base_vertex, so draws use the BaseVertex variants.
+ */
+struct PRGLGeometryAllocation
+{
+    struct PRGLGeometryPage *page;
+
+    /// @brief The first vertex of the allocation in the page's vertex buffer.
+    GLint base_vertex;
+    GLsizei num_vertices;
+
+    /// @brief Byte offset of the first index in the page's element buffer.
+    GLintptr index_offset;
+    GLsizeiptr index_bytes;
+
+    /// @brief Position of the allocation in its page's allocation list.
+    int slot;
+};
+
+/**
+ * Finds space for geometry in a page with the same vertex layout and uploads
+ * it. A new page is made if no page has room after compacting the fragmented
+ * ones.
+ *
+ * The allocation is tracked by address until it's freed, so it must not be
+ * moved or copied.
+ *
+ * @param layout[in] The layout the vertices were packed with.
+ * @param vertices[in] Packed vertices.
+ * @param num_vertices
+ * @param indices[in] Indices relative to the first vertex, or NULL.
+ * @param index_bytes Size of the indices in bytes, 0 if there are none.
+ * @param allocation[out]
+ * @return False if memory couldn't be allocated.
+ */
+bool prgl_allocate_geometry(
+    const struct PRGLVertexLayout *const layout, const void *const vertices,
+    GLsizei num_vertices, const void *const indices, GLsizeiptr index_bytes,
+    struct PRGLGeometryAllocation *const allocation
+);
+
+/**
+ * Returns an allocation's ranges to its page.
+ *
+ * @param allocation[in,out]
+ */
+void prgl_free_geometry(struct PRGLGeometryAllocation *const allocation);
+
+/**
+ * @param allocation[in]
+ * @return The page's vertex array, set up for the allocation's layout.
+ */
+GLuint prgl_geometry_vao(const struct PRGLGeometryAllocation *const allocation);
+
+/**
+ * @param allocation[in]
+ * @return The page's vertex buffer.
+ */
+GLuint prgl_geometry_vbo(const struct PRGLGeometryAllocation *const allocation);
+
+/**
+ * @param allocation[in]
+ * @return The page's element buffer.
+ */
+GLuint prgl_geometry_ebo(const struct PRGLGeometryAllocation *const allocation);
+
+/**
+ * Uploads the baked lighting of an allocation's vertices. The page's light
+ * buffer is made the first time, and its vertex array reads it as aBakedLight
+ * at location 12. Compacting the page moves the lighting with the vertices.
+ *
+ * @param allocation[in]
+ * @param colors[in] An RGB float for each of the allocation's vertices.
+ */
+void prgl_upload_geometry_light(
+    const struct PRGLGeometryAllocation *const allocation,
+    const GLfloat colors[]
+);
+
+/**
+ * Deletes every geometry page. Meshes still using them must not be drawn or
+ * deleted afterwards.
+ */
+void prgl_delete_geometry_arena(void);
+
+#endif
@@ -0,0 +1,134 @@
+#include "glad.h"
+
+#include "gl_extensions_internal.h"
+
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+
+PFNPRGLMULTIDRAWELEMENTSINDIRECTPROC prgl_gl_multi_draw_elements_indirect =
+    NULL;
+PFNPRGLDISPATCHCOMPUTEPROC prgl_gl_dispatch_compute = NULL;
+PFNPRGLMEMORYBARRIERPROC prgl_gl_memory_barrier = NULL;
+PFNPRGLCLEARBUFFERSUBDATAPROC prgl_gl_clear_buffer_sub_data = NULL;
+PFNPRGLGETPROGRAMBINARYPROC prgl_gl_get_program_binary = NULL;
+PFNPRGLPROGRAMBINARYPROC prgl_gl_program_binary = NULL;
+PFNPRGLPROGRAMPARAMETERIPROC prgl_gl_program_parameteri = NULL;
+PFNPRGLMAXSHADERCOMPILERTHREADSPROC prgl_gl_max_shader_compiler_threads =
+    NULL;
+
+static bool prgl_gl_4_3 = false;
+static bool prgl_gl_program_binaries = false;
+static bool prgl_gl_parallel_shader_compile = false;
+
+static void prgl_load_program_binary(void);
+static void prgl_load_parallel_shader_compile(void);
+
+void prgl_load_gl_extensions(void)
+{
+    prgl_load_program_binary();
+    prgl_load_parallel_shader_compile();
+
+    prgl_gl_4_3 = false;
+    if (GLVersion.major < 4 || (GLVersion.major == 4 && GLVersion.minor < 3))
+    {
+        return;
+    }
+
+    prgl_gl_multi_draw_elements_indirect =
+        (PFNPRGLMULTIDRAWELEMENTSINDIRECTPROC)glfwGetProcAddress(
+            "glMultiDrawElementsIndirect"
+        );
+    prgl_gl_dispatch_compute =
+        (PFNPRGLDISPATCHCOMPUTEPROC)glfwGetProcAddress("glDispatchCompute");
+    prgl_gl_memory_barrier =
+        (PFNPRGLMEMORYBARRIERPROC)glfwGetProcAddress("glMemoryBarrier");
+    prgl_gl_clear_buffer_sub_data =
+        (PFNPRGLCLEARBUFFERSUBDATAPROC)glfwGetProcAddress(
+            "glClearBufferSubData"
+        );
+
+    prgl_gl_4_3 = prgl_gl_multi_draw_elements_indirect != NULL
+               && prgl_gl_dispatch_compute != NULL
+               && prgl_gl_memory_barrier != NULL
+               && prgl_gl_clear_buffer_sub_data != NULL;
+    if (!prgl_gl_4_3)
+    {
+        fprintf(
+            stderr, "prgl_load_gl_extensions: Failed to load GL 4.3 "
+                    "functions, falling back to GL 3.3 paths\n"
+        );
+    }
+}
+
+bool prgl_gl_4_3_loaded(void) { return prgl_gl_4_3; }
+
+bool prgl_gl_program_binary_loaded(void) { return prgl_gl_program_binaries; }
+
+bool prgl_gl_parallel_shader_compile_loaded(void)
+{
+    return prgl_gl_parallel_shader_compile;
+}
+
+/**
+ * Loads the program binary entry points, core in GL 4.1 and available on
+ * older contexts through ARB_get_program_binary.
+ */
+static void prgl_load_program_binary(void)
+{
+    prgl_gl_program_binaries = false;
+    if ((GLVersion.major < 4 || (GLVersion.major == 4 && GLVersion.minor < 1))
+        && !glfwExtensionSupported("GL_ARB_get_program_binary"))
+    {
+        return;
+    }
+
+    prgl_gl_get_program_binary =
+        (PFNPRGLGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+    prgl_gl_program_binary =
+        (PFNPRGLPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+    prgl_gl_program_parameteri =
+        (PFNPRGLPROGRAMPARAMETERIPROC)glfwGetProcAddress(
+            "glProgramParameteri"
+        );
+
+    // Drivers may support the functions without any formats to save in
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    prgl_gl_program_binaries = prgl_gl_get_program_binary != NULL
+                            && prgl_gl_program_binary != NULL
+                            && prgl_gl_program_parameteri != NULL
+                            && num_formats > 0;
+}
+
+/**
+ * Loads KHR_parallel_shader_compile, or the ARB version which has the same
+ * enum, and lets the driver pick how many compiler threads to use.
+ */
+static void prgl_load_parallel_shader_compile(void)
+{
+    prgl_gl_parallel_shader_compile = false;
+    prgl_gl_max_shader_compiler_threads = NULL;
+    if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+    {
+        prgl_gl_max_shader_compiler_threads =
+            (PFNPRGLMAXSHADERCOMPILERTHREADSPROC)glfwGetProcAddress(
+                "glMaxShaderCompilerThreadsKHR"
+            );
+    }
+    else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+    {
+        prgl_gl_max_shader_compiler_threads =
+            (PFNPRGLMAXSHADERCOMPILERTHREADSPROC)glfwGetProcAddress(
+                "glMaxShaderCompilerThreadsARB"
+            );
+    }
+
+    if (prgl_gl_max_shader_compiler_threads == NULL)
+    {
+        return;
+    }
+
+    // All ones means implementation defined, the extension's default
+    prgl_gl_max_shader_compiler_threads(0xFFFFFFFFu);
+    prgl_gl_parallel_shader_compile = true;
+}
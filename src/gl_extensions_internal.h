@@ -0,0 +1,116 @@
+#ifndef PRGL_GL_EXTENSIONS_INTERNAL_H
+#define PRGL_GL_EXTENSIONS_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "glad.h"
+
+// The loader only covers GL 3.3, the GL 4.3 enums prgl uses are defined here
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void(APIENTRYP PFNPRGLMULTIDRAWELEMENTSINDIRECTPROC)(
+    GLenum mode, GLenum type, const void *indirect, GLsizei drawcount,
+    GLsizei stride
+);
+typedef void(APIENTRYP PFNPRGLDISPATCHCOMPUTEPROC)(
+    GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z
+);
+typedef void(APIENTRYP PFNPRGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void(APIENTRYP PFNPRGLCLEARBUFFERSUBDATAPROC)(
+    GLenum target, GLenum internalformat, GLintptr offset, GLsizeiptr size,
+    GLenum format, GLenum type, const void *data
+);
+
+typedef void(APIENTRYP PFNPRGLGETPROGRAMBINARYPROC)(
+    GLuint program, GLsizei buf_size, GLsizei *length, GLenum *binary_format,
+    void *binary
+);
+typedef void(APIENTRYP PFNPRGLPROGRAMBINARYPROC)(
+    GLuint program, GLenum binary_format, const void *binary, GLsizei length
+);
+typedef void(APIENTRYP PFNPRGLPROGRAMPARAMETERIPROC)(
+    GLuint program, GLenum pname, GLint value
+);
+typedef void(APIENTRYP PFNPRGLMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+/**
+ * Layout of one draw in an indirect buffer, fixed by GL.
+ */
+struct PRGLDrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+};
+
+// GL 4.3 entry points, NULL unless prgl_gl_4_3_loaded() is true
+extern PFNPRGLMULTIDRAWELEMENTSINDIRECTPROC
+    prgl_gl_multi_draw_elements_indirect;
+extern PFNPRGLDISPATCHCOMPUTEPROC prgl_gl_dispatch_compute;
+extern PFNPRGLMEMORYBARRIERPROC prgl_gl_memory_barrier;
+extern PFNPRGLCLEARBUFFERSUBDATAPROC prgl_gl_clear_buffer_sub_data;
+
+// GL 4.1 or ARB_get_program_binary entry points, NULL unless
+// prgl_gl_program_binary_loaded() is true
+extern PFNPRGLGETPROGRAMBINARYPROC prgl_gl_get_program_binary;
+extern PFNPRGLPROGRAMBINARYPROC prgl_gl_program_binary;
+extern PFNPRGLPROGRAMPARAMETERIPROC prgl_gl_program_parameteri;
+
+// KHR or ARB_parallel_shader_compile entry point, NULL unless
+// prgl_gl_parallel_shader_compile_loaded() is true
+extern PFNPRGLMAXSHADERCOMPILERTHREADSPROC
+    prgl_gl_max_shader_compiler_threads;
+
+/**
+ * Loads the GL 4.1 and 4.3 entry points and the extensions prgl uses if the
+ * current context supports them. Should be called once after the loader has
+ * been initialized.
+ */
+void prgl_load_gl_extensions(void);
+
+/**
+ * @return True if every GL 4.3 entry point was loaded.
+ */
+bool prgl_gl_4_3_loaded(void);
+
+/**
+ * @return True if the program binary entry points were loaded and the driver
+ * has at least one binary format.
+ */
+bool prgl_gl_program_binary_loaded(void);
+
+/**
+ * @return True if the driver compiles shaders in the background and programs
+ * can be polled with GL_COMPLETION_STATUS_KHR without blocking.
+ */
+bool prgl_gl_parallel_shader_compile_loaded(void);
+
+#endif
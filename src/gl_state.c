@@ -0,0 +1,228 @@
+#include "glad.h"
+
+#include "gl_state_internal.h"
+#include "render.h"
+
+#include <limits.h>
+
+// Names GL never generates, used for state that hasn't been set through prgl
+#define PRGL_GL_UNKNOWN_NAME UINT_MAX
+#define PRGL_GL_UNKNOWN_INT INT_MIN
+
+enum PRGLCapabilityState
+{
+    PRGL_CAPABILITY_UNKNOWN,
+    PRGL_CAPABILITY_ENABLED,
+    PRGL_CAPABILITY_DISABLED
+};
+
+enum PRGLTrackedCapability
+{
+    PRGL_TRACKED_CAPABILITY_DEPTH_TEST,
+    PRGL_TRACKED_CAPABILITY_CULL_FACE,
+    PRGL_TRACKED_CAPABILITY_BLEND,
+    PRGL_TRACKED_CAPABILITY_COUNT,
+    PRGL_TRACKED_CAPABILITY_NONE = PRGL_TRACKED_CAPABILITY_COUNT
+};
+
+/**
+ * Shadow copy of the GL state prgl changes. Anything set outside of prgl makes
+ * this stale, see prgl_reset_gl_state_cache().
+ */
+struct PRGLGLState
+{
+    GLuint program;
+    GLuint vao;
+    GLuint fbo;
+    GLuint active_texture_unit;
+    GLuint textures_2d[PRGL_GL_STATE_TEXTURE_UNITS];
+    GLint viewport[4];
+    enum PRGLCapabilityState capabilities[PRGL_TRACKED_CAPABILITY_COUNT];
+};
+
+static struct PRGLGLState prgl_gl_state;
+static bool prgl_gl_state_initialized = false;
+
+static void prgl_ensure_gl_state(void);
+static enum PRGLTrackedCapability prgl_tracked_capability(GLenum capability);
+
+void prgl_gl_use_program(GLuint program)
+{
+    prgl_ensure_gl_state();
+    if (prgl_gl_state.program != program)
+    {
+        glUseProgram(program);
+        prgl_gl_state.program = program;
+    }
+}
+
+void prgl_gl_bind_vertex_array(GLuint vao)
+{
+    prgl_ensure_gl_state();
+    if (prgl_gl_state.vao != vao)
+    {
+        glBindVertexArray(vao);
+        prgl_gl_state.vao = vao;
+    }
+}
+
+void prgl_gl_bind_texture_2d(GLuint unit, GLuint texture)
+{
+    prgl_ensure_gl_state();
+    if (unit < PRGL_GL_STATE_TEXTURE_UNITS
+        && prgl_gl_state.textures_2d[unit] == texture)
+    {
+        return;
+    }
+
+    if (prgl_gl_state.active_texture_unit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        prgl_gl_state.active_texture_unit = unit;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    if (unit < PRGL_GL_STATE_TEXTURE_UNITS)
+    {
+        prgl_gl_state.textures_2d[unit] = texture;
+    }
+}
+
+void prgl_gl_bind_texture_buffer(GLuint unit, GLuint texture)
+{
+    prgl_ensure_gl_state();
+    if (prgl_gl_state.active_texture_unit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        prgl_gl_state.active_texture_unit = unit;
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+}
+
+void prgl_gl_bind_framebuffer(GLuint fbo)
+{
+    prgl_ensure_gl_state();
+    if (prgl_gl_state.fbo != fbo)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        prgl_gl_state.fbo = fbo;
+    }
+}
+
+void prgl_gl_viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    prgl_ensure_gl_state();
+    GLint *const viewport = prgl_gl_state.viewport;
+    if (viewport[0] != x || viewport[1] != y || viewport[2] != width
+        || viewport[3] != height)
+    {
+        glViewport(x, y, width, height);
+        viewport[0] = x;
+        viewport[1] = y;
+        viewport[2] = width;
+        viewport[3] = height;
+    }
+}
+
+void prgl_gl_set_capability(GLenum capability, bool enabled)
+{
+    prgl_ensure_gl_state();
+    const enum PRGLTrackedCapability tracked =
+        prgl_tracked_capability(capability);
+    const enum PRGLCapabilityState state =
+        enabled ? PRGL_CAPABILITY_ENABLED : PRGL_CAPABILITY_DISABLED;
+
+    if (tracked != PRGL_TRACKED_CAPABILITY_NONE)
+    {
+        if (prgl_gl_state.capabilities[tracked] == state)
+        {
+            return;
+        }
+        prgl_gl_state.capabilities[tracked] = state;
+    }
+
+    if (enabled)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+}
+
+void prgl_gl_delete_vertex_array(GLuint vao)
+{
+    prgl_ensure_gl_state();
+
+    // Deleting a bound VAO reverts the binding to zero
+    if (prgl_gl_state.vao == vao)
+    {
+        prgl_gl_state.vao = 0;
+    }
+    glDeleteVertexArrays(1, &vao);
+}
+
+void prgl_gl_delete_program(GLuint program)
+{
+    prgl_ensure_gl_state();
+
+    // A program in use is only flagged for deletion and stays current, so it
+    // has to be forgotten to make sure the next use calls glUseProgram again
+    if (prgl_gl_state.program == program)
+    {
+        prgl_gl_state.program = PRGL_GL_UNKNOWN_NAME;
+    }
+    glDeleteProgram(program);
+}
+
+void prgl_reset_gl_state_cache(void)
+{
+    prgl_gl_state.program = PRGL_GL_UNKNOWN_NAME;
+    prgl_gl_state.vao = PRGL_GL_UNKNOWN_NAME;
+    prgl_gl_state.fbo = PRGL_GL_UNKNOWN_NAME;
+    prgl_gl_state.active_texture_unit = PRGL_GL_UNKNOWN_NAME;
+    for (int i = 0; i < PRGL_GL_STATE_TEXTURE_UNITS; i++)
+    {
+        prgl_gl_state.textures_2d[i] = PRGL_GL_UNKNOWN_NAME;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        prgl_gl_state.viewport[i] = PRGL_GL_UNKNOWN_INT;
+    }
+    for (int i = 0; i < PRGL_TRACKED_CAPABILITY_COUNT; i++)
+    {
+        prgl_gl_state.capabilities[i] = PRGL_CAPABILITY_UNKNOWN;
+    }
+    prgl_gl_state_initialized = true;
+}
+
+/**
+ * Marks all state as unknown the first time any state is set.
+ */
+static void prgl_ensure_gl_state(void)
+{
+    if (!prgl_gl_state_initialized)
+    {
+        prgl_reset_gl_state_cache();
+    }
+}
+
+/**
+ * @return The slot for the capability, PRGL_TRACKED_CAPABILITY_NONE if it
+ * isn't tracked.
+ */
+static enum PRGLTrackedCapability prgl_tracked_capability(GLenum capability)
+{
+    switch (capability)
+    {
+        case GL_DEPTH_TEST:
+            return PRGL_TRACKED_CAPABILITY_DEPTH_TEST;
+        case GL_CULL_FACE:
+            return PRGL_TRACKED_CAPABILITY_CULL_FACE;
+        case GL_BLEND:
+            return PRGL_TRACKED_CAPABILITY_BLEND;
+        default:
+            return PRGL_TRACKED_CAPABILITY_NONE;
+    }
+}
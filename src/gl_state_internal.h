@@ -0,0 +1,87 @@
+#ifndef PRGL_GL_STATE_INTERNAL_H
+#define PRGL_GL_STATE_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "glad.h"
+
+/**
+ * Number of texture units whose bindings are tracked. Binds to higher units
+ * are always passed through to GL.
+ */
+#define PRGL_GL_STATE_TEXTURE_UNITS 16
+
+/**
+ * Sets the program in use if it isn't already.
+ *
+ * @param program
+ */
+void prgl_gl_use_program(GLuint program);
+
+/**
+ * Binds a vertex array object if it isn't already bound.
+ *
+ * @param vao
+ */
+void prgl_gl_bind_vertex_array(GLuint vao);
+
+/**
+ * Binds a 2D texture to a texture unit if it isn't already bound there. The
+ * active texture unit is only changed when needed.
+ *
+ * @param unit Index of the texture unit, 0 for GL_TEXTURE0.
+ * @param texture
+ */
+void prgl_gl_bind_texture_2d(GLuint unit, GLuint texture);
+
+/**
+ * Binds a buffer texture to a texture unit. Buffer texture bindings aren't
+ * tracked, but the active texture unit is kept in sync.
+ *
+ * @param unit Index of the texture unit, 0 for GL_TEXTURE0.
+ * @param texture
+ */
+void prgl_gl_bind_texture_buffer(GLuint unit, GLuint texture);
+
+/**
+ * Binds a framebuffer to GL_FRAMEBUFFER if it isn't already bound.
+ *
+ * @param fbo
+ */
+void prgl_gl_bind_framebuffer(GLuint fbo);
+
+/**
+ * Sets the viewport if it has changed.
+ *
+ * @param x
+ * @param y
+ * @param width
+ * @param height
+ */
+void prgl_gl_viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+/**
+ * Enables or disables a server side capability if it isn't already in that
+ * state. GL_DEPTH_TEST, GL_CULL_FACE and GL_BLEND are tracked, anything else
+ * is always passed through to GL.
+ *
+ * @param capability
+ * @param enabled
+ */
+void prgl_gl_set_capability(GLenum capability, bool enabled);
+
+/**
+ * Deletes a vertex array object and forgets it if it was bound.
+ *
+ * @param vao
+ */
+void prgl_gl_delete_vertex_array(GLuint vao);
+
+/**
+ * Deletes a program and forgets it if it was in use.
+ *
+ * @param program
+ */
+void prgl_gl_delete_program(GLuint program);
+
+#endif
@@ -0,0 +1,345 @@
+#include "glad.h"
+
+#include "gpu_culling_internal.h"
+#include "render.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "culling_internal.h"
+#include "gl_extensions_internal.h"
+#include "render_internal.h"
+#include "render_queue_internal.h"
+#include "shaders.h"
+#include "shaders_init_internal.h"
+#include "shaders_internal.h"
+
+// Must match the compute shader's local size and buffer bindings
+static const GLuint CULL_GROUP_SIZE = 64;
+static const GLuint CULL_INSTANCES_BINDING = 0;
+static const GLuint CULL_BOUNDS_BINDING = 1;
+static const GLuint CULL_COMMANDS_BINDING = 2;
+static const GLuint CULL_VISIBLE_COMMANDS_BINDING = 3;
+static const GLuint CULL_RESULTS_BINDING = 4;
+
+// Spheres this close to a plane may land either side on the CPU and the GPU
+static const float VALIDATION_TOLERANCE = 1e-3f;
+
+static bool prgl_gpu_culling_enabled = true;
+static bool prgl_gpu_culling_validated = false;
+
+static PRGLShader prgl_cull_shader = {0};
+static bool prgl_cull_shader_set_up = false;
+static PRGLUniform prgl_cull_planes_uniform;
+static PRGLUniform prgl_cull_num_draws_uniform;
+
+// Inputs are orphaned and refilled on every cull, all are sized for
+// prgl_cull_buffer_draws draws
+static GLuint prgl_cull_bounds_buffer = 0;
+static GLuint prgl_cull_commands_buffer = 0;
+static GLuint prgl_cull_visible_commands_buffer = 0;
+static GLuint prgl_cull_results_buffer = 0;
+static int prgl_cull_buffer_draws = 0;
+
+static bool prgl_set_up_cull_shader(void);
+static void prgl_reserve_cull_buffers(int num_draws);
+static int prgl_validate_gpu_culling(
+    const struct PRGLDrawElementsIndirectCommand *const commands,
+    vec4 bounds[], int num_draws
+);
+
+void prgl_set_gpu_culling_enabled(bool enabled)
+{
+    prgl_gpu_culling_enabled = enabled;
+}
+
+void prgl_set_gpu_culling_validation(bool enabled)
+{
+    prgl_gpu_culling_validated = enabled;
+}
+
+void prgl_init_gpu_culling(void)
+{
+    if (!prgl_gl_4_3_loaded())
+    {
+        return;
+    }
+
+    // Set up once it has compiled, draws are culled on the CPU until then
+    prgl_cull_shader = prgl_init_shader_frustum_cull();
+    prgl_cull_shader_set_up = false;
+
+    glGenBuffers(1, &prgl_cull_bounds_buffer);
+    glGenBuffers(1, &prgl_cull_commands_buffer);
+    glGenBuffers(1, &prgl_cull_visible_commands_buffer);
+    glGenBuffers(1, &prgl_cull_results_buffer);
+    prgl_cull_buffer_draws = 0;
+}
+
+void prgl_delete_gpu_culling(void)
+{
+    if (prgl_cull_shader.id == 0)
+    {
+        return;
+    }
+
+    prgl_delete_shader(prgl_cull_shader);
+    prgl_cull_shader = (PRGLShader){0};
+    prgl_cull_shader_set_up = false;
+    glDeleteBuffers(1, &prgl_cull_bounds_buffer);
+    glDeleteBuffers(1, &prgl_cull_commands_buffer);
+    glDeleteBuffers(1, &prgl_cull_visible_commands_buffer);
+    glDeleteBuffers(1, &prgl_cull_results_buffer);
+    prgl_cull_bounds_buffer = 0;
+    prgl_cull_commands_buffer = 0;
+    prgl_cull_visible_commands_buffer = 0;
+    prgl_cull_results_buffer = 0;
+    prgl_cull_buffer_draws = 0;
+}
+
+bool prgl_gpu_culling_active(void)
+{
+    vec4 planes[6];
+    return prgl_gpu_culling_enabled && prgl_cull_shader.id != 0
+        && prgl_culling_frustum_planes(planes) && prgl_set_up_cull_shader();
+}
+
+GLuint prgl_gpu_cull_draws(
+    const struct PRGLDrawElementsIndirectCommand *const commands,
+    vec4 bounds[], int num_draws
+)
+{
+    prgl_reserve_cull_buffers(num_draws);
+
+    const GLsizeiptr commands_size =
+        sizeof(struct PRGLDrawElementsIndirectCommand) * num_draws;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_cull_bounds_buffer);
+    glBufferSubData(
+        GL_SHADER_STORAGE_BUFFER, 0, sizeof(vec4) * num_draws, bounds
+    );
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_cull_commands_buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, commands_size, commands);
+
+    // Zeroed commands draw nothing, and the visible count starts at zero
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_cull_visible_commands_buffer);
+    prgl_gl_clear_buffer_sub_data(
+        GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, commands_size, GL_RED_INTEGER,
+        GL_UNSIGNED_INT, NULL
+    );
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_cull_results_buffer);
+    prgl_gl_clear_buffer_sub_data(
+        GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER,
+        GL_UNSIGNED_INT, NULL
+    );
+
+    glBindBufferBase(
+        GL_SHADER_STORAGE_BUFFER, CULL_INSTANCES_BINDING,
+        prgl_instance_buffer()
+    );
+    glBindBufferBase(
+        GL_SHADER_STORAGE_BUFFER, CULL_BOUNDS_BINDING, prgl_cull_bounds_buffer
+    );
+    glBindBufferBase(
+        GL_SHADER_STORAGE_BUFFER, CULL_COMMANDS_BINDING,
+        prgl_cull_commands_buffer
+    );
+    glBindBufferBase(
+        GL_SHADER_STORAGE_BUFFER, CULL_VISIBLE_COMMANDS_BINDING,
+        prgl_cull_visible_commands_buffer
+    );
+    glBindBufferBase(
+        GL_SHADER_STORAGE_BUFFER, CULL_RESULTS_BINDING,
+        prgl_cull_results_buffer
+    );
+
+    vec4 planes[6];
+    prgl_culling_frustum_planes(planes);
+    prgl_use_shader(prgl_cull_shader);
+    glUniform4fv(prgl_cull_planes_uniform.location, 6, (const GLfloat *)planes);
+    prgl_set_uniform_int(prgl_cull_num_draws_uniform, num_draws);
+    prgl_gl_dispatch_compute(
+        (num_draws + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1
+    );
+
+    // Visible order depends on which invocation got there first, which is
+    // fine for opaque draws since the depth test decides what's in front
+    GLbitfield barriers = GL_COMMAND_BARRIER_BIT;
+    if (prgl_gpu_culling_validated)
+    {
+        barriers |= GL_BUFFER_UPDATE_BARRIER_BIT;
+    }
+    prgl_gl_memory_barrier(barriers);
+
+    const int mismatches = prgl_gpu_culling_validated
+        ? prgl_validate_gpu_culling(commands, bounds, num_draws)
+        : 0;
+    prgl_count_gpu_culling(num_draws, mismatches);
+
+    return prgl_cull_visible_commands_buffer;
+}
+
+/**
+ * Gets the culling shader's uniforms once it has finished compiling.
+ *
+ * @return True if the shader is ready to dispatch.
+ */
+static bool prgl_set_up_cull_shader(void)
+{
+    if (prgl_cull_shader_set_up)
+    {
+        return true;
+    }
+    if (!prgl_shader_ready(prgl_cull_shader))
+    {
+        return false;
+    }
+
+    const PRGLShader previous_shader = prgl_current_shader();
+    prgl_cull_planes_uniform =
+        prgl_uniform_handle(prgl_cull_shader, "frustumPlanes");
+    prgl_cull_num_draws_uniform =
+        prgl_uniform_handle(prgl_cull_shader, "numDraws");
+
+    // The instance layout never changes, so the stride is only set once
+    prgl_use_shader(prgl_cull_shader);
+    prgl_set_uniform_int(
+        prgl_uniform_handle(prgl_cull_shader, "instanceStride"),
+        PRGL_INSTANCE_STRIDE_LENGTH
+    );
+    prgl_use_shader(previous_shader);
+
+    prgl_cull_shader_set_up = true;
+    return true;
+}
+
+/**
+ * Makes sure the culling buffers can hold the given number of draws. The
+ * contents are lost when they grow.
+ *
+ * @param num_draws
+ */
+static void prgl_reserve_cull_buffers(int num_draws)
+{
+    if (num_draws <= prgl_cull_buffer_draws)
+    {
+        return;
+    }
+
+    int capacity = prgl_cull_buffer_draws == 0 ? 256 : prgl_cull_buffer_draws;
+    while (capacity < num_draws)
+    {
+        capacity *= 2;
+    }
+
+    const GLsizeiptr commands_size =
+        sizeof(struct PRGLDrawElementsIndirectCommand) * capacity;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_cull_bounds_buffer);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, sizeof(vec4) * capacity, NULL, GL_STREAM_DRAW
+    );
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_cull_commands_buffer);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, commands_size, NULL, GL_STREAM_DRAW
+    );
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_cull_visible_commands_buffer);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, commands_size, NULL, GL_STREAM_COPY
+    );
+
+    // The visible count followed by a flag per draw
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_cull_results_buffer);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * (1 + capacity), NULL,
+        GL_STREAM_READ
+    );
+
+    prgl_cull_buffer_draws = capacity;
+}
+
+/**
+ * Reads back the visibility the compute pass wrote and compares it with the
+ * CPU frustum test, printing the draws they disagree on. Spheres touching a
+ * plane within VALIDATION_TOLERANCE are allowed to go either way.
+ *
+ * @param commands[in]
+ * @param bounds[in]
+ * @param num_draws
+ * @return The number of draws the tests disagreed on.
+ */
+static int prgl_validate_gpu_culling(
+    const struct PRGLDrawElementsIndirectCommand *const commands,
+    vec4 bounds[], int num_draws
+)
+{
+    // The draws' instances are read back in one range and looked up in memory
+    GLuint first_instance = commands[0].base_instance;
+    GLuint end_instance = first_instance + 1;
+    for (int i = 1; i < num_draws; i++)
+    {
+        const GLuint instance = commands[i].base_instance;
+        first_instance = instance < first_instance ? instance : first_instance;
+        end_instance = instance >= end_instance ? instance + 1 : end_instance;
+    }
+    const size_t num_floats = (size_t)PRGL_INSTANCE_STRIDE_LENGTH
+                            * (end_instance - first_instance);
+
+    GLuint *const flags = malloc(sizeof(GLuint) * num_draws);
+    GLfloat *const instances = malloc(sizeof(GLfloat) * num_floats);
+    if (flags == NULL || instances == NULL)
+    {
+        fprintf(
+            stderr, "prgl_validate_gpu_culling: Failed to allocate readback "
+                    "memory for %d draws\n",
+            num_draws
+        );
+        free(flags);
+        free(instances);
+        return 0;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_cull_results_buffer);
+    glGetBufferSubData(
+        GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), sizeof(GLuint) * num_draws,
+        flags
+    );
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, prgl_instance_buffer());
+    glGetBufferSubData(
+        GL_SHADER_STORAGE_BUFFER,
+        sizeof(GLfloat) * PRGL_INSTANCE_STRIDE_LENGTH * first_instance,
+        sizeof(GLfloat) * num_floats, instances
+    );
+
+    int mismatches = 0;
+    for (int i = 0; i < num_draws; i++)
+    {
+        mat4 model;
+        memcpy(
+            model,
+            &instances[PRGL_INSTANCE_STRIDE_LENGTH
+                       * (commands[i].base_instance - first_instance)],
+            sizeof(mat4)
+        );
+
+        const float margin = prgl_sphere_frustum_margin(bounds[i], model);
+        if (fabsf(margin) <= VALIDATION_TOLERANCE
+            || (margin >= 0.0f) == (flags[i] != 0))
+        {
+            continue;
+        }
+
+        mismatches++;
+        fprintf(
+            stderr,
+            "prgl_validate_gpu_culling: Draw %d is %s on the GPU but %s on "
+            "the CPU, margin %f\n",
+            i, flags[i] ? "visible" : "culled",
+            margin >= 0.0f ? "visible" : "culled", margin
+        );
+    }
+
+    free(flags);
+    free(instances);
+    return mismatches;
+}
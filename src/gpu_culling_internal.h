@@ -0,0 +1,48 @@
+#ifndef PRGL_GPU_CULLING_INTERNAL_H
+#define PRGL_GPU_CULLING_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "glad.h"
+#include "cglm/types.h"
+
+struct PRGLDrawElementsIndirectCommand;
+
+/**
+ * Starts compiling the culling compute shader and creates its buffers if the
+ * GL 4.3 functions were loaded. Should be called once after the renderer has
+ * been initialized.
+ */
+void prgl_init_gpu_culling(void);
+
+/**
+ * Deletes the culling compute shader and buffers.
+ */
+void prgl_delete_gpu_culling(void);
+
+/**
+ * @return True if multi draws should be frustum culled on the GPU this frame,
+ * which needs GPU culling to be available, compiled and enabled and frustum
+ * culling to be active.
+ */
+bool prgl_gpu_culling_active(void);
+
+/**
+ * Tests draws against the frustum in a compute pass and compacts the visible
+ * ones to the front of an indirect buffer. The rest of the buffer is zeroed,
+ * so drawing all num_draws commands from it only draws the visible ones.
+ *
+ * The model matrices are read from the instance buffer at each command's base
+ * instance, so the instance data must already be uploaded.
+ *
+ * @param commands[in]
+ * @param bounds[in] Local bounding sphere of each command's mesh.
+ * @param num_draws
+ * @return The buffer holding the compacted commands.
+ */
+GLuint prgl_gpu_cull_draws(
+    const struct PRGLDrawElementsIndirectCommand *const commands,
+    vec4 bounds[], int num_draws
+);
+
+#endif
@@ -0,0 +1,477 @@
+#include "glad.h"
+
+#include "light_clusters_internal.h"
+#include "lighting.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cglm/mat4.h"
+#include "frame_uniforms_internal.h"
+#include "gl_state_internal.h"
+#include "lighting_internal.h"
+#include "render.h"
+
+const char *const PRGL_LIGHT_CLUSTERS_UNIFORM_BLOCK = "PRGLLightClusters";
+const char *const PRGL_LIGHT_CLUSTER_GRID_SAMPLER = "lightClusterGrid";
+const char *const PRGL_LIGHT_CLUSTER_INDICES_SAMPLER = "lightClusterIndices";
+
+// Render pixels along each side of a cluster, and the number of depth slices
+// between the near and far planes, which get deeper exponentially
+static const int CLUSTER_SIZE = 20;
+static const int CLUSTER_SLICES = 24;
+
+// Light count marking a cluster whose lights didn't fit the index buffer, its
+// vertices evaluate every light instead
+static const GLuint CLUSTER_OVERFLOW = 0xFFFFFFFFu;
+
+/**
+ * The PRGLLightClusters block as laid out with std140. A vertex's slice is
+ * floor(log(depth) * depth_slicing[0] + depth_slicing[1]). Zero counts turn
+ * clustering off, so every vertex evaluates every light.
+ */
+struct PRGLLightClusterUniforms
+{
+    GLint counts[4];
+    GLfloat depth_slicing[4];
+};
+
+/**
+ * The clusters a light reaches along each axis, inclusive.
+ */
+struct PRGLLightClusterRange
+{
+    int min[3];
+    int max[3];
+};
+
+static bool prgl_clustered_lighting_enabled = true;
+
+static GLuint prgl_clusters_ubo = 0;
+static GLuint prgl_cluster_grid_buffer = 0;
+static GLuint prgl_cluster_grid_texture = 0;
+static GLuint prgl_cluster_indices_buffer = 0;
+static GLuint prgl_cluster_indices_texture = 0;
+
+static int prgl_cluster_counts[3] = {0};
+static int prgl_num_clusters = 0;
+
+// Offset into the index list and light count of each cluster, and the next
+// index of each cluster to fill while building
+static GLuint *prgl_cluster_grid = NULL;
+static GLuint *prgl_cluster_fill = NULL;
+static GLushort *prgl_cluster_indices = NULL;
+static GLuint prgl_cluster_indices_capacity = 0;
+static GLuint prgl_max_cluster_indices = 0;
+
+static struct PRGLLightClusterRange prgl_light_ranges[PRGL_MAX_POINT_LIGHTS];
+static bool prgl_light_clustered[PRGL_MAX_POINT_LIGHTS];
+
+// What the clusters were last built for, so unchanged frames are skipped
+static bool prgl_clusters_built = false;
+static bool prgl_clusters_built_enabled = false;
+static unsigned prgl_clusters_lights_version = 0;
+static unsigned prgl_clusters_camera_version = 0;
+
+static bool prgl_build_light_clusters(
+    mat4 view, mat4 projection, const float depth_range[2],
+    const float depth_slicing[2]
+);
+static bool prgl_light_cluster_range(
+    int light, mat4 view, mat4 projection, const float depth_range[2],
+    const float depth_slicing[2], struct PRGLLightClusterRange *const range
+);
+static int prgl_cluster_tile(float ndc, int axis);
+static int prgl_cluster_slice(float depth, const float depth_slicing[2]);
+
+void prgl_set_clustered_lighting_enabled(bool enabled)
+{
+    prgl_clustered_lighting_enabled = enabled;
+}
+
+void prgl_init_light_clusters(void)
+{
+    prgl_cluster_counts[0] =
+        (int)ceilf(PRGL_RENDER_RESOLUTION[0] / (float)CLUSTER_SIZE);
+    prgl_cluster_counts[1] =
+        (int)ceilf(PRGL_RENDER_RESOLUTION[1] / (float)CLUSTER_SIZE);
+    prgl_cluster_counts[2] = CLUSTER_SLICES;
+    prgl_num_clusters = prgl_cluster_counts[0] * prgl_cluster_counts[1]
+                      * prgl_cluster_counts[2];
+
+    prgl_cluster_grid = calloc(prgl_num_clusters * 2, sizeof(GLuint));
+    prgl_cluster_fill = malloc(sizeof(GLuint) * prgl_num_clusters);
+    if (prgl_cluster_grid == NULL || prgl_cluster_fill == NULL)
+    {
+        fprintf(
+            stderr, "prgl_init_light_clusters: Error allocating cluster "
+                    "memory, lights won't be clustered!\n"
+        );
+        free(prgl_cluster_grid);
+        free(prgl_cluster_fill);
+        prgl_cluster_grid = NULL;
+        prgl_cluster_fill = NULL;
+        prgl_num_clusters = 0;
+    }
+
+    GLint max_texels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+    prgl_max_cluster_indices = max_texels > 0 ? (GLuint)max_texels : 0;
+
+    // Zeroed so vertices evaluate every light until the clusters are built
+    const struct PRGLLightClusterUniforms uniforms = {{0}, {0}};
+    glGenBuffers(1, &prgl_clusters_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, prgl_clusters_ubo);
+    glBufferData(
+        GL_UNIFORM_BUFFER, sizeof(uniforms), &uniforms, GL_DYNAMIC_DRAW
+    );
+    glBindBufferBase(
+        GL_UNIFORM_BUFFER, PRGL_LIGHT_CLUSTERS_UNIFORM_BINDING,
+        prgl_clusters_ubo
+    );
+
+    // Buffer textures read whatever store their buffer has, so they're only
+    // bound once and the buffers are respecified as the lists change size
+    glGenBuffers(1, &prgl_cluster_grid_buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, prgl_cluster_grid_buffer);
+    glBufferData(
+        GL_TEXTURE_BUFFER, sizeof(GLuint) * 2 * prgl_num_clusters,
+        prgl_cluster_grid, GL_STREAM_DRAW
+    );
+    glGenBuffers(1, &prgl_cluster_indices_buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, prgl_cluster_indices_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLushort), NULL, GL_STREAM_DRAW);
+
+    glGenTextures(1, &prgl_cluster_grid_texture);
+    prgl_gl_bind_texture_buffer(
+        PRGL_LIGHT_CLUSTER_GRID_TEXTURE_UNIT, prgl_cluster_grid_texture
+    );
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, prgl_cluster_grid_buffer);
+    glGenTextures(1, &prgl_cluster_indices_texture);
+    prgl_gl_bind_texture_buffer(
+        PRGL_LIGHT_CLUSTER_INDICES_TEXTURE_UNIT, prgl_cluster_indices_texture
+    );
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R16UI, prgl_cluster_indices_buffer);
+
+    prgl_clusters_built = false;
+}
+
+void prgl_delete_light_clusters(void)
+{
+    glDeleteTextures(1, &prgl_cluster_grid_texture);
+    glDeleteTextures(1, &prgl_cluster_indices_texture);
+    glDeleteBuffers(1, &prgl_cluster_grid_buffer);
+    glDeleteBuffers(1, &prgl_cluster_indices_buffer);
+    glDeleteBuffers(1, &prgl_clusters_ubo);
+    prgl_cluster_grid_texture = 0;
+    prgl_cluster_indices_texture = 0;
+    prgl_cluster_grid_buffer = 0;
+    prgl_cluster_indices_buffer = 0;
+    prgl_clusters_ubo = 0;
+
+    free(prgl_cluster_grid);
+    free(prgl_cluster_fill);
+    free(prgl_cluster_indices);
+    prgl_cluster_grid = NULL;
+    prgl_cluster_fill = NULL;
+    prgl_cluster_indices = NULL;
+    prgl_cluster_indices_capacity = 0;
+    prgl_num_clusters = 0;
+    prgl_clusters_built = false;
+}
+
+void prgl_update_light_clusters(void)
+{
+    mat4 view;
+    mat4 projection;
+    const unsigned camera_version =
+        prgl_frame_camera_matrices(view, projection);
+    const unsigned lights_version = prgl_point_lights_version();
+    const bool enabled =
+        prgl_clustered_lighting_enabled && prgl_num_clusters > 0;
+    if (prgl_clusters_built && enabled == prgl_clusters_built_enabled
+        && camera_version == prgl_clusters_camera_version
+        && lights_version == prgl_clusters_lights_version)
+    {
+        return;
+    }
+
+    prgl_clusters_built = true;
+    prgl_clusters_built_enabled = enabled;
+    prgl_clusters_camera_version = camera_version;
+    prgl_clusters_lights_version = lights_version;
+
+    // Slicing by view depth needs a perspective projection, without one the
+    // counts stay zero so clustering is off
+    struct PRGLLightClusterUniforms uniforms = {{0}, {0}};
+    const bool perspective =
+        projection[2][3] == -1.0f && projection[3][3] == 0.0f;
+    if (enabled && perspective)
+    {
+        const float depth_range[2] = {
+            projection[3][2] / (projection[2][2] - 1.0f),
+            projection[3][2] / (projection[2][2] + 1.0f),
+        };
+        const float scale =
+            (float)CLUSTER_SLICES / logf(depth_range[1] / depth_range[0]);
+        const float depth_slicing[2] = {scale, -logf(depth_range[0]) * scale};
+
+        if (prgl_build_light_clusters(
+                view, projection, depth_range, depth_slicing
+            ))
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                uniforms.counts[i] = prgl_cluster_counts[i];
+            }
+            uniforms.depth_slicing[0] = depth_slicing[0];
+            uniforms.depth_slicing[1] = depth_slicing[1];
+        }
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, prgl_clusters_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(uniforms), &uniforms);
+}
+
+/**
+ * Counts the lights reaching each cluster, lays the clusters' lists out one
+ * after another, then fills and uploads them. Lights are listed in order so
+ * vertices add them up in the same order as without clustering.
+ *
+ * @param view
+ * @param projection
+ * @param depth_range[in] The near and far plane distances.
+ * @param depth_slicing[in] Scale and bias from log depth to slice.
+ * @return False if the index list couldn't be allocated.
+ */
+static bool prgl_build_light_clusters(
+    mat4 view, mat4 projection, const float depth_range[2],
+    const float depth_slicing[2]
+)
+{
+    const int num_x = prgl_cluster_counts[0];
+    const int num_y = prgl_cluster_counts[1];
+    memset(prgl_cluster_grid, 0, sizeof(GLuint) * 2 * prgl_num_clusters);
+
+    const int num_lights = prgl_num_point_lights();
+    for (int l = 0; l < num_lights; l++)
+    {
+        struct PRGLLightClusterRange *const range = &prgl_light_ranges[l];
+        prgl_light_clustered[l] = prgl_light_cluster_range(
+            l, view, projection, depth_range, depth_slicing, range
+        );
+        if (!prgl_light_clustered[l])
+        {
+            continue;
+        }
+
+        for (int z = range->min[2]; z <= range->max[2]; z++)
+        {
+            for (int y = range->min[1]; y <= range->max[1]; y++)
+            {
+                const int row = (z * num_y + y) * num_x;
+                for (int x = range->min[0]; x <= range->max[0]; x++)
+                {
+                    prgl_cluster_grid[(row + x) * 2 + 1]++;
+                }
+            }
+        }
+    }
+
+    GLuint num_indices = 0;
+    for (int c = 0; c < prgl_num_clusters; c++)
+    {
+        const GLuint count = prgl_cluster_grid[c * 2 + 1];
+        if (count > prgl_max_cluster_indices - num_indices)
+        {
+            prgl_cluster_grid[c * 2] = 0;
+            prgl_cluster_grid[c * 2 + 1] = CLUSTER_OVERFLOW;
+            continue;
+        }
+
+        prgl_cluster_grid[c * 2] = num_indices;
+        prgl_cluster_fill[c] = num_indices;
+        num_indices += count;
+    }
+
+    if (num_indices > prgl_cluster_indices_capacity)
+    {
+        GLuint capacity = prgl_cluster_indices_capacity == 0
+                            ? 1024
+                            : prgl_cluster_indices_capacity;
+        while (capacity < num_indices)
+        {
+            capacity *= 2;
+        }
+
+        GLushort *indices =
+            realloc(prgl_cluster_indices, sizeof(GLushort) * capacity);
+        if (indices == NULL)
+        {
+            fprintf(
+                stderr, "prgl_build_light_clusters: Error allocating %u "
+                        "cluster light indices!\n",
+                capacity
+            );
+            return false;
+        }
+        prgl_cluster_indices = indices;
+        prgl_cluster_indices_capacity = capacity;
+    }
+
+    for (int l = 0; l < num_lights; l++)
+    {
+        if (!prgl_light_clustered[l])
+        {
+            continue;
+        }
+
+        const struct PRGLLightClusterRange *const range =
+            &prgl_light_ranges[l];
+        for (int z = range->min[2]; z <= range->max[2]; z++)
+        {
+            for (int y = range->min[1]; y <= range->max[1]; y++)
+            {
+                const int row = (z * num_y + y) * num_x;
+                for (int x = range->min[0]; x <= range->max[0]; x++)
+                {
+                    const int c = row + x;
+                    if (prgl_cluster_grid[c * 2 + 1] != CLUSTER_OVERFLOW)
+                    {
+                        prgl_cluster_indices[prgl_cluster_fill[c]++] =
+                            (GLushort)l;
+                    }
+                }
+            }
+        }
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, prgl_cluster_grid_buffer);
+    glBufferData(
+        GL_TEXTURE_BUFFER, sizeof(GLuint) * 2 * prgl_num_clusters,
+        prgl_cluster_grid, GL_STREAM_DRAW
+    );
+    glBindBuffer(GL_TEXTURE_BUFFER, prgl_cluster_indices_buffer);
+    glBufferData(
+        GL_TEXTURE_BUFFER,
+        sizeof(GLushort) * (num_indices > 0 ? num_indices : 1),
+        num_indices > 0 ? prgl_cluster_indices : NULL, GL_STREAM_DRAW
+    );
+    return true;
+}
+
+/**
+ * Finds the clusters a light's sphere overlaps. The sphere is projected
+ * through the corners of its view space bounding box, which is conservative.
+ *
+ * @param light Index of the light.
+ * @param view
+ * @param projection
+ * @param depth_range[in] The near and far plane distances.
+ * @param depth_slicing[in] Scale and bias from log depth to slice.
+ * @param range[out] Receives the clusters if the light reaches any.
+ * @return False if the light can't light anything in the view.
+ */
+static bool prgl_light_cluster_range(
+    int light, mat4 view, mat4 projection, const float depth_range[2],
+    const float depth_slicing[2], struct PRGLLightClusterRange *const range
+)
+{
+    vec4 sphere;
+    prgl_point_light_sphere(light, sphere);
+    const float radius = sphere[3];
+    if (radius <= 0.0f)
+    {
+        return false;
+    }
+
+    vec4 center = {sphere[0], sphere[1], sphere[2], 1.0f};
+    glm_mat4_mulv(view, center, center);
+    const float min_depth = -center[2] - radius;
+    const float max_depth = -center[2] + radius;
+    if (max_depth < depth_range[0] || min_depth > depth_range[1])
+    {
+        return false;
+    }
+
+    range->min[2] =
+        prgl_cluster_slice(fmaxf(min_depth, depth_range[0]), depth_slicing);
+    range->max[2] =
+        prgl_cluster_slice(fminf(max_depth, depth_range[1]), depth_slicing);
+    for (int axis = 0; axis < 2; axis++)
+    {
+        range->min[axis] = 0;
+        range->max[axis] = prgl_cluster_counts[axis] - 1;
+    }
+
+    // Corners behind the near plane don't project sensibly, so spheres
+    // crossing it are taken to cover the whole view
+    if (isinf(radius) || min_depth <= depth_range[0])
+    {
+        return true;
+    }
+
+    float ndc_min[2] = {INFINITY, INFINITY};
+    float ndc_max[2] = {-INFINITY, -INFINITY};
+    for (int i = 0; i < 8; i++)
+    {
+        vec4 corner = {
+            center[0] + ((i & 1) ? radius : -radius),
+            center[1] + ((i & 2) ? radius : -radius),
+            center[2] + ((i & 4) ? radius : -radius),
+            1.0f,
+        };
+        glm_mat4_mulv(projection, corner, corner);
+        for (int axis = 0; axis < 2; axis++)
+        {
+            const float ndc = corner[axis] / corner[3];
+            ndc_min[axis] = fminf(ndc_min[axis], ndc);
+            ndc_max[axis] = fmaxf(ndc_max[axis], ndc);
+        }
+    }
+
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (ndc_max[axis] < -1.0f || ndc_min[axis] > 1.0f)
+        {
+            return false;
+        }
+        range->min[axis] = prgl_cluster_tile(ndc_min[axis], axis);
+        range->max[axis] = prgl_cluster_tile(ndc_max[axis], axis);
+    }
+    return true;
+}
+
+/**
+ * Finds the cluster column or row a coordinate is in, the same way the
+ * vertex shader does.
+ *
+ * @param ndc Normalized device coordinate.
+ * @param axis 0 for x, 1 for y.
+ * @return The column or row, clamped to the grid.
+ */
+static int prgl_cluster_tile(float ndc, int axis)
+{
+    const int count = prgl_cluster_counts[axis];
+    const int tile = (int)floorf((ndc * 0.5f + 0.5f) * (float)count);
+    return tile < 0 ? 0 : (tile >= count ? count - 1 : tile);
+}
+
+/**
+ * Finds the depth slice a view depth is in, the same way the vertex shader
+ * does.
+ *
+ * @param depth Positive view space depth.
+ * @param depth_slicing[in] Scale and bias from log depth to slice.
+ * @return The slice, clamped to the grid.
+ */
+static int prgl_cluster_slice(float depth, const float depth_slicing[2])
+{
+    const int slice =
+        (int)floorf(logf(depth) * depth_slicing[0] + depth_slicing[1]);
+    return slice < 0 ? 0
+                     : (slice >= CLUSTER_SLICES ? CLUSTER_SLICES - 1 : slice);
+}
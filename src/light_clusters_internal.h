@@ -0,0 +1,47 @@
+#ifndef PRGL_LIGHT_CLUSTERS_INTERNAL_H
+#define PRGL_LIGHT_CLUSTERS_INTERNAL_H
+
+/**
+ * Uniform buffer binding point the PRGLLightClusters block is bound to when a
+ * shader program is linked.
+ */
+#define PRGL_LIGHT_CLUSTERS_UNIFORM_BINDING 2
+
+/**
+ * Texture units the cluster buffer textures stay bound to. They're at the top
+ * of the tracked units so they don't collide with material textures.
+ */
+#define PRGL_LIGHT_CLUSTER_GRID_TEXTURE_UNIT 14
+#define PRGL_LIGHT_CLUSTER_INDICES_TEXTURE_UNIT 15
+
+/**
+ * Name of the light cluster uniform block in GLSL.
+ */
+extern const char *const PRGL_LIGHT_CLUSTERS_UNIFORM_BLOCK;
+
+/**
+ * Names of the cluster buffer texture samplers in GLSL.
+ */
+extern const char *const PRGL_LIGHT_CLUSTER_GRID_SAMPLER;
+extern const char *const PRGL_LIGHT_CLUSTER_INDICES_SAMPLER;
+
+/**
+ * Creates the cluster buffers, binds the buffer textures to their units and
+ * the uniform buffer to PRGL_LIGHT_CLUSTERS_UNIFORM_BINDING. Should be called
+ * once after lighting has been initialized.
+ */
+void prgl_init_light_clusters(void);
+
+/**
+ * Deletes the cluster buffers and frees the cluster lists.
+ */
+void prgl_delete_light_clusters(void);
+
+/**
+ * Assigns the point lights to the clusters they reach and uploads the cluster
+ * lists, if the lights or the camera matrices changed since they were last
+ * built. Should be called before drawing with a clustered variant.
+ */
+void prgl_update_light_clusters(void);
+
+#endif
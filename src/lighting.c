@@ -1,9 +1,116 @@
+#include "glad.h"
+
 #include "lighting.h"
+#include "lighting_internal.h"
 
+#include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "cglm/vec3.h"
-#include "shaders.h"
+
+const char *const PRGL_LIGHTS_UNIFORM_BLOCK = "PRGLLights";
+
+/**
+ * A point light as laid out in the PRGLLights block with std140. Attenuation
+ * constants are looked up from the intensity when the light is packed.
+ */
+struct PRGLPointLightUniforms
+{
+    vec3 position;
+    float ambient;
+    vec3 color;
+    float linear;
+    float quadratic;
+    float padding[3];
+};
+
+// The light count is padded to a vec4 before the light array
+static const GLintptr LIGHTS_UNIFORMS_ARRAY_OFFSET = 16;
+static const GLsizeiptr LIGHTS_UNIFORMS_SIZE =
+    16 + sizeof(struct PRGLPointLightUniforms) * PRGL_MAX_POINT_LIGHTS;
+
+// Half a step of an 8 bit channel, lights adding less than this to a vertex
+// can't change its color on their own
+static const float LIGHT_CUTOFF = 1.0f / 512.0f;
+
+static GLuint prgl_lights_ubo = 0;
+
+// CPU copy of what was last uploaded, used to find the lights that changed
+static struct PRGLPointLightUniforms
+    prgl_uploaded_point_lights[PRGL_MAX_POINT_LIGHTS];
+static GLint prgl_uploaded_num_point_lights = 0;
+static float prgl_point_light_radii[PRGL_MAX_POINT_LIGHTS];
+static unsigned prgl_lights_version = 0;
+
+static void prgl_pack_point_light(
+    const struct PRGLPointLight *const light,
+    struct PRGLPointLightUniforms *const packed
+);
+static float prgl_point_light_brightness(
+    const struct PRGLPointLightUniforms *const packed
+);
+static float prgl_point_light_radius(
+    const struct PRGLPointLightUniforms *const packed
+);
+
+void prgl_init_lighting(void)
+{
+    glGenBuffers(1, &prgl_lights_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, prgl_lights_ubo);
+
+    // Zeroed so the light count starts at zero
+    memset(prgl_uploaded_point_lights, 0, sizeof(prgl_uploaded_point_lights));
+    memset(prgl_point_light_radii, 0, sizeof(prgl_point_light_radii));
+    prgl_uploaded_num_point_lights = 0;
+    glBufferData(
+        GL_UNIFORM_BUFFER, LIGHTS_UNIFORMS_SIZE, NULL, GL_DYNAMIC_DRAW
+    );
+    glBufferSubData(
+        GL_UNIFORM_BUFFER, 0, sizeof(GLint), &prgl_uploaded_num_point_lights
+    );
+    glBufferSubData(
+        GL_UNIFORM_BUFFER, LIGHTS_UNIFORMS_ARRAY_OFFSET,
+        sizeof(prgl_uploaded_point_lights), prgl_uploaded_point_lights
+    );
+
+    glBindBufferBase(
+        GL_UNIFORM_BUFFER, PRGL_LIGHTS_UNIFORM_BINDING, prgl_lights_ubo
+    );
+}
+
+void prgl_delete_lighting(void)
+{
+    glDeleteBuffers(1, &prgl_lights_ubo);
+    prgl_lights_ubo = 0;
+}
+
+int prgl_num_point_lights(void) { return prgl_uploaded_num_point_lights; }
+
+void prgl_point_light_sphere(int index, vec4 dest)
+{
+    glm_vec3_copy(prgl_uploaded_point_lights[index].position, dest);
+    dest[3] = prgl_point_light_radii[index];
+}
+
+float prgl_point_light_reach(const struct PRGLPointLight *const light)
+{
+    struct PRGLPointLightUniforms packed;
+    prgl_pack_point_light(light, &packed);
+    return prgl_point_light_radius(&packed);
+}
+
+float prgl_point_light_influence(int index, float distance)
+{
+    const struct PRGLPointLightUniforms *const packed =
+        &prgl_uploaded_point_lights[index];
+    return prgl_point_light_brightness(packed)
+         / (1.0f + packed->linear * distance
+            + packed->quadratic * distance * distance);
+}
+
+unsigned prgl_point_lights_version(void) { return prgl_lights_version; }
 
 void prgl_init_point_light(struct PRGLPointLight *const light, vec3 position)
 {
@@ -21,60 +128,66 @@ void prgl_update_lighting(
     {
         num_lights = PRGL_MAX_POINT_LIGHTS;
     }
+    else if (num_lights < 0)
+    {
+        num_lights = 0;
+    }
 
-    prgl_set_shader_uniform_int(
-        prgl_current_shader(), PRGL_NUM_POINT_LIGHTS_UNIFORM, num_lights
-    );
-
-    char uniform_name_buffer[64];
+    // Find the range of lights that changed so it can be sent in one upload
+    int first_dirty = num_lights;
+    int last_dirty = -1;
     for (int i = 0; i < num_lights; i++)
     {
-        snprintf(
-            uniform_name_buffer, sizeof(uniform_name_buffer),
-            "pointLights[%d].%s", i, PRGL_LIGHT_COLOR_UNIFORM
-        );
-        prgl_set_shader_uniform_vec3(
-            prgl_current_shader(), uniform_name_buffer,
-            point_lights[i].lightColor
-        );
+        struct PRGLPointLightUniforms packed;
+        prgl_pack_point_light(&point_lights[i], &packed);
+        if (memcmp(&packed, &prgl_uploaded_point_lights[i], sizeof(packed))
+            == 0)
+        {
+            continue;
+        }
 
-        snprintf(
-            uniform_name_buffer, sizeof(uniform_name_buffer),
-            "pointLights[%d].%s", i, PRGL_LIGHT_POSITION_UNIFORM
-        );
-        prgl_set_shader_uniform_vec3(
-            prgl_current_shader(), uniform_name_buffer, point_lights[i].position
-        );
-
-        snprintf(
-            uniform_name_buffer, sizeof(uniform_name_buffer),
-            "pointLights[%d].%s", i, PRGL_LIGHT_LINEAR_UNIFORM
-        );
-        prgl_set_shader_uniform_float(
-            prgl_current_shader(), uniform_name_buffer,
-            prgl_light_attenuation_linear_constant(point_lights[i].intensity)
-        );
+        prgl_uploaded_point_lights[i] = packed;
+        prgl_point_light_radii[i] = prgl_point_light_radius(&packed);
+        first_dirty = first_dirty < i ? first_dirty : i;
+        last_dirty = i;
+    }
 
-        snprintf(
-            uniform_name_buffer, sizeof(uniform_name_buffer),
-            "pointLights[%d].%s", i, PRGL_LIGHT_QUADRATIC_UNIFORM
-        );
-        prgl_set_shader_uniform_float(
-            prgl_current_shader(), uniform_name_buffer,
-            prgl_light_attenuation_quadratic_constant(point_lights[i].intensity)
-        );
+    const bool count_dirty = num_lights != prgl_uploaded_num_point_lights;
+    if (!count_dirty && last_dirty < 0)
+    {
+        return;
+    }
 
-        snprintf(
-            uniform_name_buffer, sizeof(uniform_name_buffer),
-            "pointLights[%d].%s", i, PRGL_LIGHT_AMBIENT_UNIFORM
+    prgl_lights_version++;
+    glBindBuffer(GL_UNIFORM_BUFFER, prgl_lights_ubo);
+    if (count_dirty)
+    {
+        prgl_uploaded_num_point_lights = num_lights;
+        glBufferSubData(
+            GL_UNIFORM_BUFFER, 0, sizeof(GLint),
+            &prgl_uploaded_num_point_lights
         );
-        prgl_set_shader_uniform_float(
-            prgl_current_shader(), uniform_name_buffer,
-            prgl_light_attenuation_quadratic_constant(point_lights[i].ambient)
+    }
+    if (last_dirty >= 0)
+    {
+        glBufferSubData(
+            GL_UNIFORM_BUFFER,
+            LIGHTS_UNIFORMS_ARRAY_OFFSET
+                + sizeof(struct PRGLPointLightUniforms) * first_dirty,
+            sizeof(struct PRGLPointLightUniforms)
+                * (last_dirty - first_dirty + 1),
+            &prgl_uploaded_point_lights[first_dirty]
         );
     }
 }
 
+float prgl_point_light_ambient(const struct PRGLPointLight *const light)
+{
+    return prgl_light_attenuation_quadratic_constant(
+        (enum PRGLLightIntensity)light->ambient
+    );
+}
+
 float prgl_light_attenuation_linear_constant(enum PRGLLightIntensity intensity)
 {
     switch (intensity)
@@ -130,3 +243,72 @@ float prgl_light_attenuation_quadratic_constant(
 
     return 0.0f;
 }
+
+/**
+ * Packs a light into its std140 layout, looking up its attenuation constants.
+ *
+ * @param light[in]
+ * @param packed[out]
+ */
+static void prgl_pack_point_light(
+    const struct PRGLPointLight *const light,
+    struct PRGLPointLightUniforms *const packed
+)
+{
+    memset(packed, 0, sizeof(struct PRGLPointLightUniforms));
+    glm_vec3_copy((float *)light->position, packed->position);
+    glm_vec3_copy((float *)light->lightColor, packed->color);
+    packed->ambient = prgl_point_light_ambient(light);
+    packed->linear = prgl_light_attenuation_linear_constant(light->intensity);
+    packed->quadratic =
+        prgl_light_attenuation_quadratic_constant(light->intensity);
+}
+
+/**
+ * Gets the most a light adds to a color channel of a vertex facing it before
+ * attenuation. Diffuse is at most one, so that's the ambient plus one times
+ * the brightest channel.
+ *
+ * @param packed[in]
+ * @return The unattenuated brightness.
+ */
+static float prgl_point_light_brightness(
+    const struct PRGLPointLightUniforms *const packed
+)
+{
+    return (packed->ambient + 1.0f) * glm_vec3_max((float *)packed->color);
+}
+
+/**
+ * Finds the distance at which a light adds LIGHT_CUTOFF to a vertex facing it,
+ * by solving the shader's attenuation for that distance.
+ *
+ * @param packed[in]
+ * @return The radius, INFINITY if the light isn't attenuated.
+ */
+static float prgl_point_light_radius(
+    const struct PRGLPointLightUniforms *const packed
+)
+{
+    // 1 / attenuation must reach inverse_cutoff at the radius
+    const float inverse_cutoff =
+        prgl_point_light_brightness(packed) / LIGHT_CUTOFF;
+    if (inverse_cutoff <= 1.0f)
+    {
+        return 0.0f;
+    }
+
+    const float linear = packed->linear;
+    const float quadratic = packed->quadratic;
+    if (quadratic > 0.0f)
+    {
+        const float discriminant =
+            linear * linear + 4.0f * quadratic * (inverse_cutoff - 1.0f);
+        return (-linear + sqrtf(discriminant)) / (2.0f * quadratic);
+    }
+    if (linear > 0.0f)
+    {
+        return (inverse_cutoff - 1.0f) / linear;
+    }
+    return INFINITY;
+}
@@ -0,0 +1,87 @@
+#ifndef PRGL_LIGHTING_INTERNAL_H
+#define PRGL_LIGHTING_INTERNAL_H
+
+#include "cglm/types.h"
+
+struct PRGLPointLight;
+
+/**
+ * Uniform buffer binding point the PRGLLights block is bound to when a shader
+ * program is linked.
+ */
+#define PRGL_LIGHTS_UNIFORM_BINDING 1
+
+/**
+ * Most point lights lit shaders loop over directly. Variants built for more
+ * lights than this read the lights of each vertex's cluster instead.
+ */
+#define PRGL_MAX_UNCLUSTERED_POINT_LIGHTS 8
+
+/**
+ * Name of the point light uniform block in GLSL.
+ */
+extern const char *const PRGL_LIGHTS_UNIFORM_BLOCK;
+
+/**
+ * Creates the point light uniform buffer with no lights and binds it to
+ * PRGL_LIGHTS_UNIFORM_BINDING.
+ */
+void prgl_init_lighting(void);
+
+/**
+ * Deletes the point light uniform buffer.
+ */
+void prgl_delete_lighting(void);
+
+/**
+ * @return The number of point lights last passed to prgl_update_lighting(),
+ * clamped to PRGL_MAX_POINT_LIGHTS.
+ */
+int prgl_num_point_lights(void);
+
+/**
+ * Gets the sphere a point light can reach, outside of which it adds less than
+ * half a step of an 8 bit color channel.
+ *
+ * @param index Index of the light, less than prgl_num_point_lights().
+ * @param dest[out] The light's position and radius. The radius is INFINITY
+ * for lights without attenuation and zero for lights which add nothing.
+ */
+void prgl_point_light_sphere(int index, vec4 dest);
+
+/**
+ * Gets the ambient term the shaders use for a light. The ambient value is
+ * looked up as a light intensity's quadratic constant, as the shaders have
+ * always been given it.
+ *
+ * @param light[in]
+ * @return The ambient term.
+ */
+float prgl_point_light_ambient(const struct PRGLPointLight *const light);
+
+/**
+ * Gets how far a light reaches before it adds less than half a step of an 8
+ * bit color channel, the same as the radius of prgl_point_light_sphere().
+ *
+ * @param light[in]
+ * @return The radius, INFINITY for lights without attenuation and zero for
+ * lights which add nothing.
+ */
+float prgl_point_light_reach(const struct PRGLPointLight *const light);
+
+/**
+ * Gets the most a point light adds to any color channel of a vertex facing it
+ * at the given distance.
+ *
+ * @param index Index of the light, less than prgl_num_point_lights().
+ * @param distance
+ * @return The light's influence at that distance.
+ */
+float prgl_point_light_influence(int index, float distance);
+
+/**
+ * @return A version which changes whenever the point lights do.
+ */
+unsigned prgl_point_lights_version(void);
+
+#endif
@@ -3,27 +3,47 @@
 #include "mesh.h"
 #include "mesh_internal.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "common_macros.h"
+#include "cglm/box.h"
 #include "cglm/types.h"
 #include "cglm/vec3.h"
+#include "cglm/vec4.h"
+#include "geometry_arena_internal.h"
+#include "gl_state_internal.h"
+#include "lighting.h"
+#include "mesh_optimize_internal.h"
 #include "texture.h"
 #include "types.h"
+#include "vertex_format_internal.h"
 
-// Constants for meshes with vertices, normals, and texture coordinates. If not
-// all then these values will be different, only use in that scenario.
+// Meshes are generated with float vertices, normals, and texture coordinates,
+// and packed into a smaller vertex format when uploaded.
 static const GLint VERTEX_STRIDE_LENGTH = 8;
-static const GLint FLOAT_VERTEX_STRIDE = VERTEX_STRIDE_LENGTH * sizeof(GLfloat);
-static const GLint NORMALS_OFFSET = 3 * sizeof(GLfloat);
-static const GLint TEX_COORD_OFFSET = 6 * sizeof(GLfloat);
 
 // Normal for 2D shapes, assumes positioning on XY, thus +Z normal
 static const vec3 NORMAL_POS_Z = {0.0f, 0.0f, 1.0f};
 
-static void prgl_setup_vertex_attributes(void);
+static struct PRGLMesh *prgl_create_optimized_mesh(
+    const GLfloat vertex_data[], GLsizei num_vertices, const GLuint indices[],
+    GLsizei num_indices, enum PRGLVertexFormat format, PRGLTexture texture
+);
+static void prgl_calculate_mesh_bounds(
+    struct PRGLMesh *const mesh, const GLfloat vertex_data[],
+    GLsizei num_vertices, GLint stride_length
+);
+static struct PRGLSpriteGeometry *prgl_create_sprite_geometry(
+    const GLfloat vertex_data[], GLsizei num_vertices, const GLuint indices[],
+    GLsizei num_indices
+);
+static GLfloat *prgl_create_light_geometry(
+    const GLfloat vertex_data[], GLsizei num_vertices
+);
 static void prgl_generate_cube_sphere_point(
     vec3 point, float u, float v, vec3 face_right, vec3 face_up,
     vec3 face_normal, vec3 quad_right, vec3 quad_up
@@ -39,6 +59,7 @@ void prgl_init_mesh(
         .vao = vao,
         .vbo = vbo,
         .ebo = ebo,
+        .index_type = GL_UNSIGNED_INT,
         .texture = {.id = texture.id},
         .primitive_type = primitive_type,
     };
@@ -60,14 +81,19 @@ struct PRGLMesh *prgl_create_screen_quad(PRGLTexture texture)
         {1.0f, 1.0f}  // Top-right (y=1)
     };
     
-    const GLfloat vertex_data[20] = {
-              vertices[0][0],       vertices[0][1], vertices[0][2], 
+    // The screen shader doesn't light, so the normals are left at zero
+    const GLfloat vertex_data[32] = {
+              vertices[0][0],       vertices[0][1], vertices[0][2],
+                        0.0f,                 0.0f,           0.0f,
         texture_coords[0][0], texture_coords[0][1],
-              vertices[1][0],       vertices[1][1], vertices[1][2], 
+              vertices[1][0],       vertices[1][1], vertices[1][2],
+                        0.0f,                 0.0f,           0.0f,
         texture_coords[1][0], texture_coords[1][1],
-              vertices[2][0],       vertices[2][1], vertices[2][2], 
+              vertices[2][0],       vertices[2][1], vertices[2][2],
+                        0.0f,                 0.0f,           0.0f,
         texture_coords[2][0], texture_coords[2][1],
-              vertices[3][0],       vertices[3][1], vertices[3][2], 
+              vertices[3][0],       vertices[3][1], vertices[3][2],
+                        0.0f,                 0.0f,           0.0f,
         texture_coords[3][0], texture_coords[3][1]
     };
     // clang-format on
@@ -80,53 +106,10 @@ struct PRGLMesh *prgl_create_screen_quad(PRGLTexture texture)
         0, 2, 3  // Second triangle
     };
 
-    // Create a vertex buffer object and vertex array object, the VBO is to
-    // generate the initial data, the VAO is so we can re-use it later
-    GLuint vbo;
-    GLuint vao;
-    GLuint ebo;
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
-    glGenVertexArrays(1, &vao);
-
-    // Bind VAO, then bind and set buffers, then configure the vertex attributes
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof(vertex_data), vertex_data, GL_STATIC_DRAW
-    );
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW
-    );
-
-    // Tell OpenGL how to interpret the vertex data
-    glVertexAttribPointer(
-        0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (const GLvoid *)0
-    );
-    glEnableVertexAttribArray(0);
-
-    // Tell OpenGL how to interpret the texture coordinate data
-    glVertexAttribPointer(
-        2, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat),
-        (const GLvoid *)(intptr_t)(3 * sizeof(GLfloat))
-    );
-    glEnableVertexAttribArray(2);
-
-    struct PRGLMesh *mesh = malloc(sizeof(struct PRGLMesh));
-    if (mesh == NULL)
-    {
-        fprintf(
-            stderr, "prgl_create_screen_quad: Error allocating mesh "
-                    "pointer memory!"
-        );
-        return NULL;
-    }
-
-    prgl_init_mesh(
-        mesh, (GLuint)ARR_LEN(indices), vao, vbo, ebo, texture, GL_TRIANGLES
+    return prgl_create_optimized_mesh(
+        vertex_data, 4, indices, ARR_LEN(indices), PRGL_VERTEX_FORMAT_UNLIT,
+        texture
     );
-    return mesh;
 }
 
 PRGLMeshHandle prgl_create_triangle(PRGLTexture texture)
@@ -156,33 +139,14 @@ PRGLMeshHandle prgl_create_triangle(PRGLTexture texture)
     };
     // clang-format on
 
-    // Create a vertex buffer object and vertex array object, the VBO is to
-    // generate the initial data, the VAO is so we can re-use it later
-    GLuint vbo;
-    GLuint vao;
-    glGenBuffers(1, &vbo);
-    glGenVertexArrays(1, &vao);
-
-    // Bind VAO, then bind and set buffers, then configure the vertex attributes
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof(vertex_data), vertex_data, GL_STATIC_DRAW
+    PRGLMeshHandle mesh = prgl_create_optimized_mesh(
+        vertex_data, 3, NULL, 0, PRGL_VERTEX_FORMAT_PACKED, texture
     );
-
-    prgl_setup_vertex_attributes();
-
-    PRGLMeshHandle mesh = malloc(sizeof(struct PRGLMesh));
-    if (mesh == NULL)
+    if (mesh != NULL)
     {
-        fprintf(
-            stderr,
-            "prgl_create_triangle: Error allocating mesh pointer memory!"
-        );
-        return NULL;
+        mesh->sprite_geometry =
+            prgl_create_sprite_geometry(vertex_data, 3, NULL, 0);
     }
-
-    prgl_init_mesh(mesh, (GLuint)3, vao, vbo, 0, texture, GL_TRIANGLES);
     return mesh;
 }
 
@@ -244,40 +208,19 @@ PRGLMeshHandle prgl_create_circle(PRGLTexture texture, int num_edges)
         indices[i * 3 + 2] = (i + 1) % num_edges + 1;
     }
 
-    GLuint vbo;
-    GLuint vao;
-    GLuint ebo;
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
-    glGenVertexArrays(1, &vao);
-
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof(GLfloat) * num_vertices * VERTEX_STRIDE_LENGTH,
-        vertex_data, GL_STATIC_DRAW
+    PRGLMeshHandle mesh = prgl_create_optimized_mesh(
+        vertex_data, num_vertices, indices, num_indices,
+        PRGL_VERTEX_FORMAT_PACKED, texture
     );
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * num_edges * 3, indices,
-        GL_STATIC_DRAW
-    );
-
-    prgl_setup_vertex_attributes();
-
-    free(vertex_data);
-
-    PRGLMeshHandle mesh = malloc(sizeof(struct PRGLMesh));
-    if (mesh == NULL)
+    if (mesh != NULL)
     {
-        fprintf(
-            stderr, "prgl_create_circle: Error allocating mesh pointer memory!"
+        mesh->sprite_geometry = prgl_create_sprite_geometry(
+            vertex_data, num_vertices, indices, num_indices
         );
-        return NULL;
     }
 
-    prgl_init_mesh(mesh, num_indices, vao, vbo, ebo, texture, GL_TRIANGLES);
+    free(vertex_data);
+    free(indices);
     return mesh;
 }
 
@@ -322,41 +265,16 @@ PRGLMeshHandle prgl_create_quad(PRGLTexture texture)
         0, 2, 3  // Second triangle
     };
 
-    // Create a vertex buffer object and vertex array object, the VBO is to
-    // generate the initial data, the VAO is so we can re-use it later
-    GLuint vbo;
-    GLuint vao;
-    GLuint ebo;
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
-    glGenVertexArrays(1, &vao);
-
-    // Bind VAO, then bind and set buffers, then configure the vertex attributes
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof(vertex_data), vertex_data, GL_STATIC_DRAW
-    );
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW
+    PRGLMeshHandle mesh = prgl_create_optimized_mesh(
+        vertex_data, 4, indices, ARR_LEN(indices), PRGL_VERTEX_FORMAT_PACKED,
+        texture
     );
-
-    prgl_setup_vertex_attributes();
-
-    PRGLMeshHandle mesh = malloc(sizeof(struct PRGLMesh));
-    if (mesh == NULL)
+    if (mesh != NULL)
     {
-        fprintf(
-            stderr, "prgl_create_quad: Error allocating mesh "
-                    "pointer memory!"
+        mesh->sprite_geometry = prgl_create_sprite_geometry(
+            vertex_data, 4, indices, ARR_LEN(indices)
         );
-        return NULL;
     }
-
-    prgl_init_mesh(
-        mesh, (GLuint)ARR_LEN(indices), vao, vbo, ebo, texture, GL_TRIANGLES
-    );
     return mesh;
 }
 
@@ -396,30 +314,9 @@ PRGLMeshHandle prgl_create_pyramid(PRGLTexture texture)
     };
     // clang-format on
 
-    GLuint vbo;
-    GLuint vao;
-    glGenBuffers(1, &vbo);
-    glGenVertexArrays(1, &vao);
-
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof(vertex_data), vertex_data, GL_STATIC_DRAW
+    return prgl_create_optimized_mesh(
+        vertex_data, 18, NULL, 0, PRGL_VERTEX_FORMAT_PACKED, texture
     );
-
-    prgl_setup_vertex_attributes();
-
-    PRGLMeshHandle mesh = malloc(sizeof(struct PRGLMesh));
-    if (mesh == NULL)
-    {
-        fprintf(
-            stderr, "prgl_create_pyramid: Error allocating mesh pointer memory!"
-        );
-        return NULL;
-    }
-
-    prgl_init_mesh(mesh, (GLuint)18, vao, vbo, 0, texture, GL_TRIANGLES);
-    return mesh;
 }
 
 PRGLMeshHandle prgl_create_cube(PRGLTexture texture)
@@ -477,29 +374,9 @@ PRGLMeshHandle prgl_create_cube(PRGLTexture texture)
     };
     // clang-format on
 
-    GLuint vbo;
-    GLuint vao;
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-
-    glBindVertexArray(vao);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    prgl_setup_vertex_attributes();
-
-    PRGLMeshHandle mesh = malloc(sizeof(struct PRGLMesh));
-    if (mesh == NULL)
-    {
-        fprintf(
-            stderr, "prgl_create_cube: Error allocating mesh pointer memory!"
-        );
-        return NULL;
-    }
-
-    prgl_init_mesh(mesh, (GLuint)36, vao, vbo, 0, texture, GL_TRIANGLES);
-    return mesh;
+    return prgl_create_optimized_mesh(
+        vertices, 36, NULL, 0, PRGL_VERTEX_FORMAT_PACKED, texture
+    );
 }
 
 PRGLMeshHandle prgl_create_cube_sphere(int resolution, PRGLTexture texture)
@@ -619,33 +496,10 @@ PRGLMeshHandle prgl_create_cube_sphere(int resolution, PRGLTexture texture)
         }
     }
 
-    GLuint vbo;
-    GLuint vao;
-    glGenBuffers(1, &vbo);
-    glGenVertexArrays(1, &vao);
-
-    glBindVertexArray(vao);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof(GLfloat) * vertex_data_length, vertex_data,
-        GL_STATIC_DRAW
+    PRGLMeshHandle mesh = prgl_create_optimized_mesh(
+        vertex_data, num_vertices, NULL, 0, PRGL_VERTEX_FORMAT_SPHERE, texture
     );
-
-    prgl_setup_vertex_attributes();
     free(vertex_data);
-
-    PRGLMeshHandle mesh = malloc(sizeof(struct PRGLMesh));
-    if (mesh == NULL)
-    {
-        fprintf(
-            stderr,
-            "prgl_create_cube_sphere: Error allocating mesh pointer memory!"
-        );
-        return NULL;
-    }
-
-    prgl_init_mesh(mesh, num_vertices, vao, vbo, 0, texture, GL_TRIANGLES);
     return mesh;
 }
 
@@ -677,76 +531,293 @@ PRGLMeshHandle prgl_create_line_strip(vec3 points[], int num_points)
         vertex_data[p * 3 + 2] = points[p][2];
     }
 
-    GLuint vbo;
-    GLuint vao;
-    glGenBuffers(1, &vbo);
-    glGenVertexArrays(1, &vao);
-
-    glBindVertexArray(vao);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * num_points, vertex_data,
-        GL_STATIC_DRAW
+    struct PRGLVertexLayout layout;
+    prgl_choose_vertex_layout(
+        PRGL_VERTEX_FORMAT_POSITION, vertex_data, num_points, 3, &layout
     );
 
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)0);
-    glEnableVertexAttribArray(0);
-
-    free(vertex_data);
-
     PRGLMeshHandle mesh = malloc(sizeof(struct PRGLMesh));
-    if (mesh == NULL)
+    void *packed = malloc((size_t)layout.stride * num_points);
+    if (mesh == NULL || packed == NULL)
     {
         fprintf(
             stderr,
             "prgl_create_line_strip: Error allocating mesh pointer memory!"
         );
+        free(mesh);
+        free(packed);
+        free(vertex_data);
         return NULL;
     }
+    prgl_pack_vertices(&layout, vertex_data, num_points, 3, packed);
 
+    // Line strips are drawn as arrays, so only vertices are allocated
     prgl_init_mesh(
-        mesh, (GLuint)num_points, vao, vbo, 0, PRGL_NO_TEXTURE, GL_LINE_STRIP
+        mesh, (GLuint)num_points, 0, 0, 0, PRGL_NO_TEXTURE, GL_LINE_STRIP
     );
+    if (!prgl_allocate_geometry(
+            &layout, packed, num_points, NULL, 0, &mesh->geometry
+        ))
+    {
+        free(mesh);
+        free(packed);
+        free(vertex_data);
+        return NULL;
+    }
+    mesh->vao = prgl_geometry_vao(&mesh->geometry);
+    mesh->vbo = prgl_geometry_vbo(&mesh->geometry);
+    free(packed);
+
+    prgl_calculate_mesh_bounds(mesh, vertex_data, num_points, 3);
+    free(vertex_data);
     return mesh;
 }
 
 void prgl_delete_mesh(PRGLMeshHandle mesh)
 {
     struct PRGLMesh *internal_mesh = (struct PRGLMesh *)mesh;
-    glDeleteVertexArrays(1, &internal_mesh->vao);
-    glDeleteBuffers(1, &internal_mesh->vbo);
+    if (internal_mesh->geometry.page != NULL)
+    {
+        // The page's buffers are shared, so only the ranges are given back
+        prgl_free_geometry(&internal_mesh->geometry);
+    }
+    else
+    {
+        prgl_gl_delete_vertex_array(internal_mesh->vao);
+        glDeleteBuffers(1, &internal_mesh->vbo);
 
-    if (internal_mesh->ebo != 0)
+        if (internal_mesh->ebo != 0)
+        {
+            glDeleteBuffers(1, &internal_mesh->ebo);
+        }
+    }
+
+    if (internal_mesh->sprite_geometry != NULL)
     {
-        glDeleteBuffers(1, &internal_mesh->ebo);
+        free(internal_mesh->sprite_geometry->vertices);
+        free(internal_mesh->sprite_geometry->indices);
+        free(internal_mesh->sprite_geometry);
     }
+    prgl_clear_baked_lighting(mesh);
+    free(internal_mesh->light_geometry);
 
     free(internal_mesh);
 }
 
-static void prgl_setup_vertex_attributes(void)
+/**
+ * Welds, indexes and reorders a triangle list for the vertex cache, then packs
+ * it into a vertex format and uploads it to a shared geometry page.
+ *
+ * @param vertex_data[in] Float vertices of VERTEX_STRIDE_LENGTH floats.
+ * @param num_vertices
+ * @param indices[in] Triangle list indices, or NULL if every three vertices
+ * form a triangle.
+ * @param num_indices
+ * @param format The vertex format to pack the vertices into.
+ * @param texture
+ * @return The new mesh, or NULL if memory couldn't be allocated.
+ */
+static struct PRGLMesh *prgl_create_optimized_mesh(
+    const GLfloat vertex_data[], GLsizei num_vertices, const GLuint indices[],
+    GLsizei num_indices, enum PRGLVertexFormat format, PRGLTexture texture
+)
 {
-    // position attribute
-    glVertexAttribPointer(
-        0, 3, GL_FLOAT, GL_FALSE, FLOAT_VERTEX_STRIDE, (const GLvoid *)0
+    struct PRGLOptimizedGeometry geometry;
+    if (!prgl_optimize_geometry(
+            vertex_data, num_vertices, indices, num_indices,
+            VERTEX_STRIDE_LENGTH, &geometry
+        ))
+    {
+        return NULL;
+    }
+
+    struct PRGLVertexLayout layout;
+    prgl_choose_vertex_layout(
+        format, geometry.vertices, geometry.num_vertices, VERTEX_STRIDE_LENGTH,
+        &layout
     );
-    glEnableVertexAttribArray(0);
 
-    // normals attribute
-    glVertexAttribPointer(
-        1, 3, GL_FLOAT, GL_FALSE, FLOAT_VERTEX_STRIDE,
-        (const GLvoid *)(intptr_t)NORMALS_OFFSET
+    struct PRGLMesh *mesh = malloc(sizeof(struct PRGLMesh));
+    void *packed = malloc((size_t)layout.stride * geometry.num_vertices);
+    if (mesh == NULL || packed == NULL)
+    {
+        fprintf(
+            stderr, "prgl_create_optimized_mesh: Error allocating mesh "
+                    "pointer memory!"
+        );
+        free(mesh);
+        free(packed);
+        prgl_free_optimized_geometry(&geometry);
+        return NULL;
+    }
+    prgl_pack_vertices(
+        &layout, geometry.vertices, geometry.num_vertices, VERTEX_STRIDE_LENGTH,
+        packed
     );
-    glEnableVertexAttribArray(1);
 
-    // texture coord attribute
-    glVertexAttribPointer(
-        2, 2, GL_FLOAT, GL_FALSE, FLOAT_VERTEX_STRIDE,
-        (const GLvoid *)(intptr_t)TEX_COORD_OFFSET
+    prgl_init_mesh(
+        mesh, (GLuint)geometry.num_indices, 0, 0, 0, texture, GL_TRIANGLES
+    );
+    mesh->index_type = geometry.index_type;
+    if (!prgl_allocate_geometry(
+            &layout, packed, geometry.num_vertices, geometry.indices,
+            prgl_index_size(geometry.index_type) * geometry.num_indices,
+            &mesh->geometry
+        ))
+    {
+        free(mesh);
+        free(packed);
+        prgl_free_optimized_geometry(&geometry);
+        return NULL;
+    }
+    mesh->vao = prgl_geometry_vao(&mesh->geometry);
+    mesh->vbo = prgl_geometry_vbo(&mesh->geometry);
+    mesh->ebo = prgl_geometry_ebo(&mesh->geometry);
+    prgl_calculate_mesh_bounds(
+        mesh, geometry.vertices, geometry.num_vertices, VERTEX_STRIDE_LENGTH
     );
-    glEnableVertexAttribArray(2);
+
+    // Lighting can only be baked where there are normals, if the copy can't
+    // be made the mesh just can't be baked
+    if (format != PRGL_VERTEX_FORMAT_UNLIT)
+    {
+        mesh->light_geometry = prgl_create_light_geometry(
+            geometry.vertices, geometry.num_vertices
+        );
+    }
+
+    free(packed);
+    prgl_free_optimized_geometry(&geometry);
+    return mesh;
+}
+
+/**
+ * Calculates the local space bounding box and bounding sphere of a mesh from
+ * its vertex positions, which must be the first three floats of each vertex.
+ *
+ * @param mesh[in,out]
+ * @param vertex_data[in]
+ * @param num_vertices
+ * @param stride_length Number of floats per vertex.
+ */
+static void prgl_calculate_mesh_bounds(
+    struct PRGLMesh *const mesh, const GLfloat vertex_data[],
+    GLsizei num_vertices, GLint stride_length
+)
+{
+    glm_aabb_invalidate(mesh->aabb);
+    for (GLsizei v = 0; v < num_vertices; v++)
+    {
+        const GLfloat *const position = &vertex_data[v * stride_length];
+        glm_vec3_minv(mesh->aabb[0], (float *)position, mesh->aabb[0]);
+        glm_vec3_maxv(mesh->aabb[1], (float *)position, mesh->aabb[1]);
+    }
+
+    // Centering on the box is close enough, the radius is what keeps it tight
+    vec3 center;
+    glm_aabb_center(mesh->aabb, center);
+    float radius_squared = 0.0f;
+    for (GLsizei v = 0; v < num_vertices; v++)
+    {
+        const float distance_squared = glm_vec3_distance2(
+            center, (float *)&vertex_data[v * stride_length]
+        );
+        if (distance_squared > radius_squared)
+        {
+            radius_squared = distance_squared;
+        }
+    }
+
+    glm_vec4(center, sqrtf(radius_squared), mesh->bounding_sphere);
+}
+
+/**
+ * Copies the positions and normals of a mesh's optimized vertices so lighting
+ * can be baked into them on the CPU.
+ *
+ * @param vertex_data[in] Float vertices of VERTEX_STRIDE_LENGTH floats, with
+ * the normal after the position.
+ * @param num_vertices
+ * @return Six floats per vertex, or NULL if they couldn't be allocated.
+ */
+static GLfloat *prgl_create_light_geometry(
+    const GLfloat vertex_data[], GLsizei num_vertices
+)
+{
+    GLfloat *const light_geometry =
+        malloc(sizeof(GLfloat) * 6 * (size_t)num_vertices);
+    if (light_geometry == NULL)
+    {
+        return NULL;
+    }
+
+    for (GLsizei v = 0; v < num_vertices; v++)
+    {
+        memcpy(
+            &light_geometry[v * 6], &vertex_data[v * VERTEX_STRIDE_LENGTH],
+            sizeof(GLfloat) * 6
+        );
+    }
+    return light_geometry;
+}
+
+/**
+ * Copies the XY positions and UVs of a flat mesh so its 2D draws can be
+ * transformed on the CPU and batched.
+ *
+ * @param vertex_data[in] Interleaved position, normal, and UV data.
+ * @param num_vertices
+ * @param indices[in] Triangle list indices, NULL if the vertices are a list.
+ * @param num_indices
+ * @return The geometry, or NULL if it couldn't be allocated.
+ */
+static struct PRGLSpriteGeometry *prgl_create_sprite_geometry(
+    const GLfloat vertex_data[], GLsizei num_vertices, const GLuint indices[],
+    GLsizei num_indices
+)
+{
+    if (indices == NULL)
+    {
+        num_indices = num_vertices;
+    }
+
+    struct PRGLSpriteGeometry *const geometry =
+        malloc(sizeof(struct PRGLSpriteGeometry));
+    GLfloat *const vertices = malloc(sizeof(GLfloat) * 4 * num_vertices);
+    GLuint *const sprite_indices = malloc(sizeof(GLuint) * num_indices);
+    if (geometry == NULL || vertices == NULL || sprite_indices == NULL)
+    {
+        fprintf(
+            stderr, "prgl_create_sprite_geometry: Error allocating geometry "
+                    "memory, mesh won't be batched!\n"
+        );
+        free(geometry);
+        free(vertices);
+        free(sprite_indices);
+        return NULL;
+    }
+
+    for (GLsizei v = 0; v < num_vertices; v++)
+    {
+        const GLfloat *const vertex = &vertex_data[v * VERTEX_STRIDE_LENGTH];
+        vertices[v * 4 + 0] = vertex[0];
+        vertices[v * 4 + 1] = vertex[1];
+        vertices[v * 4 + 2] = vertex[6];
+        vertices[v * 4 + 3] = vertex[7];
+    }
+
+    for (GLsizei i = 0; i < num_indices; i++)
+    {
+        sprite_indices[i] = indices == NULL ? (GLuint)i : indices[i];
+    }
+
+    *geometry = (struct PRGLSpriteGeometry){
+        .vertices = vertices,
+        .indices = sprite_indices,
+        .num_vertices = num_vertices,
+        .num_indices = num_indices,
+    };
+    return geometry;
 }
 
 /**
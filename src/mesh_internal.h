@@ -3,6 +3,25 @@
 
 #include "glad.h"
 #include "types.h"
+#include "cglm/types.h"
+#include "geometry_arena_internal.h"
+
+struct PRGLBakedLighting;
+
+/**
+ * @brief CPU copy of a flat mesh's geometry, used to batch 2D draws.
+ */
+struct PRGLSpriteGeometry
+{
+    /// @brief Interleaved XY position and UV for each vertex.
+    GLfloat *vertices;
+
+    /// @brief Triangle list indices into vertices.
+    GLuint *indices;
+
+    GLsizei num_vertices;
+    GLsizei num_indices;
+};
 
 /**
  * @brief Defines the geometry of a 3D object.
@@ -24,9 +43,42 @@ struct PRGLMesh
     /// @brief Optional - Element Buffer Object to draw vertices with indices.
     GLuint ebo;
 
+    /// @brief Type of the EBO indices, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+    GLenum index_type;
+
+    /**
+     * @brief Where the mesh lives in a shared geometry page.
+     *
+     * The VAO, VBO and EBO are the page's when this has a page, and draws must
+     * offset by its base vertex and index offset.
+     */
+    struct PRGLGeometryAllocation geometry;
+
     /// @brief Optional - Stores the texture ID for the mesh.
     PRGLTexture texture;
 
+    /// @brief The instance buffer whose attributes are set up on the VAO, or 0.
+    GLuint instance_vbo;
+
+    /// @brief Optional - Geometry for 2D batching, NULL if it can't be batched.
+    struct PRGLSpriteGeometry *sprite_geometry;
+
+    /**
+     * @brief Optional - Float position and normal of each vertex in the
+     * geometry allocation's order, used to bake lighting. NULL if the mesh
+     * has no normals.
+     */
+    GLfloat *light_geometry;
+
+    /// @brief Optional - Baked lighting of a static mesh, NULL if not baked.
+    struct PRGLBakedLighting *baked_lighting;
+
+    /// @brief Local space bounding box, the min corner then the max corner.
+    vec3 aabb[2];
+
+    /// @brief Local space bounding sphere, xyz is the center and w the radius.
+    vec4 bounding_sphere;
+
     /**
      * @brief The type of of primitive to render.
      *
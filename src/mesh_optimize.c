@@ -0,0 +1,419 @@
+#include "glad.h"
+
+#include "mesh.h"
+#include "mesh_optimize_internal.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Entries in the simulated post-transform cache, both for reordering triangles
+// and for estimating vertex shader runs. Real caches are at least this big, a
+// bigger cache only makes the estimate pessimistic.
+static const int VERTEX_CACHE_SIZE = 16;
+
+static const uint32_t WELD_EMPTY_SLOT = UINT32_MAX;
+
+static struct PRGLMeshStats prgl_mesh_totals = {0};
+
+static GLuint *prgl_weld_vertices(
+    const GLfloat vertex_data[], GLsizei num_vertices, GLint stride_length,
+    GLsizei *const num_unique
+);
+static bool prgl_reorder_triangles(
+    GLuint indices[], GLsizei num_indices, GLsizei num_vertices
+);
+static int prgl_count_vertex_shader_runs(
+    const GLuint indices[], GLsizei num_indices, GLsizei num_vertices
+);
+
+struct PRGLMeshStats prgl_mesh_stats(void) { return prgl_mesh_totals; }
+
+bool prgl_optimize_geometry(
+    const GLfloat vertex_data[], GLsizei num_vertices, const GLuint indices[],
+    GLsizei num_indices, GLint stride_length,
+    struct PRGLOptimizedGeometry *const result
+)
+{
+    *result = (struct PRGLOptimizedGeometry){0};
+    if (indices == NULL)
+    {
+        num_indices = num_vertices;
+    }
+
+    GLsizei num_unique = 0;
+    GLuint *const remap = prgl_weld_vertices(
+        vertex_data, num_vertices, stride_length, &num_unique
+    );
+    GLuint *const welded = malloc(sizeof(GLuint) * num_indices);
+    GLuint *const first_use = malloc(sizeof(GLuint) * num_unique);
+    if (remap == NULL || welded == NULL || first_use == NULL)
+    {
+        fprintf(
+            stderr, "prgl_optimize_geometry: Error allocating mesh "
+                    "optimization memory!\n"
+        );
+        free(remap);
+        free(welded);
+        free(first_use);
+        return false;
+    }
+
+    // Point the indices at the welded vertices, dropping triangles which
+    // collapsed since they can't produce any fragments
+    GLsizei num_welded = 0;
+    for (GLsizei i = 0; i + 2 < num_indices; i += 3)
+    {
+        GLuint triangle[3];
+        for (int corner = 0; corner < 3; corner++)
+        {
+            const GLuint source =
+                indices == NULL ? (GLuint)(i + corner) : indices[i + corner];
+            triangle[corner] = remap[source];
+        }
+        if (triangle[0] == triangle[1] || triangle[1] == triangle[2]
+            || triangle[0] == triangle[2])
+        {
+            continue;
+        }
+        memcpy(&welded[num_welded], triangle, sizeof(triangle));
+        num_welded += 3;
+    }
+
+    const int source_runs =
+        indices == NULL ? num_vertices
+                        : prgl_count_vertex_shader_runs(
+                              indices, num_indices, num_vertices
+                          );
+
+    // Keeps the welded order if there isn't memory to reorder, the mesh still
+    // benefits from being indexed
+    prgl_reorder_triangles(welded, num_welded, num_unique);
+
+    // Number the vertices in the order the triangles first use them, so vertex
+    // fetches walk the buffer forwards
+    for (GLsizei v = 0; v < num_unique; v++)
+    {
+        first_use[v] = WELD_EMPTY_SLOT;
+    }
+    GLsizei num_used = 0;
+    for (GLsizei i = 0; i < num_welded; i++)
+    {
+        if (first_use[welded[i]] == WELD_EMPTY_SLOT)
+        {
+            first_use[welded[i]] = (GLuint)num_used++;
+        }
+        welded[i] = first_use[welded[i]];
+    }
+
+    result->index_type =
+        num_used <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    result->vertices = malloc(sizeof(GLfloat) * stride_length * num_used);
+    result->indices =
+        malloc(prgl_index_size(result->index_type) * (size_t)num_welded);
+    if (result->vertices == NULL || result->indices == NULL)
+    {
+        fprintf(
+            stderr, "prgl_optimize_geometry: Error allocating optimized mesh "
+                    "memory!\n"
+        );
+        free(remap);
+        free(welded);
+        free(first_use);
+        prgl_free_optimized_geometry(result);
+        return false;
+    }
+
+    // The first source vertex welded into a unique vertex is copied for it
+    for (GLsizei v = 0; v < num_vertices; v++)
+    {
+        const GLuint unique = remap[v];
+        if (first_use[unique] == WELD_EMPTY_SLOT)
+        {
+            continue;
+        }
+        memcpy(
+            &result->vertices[first_use[unique] * stride_length],
+            &vertex_data[v * stride_length], sizeof(GLfloat) * stride_length
+        );
+        first_use[unique] = WELD_EMPTY_SLOT;
+    }
+
+    for (GLsizei i = 0; i < num_welded; i++)
+    {
+        if (result->index_type == GL_UNSIGNED_SHORT)
+        {
+            ((GLushort *)result->indices)[i] = (GLushort)welded[i];
+        }
+        else
+        {
+            ((GLuint *)result->indices)[i] = welded[i];
+        }
+    }
+    result->num_vertices = num_used;
+    result->num_indices = num_welded;
+
+    prgl_mesh_totals.triangles += num_welded / 3;
+    prgl_mesh_totals.source_vertices += num_vertices;
+    prgl_mesh_totals.unique_vertices += num_used;
+    prgl_mesh_totals.source_vertex_shader_runs += source_runs;
+    prgl_mesh_totals.vertex_shader_runs +=
+        prgl_count_vertex_shader_runs(welded, num_welded, num_used);
+
+    free(remap);
+    free(welded);
+    free(first_use);
+    return true;
+}
+
+void prgl_free_optimized_geometry(struct PRGLOptimizedGeometry *const geometry)
+{
+    free(geometry->vertices);
+    free(geometry->indices);
+    *geometry = (struct PRGLOptimizedGeometry){0};
+}
+
+GLsizei prgl_index_size(GLenum index_type)
+{
+    return index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+/**
+ * Finds the vertices which are identical to an earlier vertex using a hash
+ * table over the raw vertex bytes.
+ *
+ * @param vertex_data[in]
+ * @param num_vertices
+ * @param stride_length Number of floats per vertex.
+ * @param num_unique[out] The number of distinct vertices.
+ * @return For each source vertex the index of its unique vertex, numbered in
+ * the order they're first seen. NULL if memory couldn't be allocated.
+ */
+static GLuint *prgl_weld_vertices(
+    const GLfloat vertex_data[], GLsizei num_vertices, GLint stride_length,
+    GLsizei *const num_unique
+)
+{
+    // Kept at most half full so probe sequences stay short
+    uint32_t table_size = 16;
+    while (table_size < (uint32_t)num_vertices * 2)
+    {
+        table_size *= 2;
+    }
+
+    GLuint *const remap = malloc(sizeof(GLuint) * num_vertices);
+    uint32_t *const table = malloc(sizeof(uint32_t) * table_size);
+    if (remap == NULL || table == NULL)
+    {
+        free(remap);
+        free(table);
+        return NULL;
+    }
+    for (uint32_t slot = 0; slot < table_size; slot++)
+    {
+        table[slot] = WELD_EMPTY_SLOT;
+    }
+
+    const size_t vertex_size = sizeof(GLfloat) * stride_length;
+    GLsizei unique = 0;
+    for (GLsizei v = 0; v < num_vertices; v++)
+    {
+        const GLfloat *const vertex = &vertex_data[v * stride_length];
+
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        const unsigned char *const bytes = (const unsigned char *)vertex;
+        for (size_t b = 0; b < vertex_size; b++)
+        {
+            hash = (hash ^ bytes[b]) * 16777619u;
+        }
+
+        uint32_t slot = hash & (table_size - 1);
+        while (table[slot] != WELD_EMPTY_SLOT
+               && memcmp(
+                      &vertex_data[table[slot] * stride_length], vertex,
+                      vertex_size
+                  ) != 0)
+        {
+            slot = (slot + 1) & (table_size - 1);
+        }
+
+        if (table[slot] == WELD_EMPTY_SLOT)
+        {
+            table[slot] = (uint32_t)v;
+            remap[v] = (GLuint)unique++;
+        }
+        else
+        {
+            remap[v] = remap[table[slot]];
+        }
+    }
+
+    free(table);
+    *num_unique = unique;
+    return remap;
+}
+
+/**
+ * Reorders triangles in place with Tipsify (Sander, Nehab and Barczak 2007).
+ * Triangles are emitted as fans around a vertex, and the next fan is picked
+ * from the vertices just used which will still be in the cache, falling back
+ * to recently used vertices and then to the input order.
+ *
+ * @param indices[in,out]
+ * @param num_indices
+ * @param num_vertices Number of vertices the indices refer to.
+ * @return False if memory couldn't be allocated, the order is unchanged.
+ */
+static bool prgl_reorder_triangles(
+    GLuint indices[], GLsizei num_indices, GLsizei num_vertices
+)
+{
+    const GLsizei num_triangles = num_indices / 3;
+    int *const live = calloc(num_vertices, sizeof(int));
+    int *const cache_time = calloc(num_vertices, sizeof(int));
+    int *const offsets = calloc(num_vertices + 1, sizeof(int));
+    int *const adjacency = malloc(sizeof(int) * num_indices);
+    int *const dead_end = malloc(sizeof(int) * num_indices);
+    bool *const emitted = calloc(num_triangles, sizeof(bool));
+    GLuint *const output = malloc(sizeof(GLuint) * num_indices);
+    const bool allocated = live != NULL && cache_time != NULL
+                        && offsets != NULL && adjacency != NULL
+                        && dead_end != NULL && emitted != NULL
+                        && output != NULL;
+    if (allocated && num_triangles > 0)
+    {
+        // Triangles using each vertex, filling a list moves its offset to the
+        // end of the list so they're all shifted back afterwards
+        for (GLsizei i = 0; i < num_indices; i++)
+        {
+            live[indices[i]]++;
+        }
+        for (GLsizei v = 0; v < num_vertices; v++)
+        {
+            offsets[v + 1] = offsets[v] + live[v];
+        }
+        for (GLsizei i = 0; i < num_indices; i++)
+        {
+            adjacency[offsets[indices[i]]++] = (int)(i / 3);
+        }
+        for (GLsizei v = num_vertices; v > 0; v--)
+        {
+            offsets[v] = offsets[v - 1];
+        }
+        offsets[0] = 0;
+
+        int time = VERTEX_CACHE_SIZE + 1;
+        int fanning = 0;
+        int cursor = 1;
+        int dead_end_size = 0;
+        GLsizei num_output = 0;
+        while (fanning >= 0)
+        {
+            const int candidates_start = dead_end_size;
+            for (int a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+            {
+                const int triangle = adjacency[a];
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+                emitted[triangle] = true;
+
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    const GLuint v = indices[triangle * 3 + corner];
+                    output[num_output++] = v;
+                    dead_end[dead_end_size++] = (int)v;
+                    live[v]--;
+                    if (time - cache_time[v] > VERTEX_CACHE_SIZE)
+                    {
+                        cache_time[v] = time++;
+                    }
+                }
+            }
+
+            // Prefer the oldest vertex which will still be cached after its
+            // remaining triangles are emitted
+            int next = -1;
+            int best_priority = -1;
+            for (int c = candidates_start; c < dead_end_size; c++)
+            {
+                const int v = dead_end[c];
+                if (live[v] <= 0)
+                {
+                    continue;
+                }
+                int priority = 0;
+                if (time - cache_time[v] + 2 * live[v] <= VERTEX_CACHE_SIZE)
+                {
+                    priority = time - cache_time[v];
+                }
+                if (priority > best_priority)
+                {
+                    best_priority = priority;
+                    next = v;
+                }
+            }
+
+            while (next < 0 && dead_end_size > 0)
+            {
+                const int v = dead_end[--dead_end_size];
+                next = live[v] > 0 ? v : -1;
+            }
+            while (next < 0 && cursor < num_vertices)
+            {
+                next = live[cursor] > 0 ? cursor : -1;
+                cursor++;
+            }
+            fanning = next;
+        }
+
+        memcpy(indices, output, sizeof(GLuint) * num_output);
+    }
+
+    free(live);
+    free(cache_time);
+    free(offsets);
+    free(adjacency);
+    free(dead_end);
+    free(emitted);
+    free(output);
+    return allocated;
+}
+
+/**
+ * Estimates how many times the vertex shader runs for a triangle list by
+ * simulating a FIFO post-transform cache.
+ *
+ * @param indices[in]
+ * @param num_indices
+ * @param num_vertices Number of vertices the indices refer to.
+ * @return The number of cache misses, or the number of indices if memory
+ * couldn't be allocated for the simulation.
+ */
+static int prgl_count_vertex_shader_runs(
+    const GLuint indices[], GLsizei num_indices, GLsizei num_vertices
+)
+{
+    // The miss count when each vertex entered the cache, zero if it never did
+    int *const entered = calloc(num_vertices, sizeof(int));
+    if (entered == NULL)
+    {
+        return num_indices;
+    }
+
+    int misses = 0;
+    for (GLsizei i = 0; i < num_indices; i++)
+    {
+        const GLuint v = indices[i];
+        if (entered[v] == 0 || misses - entered[v] >= VERTEX_CACHE_SIZE)
+        {
+            entered[v] = ++misses;
+        }
+    }
+
+    free(entered);
+    return misses;
+}
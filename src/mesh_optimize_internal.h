@@ -0,0 +1,62 @@
+#ifndef PRGL_MESH_OPTIMIZE_INTERNAL_H
+#define PRGL_MESH_OPTIMIZE_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "glad.h"
+
+/**
+ * @brief Indexed triangle list geometry ready to be uploaded to GL buffers.
+ */
+struct PRGLOptimizedGeometry
+{
+    /// @brief Unique vertices in the order the indices first use them.
+    GLfloat *vertices;
+
+    /// @brief GLushort indices if index_type is GL_UNSIGNED_SHORT, else GLuint.
+    void *indices;
+
+    GLsizei num_vertices;
+    GLsizei num_indices;
+
+    /// @brief GL_UNSIGNED_SHORT when every index fits, else GL_UNSIGNED_INT.
+    GLenum index_type;
+};
+
+/**
+ * Welds identical vertices of a triangle list, reorders the triangles so
+ * vertices are reused while they're still in the post-transform cache, then
+ * reorders the vertices into the order they're first used.
+ *
+ * Each vertex is compared as a whole, so vertices which share a position but
+ * have different normals or texture coordinates are kept apart.
+ *
+ * @param vertex_data[in] Interleaved vertices of stride_length floats.
+ * @param num_vertices
+ * @param indices[in] Triangle list indices, or NULL if every three vertices
+ * form a triangle.
+ * @param num_indices Ignored if indices is NULL.
+ * @param stride_length Number of floats per vertex.
+ * @param result[out] Must be freed with prgl_free_optimized_geometry().
+ * @return False if memory couldn't be allocated.
+ */
+bool prgl_optimize_geometry(
+    const GLfloat vertex_data[], GLsizei num_vertices, const GLuint indices[],
+    GLsizei num_indices, GLint stride_length,
+    struct PRGLOptimizedGeometry *const result
+);
+
+/**
+ * Frees the memory of geometry made by prgl_optimize_geometry().
+ *
+ * @param geometry[in,out]
+ */
+void prgl_free_optimized_geometry(struct PRGLOptimizedGeometry *const geometry);
+
+/**
+ * @param index_type GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+ * @return The size of one index in bytes.
+ */
+GLsizei prgl_index_size(GLenum index_type);
+
+#endif
@@ -0,0 +1,247 @@
+#include "glad.h"
+
+#include "multi_draw_internal.h"
+#include "render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cglm/vec2.h"
+#include "cglm/vec4.h"
+#include "gl_extensions_internal.h"
+#include "gl_state_internal.h"
+#include "gpu_culling_internal.h"
+#include "mesh_internal.h"
+#include "mesh_optimize_internal.h"
+#include "render_internal.h"
+#include "shaders.h"
+#include "shaders_internal.h"
+
+// Draws per multi draw, a multi draw is issued early when it's full
+static const int MULTI_DRAW_MAX_COMMANDS = 4096;
+
+static bool prgl_multi_draw_enabled = true;
+
+// Indirect buffer, orphaned and refilled on every multi draw
+static GLuint prgl_indirect_buffer = 0;
+
+// The multi draw being built, issued when its state changes or on flush
+static struct PRGLDrawElementsIndirectCommand *prgl_multi_commands = NULL;
+static vec4 *prgl_multi_bounds = NULL;
+static int prgl_multi_num_commands = 0;
+static struct PRGLMesh *prgl_multi_mesh = NULL;
+static GLuint prgl_multi_shader = 0;
+static float prgl_multi_alpha = 1.0f;
+static vec2 prgl_multi_tile_factor = {1.0f, 1.0f};
+
+static bool prgl_multi_draw_matches(
+    struct PRGLMesh *const mesh, GLuint shader, float alpha, vec2 tile_factor
+);
+
+void prgl_init_multi_draw(void)
+{
+    if (!prgl_gl_4_3_loaded())
+    {
+        return;
+    }
+
+    // The instance data is shared with instanced draws, which only grow it
+    const size_t commands_size = sizeof(struct PRGLDrawElementsIndirectCommand)
+                               * MULTI_DRAW_MAX_COMMANDS;
+    prgl_multi_commands = malloc(commands_size);
+    prgl_multi_bounds = malloc(sizeof(vec4) * MULTI_DRAW_MAX_COMMANDS);
+    if (prgl_multi_commands == NULL || prgl_multi_bounds == NULL
+        || !prgl_reserve_instance_data(MULTI_DRAW_MAX_COMMANDS))
+    {
+        fprintf(
+            stderr, "prgl_init_multi_draw: Error allocating multi draw "
+                    "memory, draws won't be merged!\n"
+        );
+        free(prgl_multi_commands);
+        free(prgl_multi_bounds);
+        prgl_multi_commands = NULL;
+        prgl_multi_bounds = NULL;
+        return;
+    }
+
+    glGenBuffers(1, &prgl_indirect_buffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, prgl_indirect_buffer);
+    glBufferData(
+        GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)commands_size, NULL, GL_STREAM_DRAW
+    );
+    prgl_multi_num_commands = 0;
+}
+
+void prgl_delete_multi_draw(void)
+{
+    if (prgl_indirect_buffer != 0)
+    {
+        glDeleteBuffers(1, &prgl_indirect_buffer);
+    }
+    prgl_indirect_buffer = 0;
+
+    free(prgl_multi_commands);
+    free(prgl_multi_bounds);
+    prgl_multi_commands = NULL;
+    prgl_multi_bounds = NULL;
+    prgl_multi_num_commands = 0;
+}
+
+void prgl_set_multi_draw_enabled(bool enabled)
+{
+    prgl_multi_draw_enabled = enabled;
+}
+
+bool prgl_multi_draw_accepts(struct PRGLMesh *const mesh, GLuint shader)
+{
+    unsigned features;
+    return prgl_multi_draw_enabled && prgl_indirect_buffer != 0
+        && mesh->geometry.page != NULL && mesh->ebo != 0
+        && mesh->primitive_type == GL_TRIANGLES
+        && prgl_shader_variant_features((PRGLShader){.id = shader}, &features)
+        && !(features & PRGL_SHADER_FEATURE_INSTANCED);
+}
+
+bool prgl_multi_draw_gpu_culled(
+    struct PRGLMesh *const mesh, GLuint shader, float alpha
+)
+{
+    // Culled draws are compacted in any order, so blending would change
+    return alpha >= 1.0f && prgl_gpu_culling_active()
+        && prgl_multi_draw_accepts(mesh, shader);
+}
+
+int prgl_add_multi_draw(
+    struct PRGLMesh *const mesh, GLuint shader, mat4 model,
+    mat3 normal_matrix, vec3 color, float alpha, vec2 tile_factor
+)
+{
+    int flushed = 0;
+    if (prgl_multi_num_commands == MULTI_DRAW_MAX_COMMANDS
+        || (prgl_multi_num_commands > 0
+            && !prgl_multi_draw_matches(mesh, shader, alpha, tile_factor)))
+    {
+        flushed = prgl_flush_multi_draw();
+    }
+
+    const int index = prgl_multi_num_commands;
+    if (index == 0)
+    {
+        prgl_multi_mesh = mesh;
+        prgl_multi_shader = shader;
+        prgl_multi_alpha = alpha;
+        glm_vec2_copy(tile_factor, prgl_multi_tile_factor);
+    }
+
+    // Each draw is one instance, its base instance picks its instance data
+    prgl_set_instance_data(index, model, normal_matrix, color);
+    prgl_multi_commands[index] = (struct PRGLDrawElementsIndirectCommand){
+        .count = (GLuint)mesh->num_vertices,
+        .instance_count = 1,
+        .first_index = (GLuint)(mesh->geometry.index_offset
+                                / prgl_index_size(mesh->index_type)),
+        .base_vertex = mesh->geometry.base_vertex,
+        .base_instance = (GLuint)index,
+    };
+    glm_vec4_copy(mesh->bounding_sphere, prgl_multi_bounds[index]);
+    prgl_multi_num_commands++;
+    return flushed;
+}
+
+int prgl_flush_multi_draw(void)
+{
+    const int num_commands = prgl_multi_num_commands;
+    if (num_commands == 0)
+    {
+        return 0;
+    }
+    prgl_multi_num_commands = 0;
+
+    struct PRGLMesh *const mesh = prgl_multi_mesh;
+    const PRGLShader shader = prgl_draw_shader_variant(
+        (PRGLShader){.id = prgl_multi_shader}, mesh, true
+    );
+    unsigned features = 0;
+    prgl_shader_variant_features(shader, &features);
+
+    if (features & PRGL_SHADER_FEATURE_OBJECT_LIGHTS)
+    {
+        for (int i = 0; i < num_commands; i++)
+        {
+            prgl_select_instance_lights(i, prgl_multi_bounds[i]);
+        }
+    }
+
+    prgl_gl_bind_vertex_array(mesh->vao);
+    prgl_upload_instance_data(mesh, num_commands);
+
+    if (prgl_multi_alpha >= 1.0f && prgl_gpu_culling_active())
+    {
+        // Runs a compute pass, so it has to come before the draw's shader.
+        // Culled draws are zeroed at the end, so all of them are still drawn.
+        glBindBuffer(
+            GL_DRAW_INDIRECT_BUFFER,
+            prgl_gpu_cull_draws(
+                prgl_multi_commands, prgl_multi_bounds, num_commands
+            )
+        );
+    }
+    else
+    {
+        // Orphan the old storage so the driver doesn't stall on in-flight
+        // draws
+        const GLsizeiptr command_size =
+            sizeof(struct PRGLDrawElementsIndirectCommand);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, prgl_indirect_buffer);
+        glBufferData(
+            GL_DRAW_INDIRECT_BUFFER, command_size * MULTI_DRAW_MAX_COMMANDS,
+            NULL, GL_STREAM_DRAW
+        );
+        glBufferSubData(
+            GL_DRAW_INDIRECT_BUFFER, 0, command_size * num_commands,
+            prgl_multi_commands
+        );
+    }
+
+    prgl_use_shader(shader);
+    prgl_set_default_shared_uniforms(true);
+    prgl_set_uniform_float(
+        prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_ALPHA),
+        prgl_multi_alpha
+    );
+    prgl_set_uniform_vec2(
+        prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_TILE_FACTOR),
+        prgl_multi_tile_factor
+    );
+    if (features & PRGL_SHADER_FEATURE_TEXTURED)
+    {
+        prgl_gl_bind_texture_2d(0, (GLuint)mesh->texture.id);
+    }
+
+    prgl_gl_multi_draw_elements_indirect(
+        GL_TRIANGLES, mesh->index_type, (const void *)0, num_commands, 0
+    );
+    return 1;
+}
+
+/**
+ * Checks if a draw can join the current multi draw, which needs every draw to
+ * share the uniforms, vertex array, index type and texture.
+ *
+ * @param mesh[in]
+ * @param shader
+ * @param alpha
+ * @param tile_factor
+ * @return True if the draw shares the current multi draw's state.
+ */
+static bool prgl_multi_draw_matches(
+    struct PRGLMesh *const mesh, GLuint shader, float alpha, vec2 tile_factor
+)
+{
+    return shader == prgl_multi_shader && mesh->vao == prgl_multi_mesh->vao
+        && mesh->index_type == prgl_multi_mesh->index_type
+        && mesh->texture.id == prgl_multi_mesh->texture.id
+        && alpha == prgl_multi_alpha
+        && tile_factor[0] == prgl_multi_tile_factor[0]
+        && tile_factor[1] == prgl_multi_tile_factor[1];
+}
@@ -0,0 +1,75 @@
+#ifndef PRGL_MULTI_DRAW_INTERNAL_H
+#define PRGL_MULTI_DRAW_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "glad.h"
+#include "cglm/types.h"
+
+struct PRGLMesh;
+
+/**
+ * Creates the indirect buffer if the GL 4.3 functions were loaded. On older
+ * contexts multi draws are never accepted, so queued draws fall back to a draw
+ * call each.
+ */
+void prgl_init_multi_draw(void);
+
+/**
+ * Deletes the indirect buffer and frees the multi draw memory.
+ */
+void prgl_delete_multi_draw(void);
+
+/**
+ * Checks if a queued 3D draw can go into a multi draw.
+ *
+ * @param mesh[in]
+ * @param shader The shader the draw was made with.
+ * @return True if multi draws are available and enabled, the shader is a
+ * built in 3D variant that isn't instanced, and the mesh is an indexed
+ * triangle mesh in a shared geometry page.
+ */
+bool prgl_multi_draw_accepts(struct PRGLMesh *const mesh, GLuint shader);
+
+/**
+ * Checks if a queued 3D draw will be frustum culled on the GPU when its multi
+ * draw is issued, so it can be left out of CPU culling.
+ *
+ * @param mesh[in]
+ * @param shader The shader the draw was made with.
+ * @param alpha
+ * @return True if the draw is accepted for a multi draw, GPU culling is active
+ * and the draw is opaque.
+ */
+bool prgl_multi_draw_gpu_culled(
+    struct PRGLMesh *const mesh, GLuint shader, float alpha
+);
+
+/**
+ * Adds a 3D draw to the current multi draw. The current multi draw is issued
+ * first if the draw uses a different shader, geometry page, index type,
+ * texture, alpha or tile factor.
+ *
+ * @param mesh[in]
+ * @param shader The shader the draw was made with.
+ * @param model
+ * @param normal_matrix
+ * @param color
+ * @param alpha
+ * @param tile_factor
+ * @return The number of multi draws issued to make room, 0 or 1.
+ */
+int prgl_add_multi_draw(
+    struct PRGLMesh *const mesh, GLuint shader, mat4 model,
+    mat3 normal_matrix, vec3 color, float alpha, vec2 tile_factor
+);
+
+/**
+ * Issues the current multi draw if it has anything in it. Leaves the instanced
+ * shader, vertex array and texture bound.
+ *
+ * @return The number of multi draws issued, 0 or 1.
+ */
+int prgl_flush_multi_draw(void);
+
+#endif
@@ -0,0 +1,371 @@
+#include "object_lights_internal.h"
+#include "lighting.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "cglm/mat4.h"
+#include "cglm/vec3.h"
+#include "lighting_internal.h"
+
+const char *const PRGL_OBJECT_LIGHTS_UNIFORM = "objectLights";
+
+// Buckets of the hashed light grid, a power of two, and the most cells a light
+// or an object can cover before it's treated as covering everything
+#define LIGHT_GRID_BUCKETS 1024
+#define LIGHT_GRID_MAX_CELLS 64
+
+// Cell coordinates beyond this would overflow, lights out there are checked
+// by every object instead
+static const float LIGHT_GRID_MAX_COORDINATE = 1.0e6f;
+
+/**
+ * The grid cells a sphere overlaps along each axis, inclusive.
+ */
+struct PRGLLightGridRange
+{
+    int min[3];
+    int max[3];
+};
+
+static int prgl_lights_per_object = 0;
+
+// Each bucket's lights are a range of the entries, buckets hold every cell
+// hashed to them so lookups can find lights of other cells too
+static unsigned short prgl_light_grid_entries
+    [PRGL_MAX_POINT_LIGHTS * LIGHT_GRID_MAX_CELLS];
+static int prgl_light_grid_offsets[LIGHT_GRID_BUCKETS + 1];
+static int prgl_light_grid_fill[LIGHT_GRID_BUCKETS];
+static float prgl_light_grid_cell_size = 1.0f;
+
+// The cells each light covers, if it's in the grid
+static struct PRGLLightGridRange prgl_light_grid_ranges[PRGL_MAX_POINT_LIGHTS];
+static bool prgl_light_in_grid[PRGL_MAX_POINT_LIGHTS];
+
+// Lights too large for the grid, checked by every object
+static unsigned short prgl_unbounded_lights[PRGL_MAX_POINT_LIGHTS];
+static int prgl_num_unbounded_lights = 0;
+
+// What the grid was last built for, so unchanged lights are skipped
+static bool prgl_light_grid_built = false;
+static unsigned prgl_light_grid_version = 0;
+
+// Marks the lights already considered for the current object
+static unsigned prgl_light_query_marks[PRGL_MAX_POINT_LIGHTS];
+static unsigned prgl_light_query = 0;
+
+static void prgl_build_light_grid(void);
+static bool prgl_light_grid_range(
+    vec3 center, float radius, struct PRGLLightGridRange *const range
+);
+static unsigned prgl_light_grid_bucket(int x, int y, int z);
+static void prgl_consider_object_light(
+    int light, vec3 center, float radius, int indices[], float influences[],
+    int *const num_selected
+);
+
+void prgl_set_lights_per_object(int num_lights)
+{
+    if (num_lights > PRGL_MAX_OBJECT_POINT_LIGHTS)
+    {
+        num_lights = PRGL_MAX_OBJECT_POINT_LIGHTS;
+    }
+    else if (num_lights < 0)
+    {
+        num_lights = 0;
+    }
+    prgl_lights_per_object = num_lights;
+}
+
+bool prgl_object_lights_active(void)
+{
+    return prgl_lights_per_object > 0
+        && prgl_num_point_lights() > prgl_lights_per_object;
+}
+
+void prgl_select_object_lights(
+    vec4 local_sphere, mat4 model, float dest[PRGL_MAX_OBJECT_POINT_LIGHTS]
+)
+{
+    if (!prgl_light_grid_built
+        || prgl_light_grid_version != prgl_point_lights_version())
+    {
+        prgl_build_light_grid();
+    }
+
+    // Same world space sphere as culling, radius scaled by the largest axis
+    vec3 center;
+    glm_mat4_mulv3(model, local_sphere, 1.0f, center);
+    const float max_scale = fmaxf(
+        glm_vec3_norm2(model[0]),
+        fmaxf(glm_vec3_norm2(model[1]), glm_vec3_norm2(model[2]))
+    );
+    const float radius = local_sphere[3] * sqrtf(max_scale);
+
+    if (++prgl_light_query == 0)
+    {
+        memset(prgl_light_query_marks, 0, sizeof(prgl_light_query_marks));
+        prgl_light_query = 1;
+    }
+
+    int indices[PRGL_MAX_OBJECT_POINT_LIGHTS];
+    float influences[PRGL_MAX_OBJECT_POINT_LIGHTS];
+    int num_selected = 0;
+    for (int i = 0; i < prgl_num_unbounded_lights; i++)
+    {
+        prgl_consider_object_light(
+            prgl_unbounded_lights[i], center, radius, indices, influences,
+            &num_selected
+        );
+    }
+
+    struct PRGLLightGridRange range;
+    if (prgl_light_grid_range(center, radius, &range))
+    {
+        for (int z = range.min[2]; z <= range.max[2]; z++)
+        {
+            for (int y = range.min[1]; y <= range.max[1]; y++)
+            {
+                for (int x = range.min[0]; x <= range.max[0]; x++)
+                {
+                    const unsigned bucket = prgl_light_grid_bucket(x, y, z);
+                    for (int i = prgl_light_grid_offsets[bucket];
+                         i < prgl_light_grid_offsets[bucket + 1]; i++)
+                    {
+                        prgl_consider_object_light(
+                            prgl_light_grid_entries[i], center, radius,
+                            indices, influences, &num_selected
+                        );
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        // Objects too large for the grid check every light
+        const int num_lights = prgl_num_point_lights();
+        for (int i = 0; i < num_lights; i++)
+        {
+            prgl_consider_object_light(
+                i, center, radius, indices, influences, &num_selected
+            );
+        }
+    }
+
+    for (int i = 0; i < PRGL_MAX_OBJECT_POINT_LIGHTS; i++)
+    {
+        dest[i] = i < num_selected ? (float)indices[i] : -1.0f;
+    }
+}
+
+/**
+ * Buckets every point light by the grid cells its sphere overlaps. The cell
+ * size is the average light radius, so most lights cover a few cells.
+ */
+static void prgl_build_light_grid(void)
+{
+    const int num_lights = prgl_num_point_lights();
+    float radius_sum = 0.0f;
+    int num_finite = 0;
+    for (int i = 0; i < num_lights; i++)
+    {
+        vec4 sphere;
+        prgl_point_light_sphere(i, sphere);
+        if (sphere[3] > 0.0f && isfinite(sphere[3]))
+        {
+            radius_sum += sphere[3];
+            num_finite++;
+        }
+    }
+    prgl_light_grid_cell_size =
+        num_finite > 0 ? radius_sum / (float)num_finite : 1.0f;
+
+    // Count each bucket's lights, then turn the counts into offsets and fill
+    // them, walking the lights in order both times
+    memset(prgl_light_grid_offsets, 0, sizeof(prgl_light_grid_offsets));
+    prgl_num_unbounded_lights = 0;
+    for (int i = 0; i < num_lights; i++)
+    {
+        vec4 sphere;
+        prgl_point_light_sphere(i, sphere);
+        prgl_light_in_grid[i] = false;
+        if (sphere[3] <= 0.0f)
+        {
+            continue;
+        }
+        struct PRGLLightGridRange *const range = &prgl_light_grid_ranges[i];
+        if (!prgl_light_grid_range(sphere, sphere[3], range))
+        {
+            prgl_unbounded_lights[prgl_num_unbounded_lights++] =
+                (unsigned short)i;
+            continue;
+        }
+
+        prgl_light_in_grid[i] = true;
+        for (int z = range->min[2]; z <= range->max[2]; z++)
+        {
+            for (int y = range->min[1]; y <= range->max[1]; y++)
+            {
+                for (int x = range->min[0]; x <= range->max[0]; x++)
+                {
+                    const unsigned bucket = prgl_light_grid_bucket(x, y, z);
+                    prgl_light_grid_offsets[bucket + 1]++;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < LIGHT_GRID_BUCKETS; i++)
+    {
+        prgl_light_grid_offsets[i + 1] += prgl_light_grid_offsets[i];
+    }
+
+    memcpy(
+        prgl_light_grid_fill, prgl_light_grid_offsets,
+        sizeof(prgl_light_grid_fill)
+    );
+    for (int i = 0; i < num_lights; i++)
+    {
+        if (!prgl_light_in_grid[i])
+        {
+            continue;
+        }
+
+        const struct PRGLLightGridRange *const range =
+            &prgl_light_grid_ranges[i];
+        for (int z = range->min[2]; z <= range->max[2]; z++)
+        {
+            for (int y = range->min[1]; y <= range->max[1]; y++)
+            {
+                for (int x = range->min[0]; x <= range->max[0]; x++)
+                {
+                    const unsigned bucket = prgl_light_grid_bucket(x, y, z);
+                    prgl_light_grid_entries[prgl_light_grid_fill[bucket]++] =
+                        (unsigned short)i;
+                }
+            }
+        }
+    }
+
+    prgl_light_grid_built = true;
+    prgl_light_grid_version = prgl_point_lights_version();
+}
+
+/**
+ * Finds the grid cells a sphere overlaps.
+ *
+ * @param center
+ * @param radius
+ * @param range[out]
+ * @return False if the sphere covers more than LIGHT_GRID_MAX_CELLS cells or
+ * reaches too far out for the grid, range is left unfinished.
+ */
+static bool prgl_light_grid_range(
+    vec3 center, float radius, struct PRGLLightGridRange *const range
+)
+{
+    int num_cells = 1;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const float min =
+            floorf((center[axis] - radius) / prgl_light_grid_cell_size);
+        const float max =
+            floorf((center[axis] + radius) / prgl_light_grid_cell_size);
+        if (!(min >= -LIGHT_GRID_MAX_COORDINATE)
+            || !(max <= LIGHT_GRID_MAX_COORDINATE))
+        {
+            return false;
+        }
+
+        range->min[axis] = (int)min;
+        range->max[axis] = (int)max;
+        num_cells *= range->max[axis] - range->min[axis] + 1;
+        if (num_cells > LIGHT_GRID_MAX_CELLS)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Hashes a grid cell to its bucket.
+ *
+ * @param x
+ * @param y
+ * @param z
+ * @return The bucket index, less than LIGHT_GRID_BUCKETS.
+ */
+static unsigned prgl_light_grid_bucket(int x, int y, int z)
+{
+    const unsigned hash = (unsigned)x * 73856093u ^ (unsigned)y * 19349663u
+                        ^ (unsigned)z * 83492791u;
+    return hash & (LIGHT_GRID_BUCKETS - 1);
+}
+
+/**
+ * Adds a light to an object's selection if it reaches the object and has more
+ * influence than the least influential light selected so far. Lights already
+ * considered for the object are skipped, since a light is bucketed once for
+ * each cell it covers.
+ *
+ * @param light
+ * @param center Center of the object's world space bounding sphere.
+ * @param radius Radius of the object's world space bounding sphere.
+ * @param indices[in,out] The selected lights, most influential first.
+ * @param influences[in,out] The influence of each selected light.
+ * @param num_selected[in,out]
+ */
+static void prgl_consider_object_light(
+    int light, vec3 center, float radius, int indices[], float influences[],
+    int *const num_selected
+)
+{
+    if (prgl_light_query_marks[light] == prgl_light_query)
+    {
+        return;
+    }
+    prgl_light_query_marks[light] = prgl_light_query;
+
+    vec4 sphere;
+    prgl_point_light_sphere(light, sphere);
+    const float distance =
+        fmaxf(glm_vec3_distance(sphere, center) - radius, 0.0f);
+    if (!(distance < sphere[3]))
+    {
+        return;
+    }
+
+    // Lights are found in bucket order, so ties go to the lower index to keep
+    // the selection stable
+    const float influence = prgl_point_light_influence(light, distance);
+    int slot = *num_selected;
+    while (slot > 0
+           && (influence > influences[slot - 1]
+               || (influence == influences[slot - 1]
+                   && light < indices[slot - 1])))
+    {
+        slot--;
+    }
+    if (slot >= prgl_lights_per_object)
+    {
+        return;
+    }
+
+    const int last = *num_selected < prgl_lights_per_object
+                   ? *num_selected
+                   : prgl_lights_per_object - 1;
+    for (int i = last; i > slot; i--)
+    {
+        indices[i] = indices[i - 1];
+        influences[i] = influences[i - 1];
+    }
+    indices[slot] = light;
+    influences[slot] = influence;
+    if (*num_selected < prgl_lights_per_object)
+    {
+        (*num_selected)++;
+    }
+}
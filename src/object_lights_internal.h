@@ -0,0 +1,39 @@
+#ifndef PRGL_OBJECT_LIGHTS_INTERNAL_H
+#define PRGL_OBJECT_LIGHTS_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "cglm/types.h"
+#include "lighting.h"
+
+/**
+ * Name of the uniform holding the selected lights of a non-instanced draw in
+ * GLSL. It's a vec4, so PRGL_MAX_OBJECT_POINT_LIGHTS can't go above 4.
+ */
+extern const char *const PRGL_OBJECT_LIGHTS_UNIFORM;
+
+/**
+ * Checks if draws with lit shaders should select their lights per object,
+ * which is only worth it when there are more point lights than each object
+ * gets.
+ *
+ * @return True if selection is enabled and there are more point lights than
+ * the number selected per object.
+ */
+bool prgl_object_lights_active(void);
+
+/**
+ * Picks the point lights with the most influence on an object. The lights
+ * are found through a grid over the light spheres, which is rebuilt when the
+ * lights change.
+ *
+ * @param local_sphere The object mesh's local bounding sphere.
+ * @param model The object's model matrix.
+ * @param dest[out] Indices of the selected lights as floats, most influential
+ * first, with -1 after the last one.
+ */
+void prgl_select_object_lights(
+    vec4 local_sphere, mat4 model, float dest[PRGL_MAX_OBJECT_POINT_LIGHTS]
+);
+
+#endif
@@ -0,0 +1,166 @@
+#include "parallel_internal.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+// The calling thread runs jobs too, so it needs one fewer worker than jobs
+#define MAX_WORKERS (PRGL_MAX_PARALLEL_JOBS - 1)
+
+static pthread_mutex_t prgl_parallel_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prgl_parallel_work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t prgl_parallel_work_done = PTHREAD_COND_INITIALIZER;
+
+static pthread_t prgl_workers[MAX_WORKERS];
+static int prgl_num_workers = 0;
+static bool prgl_workers_stopping = false;
+
+// The jobs of the call in progress, everything is guarded by the mutex
+static bool prgl_parallel_busy = false;
+static char *prgl_parallel_jobs = NULL;
+static size_t prgl_parallel_job_size = 0;
+static int prgl_parallel_num_jobs = 0;
+static void (*prgl_parallel_run_job)(void *job) = NULL;
+static int prgl_next_parallel_job = 0;
+static int prgl_parallel_jobs_left = 0;
+
+static void prgl_start_workers(int num_workers);
+static void prgl_take_parallel_jobs(void);
+static void *prgl_run_worker(void *arg);
+
+int prgl_parallel_job_count(long num_items, long min_items_per_job)
+{
+    long num_jobs = num_items / min_items_per_job;
+    num_jobs = num_jobs < 1 ? 1 : num_jobs;
+    num_jobs = num_jobs > PRGL_MAX_PARALLEL_JOBS ? PRGL_MAX_PARALLEL_JOBS
+                                                 : num_jobs;
+    return (int)num_jobs;
+}
+
+void prgl_run_parallel(
+    void *const jobs, size_t job_size, int num_jobs,
+    void (*run_job)(void *job)
+)
+{
+    pthread_mutex_lock(&prgl_parallel_mutex);
+    if (num_jobs <= 1 || prgl_parallel_busy)
+    {
+        pthread_mutex_unlock(&prgl_parallel_mutex);
+        for (int i = 0; i < num_jobs; i++)
+        {
+            run_job((char *)jobs + job_size * i);
+        }
+        return;
+    }
+
+    prgl_start_workers(num_jobs - 1);
+    prgl_parallel_busy = true;
+    prgl_parallel_jobs = jobs;
+    prgl_parallel_job_size = job_size;
+    prgl_parallel_num_jobs = num_jobs;
+    prgl_parallel_run_job = run_job;
+    prgl_next_parallel_job = 0;
+    prgl_parallel_jobs_left = num_jobs;
+    pthread_cond_broadcast(&prgl_parallel_work_ready);
+
+    // The calling thread takes jobs too, which also covers any workers that
+    // couldn't be started
+    prgl_take_parallel_jobs();
+    while (prgl_parallel_jobs_left > 0)
+    {
+        pthread_cond_wait(&prgl_parallel_work_done, &prgl_parallel_mutex);
+    }
+
+    prgl_parallel_busy = false;
+    prgl_parallel_jobs = NULL;
+    prgl_parallel_num_jobs = 0;
+    prgl_parallel_run_job = NULL;
+    pthread_mutex_unlock(&prgl_parallel_mutex);
+}
+
+void prgl_delete_parallel(void)
+{
+    pthread_mutex_lock(&prgl_parallel_mutex);
+    prgl_workers_stopping = true;
+    pthread_cond_broadcast(&prgl_parallel_work_ready);
+    pthread_mutex_unlock(&prgl_parallel_mutex);
+
+    for (int i = 0; i < prgl_num_workers; i++)
+    {
+        pthread_join(prgl_workers[i], NULL);
+    }
+
+    pthread_mutex_lock(&prgl_parallel_mutex);
+    prgl_num_workers = 0;
+    prgl_workers_stopping = false;
+    pthread_mutex_unlock(&prgl_parallel_mutex);
+}
+
+/**
+ * Starts workers until there are the given number of them. Stops early if a
+ * thread can't be started, the jobs it would have taken are run by the others.
+ * Called with the mutex locked.
+ *
+ * @param num_workers
+ */
+static void prgl_start_workers(int num_workers)
+{
+    while (prgl_num_workers < num_workers)
+    {
+        if (pthread_create(
+                &prgl_workers[prgl_num_workers], NULL, prgl_run_worker, NULL
+            )
+            != 0)
+        {
+            return;
+        }
+        prgl_num_workers++;
+    }
+}
+
+/**
+ * Runs jobs of the call in progress until there are none left to take. The
+ * mutex is unlocked while a job runs. Called and returns with the mutex
+ * locked.
+ */
+static void prgl_take_parallel_jobs(void)
+{
+    while (prgl_next_parallel_job < prgl_parallel_num_jobs)
+    {
+        void *const job = prgl_parallel_jobs
+                        + prgl_parallel_job_size * prgl_next_parallel_job++;
+        void (*const run_job)(void *job) = prgl_parallel_run_job;
+
+        pthread_mutex_unlock(&prgl_parallel_mutex);
+        run_job(job);
+        pthread_mutex_lock(&prgl_parallel_mutex);
+
+        if (--prgl_parallel_jobs_left == 0)
+        {
+            pthread_cond_signal(&prgl_parallel_work_done);
+        }
+    }
+}
+
+/**
+ * Takes jobs whenever a call posts them, until the workers are stopped.
+ *
+ * @param arg Unused.
+ * @return NULL.
+ */
+static void *prgl_run_worker(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&prgl_parallel_mutex);
+    while (true)
+    {
+        prgl_take_parallel_jobs();
+        if (prgl_workers_stopping)
+        {
+            break;
+        }
+        pthread_cond_wait(&prgl_parallel_work_ready, &prgl_parallel_mutex);
+    }
+    pthread_mutex_unlock(&prgl_parallel_mutex);
+    return NULL;
+}
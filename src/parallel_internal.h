@@ -0,0 +1,41 @@
+#ifndef PRGL_PARALLEL_INTERNAL_H
+#define PRGL_PARALLEL_INTERNAL_H
+
+#include <stddef.h>
+
+/// Most jobs a single prgl_run_parallel() call runs at once.
+#define PRGL_MAX_PARALLEL_JOBS 8
+
+/**
+ * Picks how many jobs to split work into so each gets at least a minimum
+ * amount, since small amounts of work aren't worth handing to other threads.
+ *
+ * @param num_items The amount of work, e.g. vertices or nodes.
+ * @param min_items_per_job
+ * @return From 1 to PRGL_MAX_PARALLEL_JOBS.
+ */
+int prgl_parallel_job_count(long num_items, long min_items_per_job);
+
+/**
+ * Runs jobs across the calling thread and a pool of worker threads, returning
+ * once all of them are done. Workers are started the first time they're
+ * needed and wait for the next call in between, so a call only costs waking
+ * them. Jobs are run on the calling thread when workers can't be started, or
+ * when called from a job or while another thread's jobs are running.
+ *
+ * @param jobs[in,out] An array of num_jobs jobs, job_size bytes each.
+ * @param job_size
+ * @param num_jobs At most PRGL_MAX_PARALLEL_JOBS.
+ * @param run_job Called with a pointer to each job.
+ */
+void prgl_run_parallel(
+    void *const jobs, size_t job_size, int num_jobs,
+    void (*run_job)(void *job)
+);
+
+/**
+ * Stops and joins the worker threads, they're started again if needed.
+ */
+void prgl_delete_parallel(void);
+
+#endif
@@ -4,20 +4,70 @@
 #include "render_internal.h"
 
 #include <GLFW/glfw3.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "cglm/affine.h"
 #include "cglm/mat4.h"
 #include "cglm/quat.h"
 #include "cglm/types.h"
+#include "culling_internal.h"
+#include "entities.h"
 #include "game_object.h"
+#include "gl_state_internal.h"
+#include "lighting.h"
 #include "mesh_internal.h"
+#include "object_lights_internal.h"
+#include "render_queue_internal.h"
 #include "screen_internal.h"
 #include "shaders.h"
+#include "shaders_internal.h"
 #include "transform_internal.h"
+#include "transform_store.h"
 
 const vec2 PRGL_RENDER_RESOLUTION = {320.0f, 180.0f};
 
+// Per-instance data is a mat4 model, mat3 normal matrix, vec3 fill color, and
+// the indices of the instance's selected lights
+const GLint PRGL_INSTANCE_STRIDE_LENGTH =
+    16 + 9 + 3 + PRGL_MAX_OBJECT_POINT_LIGHTS;
+static const GLint INSTANCE_NORMAL_MATRIX_OFFSET = 16;
+static const GLint INSTANCE_FILL_COLOR_OFFSET = 16 + 9;
+static const GLint INSTANCE_LIGHTS_OFFSET = 16 + 9 + 3;
+static const GLuint INSTANCE_MODEL_LOCATION = 3;
+static const GLuint INSTANCE_NORMAL_MATRIX_LOCATION = 7;
+static const GLuint INSTANCE_FILL_COLOR_LOCATION = 10;
+static const GLuint INSTANCE_LIGHTS_LOCATION = 11;
+
+// Streaming buffer for instance data, orphaned and refilled on every draw
+static GLuint prgl_instance_vbo = 0;
+static GLsizeiptr prgl_instance_vbo_size = 0;
+static GLfloat *prgl_instance_data = NULL;
+static int prgl_instance_data_capacity = 0;
+
+// Transforms of the entity chunk being drawn and the matrices built from them
+static struct PRGLTransformStore prgl_entity_transforms = {0};
+static mat4 *prgl_entity_models = NULL;
+static mat3 *prgl_entity_normal_matrices = NULL;
+static int prgl_entity_matrices_capacity = 0;
+
+static void prgl_draw_mesh_3d(
+    struct PRGLMesh *const mesh, mat4 model, mat3 normal_matrix, vec3 color
+);
+static void prgl_write_instance(
+    GLfloat *const instance, mat4 model, mat3 normal_matrix, vec3 color
+);
+static void prgl_write_instance_color(GLfloat *const instance, vec3 color);
+static int prgl_cull_instances(struct PRGLMesh *const mesh, int num_instances);
+static void prgl_draw_instances(struct PRGLMesh *const mesh, int num_instances);
+static void prgl_draw_mesh_instanced(
+    struct PRGLMesh *const mesh, GLsizei num_instances
+);
+static void prgl_setup_instance_attributes(struct PRGLMesh *const mesh);
+static bool prgl_reserve_entity_matrices(int count);
+
 void prgl_clear_screen(float r, float g, float b, float a)
 {
     glClearColor((GLfloat)r, (GLfloat)g, (GLfloat)b, (GLfloat)a);
@@ -26,73 +76,30 @@ void prgl_clear_screen(float r, float g, float b, float a)
 
 void prgl_draw_game_object_3d(struct PRGLGameObject *const game_obj)
 {
-    struct PRGLMesh *const mesh = (struct PRGLMesh *)game_obj->mesh;
+    // Transform the mesh to the render position, cached until it moves and
+    // blended with the previous tick's when it moved in the last one
+    prgl_update_game_object_transform(game_obj);
 
-    glBindVertexArray(mesh->vao);
-
-    // Transform the mesh to the render position.
     mat4 model;
     mat3 normal_matrix;
-    prgl_create_model_matrix(model, game_obj);
-    prgl_set_shader_uniform_mat4(
-        prgl_current_shader(), PRGL_MODEL_UNIFORM, model
-    );
-    prgl_set_shader_uniform_vec3(
-        prgl_current_shader(), PRGL_FILL_COLOR_UNIFORM, game_obj->color
-    );
-    if (prgl_current_shader().id != prgl_shader(PRGL_SHADER_TYPE_UNLIT).id)
-    {
-        prgl_create_normal_matrix(normal_matrix, model);
-        prgl_set_shader_uniform_mat3(
-            prgl_current_shader(), PRGL_NORMAL_MATRIX_UNIFORM, normal_matrix
-        );
-        if (mesh->texture.id == 0)
-        {
-            prgl_set_shader_uniform_bool(
-                prgl_current_shader(), PRGL_USE_TEXTURE_UNIFORM, false
-            );
-        }
-        else
-        {
-            prgl_set_shader_uniform_bool(
-                prgl_current_shader(), PRGL_USE_TEXTURE_UNIFORM, true
-            );
-            glBindTexture(GL_TEXTURE_2D, (GLuint)mesh->texture.id);
-        }
-    }
-
-    if (mesh->ebo == 0)
+    if (prgl_interpolate_game_object_transform(game_obj, model, normal_matrix))
     {
-        glDrawArrays(mesh->primitive_type, 0, mesh->num_vertices);
-    }
-    else
-    {
-        glDrawElements(
-            mesh->primitive_type, mesh->num_vertices, GL_UNSIGNED_INT, 0
+        prgl_draw_mesh_3d(
+            (struct PRGLMesh *)game_obj->mesh, model, normal_matrix,
+            game_obj->color
         );
+        return;
     }
+    prgl_draw_mesh_3d(
+        (struct PRGLMesh *)game_obj->mesh, game_obj->model,
+        game_obj->normal_matrix, game_obj->color
+    );
 }
 
 void prgl_draw_game_object_2d(struct PRGLGameObject *const game_obj)
 {
     struct PRGLMesh *const mesh = (struct PRGLMesh *)game_obj->mesh;
 
-    glBindVertexArray(mesh->vao);
-
-    if (mesh->texture.id == 0)
-    {
-        prgl_set_shader_uniform_bool(
-            prgl_current_shader(), PRGL_USE_TEXTURE_UNIFORM, false
-        );
-    }
-    else
-    {
-        prgl_set_shader_uniform_bool(
-            prgl_current_shader(), PRGL_USE_TEXTURE_UNIFORM, true
-        );
-        glBindTexture(GL_TEXTURE_2D, (GLuint)mesh->texture.id);
-    }
-
     // Transform the mesh to the render position.
     mat4 trans;
     vec2 position = {game_obj->position[0], game_obj->position[1]};
@@ -112,49 +119,691 @@ void prgl_draw_game_object_2d(struct PRGLGameObject *const game_obj)
     // Negate y-axis scale, cglm quats expects 3D right hand coordinate with +y
     // up, but our 2D orthogonal projection has 0,0 at top left so -y is up
     glm_scale(trans, (vec3){scale[0], -scale[1], 1.0f});
-    prgl_set_shader_uniform_mat4(
-        prgl_current_shader(), PRGL_MODEL_UNIFORM, trans
-    );
-    prgl_set_shader_uniform_vec3(
-        prgl_current_shader(), PRGL_FILL_COLOR_UNIFORM, game_obj->color
+
+    if (prgl_render_queue_enabled())
+    {
+        prgl_queue_draw(
+            mesh, trans, NULL, game_obj->color, PRGL_RENDER_PASS_2D
+        );
+        return;
+    }
+
+    prgl_gl_bind_vertex_array(mesh->vao);
+    if (prgl_set_draw_uniforms(mesh, trans, NULL, game_obj->color, false))
+    {
+        prgl_gl_bind_texture_2d(0, (GLuint)mesh->texture.id);
+    }
+    prgl_draw_mesh(mesh);
+}
+
+void prgl_draw_game_objects_3d_instanced(
+    struct PRGLGameObject *const game_objs, int num_game_objs
+)
+{
+    if (num_game_objs <= 0 || !prgl_reserve_instance_data(num_game_objs))
+    {
+        return;
+    }
+
+    for (int i = 0; i < num_game_objs; i++)
+    {
+        GLfloat *const instance =
+            &prgl_instance_data[i * PRGL_INSTANCE_STRIDE_LENGTH];
+        prgl_update_game_object_transform(&game_objs[i]);
+
+        mat4 model;
+        mat3 normal_matrix;
+        if (prgl_interpolate_game_object_transform(
+                &game_objs[i], model, normal_matrix
+            ))
+        {
+            prgl_write_instance(
+                instance, model, normal_matrix, game_objs[i].color
+            );
+            continue;
+        }
+        prgl_write_instance(
+            instance, game_objs[i].model, game_objs[i].normal_matrix,
+            game_objs[i].color
+        );
+    }
+
+    struct PRGLMesh *const mesh = (struct PRGLMesh *)game_objs[0].mesh;
+    prgl_draw_instances(mesh, prgl_cull_instances(mesh, num_game_objs));
+}
+
+void prgl_draw_mesh_3d_instanced(
+    PRGLMeshHandle mesh, mat4 models[], vec3 colors[], int num_instances
+)
+{
+    if (num_instances <= 0 || !prgl_reserve_instance_data(num_instances))
+    {
+        return;
+    }
+
+    vec3 white = {1.0f, 1.0f, 1.0f};
+    for (int i = 0; i < num_instances; i++)
+    {
+        mat3 normal_matrix;
+        prgl_create_normal_matrix(normal_matrix, models[i]);
+        prgl_write_instance(
+            &prgl_instance_data[i * PRGL_INSTANCE_STRIDE_LENGTH], models[i],
+            normal_matrix, colors == NULL ? white : colors[i]
+        );
+    }
+
+    prgl_draw_instances(
+        (struct PRGLMesh *)mesh,
+        prgl_cull_instances((struct PRGLMesh *)mesh, num_instances)
     );
+}
 
-    if (mesh->ebo == 0)
+void prgl_draw_transforms_3d_instanced(
+    PRGLMeshHandle mesh, const struct PRGLTransformStore *const store,
+    vec3 colors[]
+)
+{
+    const int num_instances = store->count;
+    if (num_instances <= 0 || !prgl_reserve_instance_data(num_instances))
     {
-        glDrawArrays(mesh->primitive_type, 0, mesh->num_vertices);
+        return;
     }
-    else
+
+    prgl_write_transform_matrices(
+        store, prgl_instance_data, PRGL_INSTANCE_STRIDE_LENGTH,
+        &prgl_instance_data[INSTANCE_NORMAL_MATRIX_OFFSET],
+        PRGL_INSTANCE_STRIDE_LENGTH
+    );
+    vec3 white = {1.0f, 1.0f, 1.0f};
+    for (int i = 0; i < num_instances; i++)
     {
-        glDrawElements(
-            mesh->primitive_type, mesh->num_vertices, GL_UNSIGNED_INT, 0
+        prgl_write_instance_color(
+            &prgl_instance_data[i * PRGL_INSTANCE_STRIDE_LENGTH],
+            colors == NULL ? white : colors[i]
+        );
+    }
+
+    prgl_draw_instances(
+        (struct PRGLMesh *)mesh,
+        prgl_cull_instances((struct PRGLMesh *)mesh, num_instances)
+    );
+}
+
+void prgl_draw_entities_3d(void)
+{
+    struct PRGLEntityQuery query = prgl_query_entities(
+        PRGL_COMPONENT_BIT(PRGL_COMPONENT_TRANSFORM)
+        | PRGL_COMPONENT_BIT(PRGL_COMPONENT_MESH)
+    );
+    struct PRGLEntityBatch batch;
+    vec3 white = {1.0f, 1.0f, 1.0f};
+    while (prgl_next_entity_batch(&query, &batch))
+    {
+        if (!prgl_reserve_entity_matrices(batch.count))
+        {
+            return;
+        }
+
+        // Columns are read in place, a chunk at a time. The transforms of
+        // entities with a mesh are gathered into component arrays so their
+        // matrices are built several at a time.
+        struct PRGLTransform *const transforms =
+            batch.columns[PRGL_COMPONENT_TRANSFORM];
+        PRGLMeshHandle *const meshes = batch.columns[PRGL_COMPONENT_MESH];
+        vec3 *const colors = batch.columns[PRGL_COMPONENT_COLOR];
+        prgl_entity_transforms.count = 0;
+        for (int i = 0; i < batch.count; i++)
+        {
+            if (meshes[i] != NULL)
+            {
+                prgl_add_transform(
+                    &prgl_entity_transforms, transforms[i].position,
+                    transforms[i].orientation, transforms[i].scale
+                );
+            }
+        }
+        prgl_build_transform_matrices(
+            &prgl_entity_transforms, prgl_entity_models,
+            prgl_entity_normal_matrices
         );
+
+        int drawn = 0;
+        for (int i = 0; i < batch.count; i++)
+        {
+            if (meshes[i] == NULL)
+            {
+                continue;
+            }
+
+            prgl_draw_mesh_3d(
+                (struct PRGLMesh *)meshes[i], prgl_entity_models[drawn],
+                prgl_entity_normal_matrices[drawn],
+                colors == NULL ? white : colors[i]
+            );
+            drawn++;
+        }
     }
 }
 
+void prgl_init_renderer(void) { glGenBuffers(1, &prgl_instance_vbo); }
+
+GLuint prgl_instance_buffer(void) { return prgl_instance_vbo; }
+
+void prgl_delete_renderer(void)
+{
+    glDeleteBuffers(1, &prgl_instance_vbo);
+    prgl_instance_vbo = 0;
+    prgl_instance_vbo_size = 0;
+
+    free(prgl_instance_data);
+    prgl_instance_data = NULL;
+    prgl_instance_data_capacity = 0;
+
+    prgl_delete_transform_store(&prgl_entity_transforms);
+    free(prgl_entity_models);
+    free(prgl_entity_normal_matrices);
+    prgl_entity_models = NULL;
+    prgl_entity_normal_matrices = NULL;
+    prgl_entity_matrices_capacity = 0;
+}
+
 void prgl_enable_render_texture(GLuint fbo)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    glViewport(0, 0, PRGL_RENDER_RESOLUTION[0], PRGL_RENDER_RESOLUTION[1]);
+    prgl_gl_bind_framebuffer(fbo);
+    prgl_gl_viewport(
+        0, 0, PRGL_RENDER_RESOLUTION[0], PRGL_RENDER_RESOLUTION[1]
+    );
     prgl_clear_screen(0.1f, 0.1f, 0.1f, 1.0f);
 }
 
 void prgl_render_render_texture(struct PRGLMesh *const screen_quad)
 {
     // Switch back to default framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    prgl_gl_bind_framebuffer(0);
 
     // Set the viewport to the actual window size
     int windowWidth;
     int windowHeight;
     glfwGetFramebufferSize(prgl_screen()->window, &windowWidth, &windowHeight);
-    glViewport(0, 0, (GLint)windowWidth, (GLint)windowHeight);
+    prgl_gl_viewport(0, 0, (GLint)windowWidth, (GLint)windowHeight);
 
     // Render the screen quad to the window
     prgl_use_shader(prgl_shader(PRGL_SHADER_TYPE_SCREEN));
-    glBindVertexArray(screen_quad->vao);
-    glBindTexture(GL_TEXTURE_2D, (GLuint)screen_quad->texture.id);
-    glDrawElements(
-        screen_quad->primitive_type, screen_quad->num_vertices, GL_UNSIGNED_INT,
-        0
+    prgl_gl_bind_vertex_array(screen_quad->vao);
+    prgl_gl_bind_texture_2d(0, (GLuint)screen_quad->texture.id);
+    prgl_draw_mesh(screen_quad);
+}
+
+bool prgl_reserve_instance_data(int num_instances)
+{
+    if (num_instances <= prgl_instance_data_capacity)
+    {
+        return true;
+    }
+
+    int capacity = prgl_instance_data_capacity == 0
+                     ? 64
+                     : prgl_instance_data_capacity;
+    while (capacity < num_instances)
+    {
+        capacity *= 2;
+    }
+
+    GLfloat *data = realloc(
+        prgl_instance_data,
+        sizeof(GLfloat) * PRGL_INSTANCE_STRIDE_LENGTH * capacity
+    );
+    if (data == NULL)
+    {
+        fprintf(
+            stderr, "prgl_reserve_instance_data: Error allocating instance "
+                    "data memory!\n"
+        );
+        return false;
+    }
+
+    prgl_instance_data = data;
+    prgl_instance_data_capacity = capacity;
+    return true;
+}
+
+void prgl_set_instance_data(
+    int index, mat4 model, mat3 normal_matrix, vec3 color
+)
+{
+    prgl_write_instance(
+        &prgl_instance_data[index * PRGL_INSTANCE_STRIDE_LENGTH], model,
+        normal_matrix, color
+    );
+}
+
+void prgl_select_instance_lights(int index, vec4 local_sphere)
+{
+    GLfloat *const instance =
+        &prgl_instance_data[index * PRGL_INSTANCE_STRIDE_LENGTH];
+    prgl_select_object_lights(
+        local_sphere, (vec4 *)instance, &instance[INSTANCE_LIGHTS_OFFSET]
+    );
+}
+
+void prgl_upload_instance_data(struct PRGLMesh *const mesh, int num_instances)
+{
+    // Orphan the old storage so the driver doesn't stall on in-flight draws
+    const GLsizeiptr size =
+        sizeof(GLfloat) * PRGL_INSTANCE_STRIDE_LENGTH * num_instances;
+    glBindBuffer(GL_ARRAY_BUFFER, prgl_instance_vbo);
+    if (size > prgl_instance_vbo_size)
+    {
+        prgl_instance_vbo_size = sizeof(GLfloat) * PRGL_INSTANCE_STRIDE_LENGTH
+                               * prgl_instance_data_capacity;
+    }
+    glBufferData(GL_ARRAY_BUFFER, prgl_instance_vbo_size, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, prgl_instance_data);
+
+    if (mesh->instance_vbo != prgl_instance_vbo)
+    {
+        prgl_setup_instance_attributes(mesh);
+    }
+}
+
+/**
+ * Draws a mesh in the 3D pass, queued while the render queue is enabled and
+ * otherwise culled and drawn immediately with the current shader's variant.
+ *
+ * @param mesh[in]
+ * @param model The model matrix.
+ * @param normal_matrix The normal matrix.
+ * @param color The fill color.
+ */
+static void prgl_draw_mesh_3d(
+    struct PRGLMesh *const mesh, mat4 model, mat3 normal_matrix, vec3 color
+)
+{
+    if (prgl_render_queue_enabled())
+    {
+        prgl_queue_draw(mesh, model, normal_matrix, color, PRGL_RENDER_PASS_3D);
+        return;
+    }
+
+    if (!prgl_mesh_in_frustum(mesh, model))
+    {
+        prgl_count_culling(0, 1);
+        return;
+    }
+    prgl_count_culling(1, 0);
+
+    // Built in shaders are swapped for the draw's variant, which gets the
+    // alpha and tile factor set on the shader in use
+    const PRGLShader shader = prgl_current_shader();
+    const PRGLShader variant = prgl_draw_shader_variant(shader, mesh, false);
+    if (variant.id != shader.id)
+    {
+        float alpha = 1.0f;
+        vec2 tile_factor = {1.0f, 1.0f};
+        prgl_current_builtin_uniform_value(
+            PRGL_BUILTIN_UNIFORM_ALPHA, &alpha, sizeof(float)
+        );
+        prgl_current_builtin_uniform_value(
+            PRGL_BUILTIN_UNIFORM_TILE_FACTOR, tile_factor, sizeof(vec2)
+        );
+        prgl_use_shader(variant);
+        prgl_set_uniform_float(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_ALPHA), alpha
+        );
+        prgl_set_uniform_vec2(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_TILE_FACTOR),
+            tile_factor
+        );
+    }
+
+    prgl_gl_bind_vertex_array(mesh->vao);
+    if (prgl_set_draw_uniforms(mesh, model, normal_matrix, color, true))
+    {
+        prgl_gl_bind_texture_2d(0, (GLuint)mesh->texture.id);
+    }
+    prgl_draw_mesh(mesh);
+
+    if (variant.id != shader.id)
+    {
+        prgl_use_shader(shader);
+    }
+}
+
+/**
+ * Packs the data for one instance into the instance data layout.
+ *
+ * @param instance[out] Start of the instance in the instance data.
+ * @param model
+ * @param normal_matrix
+ * @param color
+ */
+static void prgl_write_instance(
+    GLfloat *const instance, mat4 model, mat3 normal_matrix, vec3 color
+)
+{
+    memcpy(instance, model, sizeof(mat4));
+    memcpy(
+        &instance[INSTANCE_NORMAL_MATRIX_OFFSET], normal_matrix, sizeof(mat3)
+    );
+    prgl_write_instance_color(instance, color);
+}
+
+/**
+ * Packs the fill color of one instance into the instance data layout, with no
+ * lights selected for it.
+ *
+ * @param instance[out] Start of the instance in the instance data.
+ * @param color
+ */
+static void prgl_write_instance_color(GLfloat *const instance, vec3 color)
+{
+    memcpy(&instance[INSTANCE_FILL_COLOR_OFFSET], color, sizeof(vec3));
+    for (int i = 0; i < PRGL_MAX_OBJECT_POINT_LIGHTS; i++)
+    {
+        instance[INSTANCE_LIGHTS_OFFSET + i] = -1.0f;
+    }
+}
+
+/**
+ * Removes the instances in prgl_instance_data outside the camera frustum,
+ * moving the visible instances to the front in the same order.
+ *
+ * @param mesh[in] The mesh shared by the instances.
+ * @param num_instances
+ * @return The number of visible instances.
+ */
+static int prgl_cull_instances(struct PRGLMesh *const mesh, int num_instances)
+{
+    if (!prgl_reserve_cull_batch(num_instances))
+    {
+        return num_instances;
+    }
+
+    for (int i = 0; i < num_instances; i++)
+    {
+        GLfloat *const instance =
+            &prgl_instance_data[i * PRGL_INSTANCE_STRIDE_LENGTH];
+        prgl_set_cull_object(i, mesh, (vec4 *)instance);
+    }
+    const int num_visible = prgl_cull_batch(num_instances);
+    prgl_count_culling(num_visible, num_instances - num_visible);
+    if (num_visible == num_instances)
+    {
+        return num_instances;
+    }
+
+    int num_kept = 0;
+    for (int i = 0; i < num_instances; i++)
+    {
+        if (!prgl_cull_object_visible(i))
+        {
+            continue;
+        }
+        if (i != num_kept)
+        {
+            memcpy(
+                &prgl_instance_data[num_kept * PRGL_INSTANCE_STRIDE_LENGTH],
+                &prgl_instance_data[i * PRGL_INSTANCE_STRIDE_LENGTH],
+                sizeof(GLfloat) * PRGL_INSTANCE_STRIDE_LENGTH
+            );
+        }
+        num_kept++;
+    }
+    return num_kept;
+}
+
+/**
+ * Draws the instances in prgl_instance_data with the instanced version of the
+ * current shader. Custom shaders don't have an instanced version, so for those
+ * each instance is drawn individually by setting the regular uniforms.
+ *
+ * @param mesh[in]
+ * @param num_instances
+ */
+static void prgl_draw_instances(struct PRGLMesh *const mesh, int num_instances)
+{
+    if (num_instances == 0)
+    {
+        return;
+    }
+
+    const PRGLShader shader = prgl_current_shader();
+    const PRGLShader variant = prgl_draw_shader_variant(shader, mesh, true);
+
+    prgl_gl_bind_vertex_array(mesh->vao);
+
+    if (variant.id == shader.id)
+    {
+        const PRGLUniform model_uniform =
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_MODEL);
+        const PRGLUniform normal_matrix_uniform =
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_NORMAL_MATRIX);
+        const PRGLUniform fill_color_uniform =
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_FILL_COLOR);
+        for (int i = 0; i < num_instances; i++)
+        {
+            GLfloat *const instance =
+                &prgl_instance_data[i * PRGL_INSTANCE_STRIDE_LENGTH];
+            prgl_set_uniform_mat4(model_uniform, (vec4 *)instance);
+            prgl_set_uniform_mat3(
+                normal_matrix_uniform,
+                (vec3 *)&instance[INSTANCE_NORMAL_MATRIX_OFFSET]
+            );
+            prgl_set_uniform_vec3(
+                fill_color_uniform, &instance[INSTANCE_FILL_COLOR_OFFSET]
+            );
+            prgl_draw_mesh(mesh);
+        }
+        return;
+    }
+
+    unsigned features = 0;
+    prgl_shader_variant_features(variant, &features);
+    if (features & PRGL_SHADER_FEATURE_OBJECT_LIGHTS)
+    {
+        for (int i = 0; i < num_instances; i++)
+        {
+            prgl_select_instance_lights(i, mesh->bounding_sphere);
+        }
+    }
+
+    prgl_upload_instance_data(mesh, num_instances);
+    prgl_use_shader(variant);
+    prgl_set_default_shared_uniforms(true);
+    if (features & PRGL_SHADER_FEATURE_TEXTURED)
+    {
+        prgl_gl_bind_texture_2d(0, (GLuint)mesh->texture.id);
+    }
+
+    prgl_draw_mesh_instanced(mesh, num_instances);
+    prgl_use_shader(shader);
+}
+
+bool prgl_set_draw_uniforms(
+    struct PRGLMesh *const mesh, mat4 model, mat3 normal_matrix, vec3 color,
+    bool is_3d
+)
+{
+    prgl_set_uniform_mat4(
+        prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_MODEL), model
+    );
+    prgl_set_uniform_vec3(
+        prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_FILL_COLOR), color
     );
+
+    // Unlit variants have no normals or textures, untextured ones no texture.
+    // Custom shaders may use anything.
+    unsigned features =
+        PRGL_SHADER_FEATURE_LIT | PRGL_SHADER_FEATURE_TEXTURED;
+    prgl_shader_variant_features(prgl_current_shader(), &features);
+    if (is_3d && !(features & PRGL_SHADER_FEATURE_LIT))
+    {
+        return false;
+    }
+
+    if (is_3d)
+    {
+        prgl_set_uniform_mat3(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_NORMAL_MATRIX),
+            normal_matrix
+        );
+    }
+    if (is_3d && (features & PRGL_SHADER_FEATURE_OBJECT_LIGHTS))
+    {
+        float lights[PRGL_MAX_OBJECT_POINT_LIGHTS];
+        prgl_select_object_lights(mesh->bounding_sphere, model, lights);
+        prgl_set_uniform_4f(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_OBJECT_LIGHTS),
+            lights[0], lights[1], lights[2], lights[3]
+        );
+    }
+
+    prgl_set_uniform_bool(
+        prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_USE_TEXTURE),
+        mesh->texture.id != 0
+    );
+    return mesh->texture.id != 0 && (features & PRGL_SHADER_FEATURE_TEXTURED);
+}
+
+void prgl_draw_mesh(struct PRGLMesh *const mesh)
+{
+    // Meshes share buffers, so the draw is offset to the mesh's geometry
+    if (mesh->ebo == 0)
+    {
+        glDrawArrays(
+            mesh->primitive_type, mesh->geometry.base_vertex, mesh->num_vertices
+        );
+    }
+    else
+    {
+        glDrawElementsBaseVertex(
+            mesh->primitive_type, mesh->num_vertices, mesh->index_type,
+            (const GLvoid *)(intptr_t)mesh->geometry.index_offset,
+            mesh->geometry.base_vertex
+        );
+    }
+}
+
+/**
+ * Issues an instanced draw call for a mesh with the currently bound VAO.
+ *
+ * @param mesh[in]
+ * @param num_instances
+ */
+static void prgl_draw_mesh_instanced(
+    struct PRGLMesh *const mesh, GLsizei num_instances
+)
+{
+    if (mesh->ebo == 0)
+    {
+        glDrawArraysInstanced(
+            mesh->primitive_type, mesh->geometry.base_vertex,
+            mesh->num_vertices, num_instances
+        );
+    }
+    else
+    {
+        glDrawElementsInstancedBaseVertex(
+            mesh->primitive_type, mesh->num_vertices, mesh->index_type,
+            (const GLvoid *)(intptr_t)mesh->geometry.index_offset,
+            num_instances, mesh->geometry.base_vertex
+        );
+    }
+}
+
+/**
+ * Points the per-instance attributes of a mesh's VAO at the instance buffer.
+ * The mesh's VAO must be bound.
+ *
+ * @param mesh[in,out]
+ */
+static void prgl_setup_instance_attributes(struct PRGLMesh *const mesh)
+{
+    const GLsizei stride = sizeof(GLfloat) * PRGL_INSTANCE_STRIDE_LENGTH;
+
+    // Matrix attributes take one location per column
+    for (GLuint col = 0; col < 4; col++)
+    {
+        const GLuint location = INSTANCE_MODEL_LOCATION + col;
+        glVertexAttribPointer(
+            location, 4, GL_FLOAT, GL_FALSE, stride,
+            (const GLvoid *)(intptr_t)(sizeof(GLfloat) * 4 * col)
+        );
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+
+    for (GLuint col = 0; col < 3; col++)
+    {
+        const GLuint location = INSTANCE_NORMAL_MATRIX_LOCATION + col;
+        glVertexAttribPointer(
+            location, 3, GL_FLOAT, GL_FALSE, stride,
+            (const GLvoid *)(intptr_t)(sizeof(GLfloat)
+                                       * (INSTANCE_NORMAL_MATRIX_OFFSET
+                                          + 3 * col))
+        );
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+
+    glVertexAttribPointer(
+        INSTANCE_FILL_COLOR_LOCATION, 3, GL_FLOAT, GL_FALSE, stride,
+        (const GLvoid *)(intptr_t)(sizeof(GLfloat) * INSTANCE_FILL_COLOR_OFFSET)
+    );
+    glVertexAttribDivisor(INSTANCE_FILL_COLOR_LOCATION, 1);
+    glEnableVertexAttribArray(INSTANCE_FILL_COLOR_LOCATION);
+
+    glVertexAttribPointer(
+        INSTANCE_LIGHTS_LOCATION, PRGL_MAX_OBJECT_POINT_LIGHTS, GL_FLOAT,
+        GL_FALSE, stride,
+        (const GLvoid *)(intptr_t)(sizeof(GLfloat) * INSTANCE_LIGHTS_OFFSET)
+    );
+    glVertexAttribDivisor(INSTANCE_LIGHTS_LOCATION, 1);
+    glEnableVertexAttribArray(INSTANCE_LIGHTS_LOCATION);
+
+    mesh->instance_vbo = prgl_instance_vbo;
+}
+
+/**
+ * Makes sure an entity chunk's transforms and matrices can be built, growing
+ * the transform store and matrix arrays when needed.
+ *
+ * @param count The number of entities in the chunk.
+ * @return False if the memory couldn't be allocated.
+ */
+static bool prgl_reserve_entity_matrices(int count)
+{
+    if (count <= prgl_entity_matrices_capacity)
+    {
+        return true;
+    }
+
+    mat4 *const models =
+        realloc(prgl_entity_models, sizeof(mat4) * (size_t)count);
+    if (models != NULL)
+    {
+        prgl_entity_models = models;
+    }
+    mat3 *const normal_matrices =
+        realloc(prgl_entity_normal_matrices, sizeof(mat3) * (size_t)count);
+    if (normal_matrices != NULL)
+    {
+        prgl_entity_normal_matrices = normal_matrices;
+    }
+
+    // The store keeps nothing between chunks, so it's started over
+    prgl_delete_transform_store(&prgl_entity_transforms);
+    if (models == NULL || normal_matrices == NULL
+        || !prgl_init_transform_store(&prgl_entity_transforms, count))
+    {
+        fprintf(
+            stderr, "prgl_reserve_entity_matrices: Error allocating entity "
+                    "matrix memory!\n"
+        );
+        prgl_entity_matrices_capacity = 0;
+        return false;
+    }
+
+    prgl_entity_matrices_capacity = count;
+    return true;
 }
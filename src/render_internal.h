@@ -1,8 +1,95 @@
 #ifndef PRGL_RENDER_INTERNAL_H
 #define PRGL_RENDER_INTERNAL_H
 
+#include <stdbool.h>
+
 #include "glad.h"
 #include "mesh.h"
+#include "cglm/types.h"
+
+struct PRGLMesh;
+
+// Number of floats per instance in the instance buffer, the model matrix comes
+// first
+extern const GLint PRGL_INSTANCE_STRIDE_LENGTH;
+
+/**
+ * Creates the GL objects used internally by the renderer, like the instance
+ * buffer. Should be called once after the window has been created.
+ */
+void prgl_init_renderer(void);
+
+/**
+ * Deletes the GL objects and memory created by prgl_init_renderer().
+ */
+void prgl_delete_renderer(void);
+
+/**
+ * @return The streaming buffer the instance data is uploaded to.
+ */
+GLuint prgl_instance_buffer(void);
+
+/**
+ * Sets the per-draw uniforms of the current shader for drawing a mesh.
+ *
+ * @param mesh[in]
+ * @param model The model matrix.
+ * @param normal_matrix The normal matrix, only read for 3D.
+ * @param color The fill color.
+ * @param is_3d
+ * @return True if the mesh's texture needs to be bound for the draw.
+ */
+bool prgl_set_draw_uniforms(
+    struct PRGLMesh *const mesh, mat4 model, mat3 normal_matrix, vec3 color,
+    bool is_3d
+);
+
+/**
+ * Makes sure the CPU side instance data can hold the given number of instances.
+ *
+ * @param num_instances
+ * @return False if memory couldn't be allocated.
+ */
+bool prgl_reserve_instance_data(int num_instances);
+
+/**
+ * Writes one instance into the CPU side instance data, which must have been
+ * reserved to hold it.
+ *
+ * @param index
+ * @param model The model matrix.
+ * @param normal_matrix
+ * @param color The fill color.
+ */
+void prgl_set_instance_data(
+    int index, mat4 model, mat3 normal_matrix, vec3 color
+);
+
+/**
+ * Selects the point lights of one instance in the CPU side instance data from
+ * its model matrix, for variants with PRGL_SHADER_FEATURE_OBJECT_LIGHTS.
+ *
+ * @param index
+ * @param local_sphere The local bounding sphere of the instance's mesh.
+ */
+void prgl_select_instance_lights(int index, vec4 local_sphere);
+
+/**
+ * Uploads the first instances of the CPU side instance data to the instance
+ * buffer and points the per-instance attributes of the mesh's VAO at it. The
+ * mesh's VAO must be bound.
+ *
+ * @param mesh[in,out]
+ * @param num_instances
+ */
+void prgl_upload_instance_data(struct PRGLMesh *const mesh, int num_instances);
+
+/**
+ * Issues the draw call for a mesh with the currently bound VAO.
+ *
+ * @param mesh[in]
+ */
+void prgl_draw_mesh(struct PRGLMesh *const mesh);
 
 /**
  * Enables the render texture fbo for rendering. This should be called before
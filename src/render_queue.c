@@ -0,0 +1,598 @@
+#include "glad.h"
+
+#include "render.h"
+#include "render_queue_internal.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "camera.h"
+#include "cglm/mat3.h"
+#include "cglm/mat4.h"
+#include "cglm/vec3.h"
+#include "culling_internal.h"
+#include "gl_state_internal.h"
+#include "mesh_internal.h"
+#include "multi_draw_internal.h"
+#include "render_internal.h"
+#include "shaders.h"
+#include "shaders_internal.h"
+#include "sprite_batch_internal.h"
+
+// Sort key layout from the most significant bit down:
+// Opaque:      pass(2) shader(8) texture(12) mesh(12) depth(24)
+// Translucent: pass(2) inverted depth(24) shader(8) texture(12) mesh(12)
+// 2D:          pass(2) submission order(32)
+// GL names are masked to fit, a collision only costs an extra bind.
+enum PRGLSortPass
+{
+    PRGL_SORT_PASS_OPAQUE,
+    PRGL_SORT_PASS_TRANSLUCENT,
+    PRGL_SORT_PASS_2D
+};
+
+static const int SORT_PASS_SHIFT = 62;
+static const uint64_t SORT_SHADER_MASK = 0xFF;
+static const uint64_t SORT_TEXTURE_MASK = 0xFFF;
+static const uint64_t SORT_MESH_MASK = 0xFFF;
+static const uint64_t SORT_DEPTH_MASK = 0xFFFFFF;
+
+// Matches the far clip of the perspective camera projection
+static const float SORT_DEPTH_RANGE = 100.0f;
+
+/**
+ * Everything needed to issue a draw after the game's draw callback returns.
+ */
+struct PRGLRenderCommand
+{
+    mat4 model;
+    mat3 normal_matrix;
+    vec3 color;
+    float alpha;
+    vec2 tile_factor;
+    struct PRGLMesh *mesh;
+    GLuint shader;
+    enum PRGLRenderPass pass;
+    bool culled;
+};
+
+struct PRGLSortEntry
+{
+    uint64_t key;
+    uint32_t command;
+};
+
+static bool prgl_queue_enabled = true;
+
+static struct PRGLRenderCommand *prgl_commands = NULL;
+static int prgl_num_commands = 0;
+static int prgl_commands_capacity = 0;
+
+static struct PRGLSortEntry *prgl_sort_entries = NULL;
+static struct PRGLSortEntry *prgl_sort_scratch = NULL;
+static int prgl_sort_capacity = 0;
+
+static struct PRGLRenderStats prgl_frame_stats = {0};
+static struct PRGLRenderStats prgl_last_frame_stats = {0};
+
+static uint64_t prgl_command_sort_key(
+    const struct PRGLRenderCommand *const command, uint32_t order
+);
+static bool prgl_command_uses_texture(
+    const struct PRGLRenderCommand *const command
+);
+static void prgl_count_draw(const struct PRGLRenderCommand *const command);
+static void prgl_cull_commands(void);
+static void prgl_count_unsorted_binds(GLuint shader);
+static void prgl_specialize_commands(void);
+static void prgl_radix_sort(int count);
+
+bool prgl_render_queue_enabled(void) { return prgl_queue_enabled; }
+
+void prgl_set_render_queue_enabled(bool enabled)
+{
+    if (!enabled)
+    {
+        prgl_flush_render_queue();
+    }
+    prgl_queue_enabled = enabled;
+}
+
+struct PRGLRenderStats prgl_render_stats(void)
+{
+    return prgl_last_frame_stats;
+}
+
+void prgl_queue_draw(
+    struct PRGLMesh *const mesh, mat4 model, mat3 normal_matrix, vec3 color,
+    enum PRGLRenderPass pass
+)
+{
+    if (prgl_num_commands == prgl_commands_capacity)
+    {
+        int capacity =
+            prgl_commands_capacity == 0 ? 256 : prgl_commands_capacity * 2;
+        struct PRGLRenderCommand *commands = realloc(
+            prgl_commands, sizeof(struct PRGLRenderCommand) * capacity
+        );
+        if (commands == NULL)
+        {
+            fprintf(
+                stderr, "prgl_queue_draw: Error allocating render command "
+                        "memory!\n"
+            );
+            return;
+        }
+        prgl_commands = commands;
+        prgl_commands_capacity = capacity;
+    }
+
+    struct PRGLRenderCommand *const command = &prgl_commands[prgl_num_commands];
+    glm_mat4_copy(model, command->model);
+    if (normal_matrix != NULL)
+    {
+        glm_mat3_copy(normal_matrix, command->normal_matrix);
+    }
+    glm_vec3_copy(color, command->color);
+    command->mesh = mesh;
+    command->shader = prgl_current_shader().id;
+    command->pass = pass;
+    command->culled = false;
+
+    // Defaults match the values in the built in shaders
+    command->alpha = 1.0f;
+    command->tile_factor[0] = 1.0f;
+    command->tile_factor[1] = 1.0f;
+    prgl_current_builtin_uniform_value(
+        PRGL_BUILTIN_UNIFORM_ALPHA, &command->alpha, sizeof(float)
+    );
+    prgl_current_builtin_uniform_value(
+        PRGL_BUILTIN_UNIFORM_TILE_FACTOR, command->tile_factor, sizeof(vec2)
+    );
+
+    prgl_num_commands++;
+}
+
+void prgl_flush_render_queue(void)
+{
+    if (prgl_num_commands == 0)
+    {
+        return;
+    }
+
+    if (prgl_num_commands > prgl_sort_capacity)
+    {
+        struct PRGLSortEntry *entries = realloc(
+            prgl_sort_entries,
+            sizeof(struct PRGLSortEntry) * prgl_commands_capacity
+        );
+        if (entries != NULL)
+        {
+            prgl_sort_entries = entries;
+        }
+        struct PRGLSortEntry *scratch = realloc(
+            prgl_sort_scratch,
+            sizeof(struct PRGLSortEntry) * prgl_commands_capacity
+        );
+        if (scratch != NULL)
+        {
+            prgl_sort_scratch = scratch;
+        }
+        if (entries == NULL || scratch == NULL)
+        {
+            fprintf(
+                stderr, "prgl_flush_render_queue: Error allocating sort "
+                        "memory!\n"
+            );
+            prgl_num_commands = 0;
+            return;
+        }
+        prgl_sort_capacity = prgl_commands_capacity;
+    }
+
+    prgl_specialize_commands();
+    prgl_cull_commands();
+
+    const PRGLShader previous_shader = prgl_current_shader();
+    prgl_count_unsorted_binds(previous_shader.id);
+
+    int num_entries = 0;
+    for (int i = 0; i < prgl_num_commands; i++)
+    {
+        if (prgl_commands[i].culled)
+        {
+            continue;
+        }
+        prgl_sort_entries[num_entries++] = (struct PRGLSortEntry){
+            .key = prgl_command_sort_key(&prgl_commands[i], (uint32_t)i),
+            .command = (uint32_t)i,
+        };
+    }
+    prgl_radix_sort(num_entries);
+
+    // Zero is never a VAO or texture we draw with, so it means nothing bound
+    GLuint bound_vao = 0;
+    GLuint bound_texture = 0;
+    bool batching = false;
+    for (int i = 0; i < num_entries; i++)
+    {
+        struct PRGLRenderCommand *const command =
+            &prgl_commands[prgl_sort_entries[i].command];
+        struct PRGLMesh *const mesh = command->mesh;
+
+        if (command->pass == PRGL_RENDER_PASS_2D
+            && prgl_sprite_batch_accepts(mesh, command->shader))
+        {
+            prgl_frame_stats.multi_draws += prgl_flush_multi_draw();
+            prgl_frame_stats.sprite_batches += prgl_add_sprite(
+                mesh, command->model, command->color, command->alpha,
+                command->tile_factor
+            );
+            prgl_frame_stats.batched_sprites++;
+            prgl_count_draw(command);
+            batching = true;
+            continue;
+        }
+
+        if (command->pass == PRGL_RENDER_PASS_3D
+            && prgl_multi_draw_accepts(mesh, command->shader))
+        {
+            prgl_frame_stats.sprite_batches += prgl_flush_sprite_batch();
+            prgl_frame_stats.multi_draws += prgl_add_multi_draw(
+                mesh, command->shader, command->model,
+                command->normal_matrix, command->color, command->alpha,
+                command->tile_factor
+            );
+            prgl_frame_stats.multi_drawn++;
+            prgl_count_draw(command);
+            batching = true;
+            continue;
+        }
+
+        // Batches bind their own state, so forget what was bound before
+        if (batching)
+        {
+            prgl_frame_stats.sprite_batches += prgl_flush_sprite_batch();
+            prgl_frame_stats.multi_draws += prgl_flush_multi_draw();
+            bound_vao = 0;
+            bound_texture = 0;
+            batching = false;
+        }
+
+        if (command->shader != prgl_current_shader().id)
+        {
+            prgl_use_shader((PRGLShader){.id = command->shader});
+            prgl_frame_stats.shader_binds++;
+        }
+
+        prgl_set_uniform_float(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_ALPHA),
+            command->alpha
+        );
+        prgl_set_uniform_vec2(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_TILE_FACTOR),
+            command->tile_factor
+        );
+
+        if (mesh->vao != bound_vao)
+        {
+            prgl_gl_bind_vertex_array(mesh->vao);
+            bound_vao = mesh->vao;
+            prgl_frame_stats.vao_binds++;
+        }
+
+        const bool is_3d = command->pass == PRGL_RENDER_PASS_3D;
+        if (prgl_set_draw_uniforms(
+                mesh, command->model, command->normal_matrix, command->color,
+                is_3d
+            )
+            && mesh->texture.id != bound_texture)
+        {
+            prgl_gl_bind_texture_2d(0, (GLuint)mesh->texture.id);
+            bound_texture = mesh->texture.id;
+            prgl_frame_stats.texture_binds++;
+        }
+
+        prgl_draw_mesh(mesh);
+        prgl_count_draw(command);
+    }
+    prgl_frame_stats.sprite_batches += prgl_flush_sprite_batch();
+    prgl_frame_stats.multi_draws += prgl_flush_multi_draw();
+
+    if (prgl_current_shader().id != previous_shader.id)
+    {
+        prgl_use_shader(previous_shader);
+    }
+
+    prgl_num_commands = 0;
+}
+
+void prgl_count_culling(int visible, int culled)
+{
+    prgl_frame_stats.visible_draws += visible;
+    prgl_frame_stats.culled_draws += culled;
+}
+
+void prgl_count_gpu_culling(int tested, int mismatches)
+{
+    prgl_frame_stats.gpu_tested_draws += tested;
+    prgl_frame_stats.gpu_cull_mismatches += mismatches;
+}
+
+void prgl_begin_render_stats_frame(void)
+{
+    prgl_last_frame_stats = prgl_frame_stats;
+    prgl_frame_stats = (struct PRGLRenderStats){0};
+}
+
+void prgl_delete_render_queue(void)
+{
+    free(prgl_commands);
+    free(prgl_sort_entries);
+    free(prgl_sort_scratch);
+    prgl_commands = NULL;
+    prgl_sort_entries = NULL;
+    prgl_sort_scratch = NULL;
+    prgl_num_commands = 0;
+    prgl_commands_capacity = 0;
+    prgl_sort_capacity = 0;
+}
+
+/**
+ * Packs the state of a command into a key where sorting by key ascending puts
+ * the draws in the order they should be issued.
+ *
+ * @param command[in]
+ * @param order The position of the command in the queue.
+ * @return The sort key.
+ */
+static uint64_t prgl_command_sort_key(
+    const struct PRGLRenderCommand *const command, uint32_t order
+)
+{
+    if (command->pass == PRGL_RENDER_PASS_2D)
+    {
+        return ((uint64_t)PRGL_SORT_PASS_2D << SORT_PASS_SHIFT)
+             | (uint64_t)order;
+    }
+
+    // Distance from the camera to the object's origin quantized to 24 bits
+    float distance = 0.0f;
+    struct PRGLCamera *const cam = prgl_active_camera();
+    if (cam != NULL)
+    {
+        distance = glm_vec3_distance(cam->position, (float *)command->model[3]);
+    }
+    float depth_unorm = distance / SORT_DEPTH_RANGE;
+    depth_unorm = depth_unorm < 0.0f ? 0.0f : depth_unorm;
+    depth_unorm = depth_unorm > 1.0f ? 1.0f : depth_unorm;
+    const uint64_t depth = (uint64_t)(depth_unorm * (float)SORT_DEPTH_MASK);
+
+    const uint64_t shader = command->shader & SORT_SHADER_MASK;
+    const uint64_t texture = command->mesh->texture.id & SORT_TEXTURE_MASK;
+    const uint64_t mesh = command->mesh->vao & SORT_MESH_MASK;
+
+    if (command->alpha < 1.0f)
+    {
+        // Back to front so blending sees what's behind
+        return ((uint64_t)PRGL_SORT_PASS_TRANSLUCENT << SORT_PASS_SHIFT)
+             | ((SORT_DEPTH_MASK - depth) << 32) | (shader << 24)
+             | (texture << 12) | mesh;
+    }
+
+    // State first to minimize binds, then front to back for early depth test
+    return ((uint64_t)PRGL_SORT_PASS_OPAQUE << SORT_PASS_SHIFT) | (shader << 48)
+         | (texture << 36) | (mesh << 24) | depth;
+}
+
+/**
+ * Checks if a command will bind its mesh's texture, without setting uniforms.
+ *
+ * @param command[in]
+ */
+static bool prgl_command_uses_texture(
+    const struct PRGLRenderCommand *const command
+)
+{
+    if (command->mesh->texture.id == 0)
+    {
+        return false;
+    }
+
+    unsigned features = PRGL_SHADER_FEATURE_TEXTURED;
+    prgl_shader_variant_features(
+        (PRGLShader){.id = command->shader}, &features
+    );
+    return command->pass == PRGL_RENDER_PASS_2D
+        || (features & PRGL_SHADER_FEATURE_TEXTURED);
+}
+
+/**
+ * Adds a flushed command to the draw counters.
+ *
+ * @param command[in]
+ */
+static void prgl_count_draw(const struct PRGLRenderCommand *const command)
+{
+    prgl_frame_stats.draws++;
+    if (command->pass != PRGL_RENDER_PASS_3D)
+    {
+        return;
+    }
+
+    if (command->alpha < 1.0f)
+    {
+        prgl_frame_stats.translucent_draws++;
+    }
+    else
+    {
+        prgl_frame_stats.opaque_draws++;
+    }
+}
+
+/**
+ * Swaps the shader of queued 3D commands made with built in shaders for the
+ * variant each draw needs. Done at flush so the variants match the lights set
+ * for the frame.
+ */
+static void prgl_specialize_commands(void)
+{
+    // Queued draws mostly share a shader, so remember the last swap
+    GLuint last_shader = 0;
+    bool last_textured = false;
+    bool last_baked = false;
+    GLuint last_variant = 0;
+    for (int i = 0; i < prgl_num_commands; i++)
+    {
+        struct PRGLRenderCommand *const command = &prgl_commands[i];
+        if (command->pass != PRGL_RENDER_PASS_3D)
+        {
+            continue;
+        }
+
+        const bool textured = command->mesh->texture.id != 0;
+        const bool baked = command->mesh->baked_lighting != NULL;
+        if (command->shader != last_shader || textured != last_textured
+            || baked != last_baked)
+        {
+            last_shader = command->shader;
+            last_textured = textured;
+            last_baked = baked;
+            last_variant = prgl_draw_shader_variant(
+                (PRGLShader){.id = command->shader}, command->mesh, false
+            ).id;
+        }
+        command->shader = last_variant;
+    }
+}
+
+/**
+ * Marks the queued 3D commands outside the camera frustum as culled. 2D
+ * commands are never culled, and commands the GPU culls are left to it.
+ */
+static void prgl_cull_commands(void)
+{
+    if (!prgl_reserve_cull_batch(prgl_num_commands))
+    {
+        return;
+    }
+
+    int num_3d = 0;
+    for (int i = 0; i < prgl_num_commands; i++)
+    {
+        struct PRGLRenderCommand *const command = &prgl_commands[i];
+        const bool is_3d = command->pass == PRGL_RENDER_PASS_3D
+            && !prgl_multi_draw_gpu_culled(
+                command->mesh, command->shader, command->alpha
+            );
+        num_3d += is_3d;
+        prgl_set_cull_object(i, is_3d ? command->mesh : NULL, command->model);
+    }
+    if (num_3d == 0)
+    {
+        return;
+    }
+
+    const int num_visible = prgl_cull_batch(prgl_num_commands);
+    for (int i = 0; i < prgl_num_commands; i++)
+    {
+        prgl_commands[i].culled = !prgl_cull_object_visible(i);
+    }
+    prgl_count_culling(
+        num_visible - (prgl_num_commands - num_3d),
+        prgl_num_commands - num_visible
+    );
+}
+
+/**
+ * Adds the binds the queued commands would need in submission order to the
+ * unsorted stats, using the same starting state as the sorted flush.
+ *
+ * @param shader The shader in use when the flush starts.
+ */
+static void prgl_count_unsorted_binds(GLuint shader)
+{
+    GLuint vao = 0;
+    GLuint texture = 0;
+    for (int i = 0; i < prgl_num_commands; i++)
+    {
+        const struct PRGLRenderCommand *const command = &prgl_commands[i];
+        if (command->culled)
+        {
+            continue;
+        }
+        if (command->shader != shader)
+        {
+            shader = command->shader;
+            prgl_frame_stats.unsorted_shader_binds++;
+        }
+        if (command->mesh->vao != vao)
+        {
+            vao = command->mesh->vao;
+            prgl_frame_stats.unsorted_vao_binds++;
+        }
+        if (prgl_command_uses_texture(command)
+            && command->mesh->texture.id != texture)
+        {
+            texture = command->mesh->texture.id;
+            prgl_frame_stats.unsorted_texture_binds++;
+        }
+    }
+}
+
+/**
+ * Sorts prgl_sort_entries by key with an LSD radix sort, one byte per pass.
+ * Passes where every key has the same byte are skipped, which is most of them
+ * since a frame's keys only differ in a few fields.
+ *
+ * @param count Number of entries to sort.
+ */
+static void prgl_radix_sort(int count)
+{
+    // Nothing to reorder, and the pass skipping reads the first entry
+    if (count <= 1)
+    {
+        return;
+    }
+
+    struct PRGLSortEntry *src = prgl_sort_entries;
+    struct PRGLSortEntry *dst = prgl_sort_scratch;
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        int offsets[256] = {0};
+        for (int i = 0; i < count; i++)
+        {
+            offsets[(src[i].key >> shift) & 0xFF]++;
+        }
+
+        if (offsets[(src[0].key >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        int total = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            const int bucket_count = offsets[b];
+            offsets[b] = total;
+            total += bucket_count;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+
+        struct PRGLSortEntry *const swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != prgl_sort_entries)
+    {
+        memcpy(prgl_sort_entries, src, sizeof(struct PRGLSortEntry) * count);
+    }
+}
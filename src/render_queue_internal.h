@@ -0,0 +1,75 @@
+#ifndef PRGL_RENDER_QUEUE_INTERNAL_H
+#define PRGL_RENDER_QUEUE_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "cglm/types.h"
+
+struct PRGLMesh;
+
+/**
+ * The phase of the game loop a draw was made in. Each pass is flushed on its
+ * own, 3D draws are sorted by state and 2D draws keep their submission order.
+ */
+enum PRGLRenderPass
+{
+    PRGL_RENDER_PASS_3D,
+    PRGL_RENDER_PASS_2D
+};
+
+/**
+ * @return True if draws should be recorded with prgl_queue_draw().
+ */
+bool prgl_render_queue_enabled(void);
+
+/**
+ * Records a draw with the current shader to be issued on the next flush. The
+ * current alpha and tile factor uniform values are recorded with it.
+ *
+ * @param mesh[in]
+ * @param model
+ * @param normal_matrix NULL for 2D draws.
+ * @param color
+ * @param pass
+ */
+void prgl_queue_draw(
+    struct PRGLMesh *const mesh, mat4 model, mat3 normal_matrix, vec3 color,
+    enum PRGLRenderPass pass
+);
+
+/**
+ * Sorts and issues all recorded draws, then empties the queue. The shader in
+ * use before the flush is restored afterwards.
+ */
+void prgl_flush_render_queue(void);
+
+/**
+ * Adds to the frame's frustum culling counters, for draws made outside the
+ * queue.
+ *
+ * @param visible Number of draws or instances which were drawn.
+ * @param culled Number of draws or instances which were skipped.
+ */
+void prgl_count_culling(int visible, int culled);
+
+/**
+ * Adds to the frame's GPU frustum culling counters.
+ *
+ * @param tested Number of draws tested in a compute pass.
+ * @param mismatches Number of draws the GPU and CPU tests disagreed on, only
+ * counted when validation is enabled.
+ */
+void prgl_count_gpu_culling(int tested, int mismatches);
+
+/**
+ * Moves the current frame's render stats to the previous frame's and resets
+ * them. Should be called once at the start of each frame.
+ */
+void prgl_begin_render_stats_frame(void);
+
+/**
+ * Frees the memory used by the render queue.
+ */
+void prgl_delete_render_queue(void);
+
+#endif
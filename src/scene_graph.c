@@ -0,0 +1,284 @@
+#include "scene_graph.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game_object.h"
+#include "parallel_internal.h"
+#include "transform_internal.h"
+
+// Roots are split into jobs of at least this many nodes, so small graphs are
+// updated on the calling thread. Jobs run on the persistent worker pool, so a
+// split graph costs waking up to 7 workers and waiting for the slowest each
+// update, which is only worth it for thousands of nodes.
+static const int MIN_SCENE_NODES_PER_JOB = 4096;
+
+/**
+ * A range of a scene graph's nodes for one job to update, starting at a root
+ * and ending before one.
+ */
+struct PRGLSceneJob
+{
+    struct PRGLSceneGraph *graph;
+    int first_node;
+    int end_node;
+};
+
+static bool prgl_reserve_scene_nodes(
+    struct PRGLSceneGraph *const graph, int capacity
+);
+static int prgl_find_scene_node(
+    const struct PRGLSceneGraph *const graph,
+    const struct PRGLGameObject *const game_obj
+);
+static int prgl_subtree_end(const struct PRGLSceneGraph *const graph, int node);
+static void prgl_run_scene_job(void *job);
+
+bool prgl_init_scene_graph(struct PRGLSceneGraph *const graph, int capacity)
+{
+    memset(graph, 0, sizeof(struct PRGLSceneGraph));
+    return prgl_reserve_scene_nodes(graph, capacity < 16 ? 16 : capacity);
+}
+
+void prgl_delete_scene_graph(struct PRGLSceneGraph *const graph)
+{
+    for (int i = 0; i < graph->count; i++)
+    {
+        graph->nodes[i]->parent = NULL;
+        graph->nodes[i]->transform_dirty = true;
+    }
+    free(graph->nodes);
+    free(graph->parents);
+    free(graph->changed);
+    memset(graph, 0, sizeof(struct PRGLSceneGraph));
+}
+
+bool prgl_add_scene_node(
+    struct PRGLSceneGraph *const graph, struct PRGLGameObject *const game_obj,
+    struct PRGLGameObject *const parent
+)
+{
+    const int parent_node =
+        parent == NULL ? -1 : prgl_find_scene_node(graph, parent);
+    if (parent != NULL && parent_node < 0)
+    {
+        fprintf(
+            stderr, "prgl_add_scene_node: The parent is not in the scene "
+                    "graph.\n"
+        );
+        return false;
+    }
+    if (graph->count == graph->capacity
+        && !prgl_reserve_scene_nodes(graph, graph->capacity * 2))
+    {
+        return false;
+    }
+
+    // Children go at the end of their parent's subtree to keep it contiguous,
+    // nodes after it move up one
+    const int node = parent_node < 0 ? graph->count
+                                     : prgl_subtree_end(graph, parent_node);
+    const int num_moved = graph->count - node;
+    memmove(
+        &graph->nodes[node + 1], &graph->nodes[node],
+        sizeof(struct PRGLGameObject *) * num_moved
+    );
+    memmove(
+        &graph->parents[node + 1], &graph->parents[node],
+        sizeof(int) * num_moved
+    );
+    memmove(
+        &graph->changed[node + 1], &graph->changed[node],
+        sizeof(bool) * num_moved
+    );
+    graph->count++;
+    for (int i = node + 1; i < graph->count; i++)
+    {
+        if (graph->parents[i] >= node)
+        {
+            graph->parents[i]++;
+        }
+    }
+
+    graph->nodes[node] = game_obj;
+    graph->parents[node] = parent_node;
+    graph->changed[node] = true;
+    game_obj->parent = parent;
+    game_obj->transform_dirty = true;
+    return true;
+}
+
+void prgl_remove_scene_node(
+    struct PRGLSceneGraph *const graph, struct PRGLGameObject *const game_obj
+)
+{
+    const int node = prgl_find_scene_node(graph, game_obj);
+    if (node < 0)
+    {
+        return;
+    }
+
+    const int end = prgl_subtree_end(graph, node);
+    for (int i = node; i < end; i++)
+    {
+        graph->nodes[i]->parent = NULL;
+        graph->nodes[i]->transform_dirty = true;
+    }
+
+    // Nodes after the subtree move down over it
+    const int num_removed = end - node;
+    const int num_moved = graph->count - end;
+    memmove(
+        &graph->nodes[node], &graph->nodes[end],
+        sizeof(struct PRGLGameObject *) * num_moved
+    );
+    memmove(
+        &graph->parents[node], &graph->parents[end], sizeof(int) * num_moved
+    );
+    memmove(
+        &graph->changed[node], &graph->changed[end], sizeof(bool) * num_moved
+    );
+    graph->count -= num_removed;
+    for (int i = node; i < graph->count; i++)
+    {
+        if (graph->parents[i] >= end)
+        {
+            graph->parents[i] -= num_removed;
+        }
+    }
+}
+
+void prgl_update_scene_graph(struct PRGLSceneGraph *const graph)
+{
+    const int num_ranges =
+        prgl_parallel_job_count(graph->count, MIN_SCENE_NODES_PER_JOB);
+
+    // Each job starts at the first root past its share of the nodes, so no
+    // subtree is split between jobs
+    struct PRGLSceneJob jobs[PRGL_MAX_PARALLEL_JOBS];
+    int num_jobs = 0;
+    int first_node = 0;
+    for (int t = 1; t <= num_ranges && first_node < graph->count; t++)
+    {
+        int end_node = (int)((long)graph->count * t / num_ranges);
+        end_node = end_node <= first_node ? first_node + 1 : end_node;
+        while (end_node < graph->count && graph->parents[end_node] >= 0)
+        {
+            end_node++;
+        }
+        jobs[num_jobs++] = (struct PRGLSceneJob){
+            .graph = graph,
+            .first_node = first_node,
+            .end_node = end_node,
+        };
+        first_node = end_node;
+    }
+
+    prgl_run_parallel(jobs, sizeof(jobs[0]), num_jobs, prgl_run_scene_job);
+}
+
+/**
+ * Makes sure a scene graph's arrays can hold the given number of nodes.
+ *
+ * @param graph[in,out]
+ * @param capacity
+ * @return False if memory couldn't be allocated.
+ */
+static bool prgl_reserve_scene_nodes(
+    struct PRGLSceneGraph *const graph, int capacity
+)
+{
+    struct PRGLGameObject **nodes =
+        realloc(graph->nodes, sizeof(struct PRGLGameObject *) * capacity);
+    if (nodes != NULL)
+    {
+        graph->nodes = nodes;
+    }
+    int *parents = realloc(graph->parents, sizeof(int) * capacity);
+    if (parents != NULL)
+    {
+        graph->parents = parents;
+    }
+    bool *changed = realloc(graph->changed, sizeof(bool) * capacity);
+    if (changed != NULL)
+    {
+        graph->changed = changed;
+    }
+    if (nodes == NULL || parents == NULL || changed == NULL)
+    {
+        fprintf(
+            stderr, "prgl_reserve_scene_nodes: Error allocating scene graph "
+                    "memory!\n"
+        );
+        return false;
+    }
+
+    graph->capacity = capacity;
+    return true;
+}
+
+/**
+ * Finds a game object's node in a scene graph.
+ *
+ * @param graph[in]
+ * @param game_obj[in]
+ * @return The node index, or -1 if the game object isn't in the graph.
+ */
+static int prgl_find_scene_node(
+    const struct PRGLSceneGraph *const graph,
+    const struct PRGLGameObject *const game_obj
+)
+{
+    for (int i = 0; i < graph->count; i++)
+    {
+        if (graph->nodes[i] == game_obj)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Finds the end of a node's subtree. Subtrees are contiguous, so the first
+ * node after it is the first one whose parent comes before the node.
+ *
+ * @param graph[in]
+ * @param node
+ * @return One past the last node of the subtree.
+ */
+static int prgl_subtree_end(const struct PRGLSceneGraph *const graph, int node)
+{
+    int end = node + 1;
+    while (end < graph->count && graph->parents[end] >= node)
+    {
+        end++;
+    }
+    return end;
+}
+
+/**
+ * Updates the world matrices of a job's nodes. A node is recomputed if it
+ * moved or its parent's world transform changed, parents are always updated
+ * first since they come earlier in the same range.
+ *
+ * @param job[in] A struct PRGLSceneJob.
+ */
+static void prgl_run_scene_job(void *job)
+{
+    const struct PRGLSceneJob *const scene_job = job;
+    struct PRGLSceneGraph *const graph = scene_job->graph;
+    for (int i = scene_job->first_node; i < scene_job->end_node; i++)
+    {
+        struct PRGLGameObject *const game_obj = graph->nodes[i];
+        const int parent = graph->parents[i];
+        graph->changed[i] = game_obj->transform_dirty
+                         || (parent >= 0 && graph->changed[parent]);
+        if (graph->changed[i])
+        {
+            game_obj->transform_dirty = true;
+            prgl_update_game_object_transform(game_obj);
+        }
+    }
+}
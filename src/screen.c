@@ -1,6 +1,9 @@
 #include "glad.h"
 #include "screen.h"
 #include "screen_internal.h"
+#include "common_macros.h"
+#include "gl_extensions_internal.h"
+#include "gl_state_internal.h"
 #include <GLFW/glfw3.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -22,8 +25,6 @@ void prgl_create_window(const char *const name)
         exit(EXIT_FAILURE);
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
@@ -42,8 +43,16 @@ void prgl_create_window(const char *const name)
     glfwWindowHint(GLFW_BLUE_BITS, mode->blueBits);
     glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
 
-    GLFWwindow *window =
-        glfwCreateWindow(mode->width, mode->height, name, monitor, NULL);
+    // 4.3 enables multi draw indirect, everything else only needs 3.3
+    const int context_versions[][2] = {{4, 3}, {3, 3}};
+    GLFWwindow *window = NULL;
+    for (size_t v = 0; v < ARR_LEN(context_versions) && window == NULL; v++)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, context_versions[v][0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, context_versions[v][1]);
+        window =
+            glfwCreateWindow(mode->width, mode->height, name, monitor, NULL);
+    }
     if (window == NULL)
     {
         fprintf(stderr, "new_window: Failed to create GLFW window\n");
@@ -59,9 +68,10 @@ void prgl_create_window(const char *const name)
         glfwTerminate();
         exit(EXIT_FAILURE);
     }
+    prgl_load_gl_extensions();
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
+    prgl_gl_set_capability(GL_DEPTH_TEST, true);
+    prgl_gl_set_capability(GL_CULL_FACE, true);
     glCullFace(GL_BACK);
 
     prgl_screen_data = (struct PRGLScreen
@@ -0,0 +1,425 @@
+#include "glad.h"
+
+#include "shader_cache_internal.h"
+#include "shaders.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gl_extensions_internal.h"
+
+// File layout: magic, driver string length and string, then entries of key,
+// binary format, binary length and binary until the end of the file
+static const char CACHE_MAGIC[8] = {'P', 'R', 'G', 'L', 'S', 'C', '1', '\0'};
+static const char *const DEFAULT_CACHE_PATH = "prgl_shader_cache.bin";
+
+/**
+ * A program binary read from or added to the cache.
+ */
+struct PRGLCachedProgram
+{
+    uint64_t key;
+    GLenum format;
+    GLsizei length;
+    void *binary;
+
+    /// @brief Loaded or stored this session, only these are written back.
+    bool used;
+};
+
+static char *prgl_cache_path = NULL;
+static bool prgl_cache_disabled = false;
+
+static bool prgl_cache_active = false;
+static bool prgl_cache_dirty = false;
+static char *prgl_cache_driver = NULL;
+static struct PRGLCachedProgram *prgl_cached_programs = NULL;
+static int prgl_num_cached_programs = 0;
+static int prgl_cached_programs_capacity = 0;
+
+static char *prgl_driver_string(void);
+static void prgl_read_shader_cache(const char *const path);
+static void prgl_write_shader_cache(const char *const path);
+static bool prgl_add_cached_program(struct PRGLCachedProgram program);
+static int prgl_find_cached_program(uint64_t key);
+
+void prgl_set_shader_cache_path(const char *const path)
+{
+    free(prgl_cache_path);
+    prgl_cache_path = NULL;
+    prgl_cache_disabled = path == NULL;
+    if (path == NULL)
+    {
+        return;
+    }
+
+    const size_t length = strlen(path) + 1;
+    prgl_cache_path = malloc(length);
+    if (prgl_cache_path == NULL)
+    {
+        fprintf(
+            stderr, "prgl_set_shader_cache_path: Error allocating path "
+                    "memory, using the default path!\n"
+        );
+        return;
+    }
+    memcpy(prgl_cache_path, path, length);
+}
+
+void prgl_init_shader_cache(void)
+{
+    prgl_cache_active = false;
+    prgl_cache_dirty = false;
+    if (prgl_cache_disabled || !prgl_gl_program_binary_loaded())
+    {
+        return;
+    }
+
+    // Binaries are only valid for the driver that made them
+    prgl_cache_driver = prgl_driver_string();
+    if (prgl_cache_driver == NULL)
+    {
+        return;
+    }
+
+    prgl_cache_active = true;
+    prgl_read_shader_cache(
+        prgl_cache_path != NULL ? prgl_cache_path : DEFAULT_CACHE_PATH
+    );
+}
+
+void prgl_delete_shader_cache(void)
+{
+    if (prgl_cache_active && prgl_cache_dirty)
+    {
+        prgl_write_shader_cache(
+            prgl_cache_path != NULL ? prgl_cache_path : DEFAULT_CACHE_PATH
+        );
+    }
+
+    for (int i = 0; i < prgl_num_cached_programs; i++)
+    {
+        free(prgl_cached_programs[i].binary);
+    }
+    free(prgl_cached_programs);
+    free(prgl_cache_driver);
+    prgl_cached_programs = NULL;
+    prgl_num_cached_programs = 0;
+    prgl_cached_programs_capacity = 0;
+    prgl_cache_driver = NULL;
+    prgl_cache_active = false;
+    prgl_cache_dirty = false;
+}
+
+uint64_t prgl_hash_shader_stage(
+    uint64_t hash, GLenum stage, const char *const source[], int num_sources
+)
+{
+    // FNV-1a over the stage type and each source string
+    const uint64_t prime = 1099511628211ull;
+    for (size_t i = 0; i < sizeof(stage); i++)
+    {
+        hash = (hash ^ ((stage >> (i * 8)) & 0xFF)) * prime;
+    }
+    for (int i = 0; i < num_sources; i++)
+    {
+        for (const char *c = source[i]; *c != '\0'; c++)
+        {
+            hash = (hash ^ (unsigned char)*c) * prime;
+        }
+    }
+
+    return hash;
+}
+
+void prgl_prepare_cached_program(GLuint program)
+{
+    if (prgl_cache_active)
+    {
+        prgl_gl_program_parameteri(
+            program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE
+        );
+    }
+}
+
+GLuint prgl_load_cached_program(uint64_t key)
+{
+    if (!prgl_cache_active)
+    {
+        return 0;
+    }
+
+    const int index = prgl_find_cached_program(key);
+    if (index < 0)
+    {
+        return 0;
+    }
+
+    struct PRGLCachedProgram *const cached = &prgl_cached_programs[index];
+    GLuint program = glCreateProgram();
+    prgl_gl_program_binary(
+        program, cached->format, cached->binary, cached->length
+    );
+
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success)
+    {
+        cached->used = true;
+        return program;
+    }
+
+    // The driver can refuse binaries at any time, e.g. after an update which
+    // kept the version string. Drop it so it's replaced once recompiled.
+    glDeleteProgram(program);
+    free(cached->binary);
+    prgl_cached_programs[index] =
+        prgl_cached_programs[--prgl_num_cached_programs];
+    prgl_cache_dirty = true;
+    return 0;
+}
+
+void prgl_store_cached_program(uint64_t key, GLuint program)
+{
+    if (!prgl_cache_active)
+    {
+        return;
+    }
+    const int index = prgl_find_cached_program(key);
+    if (index >= 0)
+    {
+        prgl_cached_programs[index].used = true;
+        return;
+    }
+
+    GLint success = GL_FALSE;
+    GLint length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!success || length <= 0)
+    {
+        return;
+    }
+
+    struct PRGLCachedProgram cached = {
+        .key = key, .binary = malloc(length), .used = true
+    };
+    if (cached.binary == NULL)
+    {
+        fprintf(
+            stderr, "prgl_store_cached_program: Error allocating binary "
+                    "memory!\n"
+        );
+        return;
+    }
+
+    prgl_gl_get_program_binary(
+        program, length, &cached.length, &cached.format, cached.binary
+    );
+    if (cached.length <= 0 || !prgl_add_cached_program(cached))
+    {
+        free(cached.binary);
+        return;
+    }
+    prgl_cache_dirty = true;
+}
+
+/**
+ * Builds the string identifying the driver binaries are valid for.
+ *
+ * @return The vendor, renderer and version strings separated by newlines, or
+ * NULL if memory couldn't be allocated. Must be freed.
+ */
+static char *prgl_driver_string(void)
+{
+    const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    const char *strings[3];
+    size_t length = 1;
+    for (size_t i = 0; i < 3; i++)
+    {
+        strings[i] = (const char *)glGetString(names[i]);
+        strings[i] = strings[i] != NULL ? strings[i] : "";
+        length += strlen(strings[i]) + 1;
+    }
+
+    char *driver = malloc(length);
+    if (driver == NULL)
+    {
+        fprintf(
+            stderr, "prgl_driver_string: Error allocating driver string "
+                    "memory!\n"
+        );
+        return NULL;
+    }
+
+    snprintf(
+        driver, length, "%s\n%s\n%s\n", strings[0], strings[1], strings[2]
+    );
+    return driver;
+}
+
+/**
+ * Reads the programs in a cache file. Missing files, files from another driver
+ * and truncated entries are ignored, so those programs are recompiled.
+ *
+ * @param path[in]
+ */
+static void prgl_read_shader_cache(const char *const path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return;
+    }
+
+    char magic[sizeof(CACHE_MAGIC)];
+    uint32_t driver_length = 0;
+    const size_t expected_length = strlen(prgl_cache_driver);
+    if (fread(magic, sizeof(magic), 1, file) != 1
+        || memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0
+        || fread(&driver_length, sizeof(driver_length), 1, file) != 1
+        || driver_length != expected_length)
+    {
+        fclose(file);
+        return;
+    }
+
+    char *driver = malloc(expected_length);
+    if (driver == NULL
+        || fread(driver, 1, expected_length, file) != expected_length
+        || memcmp(driver, prgl_cache_driver, expected_length) != 0)
+    {
+        free(driver);
+        fclose(file);
+        return;
+    }
+    free(driver);
+
+    while (true)
+    {
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+        if (fread(&key, sizeof(key), 1, file) != 1
+            || fread(&format, sizeof(format), 1, file) != 1
+            || fread(&length, sizeof(length), 1, file) != 1 || length == 0
+            || length > INT32_MAX)
+        {
+            break;
+        }
+
+        struct PRGLCachedProgram cached = {
+            .key = key,
+            .format = (GLenum)format,
+            .length = (GLsizei)length,
+            .binary = malloc(length),
+        };
+        if (cached.binary == NULL
+            || fread(cached.binary, 1, length, file) != length
+            || !prgl_add_cached_program(cached))
+        {
+            free(cached.binary);
+            break;
+        }
+    }
+
+    fclose(file);
+}
+
+/**
+ * Writes the programs used this session to a cache file, replacing it.
+ * Programs which were only read from the file are dropped, so binaries for
+ * shaders which changed or aren't built anymore don't pile up.
+ *
+ * @param path[in]
+ */
+static void prgl_write_shader_cache(const char *const path)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        fprintf(
+            stderr, "prgl_write_shader_cache: Couldn't open %s for writing\n",
+            path
+        );
+        return;
+    }
+
+    const uint32_t driver_length = (uint32_t)strlen(prgl_cache_driver);
+    bool written =
+        fwrite(CACHE_MAGIC, sizeof(CACHE_MAGIC), 1, file) == 1
+        && fwrite(&driver_length, sizeof(driver_length), 1, file) == 1
+        && fwrite(prgl_cache_driver, 1, driver_length, file) == driver_length;
+    for (int i = 0; written && i < prgl_num_cached_programs; i++)
+    {
+        const struct PRGLCachedProgram *const cached =
+            &prgl_cached_programs[i];
+        if (!cached->used)
+        {
+            continue;
+        }
+        const uint32_t format = (uint32_t)cached->format;
+        const uint32_t length = (uint32_t)cached->length;
+        written = fwrite(&cached->key, sizeof(cached->key), 1, file) == 1
+               && fwrite(&format, sizeof(format), 1, file) == 1
+               && fwrite(&length, sizeof(length), 1, file) == 1
+               && fwrite(cached->binary, 1, length, file) == length;
+    }
+
+    if (fclose(file) != 0 || !written)
+    {
+        // A partial file is still read up to the first bad entry
+        fprintf(
+            stderr, "prgl_write_shader_cache: Failed writing %s\n", path
+        );
+    }
+}
+
+/**
+ * Appends a program to the cache, which takes ownership of its binary.
+ *
+ * @param program
+ * @return False if memory couldn't be allocated, the binary isn't taken.
+ */
+static bool prgl_add_cached_program(struct PRGLCachedProgram program)
+{
+    if (prgl_num_cached_programs == prgl_cached_programs_capacity)
+    {
+        int capacity = prgl_cached_programs_capacity == 0
+                         ? 16
+                         : prgl_cached_programs_capacity * 2;
+        struct PRGLCachedProgram *programs = realloc(
+            prgl_cached_programs, sizeof(struct PRGLCachedProgram) * capacity
+        );
+        if (programs == NULL)
+        {
+            fprintf(
+                stderr, "prgl_add_cached_program: Error allocating cache "
+                        "memory!\n"
+            );
+            return false;
+        }
+        prgl_cached_programs = programs;
+        prgl_cached_programs_capacity = capacity;
+    }
+
+    prgl_cached_programs[prgl_num_cached_programs++] = program;
+    return true;
+}
+
+/**
+ * @param key
+ * @return The index of the cached program with the key, or -1.
+ */
+static int prgl_find_cached_program(uint64_t key)
+{
+    for (int i = 0; i < prgl_num_cached_programs; i++)
+    {
+        if (prgl_cached_programs[i].key == key)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
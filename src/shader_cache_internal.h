@@ -0,0 +1,64 @@
+#ifndef PRGL_SHADER_CACHE_INTERNAL_H
+#define PRGL_SHADER_CACHE_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "glad.h"
+
+/**
+ * Hash to start prgl_hash_shader_stage() from.
+ */
+#define PRGL_SHADER_HASH_SEED 14695981039346656037ull
+
+/**
+ * Reads the program binary cache file if program binaries are supported and
+ * the file was written by the same driver. Should be called once before any
+ * shader is created.
+ */
+void prgl_init_shader_cache(void);
+
+/**
+ * Writes any programs added since the cache was read back to the cache file
+ * and frees the cache.
+ */
+void prgl_delete_shader_cache(void);
+
+/**
+ * Adds the sources of one shader stage to a program's cache key.
+ *
+ * @param hash The key so far, PRGL_SHADER_HASH_SEED for the first stage.
+ * @param stage The GL shader type of the stage.
+ * @param source[in] Strings the stage is compiled from.
+ * @param num_sources
+ * @return The updated key.
+ */
+uint64_t prgl_hash_shader_stage(
+    uint64_t hash, GLenum stage, const char *const source[], int num_sources
+);
+
+/**
+ * Marks a program so its binary can be retrieved once linked, if the cache is
+ * in use. Must be called before the program is linked.
+ *
+ * @param program
+ */
+void prgl_prepare_cached_program(GLuint program);
+
+/**
+ * Creates a program from the cached binary for a key.
+ *
+ * @param key
+ * @return The linked program, or 0 if there is no usable binary for the key.
+ */
+GLuint prgl_load_cached_program(uint64_t key);
+
+/**
+ * Adds a linked program's binary to the cache under a key.
+ *
+ * @param key
+ * @param program A program prepared with prgl_prepare_cached_program().
+ */
+void prgl_store_cached_program(uint64_t key, GLuint program);
+
+#endif
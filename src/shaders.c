@@ -5,15 +5,29 @@
 #include "shaders_init_internal.h"
 
 #include <GLFW/glfw3.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 
 #include "camera.h"
+#include "frame_uniforms_internal.h"
+#include "gl_extensions_internal.h"
+#include "gl_state_internal.h"
+#include "lighting.h"
+#include "light_clusters_internal.h"
+#include "lighting_internal.h"
+#include "mesh_internal.h"
+#include "object_lights_internal.h"
 #include "render.h"
+#include "shader_cache_internal.h"
 #include "types.h"
 #include "cglm/vec2.h"
 
 const char *const PRGL_MODEL_UNIFORM = "model";
+const char *const PRGL_VIEW_UNIFORM = "view";
+const char *const PRGL_PROJECTION_UNIFORM = "projection";
 const char *const PRGL_NORMAL_MATRIX_UNIFORM = "normalMatrix";
 const char *const PRGL_NUM_POINT_LIGHTS_UNIFORM = "numPointLights";
 const char *const PRGL_LIGHT_COLOR_UNIFORM = "color";
@@ -25,19 +39,126 @@ const char *const PRGL_RENDER_RESOLUTION_UNIFORM = "renderResolution";
 const char *const PRGL_TILE_FACTOR_UNIFORM = "tileFactor";
 const char *const PRGL_FILL_COLOR_UNIFORM = "fillColor";
 const char *const PRGL_USE_TEXTURE_UNIFORM = "useTexture";
+const char *const PRGL_ALPHA_UNIFORM = "alpha";
+
+// Largest uniform value we cache for de-duplication, a mat4.
+#define PRGL_UNIFORM_CACHE_MAX_FLOATS 16
+
+// Variant keys are the PRGLShaderFeature bits with the light bucket above them
+#define PRGL_SHADER_FEATURE_BITS 8
+#define PRGL_SHADER_FEATURE_MASK ((1u << PRGL_SHADER_FEATURE_BITS) - 1)
+#define PRGL_NUM_LIGHT_BUCKETS 5
+#define PRGL_NUM_SHADER_VARIANTS                                               \
+    (PRGL_NUM_LIGHT_BUCKETS << PRGL_SHADER_FEATURE_BITS)
+
+// Light loop bounds lit variants are built for, a draw uses the smallest one
+// that fits the current number of point lights. The last is clustered.
+static const int LIGHT_BUCKETS[PRGL_NUM_LIGHT_BUCKETS] = {
+    0, 1, 4, PRGL_MAX_UNCLUSTERED_POINT_LIGHTS, PRGL_MAX_POINT_LIGHTS
+};
+
+/**
+ * A cached uniform location and the last value uploaded to it.
+ */
+struct PRGLUniformCacheEntry
+{
+    char *name;
+    uint32_t hash;
+    GLint location;
+    bool has_value;
+    GLfloat value[PRGL_UNIFORM_CACHE_MAX_FLOATS];
+};
+
+/**
+ * Uniform locations for one shader program, reflected when it is linked.
+ * Names are found through an open addressing hash table of entry indices.
+ */
+struct PRGLUniformCache
+{
+    GLuint shader_id;
+    int num_entries;
+    int entries_capacity;
+    struct PRGLUniformCacheEntry *entries;
+
+    /// Power of two sized, -1 marks an empty bucket.
+    int *buckets;
+    int num_buckets;
+
+    PRGLUniform builtins[PRGL_BUILTIN_UNIFORM_COUNT];
+};
 
 static PRGLShader prgl_shader_pool[PRGL_SHADER_TYPE_COUNT];
 static PRGLShader prgl_current_shader_ref;
+static bool prgl_vertex_wobble = true;
+static bool prgl_affine_mapping = true;
+static bool prgl_geometry_shader_affine = false;
+
+// Compiled 3D variants indexed by key, and the keys compiled so far
+static PRGLShader prgl_shader_variants[PRGL_NUM_SHADER_VARIANTS];
+static unsigned prgl_variant_keys[PRGL_NUM_SHADER_VARIANTS];
+static int prgl_num_variants = 0;
+
+/**
+ * A program handed to the driver whose compile and link results haven't been
+ * checked yet. Checking them right away would wait for the driver, so it's
+ * put off until the program is needed or has finished in the background.
+ */
+struct PRGLPendingProgram
+{
+    GLuint program;
+    GLuint shaders[3];
+    int num_shaders;
+    uint64_t key;
+};
+
+static struct PRGLShaderStats prgl_shader_build_stats = {0};
+
+static struct PRGLPendingProgram *prgl_pending_programs = NULL;
+static int prgl_num_pending_programs = 0;
+static int prgl_pending_programs_capacity = 0;
+
+static struct PRGLUniformCache **prgl_uniform_caches = NULL;
+static int prgl_num_uniform_caches = 0;
+static int prgl_uniform_caches_capacity = 0;
+static struct PRGLUniformCache *prgl_current_uniform_cache = NULL;
 
 static GLuint prgl_compile_shader(
     int gl_shader_type, const char *const shader_source[], int num_sources
 );
 
-static PRGLShader prgl_create_shader_program(GLuint shaders[], size_t length);
+static PRGLShader prgl_submit_shader_program(
+    GLuint shaders[], int length, uint64_t key
+);
+static void prgl_setup_shader_program(PRGLShader shader_program);
+static int prgl_find_pending_program(GLuint program);
+static bool prgl_pending_program_done(int index);
+static void prgl_finish_pending_program(int index);
+static void prgl_drop_pending_program(int index);
+static void prgl_wait_for_shader(GLuint program);
 
 static void prgl_validate_shader(GLuint shader);
 static void prgl_validate_shader_program(PRGLShader shader_program);
 
+static void prgl_bind_uniform_blocks(PRGLShader shader_program);
+static void prgl_bind_sampler_units(PRGLShader shader_program);
+static void prgl_create_uniform_cache(PRGLShader shader_program);
+static void prgl_delete_uniform_cache(GLuint shader_id);
+static struct PRGLUniformCache *prgl_find_uniform_cache(GLuint shader_id);
+static int prgl_uniform_cache_find(
+    struct PRGLUniformCache *const cache, const char *const name, uint32_t hash
+);
+static int prgl_uniform_cache_add(
+    struct PRGLUniformCache *const cache, const char *const name,
+    GLint location
+);
+static bool prgl_uniform_value_changed(
+    PRGLUniform uniform, const void *const value, size_t size
+);
+static uint32_t prgl_hash_uniform_name(const char *const name);
+static unsigned prgl_variant_key(unsigned features, int bucket);
+static PRGLShader prgl_shader_variant(unsigned key);
+static void prgl_update_variant_pool(void);
+
 PRGLShader prgl_shader(enum PRGLShaderType type)
 {
     return prgl_shader_pool[type];
@@ -51,7 +172,34 @@ PRGLShader prgl_create_shader(
     const char *const geometry_source[], int num_geometry_sources
 )
 {
-    // Create a basic vertex shader
+    const double start_time = glfwGetTime();
+
+    // Use the cached binary if these sources were linked before
+    uint64_t key = prgl_hash_shader_stage(
+        PRGL_SHADER_HASH_SEED, GL_VERTEX_SHADER, vertex_source,
+        num_vertex_sources
+    );
+    key = prgl_hash_shader_stage(
+        key, GL_FRAGMENT_SHADER, frag_source, num_frag_sources
+    );
+    if (geometry_source != NULL)
+    {
+        key = prgl_hash_shader_stage(
+            key, GL_GEOMETRY_SHADER, geometry_source, num_geometry_sources
+        );
+    }
+
+    PRGLShader shader_program = {.id = prgl_load_cached_program(key)};
+    if (shader_program.id != 0)
+    {
+        prgl_setup_shader_program(shader_program);
+        prgl_shader_build_stats.programs_cached++;
+        prgl_shader_build_stats.build_seconds += glfwGetTime() - start_time;
+        return shader_program;
+    }
+
+    // Stages are only submitted here, results are checked once the program
+    // is needed so the driver can compile them in the background
     GLuint vertex_shader = prgl_compile_shader(
         GL_VERTEX_SHADER, vertex_source, num_vertex_sources
     );
@@ -73,22 +221,80 @@ PRGLShader prgl_create_shader(
 
     // Use a shader program to link the shaders together
     GLuint shaders[3] = {vertex_shader, fragment_shader, geometry_shader};
-    PRGLShader shader_program =
-        prgl_create_shader_program(shaders, shader_count);
+    shader_program = prgl_submit_shader_program(shaders, shader_count, key);
+
+    prgl_shader_build_stats.build_seconds += glfwGetTime() - start_time;
+    return shader_program;
+}
 
-    // Delete the shader objects, we're done with them
-    for (int i = 0; i < shader_count; i++)
+PRGLShader prgl_create_compute_shader(
+    const char *const source[], int num_sources
+)
+{
+    const double start_time = glfwGetTime();
+    const uint64_t key = prgl_hash_shader_stage(
+        PRGL_SHADER_HASH_SEED, GL_COMPUTE_SHADER, source, num_sources
+    );
+    PRGLShader shader_program = {.id = prgl_load_cached_program(key)};
+    if (shader_program.id != 0)
     {
-        glDeleteShader(shaders[i]);
+        prgl_setup_shader_program(shader_program);
+        prgl_shader_build_stats.programs_cached++;
+        prgl_shader_build_stats.build_seconds += glfwGetTime() - start_time;
+        return shader_program;
     }
 
+    GLuint compute_shader =
+        prgl_compile_shader(GL_COMPUTE_SHADER, source, num_sources);
+    shader_program = prgl_submit_shader_program(&compute_shader, 1, key);
+
+    prgl_shader_build_stats.build_seconds += glfwGetTime() - start_time;
     return shader_program;
 }
 
+bool prgl_shader_ready(PRGLShader shader)
+{
+    const int index = prgl_find_pending_program(shader.id);
+    if (index < 0)
+    {
+        return true;
+    }
+    if (!prgl_pending_program_done(index))
+    {
+        return false;
+    }
+
+    prgl_finish_pending_program(index);
+    return true;
+}
+
+bool prgl_shaders_ready(void)
+{
+    // Finishing swaps the last program into the gap, so go backwards
+    for (int i = prgl_num_pending_programs - 1; i >= 0; i--)
+    {
+        if (prgl_pending_program_done(i))
+        {
+            prgl_finish_pending_program(i);
+        }
+    }
+
+    return prgl_num_pending_programs == 0;
+}
+
+struct PRGLShaderStats prgl_shader_stats(void)
+{
+    struct PRGLShaderStats stats = prgl_shader_build_stats;
+    stats.programs_compiling = prgl_num_pending_programs;
+    return stats;
+}
+
 void prgl_use_shader(PRGLShader shader)
 {
-    glUseProgram(shader.id);
+    prgl_wait_for_shader(shader.id);
+    prgl_gl_use_program(shader.id);
     prgl_current_shader_ref = shader;
+    prgl_current_uniform_cache = prgl_find_uniform_cache(shader.id);
 
     struct PRGLCamera *cam = prgl_active_camera();
     if (cam)
@@ -114,81 +320,288 @@ void prgl_use_shader_2d(void)
     prgl_set_default_shared_uniforms(false);
 }
 
-void prgl_delete_shader(PRGLShader shader) { glDeleteProgram(shader.id); }
+void prgl_set_vertex_wobble_enabled(bool enabled)
+{
+    prgl_vertex_wobble = enabled;
+    prgl_update_variant_pool();
+}
+
+void prgl_set_affine_mapping_enabled(bool enabled)
+{
+    prgl_affine_mapping = enabled;
+    prgl_update_variant_pool();
+}
+
+void prgl_set_geometry_shader_affine_enabled(bool enabled)
+{
+    prgl_geometry_shader_affine = enabled;
+    prgl_update_variant_pool();
+}
+
+void prgl_delete_shader(PRGLShader shader)
+{
+    const int index = prgl_find_pending_program(shader.id);
+    if (index >= 0)
+    {
+        prgl_drop_pending_program(index);
+    }
+    prgl_delete_uniform_cache(shader.id);
+    prgl_gl_delete_program(shader.id);
+}
 
 void prgl_set_shader_uniform_4f(
     PRGLShader shader, const char *const name, float a, float b, float c,
     float d
 )
 {
-    glUniform4f(glGetUniformLocation(shader.id, name), a, b, c, d);
+    prgl_set_uniform_4f(prgl_uniform_handle(shader, name), a, b, c, d);
 }
 
 void prgl_set_shader_uniform_vec3(
     PRGLShader shader, const char *const name, vec3 vec
 )
 {
-    glUniform3fv(glGetUniformLocation(shader.id, name), 1, vec);
+    prgl_set_uniform_vec3(prgl_uniform_handle(shader, name), vec);
 }
 
 void prgl_set_shader_uniform_vec2(
     PRGLShader shader, const char *const name, vec2 vec
 )
 {
-    glUniform2fv(glGetUniformLocation(shader.id, name), 1, vec);
+    prgl_set_uniform_vec2(prgl_uniform_handle(shader, name), vec);
 }
 
 void prgl_set_shader_uniform_mat4(
     PRGLShader shader, const char *const name, mat4 matrix
 )
 {
-    glUniformMatrix4fv(
-        glGetUniformLocation(shader.id, name), 1, GL_FALSE, (float *)matrix
-    );
+    prgl_set_uniform_mat4(prgl_uniform_handle(shader, name), matrix);
 }
 
 void prgl_set_shader_uniform_mat3(
     PRGLShader shader, const char *const name, mat3 matrix
 )
 {
-    glUniformMatrix3fv(
-        glGetUniformLocation(shader.id, name), 1, GL_FALSE, (float *)matrix
-    );
+    prgl_set_uniform_mat3(prgl_uniform_handle(shader, name), matrix);
 }
 
 void prgl_set_shader_uniform_float(
     PRGLShader shader, const char *const name, float value
 )
 {
-    glUniform1f(glGetUniformLocation(shader.id, name), value);
+    prgl_set_uniform_float(prgl_uniform_handle(shader, name), value);
 }
 
 void prgl_set_shader_uniform_int(
     PRGLShader shader, const char *const name, int value
 )
 {
-    glUniform1i(glGetUniformLocation(shader.id, name), value);
+    prgl_set_uniform_int(prgl_uniform_handle(shader, name), value);
 }
 
 void prgl_set_shader_uniform_bool(
     PRGLShader shader, const char *const name, bool value
 )
 {
-    glUniform1i(glGetUniformLocation(shader.id, name), (int)value);
+    prgl_set_uniform_bool(prgl_uniform_handle(shader, name), value);
+}
+
+PRGLUniform prgl_uniform_handle(PRGLShader shader, const char *const name)
+{
+    // Uniforms are reflected once the program has linked
+    prgl_wait_for_shader(shader.id);
+    struct PRGLUniformCache *const cache = prgl_find_uniform_cache(shader.id);
+    if (cache == NULL)
+    {
+        // Not a program prgl linked, so there's nothing to cache against
+        return (PRGLUniform){
+            .shader_id = shader.id,
+            .location = glGetUniformLocation(shader.id, name),
+            .slot = -1,
+        };
+    }
+
+    int slot = prgl_uniform_cache_find(
+        cache, name, prgl_hash_uniform_name(name)
+    );
+    if (slot < 0)
+    {
+        // Names reflection doesn't list, e.g. "arr[3]" of a basic type array.
+        // Misses are cached too so a bad name only costs one driver lookup.
+        slot = prgl_uniform_cache_add(
+            cache, name, glGetUniformLocation(shader.id, name)
+        );
+    }
+
+    return (PRGLUniform){
+        .shader_id = shader.id,
+        .location = slot < 0 ? glGetUniformLocation(shader.id, name)
+                             : cache->entries[slot].location,
+        .slot = slot,
+    };
+}
+
+void prgl_set_uniform_4f(
+    PRGLUniform uniform, float a, float b, float c, float d
+)
+{
+    const GLfloat value[4] = {a, b, c, d};
+    if (prgl_uniform_value_changed(uniform, value, sizeof(value)))
+    {
+        glUniform4f(uniform.location, a, b, c, d);
+    }
+}
+
+void prgl_set_uniform_vec3(PRGLUniform uniform, vec3 vec)
+{
+    if (prgl_uniform_value_changed(uniform, vec, sizeof(vec3)))
+    {
+        glUniform3fv(uniform.location, 1, vec);
+    }
+}
+
+void prgl_set_uniform_vec2(PRGLUniform uniform, vec2 vec)
+{
+    if (prgl_uniform_value_changed(uniform, vec, sizeof(vec2)))
+    {
+        glUniform2fv(uniform.location, 1, vec);
+    }
+}
+
+void prgl_set_uniform_mat4(PRGLUniform uniform, mat4 matrix)
+{
+    if (prgl_uniform_value_changed(uniform, matrix, sizeof(mat4)))
+    {
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, (float *)matrix);
+    }
+}
+
+void prgl_set_uniform_mat3(PRGLUniform uniform, mat3 matrix)
+{
+    if (prgl_uniform_value_changed(uniform, matrix, sizeof(mat3)))
+    {
+        glUniformMatrix3fv(uniform.location, 1, GL_FALSE, (float *)matrix);
+    }
+}
+
+void prgl_set_uniform_float(PRGLUniform uniform, float value)
+{
+    if (prgl_uniform_value_changed(uniform, &value, sizeof(value)))
+    {
+        glUniform1f(uniform.location, value);
+    }
+}
+
+void prgl_set_uniform_int(PRGLUniform uniform, int value)
+{
+    if (prgl_uniform_value_changed(uniform, &value, sizeof(value)))
+    {
+        glUniform1i(uniform.location, value);
+    }
+}
+
+void prgl_set_uniform_bool(PRGLUniform uniform, bool value)
+{
+    prgl_set_uniform_int(uniform, (int)value);
+}
+
+PRGLShader prgl_draw_shader_variant(
+    PRGLShader shader, const struct PRGLMesh *const mesh, bool instanced
+)
+{
+    unsigned features;
+    if (!prgl_shader_variant_features(shader, &features))
+    {
+        return shader;
+    }
+
+    features &= PRGL_SHADER_FEATURE_LIT;
+    features |= mesh->texture.id != 0 ? PRGL_SHADER_FEATURE_TEXTURED : 0;
+    features |= mesh->baked_lighting != NULL ? PRGL_SHADER_FEATURE_BAKED : 0;
+    features |= instanced ? PRGL_SHADER_FEATURE_INSTANCED : 0;
+
+    // Draws with their own lights don't loop over the rest
+    if ((features & PRGL_SHADER_FEATURE_LIT) && prgl_object_lights_active())
+    {
+        features |= PRGL_SHADER_FEATURE_OBJECT_LIGHTS;
+        return prgl_shader_variant(prgl_variant_key(features, 0));
+    }
+
+    int bucket = 0;
+    const int num_lights = prgl_num_point_lights();
+    while (LIGHT_BUCKETS[bucket] < num_lights)
+    {
+        bucket++;
+    }
+
+    if ((features & PRGL_SHADER_FEATURE_LIT)
+        && LIGHT_BUCKETS[bucket] > PRGL_MAX_UNCLUSTERED_POINT_LIGHTS)
+    {
+        prgl_update_light_clusters();
+    }
+    return prgl_shader_variant(prgl_variant_key(features, bucket));
+}
+
+bool prgl_shader_variant_features(PRGLShader shader, unsigned *const features)
+{
+    for (int i = 0; i < prgl_num_variants; i++)
+    {
+        const unsigned key = prgl_variant_keys[i];
+        if (prgl_shader_variants[key].id == shader.id)
+        {
+            *features = key & PRGL_SHADER_FEATURE_MASK;
+            return true;
+        }
+    }
+    return false;
+}
+
+PRGLUniform prgl_current_builtin_uniform(enum PRGLBuiltinUniform uniform)
+{
+    if (prgl_current_uniform_cache == NULL)
+    {
+        return (PRGLUniform){
+            .shader_id = prgl_current_shader_ref.id, .location = -1, .slot = -1
+        };
+    }
+
+    return prgl_current_uniform_cache->builtins[uniform];
+}
+
+bool prgl_current_builtin_uniform_value(
+    enum PRGLBuiltinUniform uniform, void *const value, size_t size
+)
+{
+    if (prgl_current_uniform_cache == NULL)
+    {
+        return false;
+    }
+
+    const int slot = prgl_current_uniform_cache->builtins[uniform].slot;
+    if (slot < 0 || !prgl_current_uniform_cache->entries[slot].has_value)
+    {
+        return false;
+    }
+
+    memcpy(value, prgl_current_uniform_cache->entries[slot].value, size);
+    return true;
 }
 
 void prgl_set_default_shared_uniforms(bool is_3d)
 {
-    PRGLShader current_shader = prgl_current_shader();
-    prgl_set_shader_uniform_vec2(
-        current_shader, PRGL_TILE_FACTOR_UNIFORM, GLM_VEC2_ONE
+    prgl_set_uniform_vec2(
+        prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_TILE_FACTOR),
+        GLM_VEC2_ONE
     );
 
     vec2 render_res = {PRGL_RENDER_RESOLUTION[0], PRGL_RENDER_RESOLUTION[1]};
-    prgl_set_shader_uniform_vec2(
-        current_shader, PRGL_RENDER_RESOLUTION_UNIFORM, render_res
+    prgl_set_uniform_vec2(
+        prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_RENDER_RESOLUTION),
+        render_res
     );
 
+    // Built in shaders read the camera from the PRGLFrame block, these are
+    // only active in custom shaders which declare them as plain uniforms
     struct PRGLCamera *cam = prgl_active_camera();
     if (cam == NULL)
     {
@@ -199,44 +612,170 @@ void prgl_set_default_shared_uniforms(bool is_3d)
     }
     else if (is_3d)
     {
-        prgl_set_shader_uniform_mat4(current_shader, "view", cam->view);
-        prgl_set_camera_projection(
-            prgl_active_camera(), prgl_active_camera()->fov,
-            PRGL_CAMERA_PROJECTION_PERSPECTIVE
+        prgl_set_uniform_mat4(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_VIEW), cam->view
+        );
+        prgl_set_uniform_mat4(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_PROJECTION),
+            cam->projection_perspective
         );
     }
     else
     {
-        prgl_set_camera_projection(
-            prgl_active_camera(), 0.0f, PRGL_CAMERA_PROJECTION_ORTHOGONAL
+        prgl_set_uniform_mat4(
+            prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_PROJECTION),
+            cam->projection_orthogonal
         );
     }
 }
 
 void prgl_init_shader_pool(void)
 {
+    prgl_init_shader_cache();
+
     PRGLShader shader_screen = prgl_init_shader_screen();
-    PRGLShader shader_3d = prgl_init_shader_3d();
     PRGLShader shader_2d = prgl_init_shader_2d();
-    PRGLShader shader_unlit = prgl_init_shader_unlit();
+    PRGLShader shader_2d_batched = prgl_init_shader_2d_batched();
 
     // Don't do loop so if we remove any it doesn't break even if out of order
     prgl_shader_pool[PRGL_SHADER_TYPE_SCREEN] = shader_screen;
     prgl_shader_pool[PRGL_SHADER_TYPE_2D] = shader_2d;
-    prgl_shader_pool[PRGL_SHADER_TYPE_3D] = shader_3d;
-    prgl_shader_pool[PRGL_SHADER_TYPE_UNLIT] = shader_unlit;
+    prgl_shader_pool[PRGL_SHADER_TYPE_2D_BATCHED] = shader_2d_batched;
+
+    // The loading screen draws with these, so they're finished before the
+    // variants start compiling in the background
+    prgl_wait_for_shader(shader_screen.id);
+    prgl_wait_for_shader(shader_2d.id);
+    prgl_wait_for_shader(shader_2d_batched.id);
+
+    // The 3D types are variants, other variants are compiled as draws need
+    // them
+    prgl_update_variant_pool();
 }
 
 void prgl_delete_shader_pool(void)
 {
+    // Programs still compiling are finished so their binaries are cached
+    while (prgl_num_pending_programs > 0)
+    {
+        prgl_finish_pending_program(prgl_num_pending_programs - 1);
+    }
+
+    unsigned features;
     for (int i = 0; i < PRGL_SHADER_TYPE_COUNT; i++)
     {
-        glDeleteProgram(prgl_shader_pool[i].id);
+        if (!prgl_shader_variant_features(prgl_shader_pool[i], &features))
+        {
+            prgl_delete_shader(prgl_shader_pool[i]);
+        }
+        prgl_shader_pool[i] = (PRGLShader){0};
     }
+
+    for (int i = 0; i < prgl_num_variants; i++)
+    {
+        const unsigned key = prgl_variant_keys[i];
+        prgl_delete_shader(prgl_shader_variants[key]);
+        prgl_shader_variants[key] = (PRGLShader){0};
+    }
+    prgl_num_variants = 0;
+
+    free(prgl_pending_programs);
+    prgl_pending_programs = NULL;
+    prgl_pending_programs_capacity = 0;
+
+    prgl_delete_shader_cache();
 }
 
 /**
- * Creates a shader using the given shader source code string.
+ * Builds a variant key, dropping features which have no effect without the
+ * features they depend on so equivalent variants share a key.
+ *
+ * @param features PRGLShaderFeature bits, the wobble and affine settings are
+ * added to them.
+ * @param bucket Index into LIGHT_BUCKETS, ignored for unlit variants and ones
+ * with object lights.
+ * @return The variant key.
+ */
+static unsigned prgl_variant_key(unsigned features, int bucket)
+{
+    features |= prgl_vertex_wobble ? PRGL_SHADER_FEATURE_WOBBLE : 0;
+    features |= prgl_affine_mapping ? PRGL_SHADER_FEATURE_AFFINE : 0;
+    features |=
+        prgl_geometry_shader_affine ? PRGL_SHADER_FEATURE_GEOMETRY_SHADER : 0;
+
+    if (!(features & PRGL_SHADER_FEATURE_LIT))
+    {
+        features &= ~(unsigned)(PRGL_SHADER_FEATURE_TEXTURED
+                                | PRGL_SHADER_FEATURE_OBJECT_LIGHTS
+                                | PRGL_SHADER_FEATURE_BAKED);
+        bucket = 0;
+    }
+    if (features & PRGL_SHADER_FEATURE_OBJECT_LIGHTS)
+    {
+        bucket = 0;
+    }
+    if (!(features & PRGL_SHADER_FEATURE_TEXTURED))
+    {
+        features &= ~(unsigned)PRGL_SHADER_FEATURE_AFFINE;
+    }
+    if (!(features & PRGL_SHADER_FEATURE_AFFINE))
+    {
+        features &= ~(unsigned)PRGL_SHADER_FEATURE_GEOMETRY_SHADER;
+    }
+
+    return features | ((unsigned)bucket << PRGL_SHADER_FEATURE_BITS);
+}
+
+/**
+ * Gets a 3D variant, compiling it if this is the first time it's used.
+ *
+ * @param key A key from prgl_variant_key().
+ * @return The variant's shader program.
+ */
+static PRGLShader prgl_shader_variant(unsigned key)
+{
+    if (prgl_shader_variants[key].id == 0)
+    {
+        prgl_shader_variants[key] = prgl_init_shader_3d_variant(
+            key & PRGL_SHADER_FEATURE_MASK,
+            LIGHT_BUCKETS[key >> PRGL_SHADER_FEATURE_BITS]
+        );
+        prgl_variant_keys[prgl_num_variants++] = key;
+    }
+
+    return prgl_shader_variants[key];
+}
+
+/**
+ * Points the 3D types in the shader pool at the variants for the current
+ * settings. The lit types are textured and loop over every light, so they
+ * can draw anything, but draws made with them swap in a tighter variant.
+ */
+static void prgl_update_variant_pool(void)
+{
+    // Before the pool is built there's nothing to update
+    if (prgl_shader_pool[PRGL_SHADER_TYPE_SCREEN].id == 0)
+    {
+        return;
+    }
+
+    const unsigned lit =
+        PRGL_SHADER_FEATURE_LIT | PRGL_SHADER_FEATURE_TEXTURED;
+    const unsigned instanced = PRGL_SHADER_FEATURE_INSTANCED;
+    const int all_lights = PRGL_NUM_LIGHT_BUCKETS - 1;
+    prgl_shader_pool[PRGL_SHADER_TYPE_3D] =
+        prgl_shader_variant(prgl_variant_key(lit, all_lights));
+    prgl_shader_pool[PRGL_SHADER_TYPE_3D_INSTANCED] =
+        prgl_shader_variant(prgl_variant_key(lit | instanced, all_lights));
+    prgl_shader_pool[PRGL_SHADER_TYPE_UNLIT] =
+        prgl_shader_variant(prgl_variant_key(0, 0));
+    prgl_shader_pool[PRGL_SHADER_TYPE_UNLIT_INSTANCED] =
+        prgl_shader_variant(prgl_variant_key(instanced, 0));
+}
+
+/**
+ * Creates a shader using the given shader source code string. The compile
+ * status isn't checked here, see prgl_finish_pending_program().
  *
  * @param gl_shader_type The GL macro for the type of shader
  *                           e.g. GL_VERTEX_SHADER, GL_FRAGMENT_SHADER
@@ -250,30 +789,255 @@ static GLuint prgl_compile_shader(
     GLuint shader = glCreateShader(gl_shader_type);
     glShaderSource(shader, num_sources, shader_source, NULL);
     glCompileShader(shader);
-    prgl_validate_shader(shader);
 
     return shader;
 }
 
 /**
- * Creates a shader program from an array of shader IDs.
+ * Creates a shader program from an array of shader IDs and starts linking it.
+ * The program is added to the pending programs, which take ownership of the
+ * shaders and finish the program once it's needed.
  *
  * @param shaders An array of shader IDs to attach to the program
- * @param length The length of the shaders array
+ * @param length The length of the shaders array, at most 3
+ * @param key The program's binary cache key.
+ * @return The program, which may still be compiling.
  */
-static PRGLShader prgl_create_shader_program(GLuint shaders[], size_t length)
+static PRGLShader prgl_submit_shader_program(
+    GLuint shaders[], int length, uint64_t key
+)
 {
     PRGLShader shader_program = {.id = glCreateProgram()};
-    for (size_t i = 0; i < length; i++)
+    for (int i = 0; i < length; i++)
     {
         glAttachShader(shader_program.id, shaders[i]);
     }
+    prgl_prepare_cached_program(shader_program.id);
     glLinkProgram(shader_program.id);
-    prgl_validate_shader_program(shader_program);
+
+    if (prgl_num_pending_programs == prgl_pending_programs_capacity)
+    {
+        int capacity = prgl_pending_programs_capacity == 0
+                         ? PRGL_SHADER_TYPE_COUNT * 2
+                         : prgl_pending_programs_capacity * 2;
+        struct PRGLPendingProgram *programs = realloc(
+            prgl_pending_programs, sizeof(struct PRGLPendingProgram) * capacity
+        );
+        if (programs == NULL)
+        {
+            fprintf(
+                stderr, "prgl_submit_shader_program: Error allocating pending "
+                        "program memory, finishing it now!\n"
+            );
+            prgl_validate_shader_program(shader_program);
+            prgl_setup_shader_program(shader_program);
+            for (int i = 0; i < length; i++)
+            {
+                glDeleteShader(shaders[i]);
+            }
+            prgl_shader_build_stats.programs_compiled++;
+            return shader_program;
+        }
+        prgl_pending_programs = programs;
+        prgl_pending_programs_capacity = capacity;
+    }
+
+    struct PRGLPendingProgram *const pending =
+        &prgl_pending_programs[prgl_num_pending_programs++];
+    pending->program = shader_program.id;
+    pending->num_shaders = length;
+    pending->key = key;
+    for (int i = 0; i < length; i++)
+    {
+        pending->shaders[i] = shaders[i];
+    }
 
     return shader_program;
 }
 
+/**
+ * Sets up the prgl state for a linked program, which isn't part of a program
+ * binary so it's also needed for programs loaded from the cache.
+ *
+ * @param shader_program The linked shader program.
+ */
+static void prgl_setup_shader_program(PRGLShader shader_program)
+{
+    prgl_bind_uniform_blocks(shader_program);
+    prgl_bind_sampler_units(shader_program);
+    prgl_create_uniform_cache(shader_program);
+}
+
+/**
+ * @param program
+ * @return The index of the program in the pending programs, or -1 if it isn't
+ * compiling.
+ */
+static int prgl_find_pending_program(GLuint program)
+{
+    for (int i = 0; i < prgl_num_pending_programs; i++)
+    {
+        if (prgl_pending_programs[i].program == program)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Checks if the driver is done with a pending program without waiting for it.
+ * Without parallel shader compile there's no way to ask, so the program is
+ * reported done and finishing it waits for the driver.
+ *
+ * @param index Index into the pending programs.
+ * @return True if finishing the program won't wait for the driver.
+ */
+static bool prgl_pending_program_done(int index)
+{
+    if (!prgl_gl_parallel_shader_compile_loaded())
+    {
+        return true;
+    }
+
+    GLint done = GL_FALSE;
+    glGetProgramiv(
+        prgl_pending_programs[index].program, GL_COMPLETION_STATUS_KHR, &done
+    );
+    return done == GL_TRUE;
+}
+
+/**
+ * Checks a pending program's compile and link results, waiting for the
+ * driver if it's still compiling, then sets it up for use and caches its
+ * binary. The program is removed from the pending programs.
+ *
+ * @param index Index into the pending programs.
+ */
+static void prgl_finish_pending_program(int index)
+{
+    const double start_time = glfwGetTime();
+    const struct PRGLPendingProgram pending = prgl_pending_programs[index];
+    prgl_pending_programs[index] =
+        prgl_pending_programs[--prgl_num_pending_programs];
+
+    for (int i = 0; i < pending.num_shaders; i++)
+    {
+        prgl_validate_shader(pending.shaders[i]);
+        glDeleteShader(pending.shaders[i]);
+    }
+
+    const PRGLShader shader_program = {.id = pending.program};
+    prgl_validate_shader_program(shader_program);
+    prgl_setup_shader_program(shader_program);
+    prgl_store_cached_program(pending.key, pending.program);
+
+    prgl_shader_build_stats.programs_compiled++;
+    prgl_shader_build_stats.build_seconds += glfwGetTime() - start_time;
+}
+
+/**
+ * Removes a pending program without checking it, for programs deleted before
+ * they were needed.
+ *
+ * @param index Index into the pending programs.
+ */
+static void prgl_drop_pending_program(int index)
+{
+    const struct PRGLPendingProgram pending = prgl_pending_programs[index];
+    prgl_pending_programs[index] =
+        prgl_pending_programs[--prgl_num_pending_programs];
+    for (int i = 0; i < pending.num_shaders; i++)
+    {
+        glDeleteShader(pending.shaders[i]);
+    }
+}
+
+/**
+ * Finishes a program if it's still pending, waiting for the driver if needed,
+ * so it can be used.
+ *
+ * @param program
+ */
+static void prgl_wait_for_shader(GLuint program)
+{
+    if (prgl_num_pending_programs == 0)
+    {
+        return;
+    }
+
+    const int index = prgl_find_pending_program(program);
+    if (index >= 0)
+    {
+        prgl_finish_pending_program(index);
+    }
+}
+
+/**
+ * Binds the uniform blocks prgl fills to their fixed binding points, for any
+ * the program uses.
+ *
+ * @param shader_program
+ */
+static void prgl_bind_uniform_blocks(PRGLShader shader_program)
+{
+    const char *const block_names[] = {
+        PRGL_FRAME_UNIFORM_BLOCK, PRGL_LIGHTS_UNIFORM_BLOCK,
+        PRGL_LIGHT_CLUSTERS_UNIFORM_BLOCK
+    };
+    const GLuint block_bindings[] = {
+        PRGL_FRAME_UNIFORM_BINDING, PRGL_LIGHTS_UNIFORM_BINDING,
+        PRGL_LIGHT_CLUSTERS_UNIFORM_BINDING
+    };
+    for (size_t i = 0; i < sizeof(block_names) / sizeof(block_names[0]); i++)
+    {
+        const GLuint block =
+            glGetUniformBlockIndex(shader_program.id, block_names[i]);
+        if (block != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(shader_program.id, block, block_bindings[i]);
+        }
+    }
+}
+
+/**
+ * Points the samplers for textures prgl keeps bound to their fixed texture
+ * units, for any the program uses. Samplers can't be given a unit in GLSL 330
+ * so the program is briefly made current.
+ *
+ * @param shader_program
+ */
+static void prgl_bind_sampler_units(PRGLShader shader_program)
+{
+    const char *const sampler_names[] = {
+        PRGL_LIGHT_CLUSTER_GRID_SAMPLER, PRGL_LIGHT_CLUSTER_INDICES_SAMPLER
+    };
+    const GLint sampler_units[] = {
+        PRGL_LIGHT_CLUSTER_GRID_TEXTURE_UNIT,
+        PRGL_LIGHT_CLUSTER_INDICES_TEXTURE_UNIT
+    };
+    bool program_used = false;
+    for (size_t i = 0; i < sizeof(sampler_names) / sizeof(sampler_names[0]);
+         i++)
+    {
+        const GLint location =
+            glGetUniformLocation(shader_program.id, sampler_names[i]);
+        if (location < 0)
+        {
+            continue;
+        }
+
+        prgl_gl_use_program(shader_program.id);
+        program_used = true;
+        glUniform1i(location, sampler_units[i]);
+    }
+
+    if (program_used)
+    {
+        prgl_gl_use_program(prgl_current_shader_ref.id);
+    }
+}
+
 /**
  * Checks if a shader had any compilation errors and logs them if it did.
  *
@@ -307,3 +1071,357 @@ static void prgl_validate_shader_program(PRGLShader shader_program)
         printf("ERROR::SHADER::LINK_FAILED\n%s\n", info_log);
     }
 }
+
+/**
+ * Reflects the active uniforms of a linked program into a new uniform cache
+ * and resolves the built in uniform handles for it.
+ *
+ * @param shader_program The linked shader program.
+ */
+static void prgl_create_uniform_cache(PRGLShader shader_program)
+{
+    struct PRGLUniformCache *cache = calloc(1, sizeof(struct PRGLUniformCache));
+    if (cache == NULL)
+    {
+        fprintf(
+            stderr, "prgl_create_uniform_cache: Error allocating uniform "
+                    "cache memory!\n"
+        );
+        return;
+    }
+
+    if (prgl_num_uniform_caches == prgl_uniform_caches_capacity)
+    {
+        int capacity = prgl_uniform_caches_capacity == 0
+                         ? PRGL_SHADER_TYPE_COUNT * 2
+                         : prgl_uniform_caches_capacity * 2;
+        struct PRGLUniformCache **caches = realloc(
+            prgl_uniform_caches, sizeof(struct PRGLUniformCache *) * capacity
+        );
+        if (caches == NULL)
+        {
+            fprintf(
+                stderr, "prgl_create_uniform_cache: Error allocating uniform "
+                        "cache list memory!\n"
+            );
+            free(cache);
+            return;
+        }
+        prgl_uniform_caches = caches;
+        prgl_uniform_caches_capacity = capacity;
+    }
+    prgl_uniform_caches[prgl_num_uniform_caches++] = cache;
+    cache->shader_id = shader_program.id;
+
+    GLint num_uniforms = 0;
+    GLint max_name_length = 0;
+    glGetProgramiv(shader_program.id, GL_ACTIVE_UNIFORMS, &num_uniforms);
+    glGetProgramiv(
+        shader_program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length
+    );
+
+    char *name = malloc(max_name_length > 0 ? max_name_length : 1);
+    if (name == NULL)
+    {
+        fprintf(
+            stderr, "prgl_create_uniform_cache: Error allocating uniform "
+                    "name memory!\n"
+        );
+        num_uniforms = 0;
+    }
+
+    for (GLint i = 0; i < num_uniforms; i++)
+    {
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(
+            shader_program.id, (GLuint)i, max_name_length, NULL, &size, &type,
+            name
+        );
+        const GLint location = glGetUniformLocation(shader_program.id, name);
+        prgl_uniform_cache_add(cache, name, location);
+
+        // Arrays are reported as "name[0]" but may be set with just "name"
+        const size_t length = strlen(name);
+        if (length > 3 && strcmp(name + length - 3, "[0]") == 0)
+        {
+            name[length - 3] = '\0';
+            prgl_uniform_cache_add(cache, name, location);
+        }
+    }
+    free(name);
+
+    const char *const builtin_names[PRGL_BUILTIN_UNIFORM_COUNT] = {
+        [PRGL_BUILTIN_UNIFORM_MODEL] = PRGL_MODEL_UNIFORM,
+        [PRGL_BUILTIN_UNIFORM_VIEW] = PRGL_VIEW_UNIFORM,
+        [PRGL_BUILTIN_UNIFORM_PROJECTION] = PRGL_PROJECTION_UNIFORM,
+        [PRGL_BUILTIN_UNIFORM_NORMAL_MATRIX] = PRGL_NORMAL_MATRIX_UNIFORM,
+        [PRGL_BUILTIN_UNIFORM_RENDER_RESOLUTION] =
+            PRGL_RENDER_RESOLUTION_UNIFORM,
+        [PRGL_BUILTIN_UNIFORM_TILE_FACTOR] = PRGL_TILE_FACTOR_UNIFORM,
+        [PRGL_BUILTIN_UNIFORM_FILL_COLOR] = PRGL_FILL_COLOR_UNIFORM,
+        [PRGL_BUILTIN_UNIFORM_USE_TEXTURE] = PRGL_USE_TEXTURE_UNIFORM,
+        [PRGL_BUILTIN_UNIFORM_ALPHA] = PRGL_ALPHA_UNIFORM,
+        [PRGL_BUILTIN_UNIFORM_OBJECT_LIGHTS] = PRGL_OBJECT_LIGHTS_UNIFORM,
+    };
+    for (int i = 0; i < PRGL_BUILTIN_UNIFORM_COUNT; i++)
+    {
+        cache->builtins[i] =
+            prgl_uniform_handle(shader_program, builtin_names[i]);
+    }
+}
+
+/**
+ * Frees the uniform cache belonging to a shader program, if it has one.
+ *
+ * @param shader_id
+ */
+static void prgl_delete_uniform_cache(GLuint shader_id)
+{
+    for (int i = 0; i < prgl_num_uniform_caches; i++)
+    {
+        struct PRGLUniformCache *cache = prgl_uniform_caches[i];
+        if (cache->shader_id != shader_id)
+        {
+            continue;
+        }
+
+        if (cache == prgl_current_uniform_cache)
+        {
+            prgl_current_uniform_cache = NULL;
+        }
+
+        for (int e = 0; e < cache->num_entries; e++)
+        {
+            free(cache->entries[e].name);
+        }
+        free(cache->entries);
+        free(cache->buckets);
+        free(cache);
+
+        // Order doesn't matter so swap the last cache into the empty spot
+        prgl_uniform_caches[i] =
+            prgl_uniform_caches[--prgl_num_uniform_caches];
+        break;
+    }
+
+    if (prgl_num_uniform_caches == 0)
+    {
+        free(prgl_uniform_caches);
+        prgl_uniform_caches = NULL;
+        prgl_uniform_caches_capacity = 0;
+    }
+}
+
+/**
+ * Finds the uniform cache for a shader program. The current shader's cache is
+ * checked first since that is almost always the one wanted.
+ *
+ * @param shader_id
+ * @return The cache, or NULL if the program wasn't linked by prgl.
+ */
+static struct PRGLUniformCache *prgl_find_uniform_cache(GLuint shader_id)
+{
+    if (prgl_current_uniform_cache != NULL
+        && prgl_current_uniform_cache->shader_id == shader_id)
+    {
+        return prgl_current_uniform_cache;
+    }
+
+    for (int i = 0; i < prgl_num_uniform_caches; i++)
+    {
+        if (prgl_uniform_caches[i]->shader_id == shader_id)
+        {
+            return prgl_uniform_caches[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Finds the index of a uniform's entry in a cache.
+ *
+ * @param cache[in]
+ * @param name[in]
+ * @param hash The hash of name from prgl_hash_uniform_name().
+ * @return The entry index, or -1 if the name isn't cached.
+ */
+static int prgl_uniform_cache_find(
+    struct PRGLUniformCache *const cache, const char *const name, uint32_t hash
+)
+{
+    if (cache->num_buckets == 0)
+    {
+        return -1;
+    }
+
+    const int mask = cache->num_buckets - 1;
+    for (int b = (int)(hash & (uint32_t)mask);; b = (b + 1) & mask)
+    {
+        const int slot = cache->buckets[b];
+        if (slot < 0)
+        {
+            return -1;
+        }
+
+        const struct PRGLUniformCacheEntry *const entry = &cache->entries[slot];
+        if (entry->hash == hash && strcmp(entry->name, name) == 0)
+        {
+            return slot;
+        }
+    }
+}
+
+/**
+ * Adds a uniform to a cache, growing the entry list and hash table as needed.
+ *
+ * @param cache[in,out]
+ * @param name[in]
+ * @param location The uniform location, or -1 if the uniform isn't active.
+ * @return The index of the new entry, or -1 if allocation failed.
+ */
+static int prgl_uniform_cache_add(
+    struct PRGLUniformCache *const cache, const char *const name,
+    GLint location
+)
+{
+    if (cache->num_entries == cache->entries_capacity)
+    {
+        int capacity =
+            cache->entries_capacity == 0 ? 16 : cache->entries_capacity * 2;
+        struct PRGLUniformCacheEntry *entries = realloc(
+            cache->entries, sizeof(struct PRGLUniformCacheEntry) * capacity
+        );
+        if (entries == NULL)
+        {
+            fprintf(
+                stderr, "prgl_uniform_cache_add: Error allocating uniform "
+                        "entry memory!\n"
+            );
+            return -1;
+        }
+        cache->entries = entries;
+        cache->entries_capacity = capacity;
+    }
+
+    // Keep the hash table at most half full so probe chains stay short
+    if ((cache->num_entries + 1) * 2 > cache->num_buckets)
+    {
+        int num_buckets = cache->num_buckets == 0 ? 32 : cache->num_buckets * 2;
+        int *buckets = malloc(sizeof(int) * num_buckets);
+        if (buckets == NULL)
+        {
+            fprintf(
+                stderr, "prgl_uniform_cache_add: Error allocating uniform "
+                        "table memory!\n"
+            );
+            return -1;
+        }
+
+        for (int b = 0; b < num_buckets; b++)
+        {
+            buckets[b] = -1;
+        }
+
+        const int mask = num_buckets - 1;
+        for (int e = 0; e < cache->num_entries; e++)
+        {
+            int b = (int)(cache->entries[e].hash & (uint32_t)mask);
+            while (buckets[b] >= 0)
+            {
+                b = (b + 1) & mask;
+            }
+            buckets[b] = e;
+        }
+
+        free(cache->buckets);
+        cache->buckets = buckets;
+        cache->num_buckets = num_buckets;
+    }
+
+    const size_t name_size = strlen(name) + 1;
+    char *name_copy = malloc(name_size);
+    if (name_copy == NULL)
+    {
+        fprintf(
+            stderr, "prgl_uniform_cache_add: Error allocating uniform name "
+                    "memory!\n"
+        );
+        return -1;
+    }
+    memcpy(name_copy, name, name_size);
+
+    const int slot = cache->num_entries++;
+    cache->entries[slot] = (struct PRGLUniformCacheEntry){
+        .name = name_copy,
+        .hash = prgl_hash_uniform_name(name),
+        .location = location,
+        .has_value = false,
+    };
+
+    const int mask = cache->num_buckets - 1;
+    int b = (int)(cache->entries[slot].hash & (uint32_t)mask);
+    while (cache->buckets[b] >= 0)
+    {
+        b = (b + 1) & mask;
+    }
+    cache->buckets[b] = slot;
+
+    return slot;
+}
+
+/**
+ * Compares a value against the last one uploaded to a uniform and records it
+ * if it is different. The upload goes to the bound program, so the value is
+ * only compared and recorded when that's the uniform's program.
+ *
+ * @param uniform
+ * @param value[in] The raw value, at most PRGL_UNIFORM_CACHE_MAX_FLOATS floats.
+ * @param size Size of the value in bytes.
+ * @return True if the value needs to be uploaded.
+ */
+static bool prgl_uniform_value_changed(
+    PRGLUniform uniform, const void *const value, size_t size
+)
+{
+    if (uniform.location < 0)
+    {
+        return false;
+    }
+    if (uniform.shader_id != prgl_current_shader_ref.id)
+    {
+        return true;
+    }
+
+    struct PRGLUniformCache *const cache =
+        prgl_find_uniform_cache(uniform.shader_id);
+    if (cache == NULL || uniform.slot < 0 || uniform.slot >= cache->num_entries)
+    {
+        return true;
+    }
+
+    struct PRGLUniformCacheEntry *const entry = &cache->entries[uniform.slot];
+    if (entry->has_value && memcmp(entry->value, value, size) == 0)
+    {
+        return false;
+    }
+
+    memcpy(entry->value, value, size);
+    entry->has_value = true;
+    return true;
+}
+
+/**
+ * FNV-1a hash of a uniform name.
+ */
+static uint32_t prgl_hash_uniform_name(const char *const name)
+{
+    uint32_t hash = 2166136261u;
+    for (const char *c = name; *c != '\0'; c++)
+    {
+        hash ^= (uint32_t)(unsigned char)*c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
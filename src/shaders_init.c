@@ -1,32 +1,118 @@
 #include "shaders_init_internal.h"
 #include "shaders.h"
 
+#include <stdbool.h>
+#include <stdio.h>
+
 #include "common_macros.h"
 #include "lighting.h"
+#include "lighting_internal.h"
+#include "shaders_internal.h"
 #include "types.h"
 
 // clang-format off
+// Sources which use preprocessor features are split so the version is always
+// first, followed by any feature defines, followed by the shader code.
+static const char *const SHADER_VERSION_SOURCE = "#version 330 core\n";
+
+/**
+ * The #define each 3D variant feature is compiled with.
+ */
+struct PRGLShaderFeatureDefine
+{
+    unsigned feature;
+    const char *source;
+};
+
+static const struct PRGLShaderFeatureDefine FEATURE_DEFINES[] = {
+    // Per-instance attributes replace the model, normalMatrix and fillColor
+    // uniforms. A mat4 takes 4 locations and a mat3 takes 3.
+    {PRGL_SHADER_FEATURE_INSTANCED, "#define PRGL_INSTANCED\n"},
+    {PRGL_SHADER_FEATURE_LIT, "#define PRGL_LIT\n"},
+    {PRGL_SHADER_FEATURE_TEXTURED, "#define PRGL_TEXTURED\n"},
+    {PRGL_SHADER_FEATURE_WOBBLE, "#define PRGL_WOBBLE\n"},
+    {PRGL_SHADER_FEATURE_AFFINE, "#define PRGL_AFFINE\n"},
+
+    // Selects affine texture mapping per triangle in a geometry shader instead
+    // of from interpolated vertex clip flags, kept as the reference path.
+    {PRGL_SHADER_FEATURE_GEOMETRY_SHADER,
+     "#define PRGL_AFFINE_GEOMETRY_SHADER\n"},
+
+    // Lights are picked per object on the CPU, see object_lights.c
+    {PRGL_SHADER_FEATURE_OBJECT_LIGHTS, "#define PRGL_OBJECT_LIGHTS\n"},
+
+    // Static lights come from per-vertex colors, see baked_lighting.c
+    {PRGL_SHADER_FEATURE_BAKED, "#define PRGL_BAKED_LIGHTING\n"},
+};
+
+// Camera and frame state shared by all programs, filled once per frame.
+static const char *const FRAME_UNIFORMS_SOURCE =
+    "layout (std140) uniform PRGLFrame {\n"
+    "    mat4 view;\n"
+    "    mat4 projection;\n"
+    "    mat4 viewProjection;\n"
+    "    mat4 orthoProjection;\n"
+    "    vec2 renderResolution;\n"
+    "    float time;\n"
+    "};\n";
+
 static const char *const SHARED_VERTEX_SHADER_SOURCE_3D =
-    "#version 330 core\n"
     "#define NR_POINT_LIGHTS " STRINGIFY(PRGL_MAX_POINT_LIGHTS) "\n"
 
+    // Member order matches the std140 packing in lighting.c
     "struct PointLight {\n"
     "    vec3 position;\n"
-    "    vec3 color;\n"
     "    float ambient;\n"
+    "    vec3 color;\n"
 
     // Constants for calculating light attenuation (fade distance).
     "    float linear;\n"
     "    float quadratic;\n"
     "};\n"
 
+    "layout (std140) uniform PRGLLights {\n"
+    "    int numPointLights;\n"
+    "    PointLight pointLights[NR_POINT_LIGHTS];\n"
+    "};\n"
+
+    // Lights reaching each cluster of the view, filled in light_clusters.c.
+    // The grid holds an offset into the index list and a light count.
+    "#ifdef PRGL_CLUSTERED_LIGHTING\n"
+    "layout (std140) uniform PRGLLightClusters {\n"
+    "    ivec4 lightClusterCounts;\n"
+    "    vec4 lightClusterDepthSlicing;\n"
+    "};\n"
+    "uniform usamplerBuffer lightClusterGrid;\n"
+    "uniform usamplerBuffer lightClusterIndices;\n"
+    "#endif\n"
+
+    "#ifdef PRGL_INSTANCED\n"
+    "layout (location = 3) in mat4 aInstanceModel;\n"
+    "layout (location = 7) in mat3 aInstanceNormalMatrix;\n"
+    "layout (location = 10) in vec3 aInstanceFillColor;\n"
+    "#define model aInstanceModel\n"
+    "#define normalMatrix aInstanceNormalMatrix\n"
+    "#else\n"
     "uniform mat4 model;\n"
-    "uniform mat4 view;\n"
-    "uniform mat4 projection;\n"
     "uniform mat3 normalMatrix;\n"
-    "uniform vec2 renderResolution;\n"
-    "uniform int numPointLights = 0;\n"
-    "uniform PointLight pointLights[NR_POINT_LIGHTS];\n"
+    "#endif\n"
+
+    // Indices of the lights selected for the object, most influential first
+    // and -1 after the last one
+    "#ifdef PRGL_OBJECT_LIGHTS\n"
+    "#ifdef PRGL_INSTANCED\n"
+    "layout (location = 11) in vec4 aInstanceLights;\n"
+    "#define objectLights aInstanceLights\n"
+    "#else\n"
+    "uniform vec4 objectLights;\n"
+    "#endif\n"
+    "#endif\n"
+
+    // Summed light of the static lights at the vertex
+    "#ifdef PRGL_BAKED_LIGHTING\n"
+    "layout (location = 12) in vec3 aBakedLight;\n"
+    "#endif\n"
+
 
     "vec4 calculateVertexWobble(vec4 clipSpacePos)\n"
     "{\n"
@@ -50,63 +136,171 @@ static const char *const SHARED_VERTEX_SHADER_SOURCE_3D =
     "    vec2 halfPixelOffset = 0.5 / renderResolution;\n"
     "    wobblePos.xy += halfPixelOffset * wobblePos.w;\n"
     "    return wobblePos;\n"
+    "}\n";
+
+// Gouraud shading, split from the rest of the shared vertex source to keep
+// each string within the length C99 compilers must support.
+static const char *const SHARED_LIGHTING_SHADER_SOURCE_3D =
+    // Calculates the light one point light adds to a vertex.
+    "vec3 calculatePointLight(int i, vec3 vertexPosition, vec3 worldNormal)\n"
+    "{\n"
+    "    vec3 distanceVec = pointLights[i].position - vertexPosition;\n"
+    "    vec3 lightDir = normalize(distanceVec);\n"
+
+         // Calculate diffuse, darkens the greater the angle between vectors.
+         // max() is used to prevent negatives when the angle is > 90 degrees.
+    "    float diffuse = max(dot(worldNormal, lightDir), 0.0);\n"
+    "    float distance = length(distanceVec);\n"
+    "    float attenuation = 1.0 "
+            "/ (1.0 + (pointLights[i].linear * distance) "
+            "+ (pointLights[i].quadratic * (distance * distance)));\n"
+    "    float ambient = pointLights[i].ambient;\n"
+    "    ambient *= attenuation;\n"
+    "    diffuse *= attenuation;\n"
+    "    return (ambient + diffuse) * pointLights[i].color;\n"
     "}\n"
 
+    "#ifdef PRGL_CLUSTERED_LIGHTING\n"
+    // Finds the cluster of an un-wobbled clip space position, the same way
+    // light_clusters.c bins lights. Returns -1 outside the grid, or if there
+    // is no grid this frame.
+    "int findLightCluster(vec4 clipSpacePos)\n"
+    "{\n"
+    "    if (clipSpacePos.w <= 0.0)\n"
+    "    {\n"
+    "        return -1;\n"
+    "    }\n"
+    "    vec2 ndc = clipSpacePos.xy / clipSpacePos.w;\n"
+    "    int slice = int(floor(log(clipSpacePos.w) * lightClusterDepthSlicing.x\n"
+    "                          + lightClusterDepthSlicing.y));\n"
+    "    if (any(greaterThan(abs(ndc), vec2(1.0)))\n"
+    "        || slice < 0 || slice >= lightClusterCounts.z)\n"
+    "    {\n"
+    "        return -1;\n"
+    "    }\n"
+    "    ivec2 tile = min(ivec2(floor((ndc * 0.5 + 0.5) * vec2(lightClusterCounts.xy))),\n"
+    "                     lightClusterCounts.xy - 1);\n"
+    "    return (slice * lightClusterCounts.y + tile.y) * lightClusterCounts.x + tile.x;\n"
+    "}\n"
+    "#endif\n"
+
     // Calculates lighting at vertices.
-    "vec3 calculateGouraudShading(vec3 pos, vec3 normal)\n"
+    "vec3 calculateGouraudShading(vec3 pos, vec3 normal, vec4 clipSpacePos)\n"
     "{\n"
     "    vec3 worldNormal = normalize(normalMatrix * normal);\n"
 
          // Get world space position of vertex and calculate light direction 
          // from the light source to the vertex.
     "    vec3 vertexPosition = vec3(model * vec4(pos, 1.0));\n"
+    "#ifdef PRGL_BAKED_LIGHTING\n"
+    "    vec3 lightColor = aBakedLight;\n"
+    "#else\n"
     "    vec3 lightColor = vec3(0.0);\n"
-    "    for (int i = 0; i < numPointLights; i++)\n"
+    "#endif\n"
+
+    "#ifdef PRGL_OBJECT_LIGHTS\n"
+         // Only the lights picked for the object, up to one per component
+    "    for (int i = 0; i < 4; i++)\n"
+    "    {\n"
+    "        int light = int(objectLights[i]);\n"
+    "        if (light < 0)\n"
+    "        {\n"
+    "            break;\n"
+    "        }\n"
+    "        lightColor += calculatePointLight(light, vertexPosition, worldNormal);\n"
+    "    }\n"
+    "    return lightColor;\n"
+    "#else\n"
+
+    "#ifdef PRGL_CLUSTERED_LIGHTING\n"
+         // Only the lights reaching the vertex's cluster, in light order.
+         // Vertices outside the view still color visible pixels of clipped
+         // triangles, so they and overflowed clusters use every light below.
+    "    int cluster = findLightCluster(clipSpacePos);\n"
+    "    if (cluster >= 0)\n"
+    "    {\n"
+    "        uvec2 range = texelFetch(lightClusterGrid, cluster).rg;\n"
+    "        if (range.y <= uint(NR_POINT_LIGHTS))\n"
+    "        {\n"
+    "            for (uint i = 0u; i < range.y; i++)\n"
+    "            {\n"
+    "                int light = int(texelFetch(lightClusterIndices, int(range.x + i)).r);\n"
+    "                lightColor += calculatePointLight(light, vertexPosition, worldNormal);\n"
+    "            }\n"
+    "            return lightColor;\n"
+    "        }\n"
+    "    }\n"
+    "#endif\n"
+
+    // The loop bound is the variant's light bucket so it can be unrolled
+    "    for (int i = 0; i < PRGL_LIGHT_LOOP_COUNT; i++)\n"
     "    {\n"
-    "        vec3 distanceVec = pointLights[i].position - vertexPosition;\n"
-    "        vec3 lightDir = normalize(distanceVec);\n"
-
-             // Calculate diffuse, darkens the greater the angle between vectors.
-             // max() is used to prevent negatives when the angle is > 90 degrees.
-    "        float diffuse = max(dot(worldNormal, lightDir), 0.0);\n"
-    "        float distance = length(distanceVec);\n"
-    "        float attenuation = 1.0 "
-                "/ (1.0 + (pointLights[i].linear * distance) "
-                "+ (pointLights[i].quadratic * (distance * distance)));\n"
-    "        float ambient = pointLights[i].ambient;\n"
-    "        ambient *= attenuation;\n"
-    "        diffuse *= attenuation;\n"
-    "        lightColor += (ambient + diffuse) * pointLights[i].color;\n"
+    "        if (i >= numPointLights)\n"
+    "        {\n"
+    "            break;\n"
+    "        }\n"
+    "        lightColor += calculatePointLight(i, vertexPosition, worldNormal);\n"
     "    }\n"
     "    return lightColor;\n"
+    "#endif\n"
     "}\n";
 
-const char *const SHARED_FRAG_SHADER_SOURCE_3D =
-    "#version 330 core\n"
+static const char *const SHARED_FRAG_SHADER_SOURCE_3D =
     "out vec4 FragColor;\n"
 
-    // Data received from the geometry shader
-    "flat in int useAffineFlag;\n"
-    "in vec2 perspectiveUV;\n"
-    "noperspective in vec2 affineUV;\n"
+    "#ifdef PRGL_LIT\n"
     "in vec3 fragLightColor;\n"
-
-    "uniform bool useTexture = true;\n"
+    "#ifdef PRGL_TEXTURED\n"
+    "in vec2 perspectiveUV;\n"
     "uniform sampler2D imageTexture;\n"
     "uniform vec2 tileFactor = vec2(1.0, 1.0);\n"
-    "uniform vec3 fillColor = vec3(1.0, 1.0, 1.0);"
+
+    // Data received from the geometry shader or the vertex shader. Clip flags
+    // interpolate to exactly zero across a triangle only if all of its
+    // vertices are inside the clip volume.
+    "#ifdef PRGL_AFFINE\n"
+    "noperspective in vec2 affineUV;\n"
+    "#ifdef PRGL_AFFINE_GEOMETRY_SHADER\n"
+    "flat in int useAffineFlag;\n"
+    "#else\n"
+    "noperspective in float clipOutside;\n"
+    "#define useAffineFlag (clipOutside > 0.0 ? 0 : 1)\n"
+    "#endif\n"
+    "#endif\n"
+    "#endif\n"
+    "#endif\n"
+
+    // Instanced fill color is already applied to the lit vertex color
+    "#ifndef PRGL_INSTANCED\n"
+    "uniform vec3 fillColor = vec3(1.0, 1.0, 1.0);\n"
+    "#elif !defined(PRGL_LIT)\n"
+    "flat in vec3 instanceFillColor;\n"
+    "#define fillColor instanceFillColor\n"
+    "#endif\n"
     "uniform float alpha = 1.0;\n"
 
     "void main()\n"
     "{\n"
+    "#ifdef PRGL_LIT\n"
     "   vec4 textureColor = vec4(1.0, 1.0, 1.0, 1.0);\n"
-    "   if (useTexture)\n"
-    "   {\n"
+    "#ifdef PRGL_TEXTURED\n"
+    "#ifdef PRGL_AFFINE\n"
             // Switch between UV sets based on the flag
-    "       vec2 finalUV = (useAffineFlag == 1) ? affineUV : perspectiveUV;\n"
-    "       textureColor = texture(imageTexture, finalUV * tileFactor);\n" 
-    "   }\n"
+    "   vec2 finalUV = (useAffineFlag == 1) ? affineUV : perspectiveUV;\n"
+    "#else\n"
+    "   vec2 finalUV = perspectiveUV;\n"
+    "#endif\n"
+    "   textureColor = texture(imageTexture, finalUV * tileFactor);\n"
+    "#endif\n"
+
+    "#ifdef PRGL_INSTANCED\n"
+    "   FragColor = textureColor * vec4(fragLightColor, alpha);\n"
+    "#else\n"
     "   FragColor = textureColor * vec4(fragLightColor * fillColor, alpha);\n"
+    "#endif\n"
+    "#else\n"
+    "   FragColor = vec4(fillColor, alpha);\n"
+    "#endif\n"
     "}\0";
 // clang-format on
 
@@ -145,22 +339,18 @@ PRGLShader prgl_init_shader_screen(void)
 PRGLShader prgl_init_shader_2d(void)
 {
     const char *const VERTEX_SHADER_SOURCE =
-        "#version 330 core\n"
         "layout (location = 0) in vec3 aPos;\n"
         "layout (location = 2) in vec2 aTexCoord;\n"
 
         "out vec2 texCoord;\n"
 
         "uniform mat4 model;\n"
-        "uniform mat4 projection;\n"
-
-        "uniform vec2 renderResolution;\n"
 
         "void main()\n"
         "{\n"
         // Half pixel offset to align with pixel grid
         "    vec2 halfPixelOffset = 0.5 / renderResolution;\n"
-        "    vec4 pos = projection * model * vec4(aPos.xy, 0.0f, 1.0);\n"
+        "    vec4 pos = orthoProjection * model * vec4(aPos.xy, 0.0f, 1.0);\n"
         "    pos.xy += halfPixelOffset * pos.w;\n"
         "    gl_Position = pos;\n"
         "    texCoord = aTexCoord;\n"
@@ -187,12 +377,64 @@ PRGLShader prgl_init_shader_2d(void)
         "   FragColor = textureColor * vec4(fillColor, alpha);\n"
         "}\0";
 
+    const char *const vertexSources[] = {
+        SHADER_VERSION_SOURCE, FRAME_UNIFORMS_SOURCE, VERTEX_SHADER_SOURCE
+    };
     return prgl_create_shader(
-        &VERTEX_SHADER_SOURCE, 1, &FRAG_SHADER_SOURCE, 1, NULL, 0
+        vertexSources, 3, &FRAG_SHADER_SOURCE, 1, NULL, 0
     );
 }
 
-PRGLShader prgl_init_shader_3d(void)
+PRGLShader prgl_init_shader_2d_batched(void)
+{
+    const char *const VERTEX_SHADER_SOURCE =
+        "layout (location = 0) in vec2 aPos;\n"
+        "layout (location = 2) in vec2 aTexCoord;\n"
+        "layout (location = 3) in vec4 aColor;\n"
+
+        "out vec2 texCoord;\n"
+        "out vec4 color;\n"
+
+        "void main()\n"
+        "{\n"
+        // Half pixel offset to align with pixel grid
+        "    vec2 halfPixelOffset = 0.5 / renderResolution;\n"
+        "    vec4 pos = orthoProjection * vec4(aPos, 0.0f, 1.0);\n"
+        "    pos.xy += halfPixelOffset * pos.w;\n"
+        "    gl_Position = pos;\n"
+        "    texCoord = aTexCoord;\n"
+        "    color = aColor;\n"
+        "}\0";
+
+    // Tile factor is already applied to the texture coordinates
+    const char *const FRAG_SHADER_SOURCE =
+        "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "in vec2 texCoord;\n"
+        "in vec4 color;\n"
+
+        "uniform bool useTexture = true;\n"
+        "uniform sampler2D imageTexture;\n"
+
+        "void main()\n"
+        "{\n"
+        "   vec4 textureColor = vec4(1.0, 1.0, 1.0, 1.0);\n"
+        "   if (useTexture)\n"
+        "   {\n"
+        "       textureColor = texture(imageTexture, texCoord);\n"
+        "   }\n"
+        "   FragColor = textureColor * color;\n"
+        "}\0";
+
+    const char *const vertexSources[] = {
+        SHADER_VERSION_SOURCE, FRAME_UNIFORMS_SOURCE, VERTEX_SHADER_SOURCE
+    };
+    return prgl_create_shader(
+        vertexSources, 3, &FRAG_SHADER_SOURCE, 1, NULL, 0
+    );
+}
+
+PRGLShader prgl_init_shader_3d_variant(unsigned features, int max_lights)
 {
     // clang-format off
     const char *const VERTEX_SHADER_SOURCE =
@@ -200,21 +442,60 @@ PRGLShader prgl_init_shader_3d(void)
         "layout (location = 1) in vec3 aNormal;\n"
         "layout (location = 2) in vec2 aTexCoord;\n"
 
+        "#if defined(PRGL_AFFINE_GEOMETRY_SHADER)\n"
         // Data to be sent to the geometry shader
         "out VS_OUT {\n"
         "    vec2 texCoord;\n"
         "    vec3 vertexColor;\n"
         "} vs_out;\n"
+        "#elif defined(PRGL_LIT)\n"
+        "out vec3 fragLightColor;\n"
+        "#ifdef PRGL_TEXTURED\n"
+        "out vec2 perspectiveUV;\n"
+        "#ifdef PRGL_AFFINE\n"
+        "noperspective out vec2 affineUV;\n"
+        "noperspective out float clipOutside;\n"
+        "#endif\n"
+        "#endif\n"
+        "#elif defined(PRGL_INSTANCED)\n"
+        "flat out vec3 instanceFillColor;\n"
+        "#endif\n"
 
         "void main()\n"
         "{\n"
-        "    vs_out.texCoord = aTexCoord;\n"
+        "    vec4 clipSpacePos = viewProjection * model * vec4(aPos, 1.0);\n"
+        "#ifdef PRGL_WOBBLE\n"
+        "    gl_Position = calculateVertexWobble(clipSpacePos);\n"
+        "#else\n"
+        "    gl_Position = clipSpacePos;\n"
+        "#endif\n"
 
+        "#ifdef PRGL_LIT\n"
              // For retro accuracy is calculated using un-wobbled position
-        "    vs_out.vertexColor = calculateGouraudShading(aPos, aNormal);\n"
+        "    vec3 vertexColor = calculateGouraudShading(aPos, aNormal, clipSpacePos);\n"
+        "#ifdef PRGL_INSTANCED\n"
+        "    vertexColor *= aInstanceFillColor;\n"
+        "#endif\n"
 
-        "    vec4 clipSpacePos = projection * view * model * vec4(aPos, 1.0);\n"
-        "    gl_Position = calculateVertexWobble(clipSpacePos);\n"
+        "#ifdef PRGL_AFFINE_GEOMETRY_SHADER\n"
+        "    vs_out.texCoord = aTexCoord;\n"
+        "    vs_out.vertexColor = vertexColor;\n"
+        "#else\n"
+        "    fragLightColor = vertexColor;\n"
+        "#ifdef PRGL_TEXTURED\n"
+        "    perspectiveUV = aTexCoord;\n"
+        "#ifdef PRGL_AFFINE\n"
+        "    affineUV = aTexCoord;\n"
+
+             // Same test the geometry shader makes on each vertex
+        "    bvec3 outside = greaterThan(abs(gl_Position.xyz), vec3(gl_Position.w));\n"
+        "    clipOutside = any(outside) ? 1.0 : 0.0;\n"
+        "#endif\n"
+        "#endif\n"
+        "#endif\n"
+        "#elif defined(PRGL_INSTANCED)\n"
+        "    instanceFillColor = aInstanceFillColor;\n"
+        "#endif\n"
         "}\0";
 
     const char *const GEOMETRY_SHADER_SOURCE =
@@ -262,41 +543,128 @@ PRGLShader prgl_init_shader_3d(void)
         "}\0";
     //clang-format on
 
+    char defines[512];
+    int length = snprintf(
+        defines, sizeof(defines), "#define PRGL_LIGHT_LOOP_COUNT %d\n",
+        max_lights
+    );
+
+    // Beyond a few lights, looping over every light costs more than looking
+    // up the vertex's cluster
+    if ((features & PRGL_SHADER_FEATURE_LIT)
+        && max_lights > PRGL_MAX_UNCLUSTERED_POINT_LIGHTS)
+    {
+        length += snprintf(
+            defines + length, sizeof(defines) - length,
+            "#define PRGL_CLUSTERED_LIGHTING\n"
+        );
+    }
+    for (size_t i = 0; i < ARR_LEN(FEATURE_DEFINES); i++)
+    {
+        if (features & FEATURE_DEFINES[i].feature)
+        {
+            length += snprintf(
+                defines + length, sizeof(defines) - length, "%s",
+                FEATURE_DEFINES[i].source
+            );
+        }
+    }
+
     const char *const vertexSources[] = {
-        SHARED_VERTEX_SHADER_SOURCE_3D, VERTEX_SHADER_SOURCE
+        SHADER_VERSION_SOURCE, defines, FRAME_UNIFORMS_SOURCE,
+        SHARED_VERTEX_SHADER_SOURCE_3D, SHARED_LIGHTING_SHADER_SOURCE_3D,
+        VERTEX_SHADER_SOURCE
     };
+    const char *const fragSources[] = {
+        SHADER_VERSION_SOURCE, defines, SHARED_FRAG_SHADER_SOURCE_3D
+    };
+    const bool geometry_shader = features & PRGL_SHADER_FEATURE_GEOMETRY_SHADER;
     return prgl_create_shader(
-        vertexSources, 2, &SHARED_FRAG_SHADER_SOURCE_3D, 1, &GEOMETRY_SHADER_SOURCE, 1
+        vertexSources, 6, fragSources, 3,
+        geometry_shader ? &GEOMETRY_SHADER_SOURCE : NULL, 1
     );
 }
 
-PRGLShader prgl_init_shader_unlit(void)
+PRGLShader prgl_init_shader_frustum_cull(void)
 {
-    const char *const VERTEX_SHADER_SOURCE =
-        "layout (location = 0) in vec3 aPos;\n"
+    const char *const COMPUTE_SHADER_SOURCE =
+        "#version 430 core\n"
+        "layout (local_size_x = 64) in;\n"
+
+        // Matches the indirect command layout GL reads
+        "struct DrawCommand {\n"
+        "    uint count;\n"
+        "    uint instanceCount;\n"
+        "    uint firstIndex;\n"
+        "    int baseVertex;\n"
+        "    uint baseInstance;\n"
+        "};\n"
+
+        "layout (std430, binding = 0) readonly buffer PRGLInstances {\n"
+        "    float instances[];\n"
+        "};\n"
+        "layout (std430, binding = 1) readonly buffer PRGLCullBounds {\n"
+        "    vec4 bounds[];\n"
+        "};\n"
+        "layout (std430, binding = 2) readonly buffer PRGLCullCommands {\n"
+        "    DrawCommand commands[];\n"
+        "};\n"
+        "layout (std430, binding = 3) writeonly buffer PRGLVisibleCommands {\n"
+        "    DrawCommand visibleCommands[];\n"
+        "};\n"
+        "layout (std430, binding = 4) buffer PRGLCullResults {\n"
+        "    uint numVisible;\n"
+        "    uint visible[];\n"
+        "};\n"
+
+        "uniform vec4 frustumPlanes[6];\n"
+        "uniform int numDraws;\n"
+        "uniform int instanceStride;\n"
 
         "void main()\n"
         "{\n"
-        "    vec4 clipPos = projection * view * model * vec4(aPos, 1.0);\n"
-        "    gl_Position = calculateVertexWobble(clipPos);\n"
-        "}\0";
+        "    uint draw = gl_GlobalInvocationID.x;\n"
+        "    if (draw >= uint(numDraws))\n"
+        "    {\n"
+        "        return;\n"
+        "    }\n"
 
-    const char *const FRAG_SHADER_SOURCE =
-        "#version 330 core\n"
-        "out vec4 FragColor;\n"
+        // The model matrix starts each instance, column major
+        "    int base = int(commands[draw].baseInstance) * instanceStride;\n"
+        "    mat4 model;\n"
+        "    for (int col = 0; col < 4; col++)\n"
+        "    {\n"
+        "        int i = base + col * 4;\n"
+        "        model[col] = vec4(\n"
+        "            instances[i], instances[i + 1], instances[i + 2],\n"
+        "            instances[i + 3]\n"
+        "        );\n"
+        "    }\n"
 
-        "uniform vec3 fillColor = vec3(1.0, 1.0, 1.0);"
-        "uniform float alpha = 1.0;\n"
+        // Same sphere as the CPU culling, radius scaled by the largest axis
+        "    vec4 sphere = bounds[draw];\n"
+        "    vec3 center = (model * vec4(sphere.xyz, 1.0)).xyz;\n"
+        "    float maxScale = max(\n"
+        "        dot(model[0].xyz, model[0].xyz),\n"
+        "        max(dot(model[1].xyz, model[1].xyz),\n"
+        "            dot(model[2].xyz, model[2].xyz))\n"
+        "    );\n"
+        "    float radius = sphere.w * sqrt(maxScale);\n"
+
+        "    bool isVisible = true;\n"
+        "    for (int p = 0; p < 6; p++)\n"
+        "    {\n"
+        "        vec4 plane = frustumPlanes[p];\n"
+        "        isVisible = isVisible\n"
+        "                 && dot(plane.xyz, center) + plane.w >= -radius;\n"
+        "    }\n"
 
-        "void main()\n"
-        "{\n"
-        "   FragColor = vec4(fillColor, alpha);\n"
+        "    visible[draw] = isVisible ? 1u : 0u;\n"
+        "    if (isVisible)\n"
+        "    {\n"
+        "        visibleCommands[atomicAdd(numVisible, 1u)] = commands[draw];\n"
+        "    }\n"
         "}\0";
 
-    const char *const vertexSources[] = {
-        SHARED_VERTEX_SHADER_SOURCE_3D, VERTEX_SHADER_SOURCE
-    };
-    return prgl_create_shader(
-        vertexSources, 2, &FRAG_SHADER_SOURCE, 1, NULL, 0
-    );
+    return prgl_create_compute_shader(&COMPUTE_SHADER_SOURCE, 1);
 }
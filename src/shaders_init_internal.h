@@ -1,14 +1,33 @@
 #ifndef SHADERS_INIT_INTERNAL_H
 #define SHADERS_INIT_INTERNAL_H
 
+#include <stdbool.h>
+
 #include "types.h"
 
 PRGLShader prgl_init_shader_screen(void);
 
 PRGLShader prgl_init_shader_2d(void);
 
-PRGLShader prgl_init_shader_3d(void);
+/**
+ * The 2D shader for sprite batches, vertices are already transformed to pixel
+ * coordinates and carry their fill color and alpha.
+ */
+PRGLShader prgl_init_shader_2d_batched(void);
+
+/**
+ * Builds a variant of the 3D shader, lit or unlit, with the given features
+ * compiled in.
+ *
+ * @param features PRGLShaderFeature bits.
+ * @param max_lights The most point lights the variant loops over.
+ */
+PRGLShader prgl_init_shader_3d_variant(unsigned features, int max_lights);
 
-PRGLShader prgl_init_shader_unlit(void);
+/**
+ * The GL 4.3 compute shader which frustum culls multi draw commands and
+ * compacts the visible ones, see gpu_culling.c for the buffer bindings.
+ */
+PRGLShader prgl_init_shader_frustum_cull(void);
 
 #endif
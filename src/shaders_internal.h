@@ -1,14 +1,116 @@
 #ifndef PRGL_SHADERS_INTERNAL_H
 #define PRGL_SHADERS_INTERNAL_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "types.h"
+
+struct PRGLMesh;
+
+/**
+ * Uniforms set by prgl itself every frame. Handles for these are resolved once
+ * when a shader is linked so the render loop never has to look them up.
+ */
+enum PRGLBuiltinUniform
+{
+    PRGL_BUILTIN_UNIFORM_MODEL,
+    PRGL_BUILTIN_UNIFORM_VIEW,
+    PRGL_BUILTIN_UNIFORM_PROJECTION,
+    PRGL_BUILTIN_UNIFORM_NORMAL_MATRIX,
+    PRGL_BUILTIN_UNIFORM_RENDER_RESOLUTION,
+    PRGL_BUILTIN_UNIFORM_TILE_FACTOR,
+    PRGL_BUILTIN_UNIFORM_FILL_COLOR,
+    PRGL_BUILTIN_UNIFORM_USE_TEXTURE,
+    PRGL_BUILTIN_UNIFORM_ALPHA,
+    PRGL_BUILTIN_UNIFORM_OBJECT_LIGHTS,
+    PRGL_BUILTIN_UNIFORM_COUNT
+};
+
+/**
+ * Feature bits of the built in 3D shader variants, each is compiled in as a
+ * #define so the shaders don't branch on it at run time. The lit and unlit 3D
+ * shaders are both variants, unlit ones only use the instanced and wobble
+ * bits.
+ */
+enum PRGLShaderFeature
+{
+    PRGL_SHADER_FEATURE_INSTANCED = 1 << 0,
+    PRGL_SHADER_FEATURE_LIT = 1 << 1,
+    PRGL_SHADER_FEATURE_TEXTURED = 1 << 2,
+    PRGL_SHADER_FEATURE_WOBBLE = 1 << 3,
+    PRGL_SHADER_FEATURE_AFFINE = 1 << 4,
+    PRGL_SHADER_FEATURE_GEOMETRY_SHADER = 1 << 5,
+    PRGL_SHADER_FEATURE_OBJECT_LIGHTS = 1 << 6,
+    PRGL_SHADER_FEATURE_BAKED = 1 << 7
+};
+
+/**
+ * Compiles and links a compute shader program. Needs a GL 4.3 context.
+ *
+ * @param source[in] Strings to concatenate into the shader source.
+ * @param num_sources
+ * @return The program, usable with prgl_use_shader().
+ */
+PRGLShader prgl_create_compute_shader(
+    const char *const source[], int num_sources
+);
+
 /**
- * Precompiles built in shaders and adds them to the shader pool.
+ * Reads the program binary cache, then precompiles built in shaders and adds
+ * them to the shader pool.
  */
 void prgl_init_shader_pool(void);
 
 /**
- * Deletes built in shaders from the shader pool.
+ * Deletes built in shaders from the shader pool and writes out the program
+ * binary cache.
  */
 void prgl_delete_shader_pool(void);
 
+/**
+ * Picks the shader a draw is issued with. Built in 3D shaders are swapped for
+ * the variant matching the draw, the number of point lights and the shader
+ * settings, which is compiled the first time it's needed. Other shaders are
+ * returned as they are. Lit variants with PRGL_SHADER_FEATURE_OBJECT_LIGHTS
+ * need the draw's lights selected with prgl_select_object_lights().
+ *
+ * @param shader The shader the draw was made with.
+ * @param mesh[in] The draw's mesh, for its texture and baked lighting.
+ * @param instanced True if the draw reads per-instance attributes.
+ * @return The shader to draw with.
+ */
+PRGLShader prgl_draw_shader_variant(
+    PRGLShader shader, const struct PRGLMesh *const mesh, bool instanced
+);
+
+/**
+ * Checks if a shader is a built in 3D variant and gets its features.
+ *
+ * @param shader
+ * @param features[out] Receives the PRGLShaderFeature bits if it's a variant.
+ * @return True if the shader is a built in 3D variant.
+ */
+bool prgl_shader_variant_features(PRGLShader shader, unsigned *const features);
+
+/**
+ * Gets the handle of a built in uniform for the shader currently in use.
+ *
+ * @param uniform The built in uniform to get.
+ * @return The handle, the location will be -1 if the shader doesn't use it.
+ */
+PRGLUniform prgl_current_builtin_uniform(enum PRGLBuiltinUniform uniform);
+
+/**
+ * Gets the last value set through prgl on a uniform of the current shader.
+ *
+ * @param uniform
+ * @param value[out] Receives the value if there is one.
+ * @param size Size of the value in bytes.
+ * @return False if the uniform hasn't been set, value is left unchanged.
+ */
+bool prgl_current_builtin_uniform_value(
+    enum PRGLBuiltinUniform uniform, void *const value, size_t size
+);
+
 #endif
@@ -0,0 +1,278 @@
+#include "glad.h"
+
+#include "sprite_batch_internal.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gl_state_internal.h"
+#include "mesh_internal.h"
+#include "shaders.h"
+#include "shaders_internal.h"
+
+// Pixel position, texture coordinates, and RGBA color
+static const GLint SPRITE_VERTEX_LENGTH = 8;
+static const GLsizei SPRITE_VERTEX_STRIDE = 8 * sizeof(GLfloat);
+static const GLint SPRITE_TEX_COORD_OFFSET = 2 * sizeof(GLfloat);
+static const GLint SPRITE_COLOR_OFFSET = 4 * sizeof(GLfloat);
+
+static const GLuint SPRITE_POSITION_LOCATION = 0;
+static const GLuint SPRITE_TEX_COORD_LOCATION = 2;
+static const GLuint SPRITE_COLOR_LOCATION = 3;
+
+// Size of the streaming buffers, a batch is drawn early if it would overflow
+// them. Once the end is reached the buffers are orphaned and reused from the
+// start.
+static const GLsizei SPRITE_RING_VERTICES = 16384;
+static const GLsizei SPRITE_RING_INDICES = 32768;
+
+static GLuint prgl_sprite_vao = 0;
+static GLuint prgl_sprite_vbo = 0;
+static GLuint prgl_sprite_ebo = 0;
+static GLsizei prgl_sprite_ring_vertex = 0;
+static GLsizei prgl_sprite_ring_index = 0;
+
+// The batch being built, drawn when the texture changes or on flush
+static GLfloat *prgl_batch_vertices = NULL;
+static GLuint *prgl_batch_indices = NULL;
+static GLsizei prgl_batch_num_vertices = 0;
+static GLsizei prgl_batch_num_indices = 0;
+static GLuint prgl_batch_texture = 0;
+
+static void prgl_write_sprite_ring(
+    GLenum target, GLintptr offset, GLsizeiptr size, const void *const data
+);
+
+void prgl_init_sprite_batch(void)
+{
+    prgl_batch_vertices =
+        malloc(sizeof(GLfloat) * SPRITE_VERTEX_LENGTH * SPRITE_RING_VERTICES);
+    prgl_batch_indices = malloc(sizeof(GLuint) * SPRITE_RING_INDICES);
+    if (prgl_batch_vertices == NULL || prgl_batch_indices == NULL)
+    {
+        fprintf(
+            stderr, "prgl_init_sprite_batch: Error allocating batch memory, 2D "
+                    "draws won't be batched!\n"
+        );
+        free(prgl_batch_vertices);
+        free(prgl_batch_indices);
+        prgl_batch_vertices = NULL;
+        prgl_batch_indices = NULL;
+        return;
+    }
+
+    glGenVertexArrays(1, &prgl_sprite_vao);
+    glGenBuffers(1, &prgl_sprite_vbo);
+    glGenBuffers(1, &prgl_sprite_ebo);
+
+    prgl_gl_bind_vertex_array(prgl_sprite_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, prgl_sprite_vbo);
+    glBufferData(
+        GL_ARRAY_BUFFER, SPRITE_VERTEX_STRIDE * SPRITE_RING_VERTICES, NULL,
+        GL_STREAM_DRAW
+    );
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, prgl_sprite_ebo);
+    glBufferData(
+        GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * SPRITE_RING_INDICES, NULL,
+        GL_STREAM_DRAW
+    );
+
+    glVertexAttribPointer(
+        SPRITE_POSITION_LOCATION, 2, GL_FLOAT, GL_FALSE, SPRITE_VERTEX_STRIDE,
+        (const GLvoid *)0
+    );
+    glEnableVertexAttribArray(SPRITE_POSITION_LOCATION);
+    glVertexAttribPointer(
+        SPRITE_TEX_COORD_LOCATION, 2, GL_FLOAT, GL_FALSE, SPRITE_VERTEX_STRIDE,
+        (const GLvoid *)(intptr_t)SPRITE_TEX_COORD_OFFSET
+    );
+    glEnableVertexAttribArray(SPRITE_TEX_COORD_LOCATION);
+    glVertexAttribPointer(
+        SPRITE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, SPRITE_VERTEX_STRIDE,
+        (const GLvoid *)(intptr_t)SPRITE_COLOR_OFFSET
+    );
+    glEnableVertexAttribArray(SPRITE_COLOR_LOCATION);
+
+    prgl_sprite_ring_vertex = 0;
+    prgl_sprite_ring_index = 0;
+    prgl_batch_num_vertices = 0;
+    prgl_batch_num_indices = 0;
+}
+
+void prgl_delete_sprite_batch(void)
+{
+    if (prgl_sprite_vao != 0)
+    {
+        prgl_gl_delete_vertex_array(prgl_sprite_vao);
+        glDeleteBuffers(1, &prgl_sprite_vbo);
+        glDeleteBuffers(1, &prgl_sprite_ebo);
+    }
+    prgl_sprite_vao = 0;
+    prgl_sprite_vbo = 0;
+    prgl_sprite_ebo = 0;
+
+    free(prgl_batch_vertices);
+    free(prgl_batch_indices);
+    prgl_batch_vertices = NULL;
+    prgl_batch_indices = NULL;
+    prgl_batch_num_vertices = 0;
+    prgl_batch_num_indices = 0;
+}
+
+bool prgl_sprite_batch_accepts(struct PRGLMesh *const mesh, GLuint shader)
+{
+    const struct PRGLSpriteGeometry *const geometry = mesh->sprite_geometry;
+    return prgl_sprite_vao != 0 && geometry != NULL
+        && geometry->num_vertices <= SPRITE_RING_VERTICES
+        && geometry->num_indices <= SPRITE_RING_INDICES
+        && shader == prgl_shader(PRGL_SHADER_TYPE_2D).id;
+}
+
+int prgl_add_sprite(
+    struct PRGLMesh *const mesh, mat4 model, vec3 color, float alpha,
+    vec2 tile_factor
+)
+{
+    const struct PRGLSpriteGeometry *const geometry = mesh->sprite_geometry;
+    const GLuint texture = (GLuint)mesh->texture.id;
+
+    int batches_drawn = 0;
+    if (texture != prgl_batch_texture
+        || prgl_batch_num_vertices + geometry->num_vertices
+               > SPRITE_RING_VERTICES
+        || prgl_batch_num_indices + geometry->num_indices
+               > SPRITE_RING_INDICES)
+    {
+        batches_drawn = prgl_flush_sprite_batch();
+        prgl_batch_texture = texture;
+    }
+
+    // Same as the 2D shader's model transform, z is always zero for 2D
+    GLfloat *vertex =
+        &prgl_batch_vertices[prgl_batch_num_vertices * SPRITE_VERTEX_LENGTH];
+    for (GLsizei v = 0; v < geometry->num_vertices; v++)
+    {
+        const GLfloat *const source = &geometry->vertices[v * 4];
+        const float x = source[0];
+        const float y = source[1];
+        vertex[0] = model[0][0] * x + model[1][0] * y + model[3][0];
+        vertex[1] = model[0][1] * x + model[1][1] * y + model[3][1];
+        vertex[2] = source[2] * tile_factor[0];
+        vertex[3] = source[3] * tile_factor[1];
+        vertex[4] = color[0];
+        vertex[5] = color[1];
+        vertex[6] = color[2];
+        vertex[7] = alpha;
+        vertex += SPRITE_VERTEX_LENGTH;
+    }
+
+    GLuint *const indices = &prgl_batch_indices[prgl_batch_num_indices];
+    for (GLsizei i = 0; i < geometry->num_indices; i++)
+    {
+        indices[i] = (GLuint)prgl_batch_num_vertices + geometry->indices[i];
+    }
+
+    prgl_batch_num_vertices += geometry->num_vertices;
+    prgl_batch_num_indices += geometry->num_indices;
+    return batches_drawn;
+}
+
+int prgl_flush_sprite_batch(void)
+{
+    if (prgl_batch_num_indices == 0)
+    {
+        return 0;
+    }
+
+    // The element buffer binding is part of the vertex array
+    prgl_gl_bind_vertex_array(prgl_sprite_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, prgl_sprite_vbo);
+
+    if (prgl_sprite_ring_vertex + prgl_batch_num_vertices > SPRITE_RING_VERTICES
+        || prgl_sprite_ring_index + prgl_batch_num_indices
+               > SPRITE_RING_INDICES)
+    {
+        // Orphan so the driver can give us fresh storage without waiting on
+        // draws still reading the old one
+        glBufferData(
+            GL_ARRAY_BUFFER, SPRITE_VERTEX_STRIDE * SPRITE_RING_VERTICES, NULL,
+            GL_STREAM_DRAW
+        );
+        glBufferData(
+            GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * SPRITE_RING_INDICES, NULL,
+            GL_STREAM_DRAW
+        );
+        prgl_sprite_ring_vertex = 0;
+        prgl_sprite_ring_index = 0;
+    }
+
+    prgl_write_sprite_ring(
+        GL_ARRAY_BUFFER,
+        (GLintptr)SPRITE_VERTEX_STRIDE * prgl_sprite_ring_vertex,
+        (GLsizeiptr)SPRITE_VERTEX_STRIDE * prgl_batch_num_vertices,
+        prgl_batch_vertices
+    );
+    prgl_write_sprite_ring(
+        GL_ELEMENT_ARRAY_BUFFER,
+        (GLintptr)sizeof(GLuint) * prgl_sprite_ring_index,
+        (GLsizeiptr)sizeof(GLuint) * prgl_batch_num_indices, prgl_batch_indices
+    );
+
+    const PRGLShader shader = prgl_shader(PRGL_SHADER_TYPE_2D_BATCHED);
+    if (prgl_current_shader().id != shader.id)
+    {
+        prgl_use_shader(shader);
+    }
+    prgl_set_uniform_bool(
+        prgl_current_builtin_uniform(PRGL_BUILTIN_UNIFORM_USE_TEXTURE),
+        prgl_batch_texture != 0
+    );
+    if (prgl_batch_texture != 0)
+    {
+        prgl_gl_bind_texture_2d(0, prgl_batch_texture);
+    }
+
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES, prgl_batch_num_indices, GL_UNSIGNED_INT,
+        (const GLvoid *)(intptr_t)(sizeof(GLuint) * prgl_sprite_ring_index),
+        prgl_sprite_ring_vertex
+    );
+
+    prgl_sprite_ring_vertex += prgl_batch_num_vertices;
+    prgl_sprite_ring_index += prgl_batch_num_indices;
+    prgl_batch_num_vertices = 0;
+    prgl_batch_num_indices = 0;
+    return 1;
+}
+
+/**
+ * Copies data into a range of a streaming buffer which no draw has used since
+ * the buffer was last orphaned, so the driver doesn't need to synchronize.
+ *
+ * GL 3.3 has no persistent mapping, so the range is mapped for each batch.
+ *
+ * @param target The buffer binding to write to.
+ * @param offset Offset in bytes.
+ * @param size Size in bytes.
+ * @param data[in]
+ */
+static void prgl_write_sprite_ring(
+    GLenum target, GLintptr offset, GLsizeiptr size, const void *const data
+)
+{
+    void *const mapped = glMapBufferRange(
+        target, offset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT
+            | GL_MAP_UNSYNCHRONIZED_BIT
+    );
+    if (mapped == NULL)
+    {
+        glBufferSubData(target, offset, size, data);
+        return;
+    }
+
+    memcpy(mapped, data, size);
+    glUnmapBuffer(target);
+}
@@ -0,0 +1,55 @@
+#ifndef PRGL_SPRITE_BATCH_INTERNAL_H
+#define PRGL_SPRITE_BATCH_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "glad.h"
+#include "cglm/types.h"
+
+struct PRGLMesh;
+
+/**
+ * Creates the streaming buffers and vertex array used for sprite batches.
+ */
+void prgl_init_sprite_batch(void);
+
+/**
+ * Deletes the sprite batch buffers and frees its memory.
+ */
+void prgl_delete_sprite_batch(void);
+
+/**
+ * Checks if a 2D draw can go into a sprite batch.
+ *
+ * @param mesh[in]
+ * @param shader The shader the draw was made with.
+ * @return True if the mesh has sprite geometry and the shader is the built in
+ * 2D shader.
+ */
+bool prgl_sprite_batch_accepts(struct PRGLMesh *const mesh, GLuint shader);
+
+/**
+ * Transforms a 2D draw into the current batch. The current batch is drawn
+ * first if the texture differs or it's full.
+ *
+ * @param mesh[in]
+ * @param model
+ * @param color
+ * @param alpha
+ * @param tile_factor
+ * @return The number of batches drawn to make room, 0 or 1.
+ */
+int prgl_add_sprite(
+    struct PRGLMesh *const mesh, mat4 model, vec3 color, float alpha,
+    vec2 tile_factor
+);
+
+/**
+ * Draws the current batch if it has anything in it. Leaves the batch shader,
+ * vertex array and texture bound.
+ *
+ * @return The number of batches drawn, 0 or 1.
+ */
+int prgl_flush_sprite_batch(void);
+
+#endif
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <GLFW/glfw3.h>
 
+#include "gl_state_internal.h"
 #include "render.h"
 #include "stb_image.h"
 #include "types.h"
@@ -34,7 +35,7 @@ PRGLTexture prgl_load_texture(const char *const filename)
     glGenTextures(1, &texture);
 
     // Bind texture so OpenGL knows we're configuring this one
-    glBindTexture(GL_TEXTURE_2D, texture);
+    prgl_gl_bind_texture_2d(0, texture);
 
     // Set texture wrapping and filtering options
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -60,12 +61,12 @@ struct PRGLRenderTexture prgl_create_render_texture(void)
     // Create a framebuffer object
     GLuint fbo;
     glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    prgl_gl_bind_framebuffer(fbo);
 
     // Create the texture for rendering to
     GLuint render_texture;
     glGenTextures(1, &render_texture);
-    glBindTexture(GL_TEXTURE_2D, render_texture);
+    prgl_gl_bind_texture_2d(0, render_texture);
     glTexImage2D(
         GL_TEXTURE_2D, 0, GL_RGB, PRGL_RENDER_RESOLUTION[0],
         PRGL_RENDER_RESOLUTION[1], 0, GL_RGB, GL_UNSIGNED_BYTE, NULL
@@ -1,15 +1,27 @@
 #include "transform_internal.h"
 #include "game_object.h"
-#include "cglm/affine.h"
+#include "cglm/mat3.h"
 #include "cglm/mat4.h"
 #include "cglm/quat.h"
+#include "cglm/vec3.h"
+#include "game.h"
+
+static bool prgl_game_object_moved_in_tick(
+    const struct PRGLGameObject *game_obj, unsigned long tick
+);
+static void prgl_blend_game_object_transform(
+    const struct PRGLGameObject *const game_obj, unsigned long tick,
+    float alpha, mat4 model, mat3 normal_matrix
+);
 
 void prgl_create_model_matrix(mat4 model, struct PRGLGameObject *const game_obj)
 {
-    glm_mat4_identity(model);
-    glm_translate(model, game_obj->position);
-    glm_quat_rotate(model, game_obj->orientation, model);
-    glm_scale(model, game_obj->scale);
+    // Translate * rotate * scale, built directly instead of multiplied out
+    glm_quat_mat4(game_obj->orientation, model);
+    glm_vec3_scale(model[0], game_obj->scale[0], model[0]);
+    glm_vec3_scale(model[1], game_obj->scale[1], model[1]);
+    glm_vec3_scale(model[2], game_obj->scale[2], model[2]);
+    glm_vec3_copy(game_obj->position, model[3]);
 }
 
 void prgl_create_normal_matrix(mat3 normal_matrix, mat4 model)
@@ -19,3 +31,179 @@ void prgl_create_normal_matrix(mat3 normal_matrix, mat4 model)
     glm_mat4_transpose(normal_mat4);
     glm_mat4_pick3(normal_mat4, normal_matrix);
 }
+
+void prgl_create_transform_matrices(
+    mat4 model, mat3 normal_matrix, vec3 position, versor orientation,
+    vec3 scale
+)
+{
+    glm_quat_mat4(orientation, model);
+    glm_vec3_scale(model[0], scale[0], model[0]);
+    glm_vec3_scale(model[1], scale[1], model[1]);
+    glm_vec3_scale(model[2], scale[2], model[2]);
+    glm_vec3_copy(position, model[3]);
+
+    // The inverse transpose of rotate * scale is rotate * inverse scale, so
+    // each model column is divided by its scale twice. This holds for any
+    // non-zero scale, uniform or not, and it's only the plain rotation when
+    // every scale is 1. A zero scale has no inverse, so it's left to the
+    // general path.
+    if (scale[0] != 0.0f && scale[1] != 0.0f && scale[2] != 0.0f)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            glm_vec3_scale(
+                model[i], 1.0f / (scale[i] * scale[i]), normal_matrix[i]
+            );
+        }
+    }
+    else
+    {
+        prgl_create_normal_matrix(normal_matrix, model);
+    }
+}
+
+void prgl_update_game_object_transform(struct PRGLGameObject *const game_obj)
+{
+    if (!game_obj->transform_dirty)
+    {
+        return;
+    }
+
+    mat4 local;
+    mat3 local_normal;
+    prgl_create_transform_matrices(
+        local, local_normal, game_obj->position, game_obj->orientation,
+        game_obj->scale
+    );
+
+    // Children are placed in their parent's space, the inverse transpose of a
+    // product is the product of the inverse transposes
+    const struct PRGLGameObject *const parent = game_obj->parent;
+    if (parent != NULL)
+    {
+        glm_mat4_mul((vec4 *)parent->model, local, game_obj->model);
+        glm_mat3_mul(
+            (vec3 *)parent->normal_matrix, local_normal,
+            game_obj->normal_matrix
+        );
+    }
+    else
+    {
+        glm_mat4_copy(local, game_obj->model);
+        glm_mat3_copy(local_normal, game_obj->normal_matrix);
+    }
+    game_obj->transform_dirty = false;
+}
+
+bool prgl_interpolate_game_object_transform(
+    const struct PRGLGameObject *const game_obj, mat4 model,
+    mat3 normal_matrix
+)
+{
+    const float alpha = (float)prgl_interpolation_alpha();
+    const unsigned long tick = prgl_current_tick();
+
+    // Moves before the first tick, e.g. placing objects in the init callback,
+    // have nothing to blend from, the first frame may run no ticks at all
+    if (alpha >= 1.0f || tick == 0
+        || !prgl_game_object_moved_in_tick(game_obj, tick))
+    {
+        return false;
+    }
+
+    prgl_blend_game_object_transform(
+        game_obj, tick, alpha, model, normal_matrix
+    );
+    return true;
+}
+
+/**
+ * Checks if a game object or any of its ancestors moved in an update tick.
+ *
+ * @param game_obj[in]
+ * @param tick
+ * @return True if one of them moved.
+ */
+static bool prgl_game_object_moved_in_tick(
+    const struct PRGLGameObject *game_obj, unsigned long tick
+)
+{
+    for (; game_obj != NULL; game_obj = game_obj->parent)
+    {
+        if (game_obj->move_tick == tick)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Builds a game object's world matrices part way between its previous and
+ * current transforms, blending its ancestors the same way.
+ *
+ * @param game_obj[in]
+ * @param tick The current update tick.
+ * @param alpha 0 for the previous transforms, 1 for the current ones.
+ * @param model[out]
+ * @param normal_matrix[out]
+ */
+static void prgl_blend_game_object_transform(
+    const struct PRGLGameObject *const game_obj, unsigned long tick,
+    float alpha, mat4 model, mat3 normal_matrix
+)
+{
+    if (!prgl_game_object_moved_in_tick(game_obj, tick))
+    {
+        glm_mat4_copy((vec4 *)game_obj->model, model);
+        glm_mat3_copy((vec3 *)game_obj->normal_matrix, normal_matrix);
+        return;
+    }
+
+    // Only a move in this tick has a previous transform to blend from
+    versor orientation;
+    vec3 position;
+    vec3 scale;
+    if (game_obj->move_tick == tick)
+    {
+        glm_quat_slerp(
+            (float *)game_obj->previous_orientation,
+            (float *)game_obj->orientation, alpha, orientation
+        );
+        glm_vec3_lerp(
+            (float *)game_obj->previous_position, (float *)game_obj->position,
+            alpha, position
+        );
+        glm_vec3_lerp(
+            (float *)game_obj->previous_scale, (float *)game_obj->scale, alpha,
+            scale
+        );
+    }
+    else
+    {
+        glm_quat_copy((float *)game_obj->orientation, orientation);
+        glm_vec3_copy((float *)game_obj->position, position);
+        glm_vec3_copy((float *)game_obj->scale, scale);
+    }
+
+    mat4 local;
+    mat3 local_normal;
+    prgl_create_transform_matrices(
+        local, local_normal, position, orientation, scale
+    );
+    if (game_obj->parent == NULL)
+    {
+        glm_mat4_copy(local, model);
+        glm_mat3_copy(local_normal, normal_matrix);
+        return;
+    }
+
+    mat4 parent_model;
+    mat3 parent_normal;
+    prgl_blend_game_object_transform(
+        game_obj->parent, tick, alpha, parent_model, parent_normal
+    );
+    glm_mat4_mul(parent_model, local, model);
+    glm_mat3_mul(parent_normal, local_normal, normal_matrix);
+}
@@ -1,9 +1,12 @@
 #ifndef PRGL_TRANSFORM_INTERNAL_H
 #define PRGL_TRANSFORM_INTERNAL_H
 
+#include <stdbool.h>
+
 #include "cglm/types.h"
 
 struct PRGLGameObject;
+struct PRGLTransformStore;
 
 /**
  * Creates a model matrix which can be passed to a shader transform uniform.
@@ -25,4 +28,61 @@ void prgl_create_model_matrix(
  */
 void prgl_create_normal_matrix(mat3 normal_matrix, mat4 model);
 
+/**
+ * Creates the model and normal matrices of a translation, rotation and scale.
+ * The normal matrix is derived from the scale instead of inverting the model
+ * matrix.
+ *
+ * @param[out] model
+ * @param[out] normal_matrix
+ * @param[in] position
+ * @param[in] orientation Quaternion rotation.
+ * @param[in] scale
+ */
+void prgl_create_transform_matrices(
+    mat4 model, mat3 normal_matrix, vec3 position, versor orientation,
+    vec3 scale
+);
+
+/**
+ * Rebuilds the cached model and normal matrices of a game object if its
+ * transform changed since they were last built. Game objects with a parent
+ * are placed relative to the parent's cached matrices, which must be current.
+ *
+ * @param[in,out] game_obj
+ */
+void prgl_update_game_object_transform(struct PRGLGameObject *const game_obj);
+
+/**
+ * Builds a game object's world matrices between its transforms in the last two
+ * update ticks, by the interpolation alpha of the frame being drawn. Its
+ * cached matrices, and those of its ancestors, must be current.
+ *
+ * @param[in] game_obj
+ * @param[out] model
+ * @param[out] normal_matrix
+ * @return False if the game object and its ancestors didn't move in the last
+ * tick, no tick has run yet, or the frame is drawn at the latest tick, so the
+ * cached matrices are already right and nothing is written.
+ */
+bool prgl_interpolate_game_object_transform(
+    const struct PRGLGameObject *const game_obj, mat4 model,
+    mat3 normal_matrix
+);
+
+/**
+ * Builds the model and normal matrices of every transform in a store into
+ * strided destinations, so they can be written straight into instance data.
+ *
+ * @param[in] store
+ * @param[out] model_dest Receives 16 floats per transform.
+ * @param model_stride Floats from one transform's model matrix to the next.
+ * @param[out] normal_dest Receives 9 floats per transform, or NULL.
+ * @param normal_stride Floats from one transform's normal matrix to the next.
+ */
+void prgl_write_transform_matrices(
+    const struct PRGLTransformStore *const store, float model_dest[],
+    int model_stride, float normal_dest[], int normal_stride
+);
+
 #endif
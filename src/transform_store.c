@@ -0,0 +1,329 @@
+#include "transform_store.h"
+#include "transform_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <xmmintrin.h>
+#endif
+
+#include "cglm/mat4.h"
+#include "cglm/quat.h"
+#include "cglm/vec3.h"
+
+// Number of component arrays sharing a store's allocation
+#define TRANSFORM_STORE_ARRAYS 10
+
+static bool prgl_resize_transform_store(
+    struct PRGLTransformStore *const store, int capacity
+);
+static void prgl_write_transform_matrix(
+    const struct PRGLTransformStore *const store, int index,
+    float model_dest[], float normal_dest[]
+);
+
+bool prgl_init_transform_store(
+    struct PRGLTransformStore *const store, int capacity
+)
+{
+    memset(store, 0, sizeof(struct PRGLTransformStore));
+    return prgl_resize_transform_store(store, capacity < 4 ? 4 : capacity);
+}
+
+void prgl_delete_transform_store(struct PRGLTransformStore *const store)
+{
+    // Every array is a slice of the first one's allocation
+    free(store->position_x);
+    memset(store, 0, sizeof(struct PRGLTransformStore));
+}
+
+int prgl_add_transform(
+    struct PRGLTransformStore *const store, vec3 position, versor orientation,
+    vec3 scale
+)
+{
+    if (store->count == store->capacity
+        && !prgl_resize_transform_store(store, store->capacity * 2))
+    {
+        return -1;
+    }
+
+    const int index = store->count++;
+    prgl_set_transform(store, index, position, orientation, scale);
+    return index;
+}
+
+void prgl_set_transform(
+    struct PRGLTransformStore *const store, int index, vec3 position,
+    versor orientation, vec3 scale
+)
+{
+    store->position_x[index] = position[0];
+    store->position_y[index] = position[1];
+    store->position_z[index] = position[2];
+    store->orientation_x[index] = orientation[0];
+    store->orientation_y[index] = orientation[1];
+    store->orientation_z[index] = orientation[2];
+    store->orientation_w[index] = orientation[3];
+    store->scale_x[index] = scale[0];
+    store->scale_y[index] = scale[1];
+    store->scale_z[index] = scale[2];
+}
+
+void prgl_build_transform_matrices(
+    const struct PRGLTransformStore *const store, mat4 models[],
+    mat3 normal_matrices[]
+)
+{
+    prgl_write_transform_matrices(
+        store, (float *)models, 16, (float *)normal_matrices, 9
+    );
+}
+
+void prgl_write_transform_matrices(
+    const struct PRGLTransformStore *const store, float model_dest[],
+    int model_stride, float normal_dest[], int normal_stride
+)
+{
+    int i = 0;
+#ifdef __SSE2__
+    // Each lane builds one object's matrices, the results are transposed
+    // back into one matrix per object when they're stored
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    for (; i + 4 <= store->count; i += 4)
+    {
+        const __m128 sx = _mm_loadu_ps(&store->scale_x[i]);
+        const __m128 sy = _mm_loadu_ps(&store->scale_y[i]);
+        const __m128 sz = _mm_loadu_ps(&store->scale_z[i]);
+
+        // A zero scale has no inverse, those groups take the scalar path
+        const __m128 zero_scale = _mm_or_ps(
+            _mm_or_ps(_mm_cmpeq_ps(sx, zero), _mm_cmpeq_ps(sy, zero)),
+            _mm_cmpeq_ps(sz, zero)
+        );
+        if (normal_dest != NULL && _mm_movemask_ps(zero_scale) != 0)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                prgl_write_transform_matrix(
+                    store, i + lane, &model_dest[(i + lane) * model_stride],
+                    &normal_dest[(i + lane) * normal_stride]
+                );
+            }
+            continue;
+        }
+
+        // Same rotation as glm_quat_mat4(), normalizing the quaternion
+        const __m128 x = _mm_loadu_ps(&store->orientation_x[i]);
+        const __m128 y = _mm_loadu_ps(&store->orientation_y[i]);
+        const __m128 z = _mm_loadu_ps(&store->orientation_z[i]);
+        const __m128 w = _mm_loadu_ps(&store->orientation_w[i]);
+        const __m128 norm = _mm_sqrt_ps(_mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+            _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))
+        ));
+        const __m128 s =
+            _mm_and_ps(_mm_cmpgt_ps(norm, zero), _mm_div_ps(two, norm));
+        const __m128 sx_ = _mm_mul_ps(s, x);
+        const __m128 sy_ = _mm_mul_ps(s, y);
+        const __m128 sw_ = _mm_mul_ps(s, w);
+        const __m128 xx = _mm_mul_ps(sx_, x);
+        const __m128 yy = _mm_mul_ps(sy_, y);
+        const __m128 zz = _mm_mul_ps(_mm_mul_ps(s, z), z);
+        const __m128 xy = _mm_mul_ps(sx_, y);
+        const __m128 yz = _mm_mul_ps(sy_, z);
+        const __m128 xz = _mm_mul_ps(sx_, z);
+        const __m128 wx = _mm_mul_ps(sw_, x);
+        const __m128 wy = _mm_mul_ps(sw_, y);
+        const __m128 wz = _mm_mul_ps(sw_, z);
+
+        // Rotation columns scaled by each axis, then the translation
+        __m128 c0x = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, yy), zz), sx);
+        __m128 c0y = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+        __m128 c0z = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+        __m128 c1x = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+        __m128 c1y = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), zz), sy);
+        __m128 c1z = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+        __m128 c2x = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+        __m128 c2y = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+        __m128 c2z = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), yy), sz);
+        __m128 c3x = _mm_loadu_ps(&store->position_x[i]);
+        __m128 c3y = _mm_loadu_ps(&store->position_y[i]);
+        __m128 c3z = _mm_loadu_ps(&store->position_z[i]);
+
+        // Normal columns are the model columns divided by their scale twice,
+        // the inverse transpose of rotate * scale
+        if (normal_dest != NULL)
+        {
+            const __m128 nx = _mm_div_ps(one, _mm_mul_ps(sx, sx));
+            const __m128 ny = _mm_div_ps(one, _mm_mul_ps(sy, sy));
+            const __m128 nz = _mm_div_ps(one, _mm_mul_ps(sz, sz));
+            __m128 n0 = _mm_mul_ps(c0x, nx);
+            __m128 n1 = _mm_mul_ps(c0y, nx);
+            __m128 n2 = _mm_mul_ps(c0z, nx);
+            __m128 n3 = _mm_mul_ps(c1x, ny);
+            __m128 n4 = _mm_mul_ps(c1y, ny);
+            __m128 n5 = _mm_mul_ps(c1z, ny);
+            __m128 n6 = _mm_mul_ps(c2x, nz);
+            __m128 n7 = _mm_mul_ps(c2y, nz);
+            float n8[4];
+            _mm_storeu_ps(n8, _mm_mul_ps(c2z, nz));
+
+            // A mat3 is 9 floats, stored as two groups of four and the last
+            _MM_TRANSPOSE4_PS(n0, n1, n2, n3);
+            _MM_TRANSPOSE4_PS(n4, n5, n6, n7);
+            float *const normal = &normal_dest[i * normal_stride];
+            _mm_storeu_ps(&normal[0], n0);
+            _mm_storeu_ps(&normal[4], n4);
+            _mm_storeu_ps(&normal[normal_stride], n1);
+            _mm_storeu_ps(&normal[normal_stride + 4], n5);
+            _mm_storeu_ps(&normal[normal_stride * 2], n2);
+            _mm_storeu_ps(&normal[normal_stride * 2 + 4], n6);
+            _mm_storeu_ps(&normal[normal_stride * 3], n3);
+            _mm_storeu_ps(&normal[normal_stride * 3 + 4], n7);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                normal[normal_stride * lane + 8] = n8[lane];
+            }
+        }
+
+        __m128 c0w = zero;
+        __m128 c1w = zero;
+        __m128 c2w = zero;
+        __m128 c3w = one;
+        _MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+        _MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+        _MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+        _MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+        float *const model = &model_dest[i * model_stride];
+        const __m128 columns[4][4] = {
+            {c0x, c1x, c2x, c3x},
+            {c0y, c1y, c2y, c3y},
+            {c0z, c1z, c2z, c3z},
+            {c0w, c1w, c2w, c3w},
+        };
+        for (int lane = 0; lane < 4; lane++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                _mm_storeu_ps(
+                    &model[model_stride * lane + column * 4],
+                    columns[lane][column]
+                );
+            }
+        }
+    }
+#endif
+
+    for (; i < store->count; i++)
+    {
+        prgl_write_transform_matrix(
+            store, i, &model_dest[i * model_stride],
+            normal_dest == NULL ? NULL : &normal_dest[i * normal_stride]
+        );
+    }
+}
+
+/**
+ * Moves a store's transforms into a new allocation of the given capacity,
+ * which is rounded up to a multiple of 4.
+ *
+ * @param store[in,out]
+ * @param capacity
+ * @return False if memory couldn't be allocated, the store is left as it was.
+ */
+static bool prgl_resize_transform_store(
+    struct PRGLTransformStore *const store, int capacity
+)
+{
+    capacity = (capacity + 3) & ~3;
+    float *const data =
+        malloc(sizeof(float) * TRANSFORM_STORE_ARRAYS * (size_t)capacity);
+    if (data == NULL)
+    {
+        fprintf(
+            stderr, "prgl_resize_transform_store: Error allocating transform "
+                    "memory!\n"
+        );
+        return false;
+    }
+
+    float *const old_data = store->position_x;
+    float **const arrays[TRANSFORM_STORE_ARRAYS] = {
+        &store->position_x,    &store->position_y,    &store->position_z,
+        &store->orientation_x, &store->orientation_y, &store->orientation_z,
+        &store->orientation_w, &store->scale_x,       &store->scale_y,
+        &store->scale_z,
+    };
+    for (int a = 0; a < TRANSFORM_STORE_ARRAYS; a++)
+    {
+        float *const array = &data[a * capacity];
+        if (store->count > 0)
+        {
+            memcpy(array, *arrays[a], sizeof(float) * store->count);
+        }
+        *arrays[a] = array;
+    }
+
+    free(old_data);
+    store->capacity = capacity;
+    return true;
+}
+
+/**
+ * Builds the matrices of one transform in a store, the same way
+ * prgl_update_game_object_transform() does for game objects.
+ *
+ * @param store[in]
+ * @param index
+ * @param model_dest[out] 16 floats for the model matrix.
+ * @param normal_dest[out] 9 floats for the normal matrix, or NULL.
+ */
+static void prgl_write_transform_matrix(
+    const struct PRGLTransformStore *const store, int index,
+    float model_dest[], float normal_dest[]
+)
+{
+    versor orientation = {
+        store->orientation_x[index], store->orientation_y[index],
+        store->orientation_z[index], store->orientation_w[index]
+    };
+    const vec3 scale = {
+        store->scale_x[index], store->scale_y[index], store->scale_z[index]
+    };
+
+    mat4 model;
+    glm_quat_mat4(orientation, model);
+    for (int i = 0; i < 3; i++)
+    {
+        glm_vec3_scale(model[i], scale[i], model[i]);
+    }
+    model[3][0] = store->position_x[index];
+    model[3][1] = store->position_y[index];
+    model[3][2] = store->position_z[index];
+    memcpy(model_dest, model, sizeof(mat4));
+
+    if (normal_dest == NULL)
+    {
+        return;
+    }
+    mat3 normal_matrix;
+    if (scale[0] != 0.0f && scale[1] != 0.0f && scale[2] != 0.0f)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            glm_vec3_scale(
+                model[i], 1.0f / (scale[i] * scale[i]), normal_matrix[i]
+            );
+        }
+    }
+    else
+    {
+        prgl_create_normal_matrix(normal_matrix, model);
+    }
+    memcpy(normal_dest, normal_matrix, sizeof(mat3));
+}
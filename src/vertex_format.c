@@ -0,0 +1,264 @@
+#include "glad.h"
+
+#include "vertex_format_internal.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Offsets of the attributes in the float vertices meshes are generated with
+static const GLint SOURCE_NORMAL_OFFSET = 3;
+static const GLint SOURCE_TEX_COORD_OFFSET = 6;
+
+static const GLuint POSITION_LOCATION = 0;
+static const GLuint NORMAL_LOCATION = 1;
+static const GLuint TEX_COORD_LOCATION = 2;
+
+// Normalized short positions are padded to four shorts to keep the next
+// attribute four byte aligned
+static const GLsizei SHORT_POSITION_SIZE = 4 * sizeof(GLshort);
+static const GLsizei FLOAT_POSITION_SIZE = 3 * sizeof(GLfloat);
+static const GLsizei NORMAL_SIZE = sizeof(GLuint);
+static const GLsizei TEX_COORD_SIZE = 2 * sizeof(GLushort);
+
+static bool prgl_format_has_normal(enum PRGLVertexFormat format);
+static bool prgl_format_has_tex_coord(enum PRGLVertexFormat format);
+static GLshort prgl_pack_snorm16(float value);
+static GLushort prgl_pack_unorm16(float value);
+static GLushort prgl_pack_half(float value);
+static GLuint prgl_pack_normal(const GLfloat normal[]);
+
+void prgl_choose_vertex_layout(
+    enum PRGLVertexFormat format, const GLfloat vertex_data[],
+    GLsizei num_vertices, GLint stride_length,
+    struct PRGLVertexLayout *const layout
+)
+{
+    bool positions_normalized = true;
+    bool tex_coords_normalized = true;
+    for (GLsizei v = 0; v < num_vertices; v++)
+    {
+        const GLfloat *const vertex = &vertex_data[v * stride_length];
+        for (int i = 0; i < 3; i++)
+        {
+            positions_normalized &= fabsf(vertex[i]) <= 1.0f;
+        }
+        if (prgl_format_has_tex_coord(format))
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                const float uv = vertex[SOURCE_TEX_COORD_OFFSET + i];
+                tex_coords_normalized &= uv >= 0.0f && uv <= 1.0f;
+            }
+        }
+    }
+
+    *layout = (struct PRGLVertexLayout){
+        .format = format,
+        .position_type = positions_normalized ? GL_SHORT : GL_FLOAT,
+        .tex_coord_type =
+            tex_coords_normalized ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT,
+    };
+
+    layout->stride =
+        positions_normalized ? SHORT_POSITION_SIZE : FLOAT_POSITION_SIZE;
+    if (prgl_format_has_normal(format))
+    {
+        layout->normal_offset = layout->stride;
+        layout->stride += NORMAL_SIZE;
+    }
+    if (prgl_format_has_tex_coord(format))
+    {
+        layout->tex_coord_offset = layout->stride;
+        layout->stride += TEX_COORD_SIZE;
+    }
+}
+
+void prgl_pack_vertices(
+    const struct PRGLVertexLayout *const layout, const GLfloat vertex_data[],
+    GLsizei num_vertices, GLint stride_length, void *const dest
+)
+{
+    unsigned char *packed = dest;
+    for (GLsizei v = 0; v < num_vertices; v++)
+    {
+        const GLfloat *const vertex = &vertex_data[v * stride_length];
+
+        if (layout->position_type == GL_SHORT)
+        {
+            const GLshort position[4] = {
+                prgl_pack_snorm16(vertex[0]), prgl_pack_snorm16(vertex[1]),
+                prgl_pack_snorm16(vertex[2]), 0
+            };
+            memcpy(packed, position, sizeof(position));
+        }
+        else
+        {
+            memcpy(packed, vertex, FLOAT_POSITION_SIZE);
+        }
+
+        if (prgl_format_has_normal(layout->format))
+        {
+            const GLuint normal =
+                prgl_pack_normal(&vertex[SOURCE_NORMAL_OFFSET]);
+            memcpy(&packed[layout->normal_offset], &normal, sizeof(normal));
+        }
+
+        if (prgl_format_has_tex_coord(layout->format))
+        {
+            GLushort tex_coord[2];
+            for (int i = 0; i < 2; i++)
+            {
+                const float uv = vertex[SOURCE_TEX_COORD_OFFSET + i];
+                tex_coord[i] = layout->tex_coord_type == GL_UNSIGNED_SHORT
+                                 ? prgl_pack_unorm16(uv)
+                                 : prgl_pack_half(uv);
+            }
+            memcpy(
+                &packed[layout->tex_coord_offset], tex_coord, sizeof(tex_coord)
+            );
+        }
+
+        packed += layout->stride;
+    }
+}
+
+void prgl_setup_vertex_layout(const struct PRGLVertexLayout *const layout)
+{
+    const GLboolean normalize_position = layout->position_type == GL_SHORT;
+    glVertexAttribPointer(
+        POSITION_LOCATION, 3, layout->position_type, normalize_position,
+        layout->stride, (const GLvoid *)0
+    );
+    glEnableVertexAttribArray(POSITION_LOCATION);
+
+    if (layout->format == PRGL_VERTEX_FORMAT_SPHERE)
+    {
+        // A unit sphere's normals are its positions, so read them again
+        glVertexAttribPointer(
+            NORMAL_LOCATION, 3, layout->position_type, normalize_position,
+            layout->stride, (const GLvoid *)0
+        );
+        glEnableVertexAttribArray(NORMAL_LOCATION);
+    }
+    else if (prgl_format_has_normal(layout->format))
+    {
+        glVertexAttribPointer(
+            NORMAL_LOCATION, 4, GL_INT_2_10_10_10_REV, GL_TRUE, layout->stride,
+            (const GLvoid *)(intptr_t)layout->normal_offset
+        );
+        glEnableVertexAttribArray(NORMAL_LOCATION);
+    }
+
+    if (prgl_format_has_tex_coord(layout->format))
+    {
+        glVertexAttribPointer(
+            TEX_COORD_LOCATION, 2, layout->tex_coord_type,
+            layout->tex_coord_type == GL_UNSIGNED_SHORT, layout->stride,
+            (const GLvoid *)(intptr_t)layout->tex_coord_offset
+        );
+        glEnableVertexAttribArray(TEX_COORD_LOCATION);
+    }
+}
+
+/**
+ * @param format
+ * @return True if the format stores a normal of its own.
+ */
+static bool prgl_format_has_normal(enum PRGLVertexFormat format)
+{
+    return format == PRGL_VERTEX_FORMAT_PACKED;
+}
+
+/**
+ * @param format
+ * @return True if the format stores texture coordinates.
+ */
+static bool prgl_format_has_tex_coord(enum PRGLVertexFormat format)
+{
+    return format != PRGL_VERTEX_FORMAT_POSITION;
+}
+
+/**
+ * @param value Clamped to -1 to 1.
+ * @return The value as a signed normalized short.
+ */
+static GLshort prgl_pack_snorm16(float value)
+{
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (GLshort)lroundf(value * 32767.0f);
+}
+
+/**
+ * @param value Clamped to 0 to 1.
+ * @return The value as an unsigned normalized short.
+ */
+static GLushort prgl_pack_unorm16(float value)
+{
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (GLushort)lroundf(value * 65535.0f);
+}
+
+/**
+ * Converts a float to a half float, rounding to nearest. Values too large for
+ * a half become infinity.
+ *
+ * @param value
+ * @return The bits of the half float.
+ */
+static GLushort prgl_pack_half(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const int32_t float_exponent = (int32_t)((bits >> 23) & 0xFF);
+    const int32_t exponent = float_exponent - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (float_exponent == 0xFF)
+    {
+        return (GLushort)(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+    }
+    if (exponent >= 31)
+    {
+        return (GLushort)(sign | 0x7C00);
+    }
+    if (exponent <= 0)
+    {
+        // Subnormal half, or zero if it's too small for that too
+        if (exponent < -10)
+        {
+            return (GLushort)sign;
+        }
+        mantissa |= 0x800000;
+        const int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        half += (mantissa >> (shift - 1)) & 1;
+        return (GLushort)(sign | half);
+    }
+
+    // A carry out of the mantissa correctly bumps the exponent
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    half += (mantissa >> 12) & 1;
+    return (GLushort)half;
+}
+
+/**
+ * Packs a normal into GL_INT_2_10_10_10_REV, x in the lowest bits.
+ *
+ * @param normal[in] Components are clamped to -1 to 1.
+ * @return The packed normal with w left at zero.
+ */
+static GLuint prgl_pack_normal(const GLfloat normal[])
+{
+    GLuint packed = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        float value = normal[i];
+        value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+        const int32_t component = (int32_t)lroundf(value * 511.0f);
+        packed |= ((GLuint)component & 0x3FF) << (i * 10);
+    }
+    return packed;
+}
@@ -0,0 +1,88 @@
+#ifndef PRGL_VERTEX_FORMAT_INTERNAL_H
+#define PRGL_VERTEX_FORMAT_INTERNAL_H
+
+#include "glad.h"
+
+/**
+ * How a mesh's vertices are stored on the GPU. Meshes are always generated as
+ * float position, normal, and texture coordinates, and packed into one of
+ * these when uploaded. Every format feeds the same shader inputs, aPos at
+ * location 0, aNormal at 1, and aTexCoord at 2.
+ *
+ * Positions are normalized shorts when they're all within -1 to 1, else
+ * floats. Texture coordinates are normalized unsigned shorts when they're all
+ * within 0 to 1, else half floats.
+ */
+enum PRGLVertexFormat
+{
+    /// Position, GL_INT_2_10_10_10_REV normal, and texture coordinates.
+    PRGL_VERTEX_FORMAT_PACKED,
+
+    /// Position and texture coordinates, the normal reads the position. Only
+    /// for meshes on a unit sphere around their origin.
+    PRGL_VERTEX_FORMAT_SPHERE,
+
+    /// Position and texture coordinates without a normal.
+    PRGL_VERTEX_FORMAT_UNLIT,
+
+    /// Position only.
+    PRGL_VERTEX_FORMAT_POSITION
+};
+
+/**
+ * The byte layout a format was packed into for a specific set of vertices.
+ */
+struct PRGLVertexLayout
+{
+    enum PRGLVertexFormat format;
+    GLsizei stride;
+
+    /// GL_SHORT or GL_FLOAT.
+    GLenum position_type;
+
+    /// GL_UNSIGNED_SHORT or GL_HALF_FLOAT.
+    GLenum tex_coord_type;
+
+    GLsizei normal_offset;
+    GLsizei tex_coord_offset;
+};
+
+/**
+ * Picks the smallest layout of a format which can hold the given vertices.
+ *
+ * @param format
+ * @param vertex_data[in] Float vertices, with a normal at 3 and texture
+ * coordinates at 6 unless the format is PRGL_VERTEX_FORMAT_POSITION.
+ * @param num_vertices
+ * @param stride_length Number of floats per vertex in vertex_data.
+ * @param layout[out]
+ */
+void prgl_choose_vertex_layout(
+    enum PRGLVertexFormat format, const GLfloat vertex_data[],
+    GLsizei num_vertices, GLint stride_length,
+    struct PRGLVertexLayout *const layout
+);
+
+/**
+ * Packs float vertices into a layout.
+ *
+ * @param layout[in]
+ * @param vertex_data[in] The vertices the layout was chosen for.
+ * @param num_vertices
+ * @param stride_length Number of floats per vertex in vertex_data.
+ * @param dest[out] Must hold layout->stride * num_vertices bytes.
+ */
+void prgl_pack_vertices(
+    const struct PRGLVertexLayout *const layout, const GLfloat vertex_data[],
+    GLsizei num_vertices, GLint stride_length, void *const dest
+);
+
+/**
+ * Sets the vertex attributes for a layout on the bound vertex array, reading
+ * from the buffer bound to GL_ARRAY_BUFFER.
+ *
+ * @param layout[in]
+ */
+void prgl_setup_vertex_layout(const struct PRGLVertexLayout *const layout);
+
+#endif
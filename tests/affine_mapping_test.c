@@ -0,0 +1,75 @@
+/**
+ * Checks that picking affine texture mapping with the interpolated vertex clip
+ * test renders the same frame as the reference geometry shader. A textured
+ * scene is rendered with the default path, then with the geometry shader, and
+ * the two frames have to match byte for byte.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "screen.h"
+#include "shaders.h"
+#include "test_scene.h"
+
+// Frames to render before each capture, so the shaders have been built
+static const int SETTLE_FRAMES = 2;
+
+static struct PRGLTestScene scene;
+static int frame = 0;
+static unsigned char *frames[2] = {NULL, NULL};
+static int num_bytes[2] = {0, 0};
+static int num_frames = 0;
+
+static void init(void)
+{
+    prgl_init_test_scene(&scene, prgl_create_test_texture(), 0);
+}
+
+static void update(void) { prgl_update_test_scene(&scene); }
+
+static void draw_3d(void) { prgl_draw_test_scene(&scene); }
+
+static void draw_2d(void) {}
+
+static void cleanup(void)
+{
+    if (++frame < SETTLE_FRAMES)
+    {
+        return;
+    }
+
+    frames[num_frames] = prgl_read_test_frame(&num_bytes[num_frames]);
+    frame = 0;
+    if (++num_frames == 2)
+    {
+        prgl_close_game();
+        return;
+    }
+    prgl_set_geometry_shader_affine_enabled(true);
+}
+
+int main(void)
+{
+    prgl_run_game(
+        "affine_mapping_test", init, update, draw_3d, draw_2d, cleanup
+    );
+
+    if (frames[0] == NULL || frames[1] == NULL || num_bytes[0] != num_bytes[1])
+    {
+        fprintf(stderr, "affine_mapping_test: Failed to read the frames\n");
+        free(frames[0]);
+        free(frames[1]);
+        return EXIT_FAILURE;
+    }
+
+    const int differences =
+        prgl_count_frame_differences(frames[0], frames[1], num_bytes[0]);
+    printf(
+        "affine_mapping_test: %d of %d bytes differ\n", differences,
+        num_bytes[0]
+    );
+    free(frames[0]);
+    free(frames[1]);
+    return differences == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
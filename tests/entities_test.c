@@ -0,0 +1,241 @@
+/**
+ * Checks the entity storage and drawing entities:
+ * - Entities are created, destroyed and moved between archetypes, then every
+ * handle and component value is checked and queries have to visit each live
+ * entity once.
+ * - The test scene is rendered from its game objects, then from entities with
+ * the same transforms, meshes and colors spread over two archetypes, and the
+ * two frames have to match byte for byte.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cglm/quat.h"
+#include "cglm/vec3.h"
+#include "entities.h"
+#include "entities_internal.h"
+#include "game.h"
+#include "render.h"
+#include "screen.h"
+#include "test_scene.h"
+
+#define NUM_STORAGE_ENTITIES 20000
+
+// Frames to render before each capture, so the shaders have been built
+static const int SETTLE_FRAMES = 2;
+
+static PRGLEntity storage_entities[NUM_STORAGE_ENTITIES];
+
+static struct PRGLTestScene scene;
+static PRGLEntity scene_entities[PRGL_TEST_SCENE_MAX_OBJECTS];
+static bool draw_entities = false;
+static int frame = 0;
+static unsigned char *frames[2] = {NULL, NULL};
+static int num_bytes[2] = {0, 0};
+static int num_frames = 0;
+
+/**
+ * Creates, destroys and changes the components of many entities, then checks
+ * the handles, values and queries.
+ *
+ * @return The number of failed checks.
+ */
+static int check_storage(void)
+{
+    const uint32_t components = PRGL_COMPONENT_BIT(PRGL_COMPONENT_TRANSFORM)
+                              | PRGL_COMPONENT_BIT(PRGL_COMPONENT_COLOR);
+    const int extra = prgl_register_component(sizeof(int));
+    if (extra < 0
+        || !prgl_create_entities(
+            components, NUM_STORAGE_ENTITIES, storage_entities
+        ))
+    {
+        return 1;
+    }
+    for (int i = 0; i < NUM_STORAGE_ENTITIES; i++)
+    {
+        float *const color =
+            prgl_entity_component(storage_entities[i], PRGL_COMPONENT_COLOR);
+        color[0] = (float)i;
+    }
+
+    // Every third entity is destroyed, and the ones after them get a new
+    // component, which moves them to another archetype
+    for (int i = 0; i < NUM_STORAGE_ENTITIES; i += 3)
+    {
+        prgl_destroy_entities(&storage_entities[i], 1);
+    }
+    for (int i = 1; i < NUM_STORAGE_ENTITIES; i += 3)
+    {
+        prgl_set_entity_components(
+            storage_entities[i], components | PRGL_COMPONENT_BIT(extra)
+        );
+    }
+
+    int failures = 0;
+    int num_alive = 0;
+    for (int i = 0; i < NUM_STORAGE_ENTITIES; i++)
+    {
+        const bool alive = i % 3 != 0;
+        failures += prgl_entity_alive(storage_entities[i]) != alive;
+        if (!alive)
+        {
+            failures += prgl_entity_component(
+                            storage_entities[i], PRGL_COMPONENT_COLOR
+                        )
+                     != NULL;
+            continue;
+        }
+
+        num_alive++;
+        const float *const color =
+            prgl_entity_component(storage_entities[i], PRGL_COMPONENT_COLOR);
+        failures += color == NULL || color[0] != (float)i;
+        failures += (prgl_entity_component(storage_entities[i], extra) != NULL)
+                 != (i % 3 == 1);
+    }
+
+    // Reused indices get a new generation, so stale handles stay stale
+    PRGLEntity reused[10];
+    if (!prgl_create_entities(components, 10, reused))
+    {
+        return failures + 1;
+    }
+    num_alive += 10;
+    for (int i = 0; i < 10; i++)
+    {
+        for (int j = 0; j < NUM_STORAGE_ENTITIES; j += 3)
+        {
+            failures += reused[i].index == storage_entities[j].index
+                     && reused[i].generation == storage_entities[j].generation;
+        }
+    }
+    failures += prgl_entity_alive(storage_entities[0]);
+
+    struct PRGLEntityQuery query =
+        prgl_query_entities(PRGL_COMPONENT_BIT(PRGL_COMPONENT_COLOR));
+    struct PRGLEntityBatch batch;
+    int num_queried = 0;
+    while (prgl_next_entity_batch(&query, &batch))
+    {
+        vec3 *const colors = batch.columns[PRGL_COMPONENT_COLOR];
+        for (int i = 0; i < batch.count; i++)
+        {
+            failures += prgl_entity_component(
+                            batch.entities[i], PRGL_COMPONENT_COLOR
+                        )
+                     != colors[i];
+        }
+        num_queried += batch.count;
+    }
+    failures += num_queried != num_alive;
+
+    prgl_delete_entities();
+    return failures;
+}
+
+/**
+ * Creates an entity for each game object of the test scene, every other one
+ * with an extra component so they're drawn from two archetypes.
+ */
+static void create_scene_entities(void)
+{
+    const uint32_t components = PRGL_COMPONENT_BIT(PRGL_COMPONENT_TRANSFORM)
+                              | PRGL_COMPONENT_BIT(PRGL_COMPONENT_MESH)
+                              | PRGL_COMPONENT_BIT(PRGL_COMPONENT_COLOR);
+    const int extra = prgl_register_component(sizeof(double));
+    if (!prgl_create_entities(components, scene.num_objects, scene_entities))
+    {
+        return;
+    }
+
+    for (int i = 0; i < scene.num_objects; i++)
+    {
+        struct PRGLGameObject *const game_obj = &scene.objects[i];
+        if (i % 2 == 1)
+        {
+            prgl_set_entity_components(
+                scene_entities[i], components | PRGL_COMPONENT_BIT(extra)
+            );
+        }
+
+        struct PRGLTransform *const transform =
+            prgl_entity_component(scene_entities[i], PRGL_COMPONENT_TRANSFORM);
+        glm_quat_copy(game_obj->orientation, transform->orientation);
+        glm_vec3_copy(game_obj->position, transform->position);
+        glm_vec3_copy(game_obj->scale, transform->scale);
+        *(PRGLMeshHandle *)prgl_entity_component(
+            scene_entities[i], PRGL_COMPONENT_MESH
+        ) = game_obj->mesh;
+        glm_vec3_copy(
+            game_obj->color,
+            prgl_entity_component(scene_entities[i], PRGL_COMPONENT_COLOR)
+        );
+    }
+}
+
+static void init(void)
+{
+    prgl_init_test_scene(&scene, prgl_create_test_texture(), 0);
+}
+
+static void update(void) { prgl_update_test_scene(&scene); }
+
+static void draw_3d(void)
+{
+    if (draw_entities)
+    {
+        prgl_draw_entities_3d();
+    }
+    else
+    {
+        prgl_draw_test_scene(&scene);
+    }
+}
+
+static void draw_2d(void) {}
+
+static void cleanup(void)
+{
+    if (++frame < SETTLE_FRAMES)
+    {
+        return;
+    }
+
+    frames[num_frames] = prgl_read_test_frame(&num_bytes[num_frames]);
+    frame = 0;
+    if (++num_frames == 2)
+    {
+        prgl_close_game();
+        return;
+    }
+    create_scene_entities();
+    draw_entities = true;
+}
+
+int main(void)
+{
+    const int storage_failures = check_storage();
+    printf("entities_test: %d storage checks failed\n", storage_failures);
+
+    prgl_run_game("entities_test", init, update, draw_3d, draw_2d, cleanup);
+
+    if (frames[0] == NULL || frames[1] == NULL || num_bytes[0] != num_bytes[1])
+    {
+        fprintf(stderr, "entities_test: Failed to read the frames\n");
+        free(frames[0]);
+        free(frames[1]);
+        return EXIT_FAILURE;
+    }
+
+    const int differences =
+        prgl_count_frame_differences(frames[0], frames[1], num_bytes[0]);
+    printf(
+        "entities_test: %d of %d bytes differ from the game objects\n",
+        differences, num_bytes[0]
+    );
+    free(frames[0]);
+    free(frames[1]);
+    return storage_failures == 0 && differences == 0 ? EXIT_SUCCESS
+                                                     : EXIT_FAILURE;
+}
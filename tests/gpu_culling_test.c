@@ -0,0 +1,65 @@
+/**
+ * Checks the compute shader frustum culling of multi draws against the CPU
+ * frustum test. The scene has draws inside and outside the view, and with
+ * validation on every draw the GPU culls is read back and compared with the
+ * CPU test, disagreements are counted in the render stats.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "render.h"
+#include "screen.h"
+#include "test_scene.h"
+#include "texture.h"
+
+static const int NUM_FRAMES = 3;
+static const int NUM_HIDDEN_OBJECTS = 20;
+
+static struct PRGLTestScene scene;
+static int frame = 0;
+static int tested_draws = 0;
+static int mismatches = 0;
+
+static void init(void)
+{
+    prgl_init_test_scene(&scene, PRGL_NO_TEXTURE, NUM_HIDDEN_OBJECTS);
+    prgl_set_gpu_culling_validation(true);
+}
+
+static void update(void) { prgl_update_test_scene(&scene); }
+
+static void draw_3d(void) { prgl_draw_test_scene(&scene); }
+
+static void draw_2d(void) {}
+
+static void cleanup(void)
+{
+    const struct PRGLRenderStats stats = prgl_render_stats();
+    tested_draws += stats.gpu_tested_draws;
+    mismatches += stats.gpu_cull_mismatches;
+
+    if (++frame == NUM_FRAMES)
+    {
+        prgl_close_game();
+    }
+}
+
+int main(void)
+{
+    prgl_run_game(
+        "gpu_culling_test", init, update, draw_3d, draw_2d, cleanup
+    );
+
+    // Compute culling needs a GL 4.3 context
+    if (tested_draws == 0)
+    {
+        printf("gpu_culling_test: No draws were culled on the GPU, skipped\n");
+        return PRGL_TEST_SKIPPED;
+    }
+    printf(
+        "gpu_culling_test: %d draws tested, %d mismatches\n", tested_draws,
+        mismatches
+    );
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
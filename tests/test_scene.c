@@ -0,0 +1,125 @@
+#include "glad.h"
+
+#include "test_scene.h"
+
+#include <stdlib.h>
+
+#include "mesh.h"
+#include "render.h"
+#include "texture.h"
+
+void prgl_init_test_scene(
+    struct PRGLTestScene *const scene, PRGLTexture texture, int num_hidden
+)
+{
+    prgl_init_camera(
+        &scene->camera, 60.0f, 1.0f, PRGL_CAMERA_PROJECTION_PERSPECTIVE
+    );
+    scene->camera.position[2] = 6.0f;
+
+    const PRGLMeshHandle meshes[3] = {
+        prgl_create_cube(texture),
+        prgl_create_cube_sphere(4, PRGL_NO_TEXTURE),
+        prgl_create_pyramid(PRGL_NO_TEXTURE),
+    };
+
+    // A 3x3x3 grid, each object turned and tinted differently
+    scene->num_objects = 0;
+    for (int i = 0; i < PRGL_TEST_SCENE_GRID_OBJECTS; i++)
+    {
+        struct PRGLGameObject *const game_obj =
+            &scene->objects[scene->num_objects++];
+        prgl_init_game_object(
+            game_obj, meshes[i % 3],
+            (vec3){(float)(i % 3) - 1.0f, (float)((i / 3) % 3) - 1.0f,
+                   -(float)(i / 9) * 1.5f}
+        );
+        prgl_set_game_object_scale(game_obj, (vec3){0.6f, 0.6f, 0.6f});
+        prgl_rotate_game_object(game_obj, 20.0f * i, 10.0f * i, 0.0f);
+        prgl_set_game_object_color(
+            game_obj, 0.5f + 0.02f * i, 1.0f - 0.02f * i, 0.8f
+        );
+    }
+
+    // Off to the side or behind the camera
+    for (int i = 0; i < num_hidden
+                    && scene->num_objects < PRGL_TEST_SCENE_MAX_OBJECTS;
+         i++)
+    {
+        prgl_init_game_object(
+            &scene->objects[scene->num_objects++], meshes[i % 3],
+            (vec3){i % 2 ? 30.0f : 0.0f, 0.0f, i % 2 ? 0.0f : 12.0f + i}
+        );
+    }
+
+    prgl_init_point_light(&scene->lights[0], (vec3){0.0f, 2.0f, 3.0f});
+    prgl_init_point_light(&scene->lights[1], (vec3){-3.0f, -1.0f, 1.0f});
+    scene->lights[1].lightColor[1] = 0.3f;
+    prgl_init_point_light(&scene->lights[2], (vec3){3.0f, 0.0f, -2.0f});
+    scene->lights[2].intensity = PRGL_LIGHT_INTENSITY_HIGH;
+}
+
+void prgl_update_test_scene(struct PRGLTestScene *const scene)
+{
+    prgl_update_camera(&scene->camera);
+    prgl_update_lighting(scene->lights, 3);
+}
+
+void prgl_draw_test_scene(struct PRGLTestScene *const scene)
+{
+    for (int i = 0; i < scene->num_objects; i++)
+    {
+        prgl_draw_game_object_3d(&scene->objects[i]);
+    }
+}
+
+PRGLTexture prgl_create_test_texture(void)
+{
+    const unsigned char pixels[16] = {
+        255, 255, 255, 255, 0, 0, 0, 255, 0, 0, 0, 255, 255, 255, 255, 255,
+    };
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(
+        GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels
+    );
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // The texture was bound behind prgl's back
+    prgl_reset_gl_state_cache();
+    return (PRGLTexture){.id = texture};
+}
+
+unsigned char *prgl_read_test_frame(int *const num_bytes)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    *num_bytes = viewport[2] * viewport[3] * 3;
+
+    unsigned char *const pixels = malloc((size_t)*num_bytes);
+    if (pixels == NULL)
+    {
+        return NULL;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(
+        viewport[0], viewport[1], viewport[2], viewport[3], GL_RGB,
+        GL_UNSIGNED_BYTE, pixels
+    );
+    return pixels;
+}
+
+int prgl_count_frame_differences(
+    const unsigned char a[], const unsigned char b[], int num_bytes
+)
+{
+    int differences = 0;
+    for (int i = 0; i < num_bytes; i++)
+    {
+        differences += a[i] != b[i];
+    }
+    return differences;
+}
@@ -0,0 +1,88 @@
+#ifndef PRGL_TEST_SCENE_H
+#define PRGL_TEST_SCENE_H
+
+#include <stdbool.h>
+
+#include "camera.h"
+#include "game_object.h"
+#include "lighting.h"
+#include "types.h"
+
+/// Exit code ctest reports as a skipped test, for missing GL features.
+#define PRGL_TEST_SKIPPED 77
+
+/// Objects in the visible grid of a test scene.
+#define PRGL_TEST_SCENE_GRID_OBJECTS 27
+
+/// Most objects a test scene holds, the grid plus objects outside the view.
+#define PRGL_TEST_SCENE_MAX_OBJECTS 64
+
+/**
+ * A fixed, lit 3D scene for tests and benchmarks to render: a grid of cubes,
+ * spheres and pyramids in front of the camera, lit by three point lights.
+ */
+struct PRGLTestScene
+{
+    struct PRGLCamera camera;
+    struct PRGLGameObject objects[PRGL_TEST_SCENE_MAX_OBJECTS];
+    int num_objects;
+    struct PRGLPointLight lights[3];
+};
+
+/**
+ * Creates a test scene's meshes and places its objects. Call from the init
+ * callback of prgl_run_game().
+ *
+ * @param scene[out]
+ * @param texture The texture of the grid's cubes, or PRGL_NO_TEXTURE.
+ * @param num_hidden Objects to add outside the camera's view, at most
+ * PRGL_TEST_SCENE_MAX_OBJECTS - PRGL_TEST_SCENE_GRID_OBJECTS.
+ */
+void prgl_init_test_scene(
+    struct PRGLTestScene *const scene, PRGLTexture texture, int num_hidden
+);
+
+/**
+ * Updates a test scene's camera and lights. Call from the update callback.
+ *
+ * @param scene[in,out]
+ */
+void prgl_update_test_scene(struct PRGLTestScene *const scene);
+
+/**
+ * Draws every object of a test scene with prgl_draw_game_object_3d().
+ *
+ * @param scene[in,out]
+ */
+void prgl_draw_test_scene(struct PRGLTestScene *const scene);
+
+/**
+ * Creates a 2x2 black and white checker texture with nearest filtering.
+ *
+ * @return The texture.
+ */
+PRGLTexture prgl_create_test_texture(void);
+
+/**
+ * Reads back the frame just rendered to the window, call from the cleanup
+ * callback.
+ *
+ * @param num_bytes[out] The size of the frame, 3 bytes per pixel.
+ * @return The RGB pixels, free with free(), or NULL if memory couldn't be
+ * allocated.
+ */
+unsigned char *prgl_read_test_frame(int *const num_bytes);
+
+/**
+ * Compares two frames read with prgl_read_test_frame().
+ *
+ * @param a[in]
+ * @param b[in]
+ * @param num_bytes
+ * @return The number of color channels which differ.
+ */
+int prgl_count_frame_differences(
+    const unsigned char a[], const unsigned char b[], int num_bytes
+);
+
+#endif